@@ -0,0 +1,648 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Benchmark of read and write throughput of every supported file format.
+ *
+ * Input data is generated in memory at several sizes, so the benchmark
+ * doesn't depend on any sample files. Results are printed as JSON (default)
+ * or CSV to compare them between library versions:
+ *
+ *   pgefl_bench [--quick] [--csv] [--sizes 1000,10000] [--iterations N]
+ *               [--min-time SEC] [--filter TEXT] [--tmp DIR] [--output FILE]
+ */
+
+#include "file_formats.h"
+#include "synthetic_data.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+static std::atomic<unsigned long> s_allocations(0);
+static std::atomic<unsigned long long> s_allocatedBytes(0);
+
+void *operator new(std::size_t size)
+{
+    s_allocations++;
+    s_allocatedBytes += size;
+    void *p = std::malloc(size ? size : 1);
+    if(!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+//! Peak resident set size of the process in kilobytes, 0 if unknown
+static unsigned long peakRssKb()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS pmc;
+    if(GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return static_cast<unsigned long>(pmc.PeakWorkingSetSize / 1024);
+    return 0;
+#else
+    struct rusage u;
+    if(getrusage(RUSAGE_SELF, &u) != 0)
+        return 0;
+#   if defined(__APPLE__)
+    return static_cast<unsigned long>(u.ru_maxrss / 1024);
+#   else
+    return static_cast<unsigned long>(u.ru_maxrss);
+#   endif
+#endif
+}
+
+
+/*********************************************************************************
+ * Synthetic data
+ *********************************************************************************/
+
+static PGESTRING num(long v)
+{
+    return std::to_string(v);
+}
+
+//! NPC.txt with every standard field
+static std::string makeNpcTxt()
+{
+    static const char *numeric[] =
+    {
+        "gfxoffsetx", "gfxoffsety", "gfxwidth", "gfxheight", "foreground", "width", "height",
+        "score", "health", "playerblock", "playerblocktop", "npcblock", "npcblocktop",
+        "grabside", "grabtop", "jumphurt", "nohurt", "speed", "noblockcollision", "cliffturn",
+        "noyoshi", "nofireball", "nogravity", "noiceball", "frames", "framespeed", "framestyle",
+        "nohammer", "noshell", "grid", "gridoffsetx", "gridoffsety", "gridalign"
+    };
+    static const char *text[] =
+    {
+        "name", "description", "image", "icon", "script", "group", "category"
+    };
+
+    std::string out;
+    int v = 1;
+    for(const char *k : numeric)
+        out += std::string(k) + "=" + num(v++ % 4) + "\n";
+    for(const char *k : text)
+        out += std::string(k) + "=\"Some " + k + " value\"\n";
+    return out;
+}
+
+//! Editor's meta-data with roughly the given number of bookmarks
+static MetaData makeMeta(long elements)
+{
+    MetaData meta;
+    for(long i = 0; i < elements; i++)
+    {
+        Bookmark b;
+        b.bookmarkName = "Bookmark \"" + num(i) + "\"";
+        b.x = static_cast<double>(i * 32);
+        b.y = static_cast<double>(-i * 16);
+        meta.bookmarks.push_back(b);
+    }
+    return meta;
+}
+
+
+/*********************************************************************************
+ * Measurement
+ *********************************************************************************/
+
+struct Options
+{
+    std::vector<long> sizes = {1000, 10000, 100000};
+    int iterations = 3;
+    double minTime = 0.2;
+    bool csv = false;
+    std::string filter;
+    std::string tmpDir;
+    std::string output;
+};
+
+struct Result
+{
+    std::string format;
+    std::string operation;
+    long size = 0;
+    size_t bytes = 0;
+    size_t elements = 0;
+    int iterations = 0;
+    double bestSec = 0.0;
+    double medianSec = 0.0;
+    unsigned long allocations = 0;
+    unsigned long long allocatedBytes = 0;
+    unsigned long peakRss = 0;
+    bool ok = true;
+};
+
+class Bench
+{
+public:
+    explicit Bench(const Options &o) : m_opt(o) {}
+
+    /*!
+     * \brief Runs the operation repeatedly and stores the result
+     * \param format Name of the file format
+     * \param operation Name of the operation
+     * \param size Requested size of the synthetic data
+     * \param bytes Bytes read or written by one run
+     * \param run Operation, returns number of processed elements, or -1 on failure
+     */
+    void run(const std::string &format, const std::string &operation, long size, size_t bytes,
+             const std::function<long()> &run)
+    {
+        const std::string name = format + " " + operation;
+        if(!m_opt.filter.empty() && name.find(m_opt.filter) == std::string::npos)
+            return;
+
+        Result r;
+        r.format = format;
+        r.operation = operation;
+        r.size = size;
+        r.bytes = bytes;
+
+        // Warm-up, also counts allocations of a single run
+        unsigned long allocs = s_allocations.load();
+        unsigned long long allocBytes = s_allocatedBytes.load();
+        long elements = run();
+        r.allocations = s_allocations.load() - allocs;
+        r.allocatedBytes = s_allocatedBytes.load() - allocBytes;
+        r.ok = elements >= 0;
+        r.elements = elements >= 0 ? static_cast<size_t>(elements) : 0;
+
+        std::vector<double> times;
+        double total = 0.0;
+        while(r.ok && (static_cast<int>(times.size()) < m_opt.iterations || total < m_opt.minTime))
+        {
+            auto begin = std::chrono::steady_clock::now();
+            r.ok = run() >= 0;
+            auto end = std::chrono::steady_clock::now();
+            const double sec = std::chrono::duration<double>(end - begin).count();
+            times.push_back(sec);
+            total += sec;
+            if(times.size() >= 1000)
+                break;
+        }
+
+        if(!times.empty())
+        {
+            std::sort(times.begin(), times.end());
+            r.bestSec = times.front();
+            r.medianSec = times[times.size() / 2];
+        }
+        r.iterations = static_cast<int>(times.size());
+        r.peakRss = peakRssKb();
+
+        std::fprintf(stderr, "%-14s %-10s %8ld %s %10.2f MB/s %12.0f elements/s %9lu allocations\n",
+                     format.c_str(), operation.c_str(), size, r.ok ? "  " : "!!",
+                     mbPerSec(r), elementsPerSec(r), r.allocations);
+        m_results.push_back(r);
+    }
+
+    bool failed() const
+    {
+        for(const Result &r : m_results)
+        {
+            if(!r.ok)
+                return true;
+        }
+        return false;
+    }
+
+    std::string report() const
+    {
+        return m_opt.csv ? reportCsv() : reportJson();
+    }
+
+private:
+    static double mbPerSec(const Result &r)
+    {
+        return r.bestSec > 0.0 ? double(r.bytes) / r.bestSec / 1000000.0 : 0.0;
+    }
+
+    static double elementsPerSec(const Result &r)
+    {
+        return r.bestSec > 0.0 ? double(r.elements) / r.bestSec : 0.0;
+    }
+
+    static std::string fmt(const char *format, double v)
+    {
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), format, v);
+        return buf;
+    }
+
+    std::string reportJson() const
+    {
+        std::string out = "{\n  \"library\": \"pgefl\",\n";
+#ifdef PGE_FILES_ARENA
+        out += "  \"arena_containers\": true,\n";
+#else
+        out += "  \"arena_containers\": false,\n";
+#endif
+        out += "  \"results\": [\n";
+        for(size_t i = 0; i < m_results.size(); i++)
+        {
+            const Result &r = m_results[i];
+            out += "    {\"format\": \"" + r.format + "\", \"operation\": \"" + r.operation + "\"" +
+                   ", \"size\": " + num(r.size) +
+                   ", \"ok\": " + (r.ok ? "true" : "false") +
+                   ", \"bytes\": " + std::to_string(r.bytes) +
+                   ", \"elements\": " + std::to_string(r.elements) +
+                   ", \"iterations\": " + num(r.iterations) +
+                   ", \"best_sec\": " + fmt("%.9f", r.bestSec) +
+                   ", \"median_sec\": " + fmt("%.9f", r.medianSec) +
+                   ", \"mb_per_sec\": " + fmt("%.3f", mbPerSec(r)) +
+                   ", \"elements_per_sec\": " + fmt("%.1f", elementsPerSec(r)) +
+                   ", \"allocations\": " + std::to_string(r.allocations) +
+                   ", \"allocated_bytes\": " + std::to_string(r.allocatedBytes) +
+                   ", \"peak_rss_kb\": " + std::to_string(r.peakRss) + "}";
+            out += (i + 1 < m_results.size()) ? ",\n" : "\n";
+        }
+        out += "  ]\n}\n";
+        return out;
+    }
+
+    std::string reportCsv() const
+    {
+        std::string out = "format,operation,size,ok,bytes,elements,iterations,best_sec,median_sec,"
+                          "mb_per_sec,elements_per_sec,allocations,allocated_bytes,peak_rss_kb\n";
+        for(const Result &r : m_results)
+        {
+            out += r.format + "," + r.operation + "," + num(r.size) + "," + (r.ok ? "1" : "0") + "," +
+                   std::to_string(r.bytes) + "," + std::to_string(r.elements) + "," + num(r.iterations) + "," +
+                   fmt("%.9f", r.bestSec) + "," + fmt("%.9f", r.medianSec) + "," +
+                   fmt("%.3f", mbPerSec(r)) + "," + fmt("%.1f", elementsPerSec(r)) + "," +
+                   std::to_string(r.allocations) + "," + std::to_string(r.allocatedBytes) + "," +
+                   std::to_string(r.peakRss) + "\n";
+        }
+        return out;
+    }
+
+    const Options &m_opt;
+    std::vector<Result> m_results;
+};
+
+
+/*********************************************************************************
+ * Benchmark cases
+ *********************************************************************************/
+
+static void benchLevel(Bench &b, const Options &o, long size, const char *format,
+                       FileFormats::LevelFileFormat type, const char *ext)
+{
+    LevelData src = SyntheticData::makeLevel(SyntheticData::LevelConfig::scaled(size));
+    PGESTRING raw;
+    if(!FileFormats::SaveLevelData(src, raw, type))
+    {
+        std::fprintf(stderr, "%s: failed to generate the level: %s\n", format, src.meta.ERROR_info.c_str());
+        return;
+    }
+
+    const PGESTRING path = o.tmpDir + "/pgefl_bench_level." + ext;
+    if(!PGE_FileFormats_misc::writeBinaryFile(path, raw))
+        return;
+
+    b.run(format, "read_raw", size, raw.size(), [&]() -> long
+    {
+        LevelData d;
+        PGESTRING in = raw;
+        return FileFormats::OpenLevelRaw(in, path, d) ? static_cast<long>(SyntheticData::levelElements(d)) : -1;
+    });
+    b.run(format, "read_file", size, raw.size(), [&]() -> long
+    {
+        LevelData d;
+        return FileFormats::OpenLevelFile(path, d) ? static_cast<long>(SyntheticData::levelElements(d)) : -1;
+    });
+    b.run(format, "write_raw", size, raw.size(), [&]() -> long
+    {
+        PGESTRING out;
+        return FileFormats::SaveLevelData(src, out, type) ? static_cast<long>(SyntheticData::levelElements(src)) : -1;
+    });
+    b.run(format, "write_file", size, raw.size(), [&]() -> long
+    {
+        return FileFormats::SaveLevelFile(src, path, type) ? static_cast<long>(SyntheticData::levelElements(src)) : -1;
+    });
+
+    std::remove(path.c_str());
+}
+
+static void benchWorld(Bench &b, const Options &o, long size, const char *format,
+                       FileFormats::WorldFileFormat type, const char *ext)
+{
+    WorldData src = SyntheticData::makeWorld(SyntheticData::WorldConfig::scaled(size));
+    PGESTRING raw;
+    // The library has no writer of SMBX-38A world maps, reading only
+    const bool canWrite = (type != FileFormats::WLD_SMBX38A);
+    if(!canWrite)
+        raw = SyntheticData::smbx38aWorldText(src);
+    else if(!FileFormats::SaveWorldData(src, raw, type))
+    {
+        std::fprintf(stderr, "%s: failed to generate the world map: %s\n", format, src.meta.ERROR_info.c_str());
+        return;
+    }
+
+    const PGESTRING path = o.tmpDir + "/pgefl_bench_world." + ext;
+    if(!PGE_FileFormats_misc::writeBinaryFile(path, raw))
+        return;
+
+    b.run(format, "read_raw", size, raw.size(), [&]() -> long
+    {
+        WorldData d;
+        PGESTRING in = raw;
+        return FileFormats::OpenWorldRaw(in, path, d) ? static_cast<long>(SyntheticData::worldElements(d)) : -1;
+    });
+    b.run(format, "read_file", size, raw.size(), [&]() -> long
+    {
+        WorldData d;
+        return FileFormats::OpenWorldFile(path, d) ? static_cast<long>(SyntheticData::worldElements(d)) : -1;
+    });
+    if(!canWrite)
+    {
+        std::remove(path.c_str());
+        return;
+    }
+
+    b.run(format, "write_raw", size, raw.size(), [&]() -> long
+    {
+        PGESTRING out;
+        return FileFormats::SaveWorldData(src, out, type) ? static_cast<long>(SyntheticData::worldElements(src)) : -1;
+    });
+    b.run(format, "write_file", size, raw.size(), [&]() -> long
+    {
+        return FileFormats::SaveWorldFile(src, path, type) ? static_cast<long>(SyntheticData::worldElements(src)) : -1;
+    });
+
+    std::remove(path.c_str());
+}
+
+static void benchSaves(Bench &b, const Options &o, long size)
+{
+    GamesaveData src = SyntheticData::makeSave(size);
+    PGESTRING savx;
+    if(!FileFormats::WriteExtendedSaveFileRaw(src, savx))
+        return;
+    const PGESTRING savxPath = o.tmpDir + "/pgefl_bench_save.savx";
+    if(!PGE_FileFormats_misc::writeBinaryFile(savxPath, savx))
+        return;
+
+    b.run("PGE-X SAVX", "read_raw", size, savx.size(), [&]() -> long
+    {
+        GamesaveData d;
+        PGESTRING in = savx;
+        return FileFormats::ReadExtendedSaveFileRaw(in, savxPath, d) ? static_cast<long>(SyntheticData::saveElements(d)) : -1;
+    });
+    b.run("PGE-X SAVX", "read_file", size, savx.size(), [&]() -> long
+    {
+        GamesaveData d;
+        return FileFormats::ReadExtendedSaveFileF(savxPath, d) ? static_cast<long>(SyntheticData::saveElements(d)) : -1;
+    });
+    b.run("PGE-X SAVX", "write_raw", size, savx.size(), [&]() -> long
+    {
+        PGESTRING out;
+        return FileFormats::WriteExtendedSaveFileRaw(src, out) ? static_cast<long>(SyntheticData::saveElements(src)) : -1;
+    });
+    b.run("PGE-X SAVX", "write_file", size, savx.size(), [&]() -> long
+    {
+        return FileFormats::WriteExtendedSaveFileF(savxPath, src) ? static_cast<long>(SyntheticData::saveElements(src)) : -1;
+    });
+    std::remove(savxPath.c_str());
+
+    // The library has no writer of SMBX64 game saves, reading only
+    const PGESTRING sav = SyntheticData::smbx64SaveText(src);
+    const PGESTRING savPath = o.tmpDir + "/pgefl_bench_save.sav";
+    if(!PGE_FileFormats_misc::writeBinaryFile(savPath, sav))
+        return;
+
+    b.run("SMBX64 SAV", "read_raw", size, sav.size(), [&]() -> long
+    {
+        GamesaveData d;
+        PGESTRING in = sav;
+        return FileFormats::ReadSMBX64SavFileRaw(in, savPath, d) ? static_cast<long>(SyntheticData::saveElements(d)) : -1;
+    });
+    b.run("SMBX64 SAV", "read_file", size, sav.size(), [&]() -> long
+    {
+        GamesaveData d;
+        return FileFormats::ReadSMBX64SavFileF(savPath, d) ? static_cast<long>(SyntheticData::saveElements(d)) : -1;
+    });
+    std::remove(savPath.c_str());
+}
+
+static void benchMeta(Bench &b, const Options &o, long size)
+{
+    MetaData src = makeMeta(size);
+    PGESTRING raw;
+    if(!FileFormats::WriteNonSMBX64MetaDataRaw(src, raw))
+        return;
+    const PGESTRING path = o.tmpDir + "/pgefl_bench.lvl.meta";
+    if(!PGE_FileFormats_misc::writeBinaryFile(path, raw))
+        return;
+
+    b.run("PGE-X META", "read_raw", size, raw.size(), [&]() -> long
+    {
+        MetaData d;
+        PGESTRING in = raw;
+        return FileFormats::ReadNonSMBX64MetaDataRaw(in, path, d) ? static_cast<long>(d.bookmarks.size()) : -1;
+    });
+    b.run("PGE-X META", "read_file", size, raw.size(), [&]() -> long
+    {
+        MetaData d;
+        return FileFormats::ReadNonSMBX64MetaDataF(path, d) ? static_cast<long>(d.bookmarks.size()) : -1;
+    });
+    b.run("PGE-X META", "write_raw", size, raw.size(), [&]() -> long
+    {
+        PGESTRING out;
+        return FileFormats::WriteNonSMBX64MetaDataRaw(src, out) ? static_cast<long>(src.bookmarks.size()) : -1;
+    });
+    b.run("PGE-X META", "write_file", size, raw.size(), [&]() -> long
+    {
+        return FileFormats::WriteNonSMBX64MetaDataF(path, src) ? static_cast<long>(src.bookmarks.size()) : -1;
+    });
+    std::remove(path.c_str());
+}
+
+//! NPC.txt has the fixed set of fields, so it's measured at one size only
+static void benchNpcTxt(Bench &b, const Options &o)
+{
+    const PGESTRING raw = makeNpcTxt();
+    const PGESTRING path = o.tmpDir + "/pgefl_bench_npc-1.txt";
+    if(!PGE_FileFormats_misc::writeBinaryFile(path, raw))
+        return;
+
+    const long fields = static_cast<long>(std::count(raw.begin(), raw.end(), '\n'));
+    NPCConfigFile src;
+    {
+        PGESTRING in = raw;
+        if(!FileFormats::ReadNpcTXTFileRAW(in, src))
+            return;
+    }
+
+    b.run("SMBX64 NPC.txt", "read_raw", 1, raw.size(), [&]() -> long
+    {
+        NPCConfigFile d;
+        PGESTRING in = raw;
+        return FileFormats::ReadNpcTXTFileRAW(in, d) ? fields : -1;
+    });
+    b.run("SMBX64 NPC.txt", "read_file", 1, raw.size(), [&]() -> long
+    {
+        NPCConfigFile d;
+        return FileFormats::ReadNpcTXTFileF(path, d) ? fields : -1;
+    });
+    b.run("SMBX64 NPC.txt", "write_raw", 1, raw.size(), [&]() -> long
+    {
+        PGESTRING out;
+        return FileFormats::WriteNPCTxtFileRaw(src, out) ? fields : -1;
+    });
+    b.run("SMBX64 NPC.txt", "write_file", 1, raw.size(), [&]() -> long
+    {
+        return FileFormats::WriteNPCTxtFileF(path, src) ? fields : -1;
+    });
+    std::remove(path.c_str());
+}
+
+
+static bool parseArgs(int argc, char **argv, Options &o)
+{
+    for(int i = 1; i < argc; i++)
+    {
+        const std::string a = argv[i];
+        const bool hasValue = (i + 1 < argc);
+        if(a == "--quick")
+        {
+            o.sizes = {100};
+            o.iterations = 1;
+            o.minTime = 0.0;
+        }
+        else if(a == "--csv")
+            o.csv = true;
+        else if(a == "--json")
+            o.csv = false;
+        else if(a == "--sizes" && hasValue)
+        {
+            o.sizes.clear();
+            std::string list = argv[++i];
+            size_t pos = 0;
+            while(pos <= list.size())
+            {
+                size_t comma = list.find(',', pos);
+                if(comma == std::string::npos)
+                    comma = list.size();
+                const long v = std::atol(list.substr(pos, comma - pos).c_str());
+                if(v > 0)
+                    o.sizes.push_back(v);
+                pos = comma + 1;
+            }
+            if(o.sizes.empty())
+                return false;
+        }
+        else if(a == "--iterations" && hasValue)
+            o.iterations = std::max(1, std::atoi(argv[++i]));
+        else if(a == "--min-time" && hasValue)
+            o.minTime = std::atof(argv[++i]);
+        else if(a == "--filter" && hasValue)
+            o.filter = argv[++i];
+        else if(a == "--tmp" && hasValue)
+            o.tmpDir = argv[++i];
+        else if(a == "--output" && hasValue)
+            o.output = argv[++i];
+        else
+            return false;
+    }
+
+    if(o.tmpDir.empty())
+    {
+        const char *env = std::getenv("TMPDIR");
+        if(!env)
+            env = std::getenv("TEMP");
+#if defined(_WIN32)
+        o.tmpDir = env ? env : ".";
+#else
+        o.tmpDir = env ? env : "/tmp";
+#endif
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    Options o;
+    if(!parseArgs(argc, argv, o))
+    {
+        std::fprintf(stderr,
+                     "Usage: %s [--quick] [--csv|--json] [--sizes N,N,...] [--iterations N]\n"
+                     "          [--min-time SEC] [--filter TEXT] [--tmp DIR] [--output FILE]\n",
+                     argv[0]);
+        return 2;
+    }
+
+    Bench b(o);
+    for(long size : o.sizes)
+    {
+        benchLevel(b, o, size, "PGE-X LVLX", FileFormats::LVL_PGEX, "lvlx");
+        benchLevel(b, o, size, "SMBX64 LVL", FileFormats::LVL_SMBX64, "lvl");
+        benchLevel(b, o, size, "SMBX-38A LVL", FileFormats::LVL_SMBX38A, "lvl");
+        benchWorld(b, o, size, "PGE-X WLDX", FileFormats::WLD_PGEX, "wldx");
+        benchWorld(b, o, size, "SMBX64 WLD", FileFormats::WLD_SMBX64, "wld");
+        benchWorld(b, o, size, "SMBX-38A WLD", FileFormats::WLD_SMBX38A, "wld");
+        benchSaves(b, o, size);
+        benchMeta(b, o, size);
+    }
+    benchNpcTxt(b, o);
+
+    const std::string report = b.report();
+    if(o.output.empty())
+        std::fputs(report.c_str(), stdout);
+    else if(!PGE_FileFormats_misc::writeBinaryFile(o.output, report))
+    {
+        std::fprintf(stderr, "Failed to write %s\n", o.output.c_str());
+        return 1;
+    }
+
+    return b.failed() ? 1 : 0;
+}
@@ -0,0 +1,1023 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "compiled_level.h"
+#include "pge_file_lib_private.h"
+
+#include <cstring>
+#include <vector>
+
+#ifdef PGE_FILES_QT
+#include <QFile>
+#elif defined(_WIN32)
+#include <windows.h>
+#elif !defined(PGE_MIN_PORT) && !defined(__3DS__) && !defined(VITA)
+#define COMPILED_LEVEL_USE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/*
+ * Image layout: the header with the table of chunks, then chunks, each
+ * chunk is aligned at the 8-byte boundary. Every chunk is a plain array of
+ * one of the public structures or of the scalar values.
+ */
+
+enum CompiledLevelChunk
+{
+    CL_STRING_OFFSETS = 0,
+    CL_STRING_DATA,
+    CL_INFO,
+    CL_SECTIONS,
+    CL_PLAYERS,
+    CL_LAYERS,
+    CL_EVENTS,
+    CL_EVENT_SETS,
+    CL_EVENT_LAYER_REFS,
+
+    CL_BLOCK_X,
+    CL_BLOCK_Y,
+    CL_BLOCK_W,
+    CL_BLOCK_H,
+    CL_BLOCK_ID,
+    CL_BLOCK_NPC_ID,
+    CL_BLOCK_LAYER,
+    CL_BLOCK_EVENT_DESTROY,
+    CL_BLOCK_EVENT_HIT,
+    CL_BLOCK_EVENT_EMPTY_LAYER,
+    CL_BLOCK_FLAGS,
+
+    CL_BGO_X,
+    CL_BGO_Y,
+    CL_BGO_ID,
+    CL_BGO_LAYER,
+    CL_BGO_Z_MODE,
+    CL_BGO_Z_OFFSET,
+    CL_BGO_SMBX64_SP,
+
+    CL_NPC_X,
+    CL_NPC_Y,
+    CL_NPC_ID,
+    CL_NPC_DIRECTION,
+    CL_NPC_CONTENTS,
+    CL_NPC_SPECIAL_DATA,
+    CL_NPC_GENERATOR_TYPE,
+    CL_NPC_GENERATOR_DIRECTION,
+    CL_NPC_GENERATOR_PERIOD,
+    CL_NPC_MSG,
+    CL_NPC_LAYER,
+    CL_NPC_ATTACH_LAYER,
+    CL_NPC_EVENT_ACTIVATE,
+    CL_NPC_EVENT_DIE,
+    CL_NPC_EVENT_TALK,
+    CL_NPC_EVENT_EMPTY_LAYER,
+    CL_NPC_FLAGS,
+
+    CL_DOOR_IX,
+    CL_DOOR_IY,
+    CL_DOOR_OX,
+    CL_DOOR_OY,
+    CL_DOOR_IDIRECT,
+    CL_DOOR_ODIRECT,
+    CL_DOOR_TYPE,
+    CL_DOOR_LEVEL_NAME,
+    CL_DOOR_WARP_TO,
+    CL_DOOR_WORLD_X,
+    CL_DOOR_WORLD_Y,
+    CL_DOOR_STARS,
+    CL_DOOR_LAYER,
+    CL_DOOR_EVENT_ENTER,
+    CL_DOOR_FLAGS,
+
+    CL_PHYS_X,
+    CL_PHYS_Y,
+    CL_PHYS_W,
+    CL_PHYS_H,
+    CL_PHYS_ENV_TYPE,
+    CL_PHYS_FRICTION,
+    CL_PHYS_ACCEL_DIRECTION,
+    CL_PHYS_ACCEL,
+    CL_PHYS_MAX_VELOCITY,
+    CL_PHYS_LAYER,
+    CL_PHYS_TOUCH_EVENT,
+
+    CL_CHUNKS_COUNT
+};
+
+enum CompiledLevelInfo
+{
+    CL_INFO_LEVEL_NAME = 0,
+    CL_INFO_STARS,
+    CL_INFO_FAIL_LEVEL,
+    CL_INFO_FAIL_WARP,
+    CL_INFO_COUNT
+};
+
+struct CompiledLevelChunkEntry
+{
+    uint32_t offset;
+    uint32_t size;
+};
+
+struct CompiledLevelHeader
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t chunksCount;
+    uint32_t totalSize;
+    CompiledLevelChunkEntry chunks[CL_CHUNKS_COUNT];
+};
+
+static const char     s_clMagic[8] = {'P', 'G', 'E', 'L', 'V', 'L', 'C', '\0'};
+static const uint32_t s_clByteOrder = 0x01020304;
+
+
+/*****************Builder***************************/
+
+class CompiledLevelBuilder
+{
+public:
+    explicit CompiledLevelBuilder(const LevelData &src) : m_src(src)
+    {
+        std::memset(&m_header, 0, sizeof(m_header));
+        // Index 0 is always an empty string
+        m_strings.push_back(0);
+        m_strings.push_back(1);
+        m_stringData.push_back('\0');
+
+        for(pge_size_t i = 0; i < m_src.layers.size(); i++)
+        {
+            if(m_layerIndex.find(m_src.layers[i].name) == m_layerIndex.end())
+                m_layerIndex[m_src.layers[i].name] = static_cast<int32_t>(i);
+        }
+
+        for(pge_size_t i = 0; i < m_src.events.size(); i++)
+        {
+            if(m_eventIndex.find(m_src.events[i].name) == m_eventIndex.end())
+                m_eventIndex[m_src.events[i].name] = static_cast<int32_t>(i);
+        }
+    }
+
+    bool overflow() const
+    {
+        return m_overflow;
+    }
+
+    int32_t i32(long long v)
+    {
+        if(v < INT32_MIN || v > INT32_MAX)
+        {
+            m_overflow = true;
+            return 0;
+        }
+        return static_cast<int32_t>(v);
+    }
+
+    uint32_t u32(unsigned long long v)
+    {
+        if(v > UINT32_MAX)
+        {
+            m_overflow = true;
+            return 0;
+        }
+        return static_cast<uint32_t>(v);
+    }
+
+    int32_t layer(const PGESTRING &name) const
+    {
+        auto it = m_layerIndex.find(name);
+        return (it == m_layerIndex.end()) ? static_cast<int32_t>(CompiledLevel::NONE) : PGEMAPVAL(it);
+    }
+
+    int32_t event(const PGESTRING &name) const
+    {
+        if(IsEmpty(name))
+            return CompiledLevel::NONE;
+        auto it = m_eventIndex.find(name);
+        return (it == m_eventIndex.end()) ? static_cast<int32_t>(CompiledLevel::NONE) : PGEMAPVAL(it);
+    }
+
+    uint32_t str(const PGESTRING &s)
+    {
+        if(IsEmpty(s))
+            return 0;
+
+        auto it = m_stringIndex.find(s);
+        if(it != m_stringIndex.end())
+            return PGEMAPVAL(it);
+
+        uint32_t index = static_cast<uint32_t>(m_strings.size() - 1);
+#ifdef PGE_FILES_QT
+        QByteArray u = s.toUtf8();
+        m_stringData.append(u.constData(), static_cast<size_t>(u.size()));
+#else
+        m_stringData.append(s);
+#endif
+        m_stringData.push_back('\0');
+        m_strings.push_back(u32(m_stringData.size()));
+        m_stringIndex[s] = index;
+        return index;
+    }
+
+    template<class T>
+    void chunk(CompiledLevelChunk id, const std::vector<T> &data)
+    {
+        chunk(id, data.data(), data.size() * sizeof(T));
+    }
+
+    void chunk(CompiledLevelChunk id, const void *data, size_t size)
+    {
+        while(m_body.size() % 8 != 0)
+            m_body.push_back('\0');
+        m_header.chunks[id].offset = u32(sizeof(CompiledLevelHeader) + m_body.size());
+        m_header.chunks[id].size = u32(size);
+        if(size > 0)
+            m_body.append(reinterpret_cast<const char *>(data), size);
+    }
+
+    void finish(std::string &out)
+    {
+        // Strings are collected during the build, therefore are stored last
+        chunk(CL_STRING_OFFSETS, m_strings);
+        chunk(CL_STRING_DATA, m_stringData.data(), m_stringData.size());
+
+        std::memcpy(m_header.magic, s_clMagic, sizeof(s_clMagic));
+        m_header.version = CompiledLevel::VERSION;
+        m_header.byteOrder = s_clByteOrder;
+        m_header.chunksCount = CL_CHUNKS_COUNT;
+        m_header.totalSize = u32(sizeof(CompiledLevelHeader) + m_body.size());
+
+        out.clear();
+        out.reserve(sizeof(CompiledLevelHeader) + m_body.size());
+        out.append(reinterpret_cast<const char *>(&m_header), sizeof(CompiledLevelHeader));
+        out.append(m_body);
+    }
+
+private:
+    const LevelData &m_src;
+    CompiledLevelHeader m_header;
+    std::string m_body;
+    bool m_overflow = false;
+
+    std::vector<uint32_t> m_strings;
+    std::string m_stringData;
+    PGEHASH<PGESTRING, uint32_t> m_stringIndex;
+    PGEHASH<PGESTRING, int32_t> m_layerIndex;
+    PGEHASH<PGESTRING, int32_t> m_eventIndex;
+};
+
+static void compiledLevelBuildHead(CompiledLevelBuilder &b, const LevelData &src)
+{
+    std::vector<uint32_t> info(CL_INFO_COUNT);
+    info[CL_INFO_LEVEL_NAME] = b.str(src.LevelName);
+    info[CL_INFO_STARS] = static_cast<uint32_t>(b.i32(src.stars));
+    info[CL_INFO_FAIL_LEVEL] = b.str(src.open_level_on_fail);
+    info[CL_INFO_FAIL_WARP] = src.open_level_on_fail_warpID;
+    b.chunk(CL_INFO, info);
+
+    std::vector<CompiledLevelSection> sections;
+    sections.reserve(src.sections.size());
+    for(const LevelSection &s : src.sections)
+    {
+        CompiledLevelSection o;
+        o.id = b.i32(s.id);
+        o.left = b.i32(s.size_left);
+        o.top = b.i32(s.size_top);
+        o.right = b.i32(s.size_right);
+        o.bottom = b.i32(s.size_bottom);
+        o.musicId = s.music_id;
+        o.musicFile = b.str(s.music_file);
+        o.background = s.background;
+        o.lightingValue = s.lighting_value;
+        o.flags = (s.wrap_h ? CompiledLevelSection::WRAP_H : 0) |
+                  (s.wrap_v ? CompiledLevelSection::WRAP_V : 0) |
+                  (s.OffScreenEn ? CompiledLevelSection::OFFSCREEN_EXIT : 0) |
+                  (s.underwater ? CompiledLevelSection::UNDERWATER : 0) |
+                  (s.lock_left_scroll ? CompiledLevelSection::LOCK_LEFT_SCROLL : 0) |
+                  (s.lock_right_scroll ? CompiledLevelSection::LOCK_RIGHT_SCROLL : 0) |
+                  (s.lock_up_scroll ? CompiledLevelSection::LOCK_UP_SCROLL : 0) |
+                  (s.lock_down_scroll ? CompiledLevelSection::LOCK_DOWN_SCROLL : 0);
+        sections.push_back(o);
+    }
+    b.chunk(CL_SECTIONS, sections);
+
+    std::vector<CompiledLevelPlayer> players;
+    players.reserve(src.players.size());
+    for(const PlayerPoint &p : src.players)
+    {
+        CompiledLevelPlayer o;
+        o.id = p.id;
+        o.x = b.i32(p.x);
+        o.y = b.i32(p.y);
+        o.w = b.i32(p.w);
+        o.h = b.i32(p.h);
+        o.direction = p.direction;
+        players.push_back(o);
+    }
+    b.chunk(CL_PLAYERS, players);
+
+    std::vector<CompiledLevelLayer> layers;
+    layers.reserve(src.layers.size());
+    for(const LevelLayer &l : src.layers)
+    {
+        CompiledLevelLayer o;
+        o.name = b.str(l.name);
+        o.flags = l.hidden ? CompiledLevelLayer::HIDDEN : 0;
+        layers.push_back(o);
+    }
+    b.chunk(CL_LAYERS, layers);
+}
+
+static void compiledLevelBuildEvents(CompiledLevelBuilder &b, const LevelData &src)
+{
+    std::vector<CompiledLevelEvent> events;
+    std::vector<CompiledLevelEventSet> sets;
+    std::vector<int32_t> layerRefs;
+    events.reserve(src.events.size());
+
+    auto addRefs = [&](const PGESTRINGList &names, uint32_t &begin, uint32_t &count)
+    {
+        begin = static_cast<uint32_t>(layerRefs.size());
+        for(const PGESTRING &n : names)
+            layerRefs.push_back(b.layer(n));
+        count = static_cast<uint32_t>(layerRefs.size()) - begin;
+    };
+
+    for(const LevelSMBX64Event &e : src.events)
+    {
+        CompiledLevelEvent o;
+        o.name = b.str(e.name);
+        o.msg = b.str(e.msg);
+        o.soundId = b.i32(e.sound_id);
+        o.endGame = b.i32(e.end_game);
+        o.trigger = b.event(e.trigger);
+        o.triggerTimer = b.i32(e.trigger_timer);
+        o.autostart = e.autostart;
+        o.moveLayer = IsEmpty(e.movelayer) ? static_cast<int32_t>(CompiledLevel::NONE) : b.layer(e.movelayer);
+        o.layerSpeedX = static_cast<float>(e.layer_speed_x);
+        o.layerSpeedY = static_cast<float>(e.layer_speed_y);
+        o.scrollSection = b.i32(e.scroll_section);
+        o.flags = e.nosmoke ? CompiledLevelEvent::NO_SMOKE : 0;
+        addRefs(e.layers_hide, o.layersHideBegin, o.layersHideCount);
+        addRefs(e.layers_show, o.layersShowBegin, o.layersShowCount);
+        addRefs(e.layers_toggle, o.layersToggleBegin, o.layersToggleCount);
+
+        o.setsBegin = static_cast<uint32_t>(sets.size());
+        for(const LevelEvent_Sets &s : e.sets)
+        {
+            CompiledLevelEventSet so;
+            so.id = b.i32(s.id);
+            so.musicId = b.i32(s.music_id);
+            so.musicFile = b.str(s.music_file);
+            so.backgroundId = b.i32(s.background_id);
+            so.left = b.i32(s.position_left);
+            so.top = b.i32(s.position_top);
+            so.right = b.i32(s.position_right);
+            so.bottom = b.i32(s.position_bottom);
+            so.autoscrollX = s.autoscrol_x;
+            so.autoscrollY = s.autoscrol_y;
+            so.flags = s.autoscrol ? CompiledLevelEventSet::AUTOSCROLL : 0;
+            sets.push_back(so);
+        }
+        o.setsCount = static_cast<uint32_t>(sets.size()) - o.setsBegin;
+        events.push_back(o);
+    }
+
+    b.chunk(CL_EVENTS, events);
+    b.chunk(CL_EVENT_SETS, sets);
+    b.chunk(CL_EVENT_LAYER_REFS, layerRefs);
+}
+
+static void compiledLevelBuildBlocks(CompiledLevelBuilder &b, const LevelData &src)
+{
+    const size_t n = src.blocks.size();
+    std::vector<int32_t> x(n), y(n), w(n), h(n), npcId(n), layer(n), evDestroy(n), evHit(n), evEmpty(n);
+    std::vector<uint32_t> id(n);
+    std::vector<uint8_t> flags(n);
+
+    for(size_t i = 0; i < n; i++)
+    {
+        const LevelBlock &o = src.blocks[static_cast<pge_size_t>(i)];
+        x[i] = b.i32(o.x);
+        y[i] = b.i32(o.y);
+        w[i] = b.i32(o.w);
+        h[i] = b.i32(o.h);
+        id[i] = b.u32(o.id);
+        npcId[i] = b.i32(o.npc_id);
+        layer[i] = b.layer(o.layer);
+        evDestroy[i] = b.event(o.event_destroy);
+        evHit[i] = b.event(o.event_hit);
+        evEmpty[i] = b.event(o.event_emptylayer);
+        flags[i] = static_cast<uint8_t>((o.invisible ? CompiledLevelBlocks::INVISIBLE : 0) |
+                                        (o.slippery ? CompiledLevelBlocks::SLIPPERY : 0) |
+                                        (o.autoscale ? CompiledLevelBlocks::AUTOSCALE : 0));
+    }
+
+    b.chunk(CL_BLOCK_X, x);
+    b.chunk(CL_BLOCK_Y, y);
+    b.chunk(CL_BLOCK_W, w);
+    b.chunk(CL_BLOCK_H, h);
+    b.chunk(CL_BLOCK_ID, id);
+    b.chunk(CL_BLOCK_NPC_ID, npcId);
+    b.chunk(CL_BLOCK_LAYER, layer);
+    b.chunk(CL_BLOCK_EVENT_DESTROY, evDestroy);
+    b.chunk(CL_BLOCK_EVENT_HIT, evHit);
+    b.chunk(CL_BLOCK_EVENT_EMPTY_LAYER, evEmpty);
+    b.chunk(CL_BLOCK_FLAGS, flags);
+}
+
+static void compiledLevelBuildBGOs(CompiledLevelBuilder &b, const LevelData &src)
+{
+    const size_t n = src.bgo.size();
+    std::vector<int32_t> x(n), y(n), layer(n), zMode(n), sp(n);
+    std::vector<uint32_t> id(n);
+    std::vector<float> zOffset(n);
+
+    for(size_t i = 0; i < n; i++)
+    {
+        const LevelBGO &o = src.bgo[static_cast<pge_size_t>(i)];
+        x[i] = b.i32(o.x);
+        y[i] = b.i32(o.y);
+        id[i] = b.u32(o.id);
+        layer[i] = b.layer(o.layer);
+        zMode[i] = o.z_mode;
+        zOffset[i] = static_cast<float>(o.z_offset);
+        sp[i] = b.i32(o.smbx64_sp);
+    }
+
+    b.chunk(CL_BGO_X, x);
+    b.chunk(CL_BGO_Y, y);
+    b.chunk(CL_BGO_ID, id);
+    b.chunk(CL_BGO_LAYER, layer);
+    b.chunk(CL_BGO_Z_MODE, zMode);
+    b.chunk(CL_BGO_Z_OFFSET, zOffset);
+    b.chunk(CL_BGO_SMBX64_SP, sp);
+}
+
+static void compiledLevelBuildNPCs(CompiledLevelBuilder &b, const LevelData &src)
+{
+    const size_t n = src.npc.size();
+    std::vector<int32_t> x(n), y(n), dir(n), contents(n), special(n), genType(n), genDir(n), genPeriod(n);
+    std::vector<int32_t> layer(n), attach(n), evActivate(n), evDie(n), evTalk(n), evEmpty(n);
+    std::vector<uint32_t> id(n), msg(n);
+    std::vector<uint8_t> flags(n);
+
+    for(size_t i = 0; i < n; i++)
+    {
+        const LevelNPC &o = src.npc[static_cast<pge_size_t>(i)];
+        x[i] = b.i32(o.x);
+        y[i] = b.i32(o.y);
+        id[i] = b.u32(o.id);
+        dir[i] = o.direct;
+        contents[i] = b.i32(o.contents);
+        special[i] = b.i32(o.special_data);
+        genType[i] = o.generator_type;
+        genDir[i] = o.generator_direct;
+        genPeriod[i] = o.generator_period;
+        msg[i] = b.str(o.msg);
+        layer[i] = b.layer(o.layer);
+        attach[i] = IsEmpty(o.attach_layer) ? static_cast<int32_t>(CompiledLevel::NONE) : b.layer(o.attach_layer);
+        evActivate[i] = b.event(o.event_activate);
+        evDie[i] = b.event(o.event_die);
+        evTalk[i] = b.event(o.event_talk);
+        evEmpty[i] = b.event(o.event_emptylayer);
+        flags[i] = static_cast<uint8_t>((o.friendly ? CompiledLevelNPCs::FRIENDLY : 0) |
+                                        (o.nomove ? CompiledLevelNPCs::NO_MOVE : 0) |
+                                        (o.is_boss ? CompiledLevelNPCs::BOSS : 0) |
+                                        (o.generator ? CompiledLevelNPCs::GENERATOR : 0) |
+                                        (o.is_star ? CompiledLevelNPCs::STAR : 0));
+    }
+
+    b.chunk(CL_NPC_X, x);
+    b.chunk(CL_NPC_Y, y);
+    b.chunk(CL_NPC_ID, id);
+    b.chunk(CL_NPC_DIRECTION, dir);
+    b.chunk(CL_NPC_CONTENTS, contents);
+    b.chunk(CL_NPC_SPECIAL_DATA, special);
+    b.chunk(CL_NPC_GENERATOR_TYPE, genType);
+    b.chunk(CL_NPC_GENERATOR_DIRECTION, genDir);
+    b.chunk(CL_NPC_GENERATOR_PERIOD, genPeriod);
+    b.chunk(CL_NPC_MSG, msg);
+    b.chunk(CL_NPC_LAYER, layer);
+    b.chunk(CL_NPC_ATTACH_LAYER, attach);
+    b.chunk(CL_NPC_EVENT_ACTIVATE, evActivate);
+    b.chunk(CL_NPC_EVENT_DIE, evDie);
+    b.chunk(CL_NPC_EVENT_TALK, evTalk);
+    b.chunk(CL_NPC_EVENT_EMPTY_LAYER, evEmpty);
+    b.chunk(CL_NPC_FLAGS, flags);
+}
+
+static void compiledLevelBuildDoors(CompiledLevelBuilder &b, const LevelData &src)
+{
+    const size_t n = src.doors.size();
+    std::vector<int32_t> ix(n), iy(n), ox(n), oy(n), idir(n), odir(n), type(n), warpTo(n);
+    std::vector<int32_t> worldX(n), worldY(n), stars(n), layer(n), evEnter(n);
+    std::vector<uint32_t> lname(n);
+    std::vector<uint16_t> flags(n);
+
+    for(size_t i = 0; i < n; i++)
+    {
+        const LevelDoor &o = src.doors[static_cast<pge_size_t>(i)];
+        ix[i] = b.i32(o.ix);
+        iy[i] = b.i32(o.iy);
+        ox[i] = b.i32(o.ox);
+        oy[i] = b.i32(o.oy);
+        idir[i] = o.idirect;
+        odir[i] = o.odirect;
+        type[i] = o.type;
+        lname[i] = b.str(o.lname);
+        warpTo[i] = b.i32(o.warpto);
+        worldX[i] = b.i32(o.world_x);
+        worldY[i] = b.i32(o.world_y);
+        stars[i] = o.stars;
+        layer[i] = b.layer(o.layer);
+        evEnter[i] = b.event(o.event_enter);
+        flags[i] = static_cast<uint16_t>((o.isSetIn ? CompiledLevelDoors::SET_IN : 0) |
+                                         (o.isSetOut ? CompiledLevelDoors::SET_OUT : 0) |
+                                         (o.lvl_i ? CompiledLevelDoors::LEVEL_ENTRANCE : 0) |
+                                         (o.lvl_o ? CompiledLevelDoors::LEVEL_EXIT : 0) |
+                                         (o.novehicles ? CompiledLevelDoors::NO_VEHICLES : 0) |
+                                         (o.allownpc ? CompiledLevelDoors::ALLOW_NPC : 0) |
+                                         (o.locked ? CompiledLevelDoors::LOCKED : 0) |
+                                         (o.need_a_bomb ? CompiledLevelDoors::NEED_A_BOMB : 0) |
+                                         (o.two_way ? CompiledLevelDoors::TWO_WAY : 0) |
+                                         (o.allownpc_interlevel ? CompiledLevelDoors::ALLOW_NPC_INTERLEVEL : 0) |
+                                         (o.hide_entering_scene ? CompiledLevelDoors::HIDE_ENTERING_SCENE : 0));
+    }
+
+    b.chunk(CL_DOOR_IX, ix);
+    b.chunk(CL_DOOR_IY, iy);
+    b.chunk(CL_DOOR_OX, ox);
+    b.chunk(CL_DOOR_OY, oy);
+    b.chunk(CL_DOOR_IDIRECT, idir);
+    b.chunk(CL_DOOR_ODIRECT, odir);
+    b.chunk(CL_DOOR_TYPE, type);
+    b.chunk(CL_DOOR_LEVEL_NAME, lname);
+    b.chunk(CL_DOOR_WARP_TO, warpTo);
+    b.chunk(CL_DOOR_WORLD_X, worldX);
+    b.chunk(CL_DOOR_WORLD_Y, worldY);
+    b.chunk(CL_DOOR_STARS, stars);
+    b.chunk(CL_DOOR_LAYER, layer);
+    b.chunk(CL_DOOR_EVENT_ENTER, evEnter);
+    b.chunk(CL_DOOR_FLAGS, flags);
+}
+
+static void compiledLevelBuildPhysEnvs(CompiledLevelBuilder &b, const LevelData &src)
+{
+    const size_t n = src.physez.size();
+    std::vector<int32_t> x(n), y(n), w(n), h(n), envType(n), layer(n), touchEvent(n);
+    std::vector<float> friction(n), accelDir(n), accel(n), maxVel(n);
+
+    for(size_t i = 0; i < n; i++)
+    {
+        const LevelPhysEnv &o = src.physez[static_cast<pge_size_t>(i)];
+        x[i] = b.i32(o.x);
+        y[i] = b.i32(o.y);
+        w[i] = b.i32(o.w);
+        h[i] = b.i32(o.h);
+        envType[i] = o.env_type;
+        friction[i] = static_cast<float>(o.friction);
+        accelDir[i] = static_cast<float>(o.accel_direct);
+        accel[i] = static_cast<float>(o.accel);
+        maxVel[i] = static_cast<float>(o.max_velocity);
+        layer[i] = b.layer(o.layer);
+        touchEvent[i] = b.event(o.touch_event);
+    }
+
+    b.chunk(CL_PHYS_X, x);
+    b.chunk(CL_PHYS_Y, y);
+    b.chunk(CL_PHYS_W, w);
+    b.chunk(CL_PHYS_H, h);
+    b.chunk(CL_PHYS_ENV_TYPE, envType);
+    b.chunk(CL_PHYS_FRICTION, friction);
+    b.chunk(CL_PHYS_ACCEL_DIRECTION, accelDir);
+    b.chunk(CL_PHYS_ACCEL, accel);
+    b.chunk(CL_PHYS_MAX_VELOCITY, maxVel);
+    b.chunk(CL_PHYS_LAYER, layer);
+    b.chunk(CL_PHYS_TOUCH_EVENT, touchEvent);
+}
+
+bool CompiledLevel::build(const LevelData &src, std::string &out, PGESTRING *errorString)
+{
+    CompiledLevelBuilder b(src);
+
+    compiledLevelBuildHead(b, src);
+    compiledLevelBuildEvents(b, src);
+    compiledLevelBuildBlocks(b, src);
+    compiledLevelBuildBGOs(b, src);
+    compiledLevelBuildNPCs(b, src);
+    compiledLevelBuildDoors(b, src);
+    compiledLevelBuildPhysEnvs(b, src);
+
+    if(b.overflow())
+    {
+        out.clear();
+        if(errorString)
+            *errorString = "Level contains values out of the 32-bit range";
+        return false;
+    }
+
+    b.finish(out);
+    return true;
+}
+
+bool CompiledLevel::buildFile(const LevelData &src, const PGESTRING &filePath, PGESTRING *errorString)
+{
+    std::string image;
+    if(!build(src, image, errorString))
+        return false;
+
+    if(!PGE_FileFormats_misc::writeBinaryFile(filePath, image))
+    {
+        if(errorString)
+            *errorString = "Failed to write the compiled level file";
+        return false;
+    }
+
+    return true;
+}
+
+
+/*****************View***************************/
+
+const char *CompiledLevelView::string(uint32_t index) const
+{
+    if(!m_valid || index >= m_stringsCount)
+        return "";
+    return m_stringData + m_stringOffsets[index];
+}
+
+uint32_t CompiledLevelView::levelName() const
+{
+    return m_info ? m_info[CL_INFO_LEVEL_NAME] : 0;
+}
+
+int32_t CompiledLevelView::stars() const
+{
+    return m_info ? static_cast<int32_t>(m_info[CL_INFO_STARS]) : 0;
+}
+
+uint32_t CompiledLevelView::openLevelOnFail() const
+{
+    return m_info ? m_info[CL_INFO_FAIL_LEVEL] : 0;
+}
+
+uint32_t CompiledLevelView::openLevelOnFailWarpId() const
+{
+    return m_info ? m_info[CL_INFO_FAIL_WARP] : 0;
+}
+
+/*
+ * Resolves typed column pointers of the image and checks that every column
+ * of one collection has the same number of elements.
+ */
+class CompiledLevelResolver
+{
+public:
+    CompiledLevelResolver(const char *base, const CompiledLevelHeader *header) :
+        m_base(base), m_header(header)
+    {}
+
+    template<class T>
+    bool array(CompiledLevelChunk id, const T *&ptr, uint32_t &count)
+    {
+        const CompiledLevelChunkEntry &c = m_header->chunks[id];
+        if(c.size % sizeof(T) != 0)
+            return false;
+        count = static_cast<uint32_t>(c.size / sizeof(T));
+        ptr = reinterpret_cast<const T *>(m_base + c.offset);
+        return true;
+    }
+
+    template<class T>
+    bool column(CompiledLevelChunk id, const T *&ptr, uint32_t count)
+    {
+        uint32_t got = 0;
+        return array(id, ptr, got) && (got == count);
+    }
+
+private:
+    const char *m_base;
+    const CompiledLevelHeader *m_header;
+};
+
+bool CompiledLevelView::open(const void *data, size_t size)
+{
+    *this = CompiledLevelView();
+    m_base = reinterpret_cast<const char *>(data);
+
+    if(!data || size < sizeof(CompiledLevelHeader))
+    {
+        m_error = "Image is too small";
+        return false;
+    }
+
+    if(reinterpret_cast<uintptr_t>(data) % 8 != 0)
+    {
+        m_error = "Image is not aligned";
+        return false;
+    }
+
+    const CompiledLevelHeader *h = reinterpret_cast<const CompiledLevelHeader *>(data);
+    if(std::memcmp(h->magic, s_clMagic, sizeof(s_clMagic)) != 0)
+    {
+        m_error = "Not a compiled level";
+        return false;
+    }
+
+    if(h->byteOrder != s_clByteOrder)
+    {
+        m_error = "Compiled level has a different byte order";
+        return false;
+    }
+
+    if(h->version != static_cast<uint32_t>(CompiledLevel::VERSION))
+    {
+        m_error = "Unsupported version of the compiled level";
+        return false;
+    }
+
+    if(h->chunksCount != CL_CHUNKS_COUNT || h->totalSize != size)
+    {
+        m_error = "Compiled level is damaged";
+        return false;
+    }
+
+    for(uint32_t i = 0; i < CL_CHUNKS_COUNT; i++)
+    {
+        const CompiledLevelChunkEntry &c = h->chunks[i];
+        if(c.offset % 8 != 0 || c.offset < sizeof(CompiledLevelHeader) ||
+           c.offset > size || c.size > size - c.offset)
+        {
+            m_error = "Compiled level is damaged";
+            return false;
+        }
+    }
+
+    CompiledLevelResolver r(m_base, h);
+    bool ok = true;
+    uint32_t infoCount = 0;
+
+    // String table: offsets of each string, plus the end offset
+    ok &= r.array(CL_STRING_OFFSETS, m_stringOffsets, m_stringsCount);
+    ok &= r.array(CL_STRING_DATA, m_stringData, m_stringDataSize);
+    if(ok)
+    {
+        ok &= (m_stringsCount >= 1) && (m_stringDataSize >= 1);
+        ok = ok && (m_stringOffsets[m_stringsCount - 1] == m_stringDataSize);
+        ok = ok && (m_stringData[m_stringDataSize - 1] == '\0');
+        for(uint32_t i = 0; ok && i + 1 < m_stringsCount; i++)
+            ok &= (m_stringOffsets[i] < m_stringOffsets[i + 1]);
+        m_stringsCount -= 1;
+    }
+
+    ok &= r.array(CL_INFO, m_info, infoCount) && (infoCount == CL_INFO_COUNT);
+    ok &= r.array(CL_SECTIONS, m_sections, m_sectionsCount);
+    ok &= r.array(CL_PLAYERS, m_players, m_playersCount);
+    ok &= r.array(CL_LAYERS, m_layers, m_layersCount);
+    ok &= r.array(CL_EVENTS, m_events, m_eventsCount);
+    ok &= r.array(CL_EVENT_SETS, m_eventSets, m_eventSetsCount);
+    ok &= r.array(CL_EVENT_LAYER_REFS, m_eventLayerRefs, m_eventLayerRefsCount);
+
+    for(uint32_t i = 0; ok && i < m_eventsCount; i++)
+    {
+        const CompiledLevelEvent &e = m_events[i];
+        ok &= (static_cast<uint64_t>(e.layersHideBegin) + e.layersHideCount <= m_eventLayerRefsCount);
+        ok &= (static_cast<uint64_t>(e.layersShowBegin) + e.layersShowCount <= m_eventLayerRefsCount);
+        ok &= (static_cast<uint64_t>(e.layersToggleBegin) + e.layersToggleCount <= m_eventLayerRefsCount);
+        ok &= (static_cast<uint64_t>(e.setsBegin) + e.setsCount <= m_eventSetsCount);
+    }
+
+    CompiledLevelBlocks &bl = m_blocks;
+    ok &= r.array(CL_BLOCK_X, bl.x, bl.count);
+    ok &= r.column(CL_BLOCK_Y, bl.y, bl.count);
+    ok &= r.column(CL_BLOCK_W, bl.w, bl.count);
+    ok &= r.column(CL_BLOCK_H, bl.h, bl.count);
+    ok &= r.column(CL_BLOCK_ID, bl.id, bl.count);
+    ok &= r.column(CL_BLOCK_NPC_ID, bl.npcId, bl.count);
+    ok &= r.column(CL_BLOCK_LAYER, bl.layer, bl.count);
+    ok &= r.column(CL_BLOCK_EVENT_DESTROY, bl.eventDestroy, bl.count);
+    ok &= r.column(CL_BLOCK_EVENT_HIT, bl.eventHit, bl.count);
+    ok &= r.column(CL_BLOCK_EVENT_EMPTY_LAYER, bl.eventEmptyLayer, bl.count);
+    ok &= r.column(CL_BLOCK_FLAGS, bl.flags, bl.count);
+
+    CompiledLevelBGOs &bg = m_bgo;
+    ok &= r.array(CL_BGO_X, bg.x, bg.count);
+    ok &= r.column(CL_BGO_Y, bg.y, bg.count);
+    ok &= r.column(CL_BGO_ID, bg.id, bg.count);
+    ok &= r.column(CL_BGO_LAYER, bg.layer, bg.count);
+    ok &= r.column(CL_BGO_Z_MODE, bg.zMode, bg.count);
+    ok &= r.column(CL_BGO_Z_OFFSET, bg.zOffset, bg.count);
+    ok &= r.column(CL_BGO_SMBX64_SP, bg.smbx64Sp, bg.count);
+
+    CompiledLevelNPCs &np = m_npc;
+    ok &= r.array(CL_NPC_X, np.x, np.count);
+    ok &= r.column(CL_NPC_Y, np.y, np.count);
+    ok &= r.column(CL_NPC_ID, np.id, np.count);
+    ok &= r.column(CL_NPC_DIRECTION, np.direction, np.count);
+    ok &= r.column(CL_NPC_CONTENTS, np.contents, np.count);
+    ok &= r.column(CL_NPC_SPECIAL_DATA, np.specialData, np.count);
+    ok &= r.column(CL_NPC_GENERATOR_TYPE, np.generatorType, np.count);
+    ok &= r.column(CL_NPC_GENERATOR_DIRECTION, np.generatorDirection, np.count);
+    ok &= r.column(CL_NPC_GENERATOR_PERIOD, np.generatorPeriod, np.count);
+    ok &= r.column(CL_NPC_MSG, np.msg, np.count);
+    ok &= r.column(CL_NPC_LAYER, np.layer, np.count);
+    ok &= r.column(CL_NPC_ATTACH_LAYER, np.attachLayer, np.count);
+    ok &= r.column(CL_NPC_EVENT_ACTIVATE, np.eventActivate, np.count);
+    ok &= r.column(CL_NPC_EVENT_DIE, np.eventDie, np.count);
+    ok &= r.column(CL_NPC_EVENT_TALK, np.eventTalk, np.count);
+    ok &= r.column(CL_NPC_EVENT_EMPTY_LAYER, np.eventEmptyLayer, np.count);
+    ok &= r.column(CL_NPC_FLAGS, np.flags, np.count);
+
+    CompiledLevelDoors &dr = m_doors;
+    ok &= r.array(CL_DOOR_IX, dr.ix, dr.count);
+    ok &= r.column(CL_DOOR_IY, dr.iy, dr.count);
+    ok &= r.column(CL_DOOR_OX, dr.ox, dr.count);
+    ok &= r.column(CL_DOOR_OY, dr.oy, dr.count);
+    ok &= r.column(CL_DOOR_IDIRECT, dr.idirect, dr.count);
+    ok &= r.column(CL_DOOR_ODIRECT, dr.odirect, dr.count);
+    ok &= r.column(CL_DOOR_TYPE, dr.type, dr.count);
+    ok &= r.column(CL_DOOR_LEVEL_NAME, dr.levelName, dr.count);
+    ok &= r.column(CL_DOOR_WARP_TO, dr.warpTo, dr.count);
+    ok &= r.column(CL_DOOR_WORLD_X, dr.worldX, dr.count);
+    ok &= r.column(CL_DOOR_WORLD_Y, dr.worldY, dr.count);
+    ok &= r.column(CL_DOOR_STARS, dr.stars, dr.count);
+    ok &= r.column(CL_DOOR_LAYER, dr.layer, dr.count);
+    ok &= r.column(CL_DOOR_EVENT_ENTER, dr.eventEnter, dr.count);
+    ok &= r.column(CL_DOOR_FLAGS, dr.flags, dr.count);
+
+    CompiledLevelPhysEnvs &ph = m_physez;
+    ok &= r.array(CL_PHYS_X, ph.x, ph.count);
+    ok &= r.column(CL_PHYS_Y, ph.y, ph.count);
+    ok &= r.column(CL_PHYS_W, ph.w, ph.count);
+    ok &= r.column(CL_PHYS_H, ph.h, ph.count);
+    ok &= r.column(CL_PHYS_ENV_TYPE, ph.envType, ph.count);
+    ok &= r.column(CL_PHYS_FRICTION, ph.friction, ph.count);
+    ok &= r.column(CL_PHYS_ACCEL_DIRECTION, ph.accelDirection, ph.count);
+    ok &= r.column(CL_PHYS_ACCEL, ph.accel, ph.count);
+    ok &= r.column(CL_PHYS_MAX_VELOCITY, ph.maxVelocity, ph.count);
+    ok &= r.column(CL_PHYS_LAYER, ph.layer, ph.count);
+    ok &= r.column(CL_PHYS_TOUCH_EVENT, ph.touchEvent, ph.count);
+
+    if(!ok)
+    {
+        *this = CompiledLevelView();
+        m_error = "Compiled level is damaged";
+        return false;
+    }
+
+    m_valid = true;
+    m_error = "";
+    return true;
+}
+
+
+/*****************Mapped file***************************/
+
+#ifdef _WIN32
+struct CompiledLevelWinMapping
+{
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+};
+#endif
+
+CompiledLevelFile::~CompiledLevelFile()
+{
+    close();
+}
+
+bool CompiledLevelFile::open(const PGESTRING &filePath)
+{
+    close();
+
+#if defined(PGE_FILES_QT)
+    QFile *f = new QFile(filePath);
+    if(f->open(QIODevice::ReadOnly) && f->size() > 0)
+    {
+        uchar *p = f->map(0, f->size());
+        if(p)
+        {
+            m_mapping = f;
+            m_data = p;
+            m_size = static_cast<size_t>(f->size());
+        }
+    }
+    if(!m_mapping)
+        delete f;
+#elif defined(_WIN32)
+    int len = MultiByteToWideChar(CP_UTF8, 0, filePath.c_str(), static_cast<int>(filePath.size()), nullptr, 0);
+    std::wstring pathW(static_cast<size_t>(len), L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, filePath.c_str(), static_cast<int>(filePath.size()), &pathW[0], len);
+
+    CompiledLevelWinMapping *w = new CompiledLevelWinMapping;
+    w->file = CreateFileW(pathW.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER fileSize;
+    if(w->file != INVALID_HANDLE_VALUE && GetFileSizeEx(w->file, &fileSize) && fileSize.QuadPart > 0)
+    {
+        w->mapping = CreateFileMappingW(w->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if(w->mapping)
+        {
+            m_data = MapViewOfFile(w->mapping, FILE_MAP_READ, 0, 0, 0);
+            m_size = static_cast<size_t>(fileSize.QuadPart);
+        }
+    }
+    if(m_data)
+        m_mapping = w;
+    else
+    {
+        if(w->mapping)
+            CloseHandle(w->mapping);
+        if(w->file != INVALID_HANDLE_VALUE)
+            CloseHandle(w->file);
+        delete w;
+    }
+#elif defined(COMPILED_LEVEL_USE_MMAP)
+    int fd = ::open(filePath.c_str(), O_RDONLY);
+    if(fd >= 0)
+    {
+        struct stat st;
+        if(fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            void *p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if(p != MAP_FAILED)
+            {
+                m_data = p;
+                m_size = static_cast<size_t>(st.st_size);
+                m_mapping = p;
+            }
+        }
+        ::close(fd);
+    }
+#endif
+
+    if(!m_data)
+    {
+        // No memory mapping on this platform, or it has failed
+        if(!PGE_FileFormats_misc::readBinaryFile(filePath, m_buffer))
+            return false;
+        m_data = m_buffer.data();
+        m_size = m_buffer.size();
+    }
+
+    if(!m_view.open(m_data, m_size))
+    {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void CompiledLevelFile::close()
+{
+    m_view = CompiledLevelView();
+
+    if(m_mapping)
+    {
+#if defined(PGE_FILES_QT)
+        QFile *f = reinterpret_cast<QFile *>(m_mapping);
+        f->unmap(reinterpret_cast<uchar *>(const_cast<void *>(m_data)));
+        delete f;
+#elif defined(_WIN32)
+        CompiledLevelWinMapping *w = reinterpret_cast<CompiledLevelWinMapping *>(m_mapping);
+        UnmapViewOfFile(m_data);
+        CloseHandle(w->mapping);
+        CloseHandle(w->file);
+        delete w;
+#elif defined(COMPILED_LEVEL_USE_MMAP)
+        munmap(m_mapping, m_size);
+#endif
+        m_mapping = nullptr;
+    }
+
+    m_buffer.clear();
+    m_data = nullptr;
+    m_size = 0;
+}
@@ -0,0 +1,488 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*!
+ * \file compiled_level.h
+ * \brief Contains the read-only flattened level representation for runtime engines
+ *
+ * A compiled level is a pointer-free binary image of the level data which
+ * can be used directly from memory (for example, from a memory-mapped file)
+ * without any parsing. Element collections are stored as struct-of-arrays,
+ * all strings are stored in one string table and referred by indices,
+ * layer and event names are resolved into indices of the layers and events
+ * arrays (-1 means "none").
+ *
+ * The compiled level keeps the runtime-relevant subset of the level data only:
+ * editor-specific meta-data, custom parameters, scripts and SMBX-38A extra
+ * configs are not presented here.
+ *
+ * The image uses the native byte order and gets rejected on the machine
+ * with a different byte order: it's a cache, not an interchange format.
+ */
+
+#pragma once
+#ifndef COMPILED_LEVEL_H
+#define COMPILED_LEVEL_H
+
+#include "pge_file_lib_globs.h"
+#include "lvl_filedata.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*!
+ * \brief Level section entry
+ */
+struct CompiledLevelSection
+{
+    enum Flags
+    {
+        WRAP_H = 0x01,
+        WRAP_V = 0x02,
+        OFFSCREEN_EXIT = 0x04,
+        UNDERWATER = 0x08,
+        LOCK_LEFT_SCROLL = 0x10,
+        LOCK_RIGHT_SCROLL = 0x20,
+        LOCK_UP_SCROLL = 0x40,
+        LOCK_DOWN_SCROLL = 0x80
+    };
+    int32_t  id;
+    int32_t  left;
+    int32_t  top;
+    int32_t  right;
+    int32_t  bottom;
+    uint32_t musicId;
+    //! String index of the custom music file
+    uint32_t musicFile;
+    uint32_t background;
+    int32_t  lightingValue;
+    uint32_t flags;
+};
+
+/*!
+ * \brief Player start point entry
+ */
+struct CompiledLevelPlayer
+{
+    uint32_t id;
+    int32_t  x;
+    int32_t  y;
+    int32_t  w;
+    int32_t  h;
+    int32_t  direction;
+};
+
+/*!
+ * \brief Layer entry
+ */
+struct CompiledLevelLayer
+{
+    enum Flags
+    {
+        HIDDEN = 0x01
+    };
+    //! String index of the layer name
+    uint32_t name;
+    uint32_t flags;
+};
+
+/*!
+ * \brief Section settings changed by event
+ */
+struct CompiledLevelEventSet
+{
+    enum Flags
+    {
+        AUTOSCROLL = 0x01
+    };
+    //! Section ID
+    int32_t  id;
+    int32_t  musicId;
+    //! String index of the custom music file
+    uint32_t musicFile;
+    int32_t  backgroundId;
+    int32_t  left;
+    int32_t  top;
+    int32_t  right;
+    int32_t  bottom;
+    float    autoscrollX;
+    float    autoscrollY;
+    uint32_t flags;
+};
+
+/*!
+ * \brief Event entry
+ */
+struct CompiledLevelEvent
+{
+    enum Flags
+    {
+        NO_SMOKE = 0x01
+    };
+    //! String index of the event name
+    uint32_t name;
+    //! String index of the message
+    uint32_t msg;
+    int32_t  soundId;
+    int32_t  endGame;
+    //! Index of event to trigger
+    int32_t  trigger;
+    int32_t  triggerTimer;
+    int32_t  autostart;
+    //! Index of layer to move
+    int32_t  moveLayer;
+    float    layerSpeedX;
+    float    layerSpeedY;
+    int32_t  scrollSection;
+    uint32_t flags;
+    //! Range of layer indices to hide in the layer references array
+    uint32_t layersHideBegin;
+    uint32_t layersHideCount;
+    //! Range of layer indices to show in the layer references array
+    uint32_t layersShowBegin;
+    uint32_t layersShowCount;
+    //! Range of layer indices to toggle in the layer references array
+    uint32_t layersToggleBegin;
+    uint32_t layersToggleCount;
+    //! Range of section settings in the event sets array
+    uint32_t setsBegin;
+    uint32_t setsCount;
+};
+
+/*!
+ * \brief Columns of blocks
+ */
+struct CompiledLevelBlocks
+{
+    enum Flags
+    {
+        INVISIBLE = 0x01,
+        SLIPPERY = 0x02,
+        AUTOSCALE = 0x04
+    };
+    uint32_t count = 0;
+    const int32_t  *x = nullptr;
+    const int32_t  *y = nullptr;
+    const int32_t  *w = nullptr;
+    const int32_t  *h = nullptr;
+    const uint32_t *id = nullptr;
+    const int32_t  *npcId = nullptr;
+    const int32_t  *layer = nullptr;
+    const int32_t  *eventDestroy = nullptr;
+    const int32_t  *eventHit = nullptr;
+    const int32_t  *eventEmptyLayer = nullptr;
+    const uint8_t  *flags = nullptr;
+};
+
+/*!
+ * \brief Columns of background objects
+ */
+struct CompiledLevelBGOs
+{
+    uint32_t count = 0;
+    const int32_t  *x = nullptr;
+    const int32_t  *y = nullptr;
+    const uint32_t *id = nullptr;
+    const int32_t  *layer = nullptr;
+    const int32_t  *zMode = nullptr;
+    const float    *zOffset = nullptr;
+    const int32_t  *smbx64Sp = nullptr;
+};
+
+/*!
+ * \brief Columns of NPCs
+ */
+struct CompiledLevelNPCs
+{
+    enum Flags
+    {
+        FRIENDLY = 0x01,
+        NO_MOVE = 0x02,
+        BOSS = 0x04,
+        GENERATOR = 0x08,
+        STAR = 0x10
+    };
+    uint32_t count = 0;
+    const int32_t  *x = nullptr;
+    const int32_t  *y = nullptr;
+    const uint32_t *id = nullptr;
+    const int32_t  *direction = nullptr;
+    const int32_t  *contents = nullptr;
+    const int32_t  *specialData = nullptr;
+    const int32_t  *generatorType = nullptr;
+    const int32_t  *generatorDirection = nullptr;
+    const int32_t  *generatorPeriod = nullptr;
+    //! String index of the talk message
+    const uint32_t *msg = nullptr;
+    const int32_t  *layer = nullptr;
+    const int32_t  *attachLayer = nullptr;
+    const int32_t  *eventActivate = nullptr;
+    const int32_t  *eventDie = nullptr;
+    const int32_t  *eventTalk = nullptr;
+    const int32_t  *eventEmptyLayer = nullptr;
+    const uint8_t  *flags = nullptr;
+};
+
+/*!
+ * \brief Columns of warps
+ */
+struct CompiledLevelDoors
+{
+    enum Flags
+    {
+        SET_IN = 0x0001,
+        SET_OUT = 0x0002,
+        LEVEL_ENTRANCE = 0x0004,
+        LEVEL_EXIT = 0x0008,
+        NO_VEHICLES = 0x0010,
+        ALLOW_NPC = 0x0020,
+        LOCKED = 0x0040,
+        NEED_A_BOMB = 0x0080,
+        TWO_WAY = 0x0100,
+        ALLOW_NPC_INTERLEVEL = 0x0200,
+        HIDE_ENTERING_SCENE = 0x0400
+    };
+    uint32_t count = 0;
+    const int32_t  *ix = nullptr;
+    const int32_t  *iy = nullptr;
+    const int32_t  *ox = nullptr;
+    const int32_t  *oy = nullptr;
+    const int32_t  *idirect = nullptr;
+    const int32_t  *odirect = nullptr;
+    const int32_t  *type = nullptr;
+    //! String index of the target level file
+    const uint32_t *levelName = nullptr;
+    const int32_t  *warpTo = nullptr;
+    const int32_t  *worldX = nullptr;
+    const int32_t  *worldY = nullptr;
+    const int32_t  *stars = nullptr;
+    const int32_t  *layer = nullptr;
+    const int32_t  *eventEnter = nullptr;
+    const uint16_t *flags = nullptr;
+};
+
+/*!
+ * \brief Columns of physical environment zones
+ */
+struct CompiledLevelPhysEnvs
+{
+    uint32_t count = 0;
+    const int32_t  *x = nullptr;
+    const int32_t  *y = nullptr;
+    const int32_t  *w = nullptr;
+    const int32_t  *h = nullptr;
+    const int32_t  *envType = nullptr;
+    const float    *friction = nullptr;
+    const float    *accelDirection = nullptr;
+    const float    *accel = nullptr;
+    const float    *maxVelocity = nullptr;
+    const int32_t  *layer = nullptr;
+    const int32_t  *touchEvent = nullptr;
+};
+
+/*!
+ * \brief Converter of the level data into the compiled level image
+ */
+class CompiledLevel
+{
+public:
+    //! Version of the compiled level image layout
+    enum { VERSION = 1 };
+    //! Value of the layer or event index which refers nothing
+    enum { NONE = -1 };
+
+    /*!
+     * \brief Converts the level data into the compiled level image
+     * \param [__in] src Level data structure
+     * \param [__out] out Compiled level image
+     * \param [__out] errorString Error description (optional)
+     * \return true on success, false if the level data can't be represented
+     *         (for example, coordinates are out of the 32-bit range)
+     */
+    static bool build(const LevelData &src, std::string &out, PGESTRING *errorString = nullptr);
+    /*!
+     * \brief Converts the level data into the compiled level image and saves it into the file
+     * \param [__in] src Level data structure
+     * \param [__in] filePath Path to the target file
+     * \param [__out] errorString Error description (optional)
+     * \return true on success
+     */
+    static bool buildFile(const LevelData &src, const PGESTRING &filePath, PGESTRING *errorString = nullptr);
+};
+
+/*!
+ * \brief Read-only view over the compiled level image, performs no copying
+ *
+ * The image memory must stay alive and unchanged while the view is in use,
+ * and must be aligned at the 8-byte boundary.
+ */
+class CompiledLevelView
+{
+public:
+    CompiledLevelView() = default;
+
+    /*!
+     * \brief Attaches the view to the compiled level image and validates it
+     * \param data Pointer to the image
+     * \param size Size of the image in bytes
+     * \return true if image is valid
+     */
+    bool open(const void *data, size_t size);
+    /*!
+     * \brief Is the view attached to the valid image
+     */
+    bool isValid() const
+    {
+        return m_valid;
+    }
+    /*!
+     * \brief Description of the recent open() failure
+     */
+    const char *errorString() const
+    {
+        return m_error;
+    }
+
+    /*!
+     * \brief Number of strings in the string table
+     */
+    uint32_t stringsCount() const
+    {
+        return m_stringsCount;
+    }
+    /*!
+     * \brief Gives string from the string table
+     * \param index Index of the string
+     * \return Zero-terminated UTF-8 string, empty string if index is out of range
+     */
+    const char *string(uint32_t index) const;
+
+    //! String index of the level title
+    uint32_t levelName() const;
+    //! Number of stars in the level
+    int32_t  stars() const;
+    //! String index of the level to open on player's fail
+    uint32_t openLevelOnFail() const;
+    //! Warp ID of the level to open on player's fail
+    uint32_t openLevelOnFailWarpId() const;
+
+    const CompiledLevelSection *sections() const { return m_sections; }
+    uint32_t sectionsCount() const { return m_sectionsCount; }
+    const CompiledLevelPlayer *players() const { return m_players; }
+    uint32_t playersCount() const { return m_playersCount; }
+    const CompiledLevelLayer *layers() const { return m_layers; }
+    uint32_t layersCount() const { return m_layersCount; }
+    const CompiledLevelEvent *events() const { return m_events; }
+    uint32_t eventsCount() const { return m_eventsCount; }
+    const CompiledLevelEventSet *eventSets() const { return m_eventSets; }
+    uint32_t eventSetsCount() const { return m_eventSetsCount; }
+    //! Layer indices referred by the events
+    const int32_t *eventLayerRefs() const { return m_eventLayerRefs; }
+    uint32_t eventLayerRefsCount() const { return m_eventLayerRefsCount; }
+
+    const CompiledLevelBlocks &blocks() const { return m_blocks; }
+    const CompiledLevelBGOs &bgo() const { return m_bgo; }
+    const CompiledLevelNPCs &npc() const { return m_npc; }
+    const CompiledLevelDoors &doors() const { return m_doors; }
+    const CompiledLevelPhysEnvs &physez() const { return m_physez; }
+
+private:
+    const char *m_base = nullptr;
+    bool m_valid = false;
+    const char *m_error = "Not opened";
+
+    const uint32_t *m_stringOffsets = nullptr;
+    const char *m_stringData = nullptr;
+    uint32_t m_stringsCount = 0;
+    uint32_t m_stringDataSize = 0;
+
+    const uint32_t *m_info = nullptr;
+
+    const CompiledLevelSection *m_sections = nullptr;
+    uint32_t m_sectionsCount = 0;
+    const CompiledLevelPlayer *m_players = nullptr;
+    uint32_t m_playersCount = 0;
+    const CompiledLevelLayer *m_layers = nullptr;
+    uint32_t m_layersCount = 0;
+    const CompiledLevelEvent *m_events = nullptr;
+    uint32_t m_eventsCount = 0;
+    const CompiledLevelEventSet *m_eventSets = nullptr;
+    uint32_t m_eventSetsCount = 0;
+    const int32_t *m_eventLayerRefs = nullptr;
+    uint32_t m_eventLayerRefsCount = 0;
+
+    CompiledLevelBlocks   m_blocks;
+    CompiledLevelBGOs     m_bgo;
+    CompiledLevelNPCs     m_npc;
+    CompiledLevelDoors    m_doors;
+    CompiledLevelPhysEnvs m_physez;
+};
+
+/*!
+ * \brief Compiled level file mapped into memory
+ *
+ * Uses memory mapping where supported by the platform,
+ * otherwise reads the whole file into the memory buffer.
+ */
+class CompiledLevelFile
+{
+public:
+    CompiledLevelFile() = default;
+    ~CompiledLevelFile();
+    CompiledLevelFile(const CompiledLevelFile &) = delete;
+    CompiledLevelFile &operator=(const CompiledLevelFile &) = delete;
+
+    /*!
+     * \brief Maps the compiled level file and opens the view over it
+     * \param filePath Path to the compiled level file
+     * \return true if file was mapped and the image is valid
+     */
+    bool open(const PGESTRING &filePath);
+    /*!
+     * \brief Unmaps the file
+     */
+    void close();
+
+    /*!
+     * \brief View over the mapped image
+     */
+    const CompiledLevelView &view() const
+    {
+        return m_view;
+    }
+
+private:
+    CompiledLevelView m_view;
+    const void *m_data = nullptr;
+    size_t m_size = 0;
+    //! Platform-specific mapping handle
+    void *m_mapping = nullptr;
+    //! Fallback buffer when memory mapping is unavailable
+    std::string m_buffer;
+};
+
+#endif // COMPILED_LEVEL_H
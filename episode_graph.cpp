@@ -0,0 +1,368 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "episode_graph.h"
+#include "file_formats.h"
+#include "pge_x.h"
+#include "pge_file_lib_private.h"
+
+#include <algorithm>
+#include <deque>
+
+/*!
+ * \brief Value of the PGE-X file which is a link to another file
+ */
+struct EpisodeGraphPgeXQuery
+{
+    //! Name of the section
+    const char *section;
+    //! Name of the field
+    const char *field;
+    //! Type of the link
+    EpisodeGraph::LinkType type;
+};
+
+static const EpisodeGraphPgeXQuery s_lvlxQueries[] =
+{
+    {"HEAD",    "DL", EpisodeGraph::LINK_FAIL},
+    {"DOORS",   "LF", EpisodeGraph::LINK_WARP}
+};
+
+static const EpisodeGraphPgeXQuery s_wldxQueries[] =
+{
+    {"HEAD",    "IT", EpisodeGraph::LINK_INTRO},
+    {"HEAD",    "GO", EpisodeGraph::LINK_GAMEOVER},
+    {"LEVELS",  "LF", EpisodeGraph::LINK_WORLD_LEVEL}
+};
+
+typedef PGEPAIR<EpisodeGraph::LinkType, PGESTRING> EpisodeGraphRawLink;
+
+/*
+ * Walks through the file line by line, and splits only lines of
+ * sections that are in the list of queries. All other sections are skipped.
+ */
+static bool episodeGraphScanPgeX(PGE_FileFormats_misc::TextInput &in,
+                                 const EpisodeGraphPgeXQuery *queries, size_t queriesCount,
+                                 PGELIST<EpisodeGraphRawLink> &out)
+{
+    PGESTRING line;
+    PGESTRING section;
+    PGESTRING sectionEnd;
+    bool sectionWanted = false;
+
+    while(!in.eof())
+    {
+        line = in.readLine();
+
+        if(IsEmpty(line))
+            continue;
+
+        if(IsEmpty(section))
+        {
+            if(!PGEFile::IsSectionTitle(line))
+                return false;
+            section = line;
+            sectionEnd = line + "_END";
+            sectionWanted = false;
+            for(size_t q = 0; q < queriesCount; q++)
+                sectionWanted |= (section == queries[q].section);
+            continue;
+        }
+
+        if(line == sectionEnd)
+        {
+            section.clear();
+            continue;
+        }
+
+        if(!sectionWanted)
+            continue;
+
+        bool valid = true;
+        PGEVECTOR<PGESTRINGList> data = PGEFile::splitDataLine(line, &valid);
+        if(!valid)
+            return false;
+
+        for(const PGESTRINGList &val : data)
+        {
+            if(val.size() != 2)
+                return false;
+            for(size_t q = 0; q < queriesCount; q++)
+            {
+                if((section == queries[q].section) && (val[0] == queries[q].field))
+                {
+                    if(!PGEFile::IsQoutedString(val[1]))
+                        return false;
+                    out.push_back(EpisodeGraphRawLink(queries[q].type, PGEFile::X2STRING(val[1])));
+                }
+            }
+        }
+    }
+
+    return IsEmpty(section);
+}
+
+static bool episodeGraphIsLegacyFormat(PGE_FileFormats_misc::TextInput &in)
+{
+    PGESTRING firstLine = in.readLine();
+    in.seek(0, PGE_FileFormats_misc::TextInput::begin);
+    return PGE_StartsWith(firstLine, "SMBXFile") ||
+           PGE_FileFormats_misc::PGE_DetectSMBXFile(firstLine);
+}
+
+static bool episodeGraphReadLevel(const PGESTRING &filePath, PGELIST<EpisodeGraphRawLink> &out)
+{
+    PGE_FileFormats_misc::TextFileInput file;
+    if(!file.open(filePath, true))
+        return false;
+
+    if(!episodeGraphIsLegacyFormat(file))
+        return episodeGraphScanPgeX(file, s_lvlxQueries,
+                                    sizeof(s_lvlxQueries) / sizeof(EpisodeGraphPgeXQuery), out);
+    file.close();
+
+    LevelData data;
+    if(!FileFormats::OpenLevelFile(filePath, data))
+        return false;
+
+    for(const LevelDoor &door : data.doors)
+        out.push_back(EpisodeGraphRawLink(EpisodeGraph::LINK_WARP, door.lname));
+    out.push_back(EpisodeGraphRawLink(EpisodeGraph::LINK_FAIL, data.open_level_on_fail));
+    return true;
+}
+
+static bool episodeGraphReadWorld(const PGESTRING &filePath, PGELIST<EpisodeGraphRawLink> &out)
+{
+    PGE_FileFormats_misc::TextFileInput file;
+    if(!file.open(filePath, true))
+        return false;
+
+    if(!episodeGraphIsLegacyFormat(file))
+        return episodeGraphScanPgeX(file, s_wldxQueries,
+                                    sizeof(s_wldxQueries) / sizeof(EpisodeGraphPgeXQuery), out);
+    file.close();
+
+    WorldData data;
+    if(!FileFormats::OpenWorldFile(filePath, data))
+        return false;
+
+    out.push_back(EpisodeGraphRawLink(EpisodeGraph::LINK_INTRO, data.IntroLevel_file));
+    for(const WorldLevelTile &level : data.levels)
+        out.push_back(EpisodeGraphRawLink(EpisodeGraph::LINK_WORLD_LEVEL, level.lvlfile));
+    out.push_back(EpisodeGraphRawLink(EpisodeGraph::LINK_GAMEOVER, data.GameOverLevel_file));
+    return true;
+}
+
+static bool episodeGraphIsWorldFile(const PGESTRING &filePath)
+{
+    PGE_FileFormats_misc::FileInfo info(filePath);
+    PGESTRING suffix = info.suffix();
+    return (suffix == "wld") || (suffix == "wldx");
+}
+
+
+PGESTRING EpisodeGraph::normalizePath(const PGESTRING &filePath)
+{
+    PGE_FileFormats_misc::FileInfo info(filePath);
+    return info.fullPath();
+}
+
+EpisodeGraph::Node &EpisodeGraph::addNode(const PGESTRING &path, bool isWorld)
+{
+    Node &node = m_nodes[path];
+    node.path = path;
+    node.isWorld = isWorld;
+    node.valid = false;
+    node.links.clear();
+    return node;
+}
+
+void EpisodeGraph::addLink(Node &node, const PGESTRING &dirPath, const PGESTRING &target, LinkType type)
+{
+    if(IsEmpty(target))
+        return;
+
+    PGESTRING fullPath = normalizePath(dirPath + "/" + target);
+
+    for(Link &l : node.links)
+    {
+        if(l.type == type && l.target == fullPath)
+        {
+            l.weight++;
+            return;
+        }
+    }
+
+    Link l;
+    l.target = fullPath;
+    l.type = type;
+    l.weight = 1;
+    node.links.push_back(l);
+}
+
+bool EpisodeGraph::addLevel(const PGESTRING &filePath)
+{
+    PGE_FileFormats_misc::FileInfo info(filePath);
+    Node &node = addNode(info.fullPath(), false);
+    PGELIST<EpisodeGraphRawLink> links;
+
+    node.valid = episodeGraphReadLevel(node.path, links);
+    if(!node.valid)
+        return false;
+
+    for(const EpisodeGraphRawLink &l : links)
+        addLink(node, info.dirpath(), l.second, l.first);
+
+    return true;
+}
+
+bool EpisodeGraph::addWorld(const PGESTRING &filePath)
+{
+    PGE_FileFormats_misc::FileInfo info(filePath);
+    Node &node = addNode(info.fullPath(), true);
+    PGELIST<EpisodeGraphRawLink> links;
+
+    node.valid = episodeGraphReadWorld(node.path, links);
+    if(!node.valid)
+        return false;
+
+    for(const EpisodeGraphRawLink &l : links)
+        addLink(node, info.dirpath(), l.second, l.first);
+
+    return true;
+}
+
+unsigned int EpisodeGraph::crawl(const PGESTRING &entryFile, unsigned int maxDepth)
+{
+    typedef PGEPAIR<PGESTRING, unsigned int> QueueEntry;
+    std::deque<QueueEntry> queue;
+    unsigned int scanned = 0;
+
+    queue.push_back(QueueEntry(normalizePath(entryFile), 0));
+
+    while(!queue.empty())
+    {
+        QueueEntry e = queue.front();
+        queue.pop_front();
+
+        if(contains(e.first))
+            continue;
+
+        bool ok = episodeGraphIsWorldFile(e.first) ? addWorld(e.first) : addLevel(e.first);
+        if(!ok)
+            continue;
+        scanned++;
+
+        if(maxDepth > 0 && e.second + 1 > maxDepth)
+            continue;
+
+        const Node *n = node(e.first);
+        for(const Link &l : n->links)
+        {
+            if(!contains(l.target))
+                queue.push_back(QueueEntry(l.target, e.second + 1));
+        }
+    }
+
+    return scanned;
+}
+
+bool EpisodeGraph::contains(const PGESTRING &filePath) const
+{
+    return m_nodes.find(filePath) != m_nodes.end() ||
+           m_nodes.find(normalizePath(filePath)) != m_nodes.end();
+}
+
+const EpisodeGraph::Node *EpisodeGraph::node(const PGESTRING &filePath) const
+{
+    auto it = m_nodes.find(filePath);
+    if(it == m_nodes.end())
+        it = m_nodes.find(normalizePath(filePath));
+    if(it == m_nodes.end())
+        return nullptr;
+    return &PGEMAPVAL(it);
+}
+
+static int episodeGraphLinkRank(EpisodeGraph::LinkType type)
+{
+    switch(type)
+    {
+    case EpisodeGraph::LINK_INTRO:
+        return 0;
+    case EpisodeGraph::LINK_WARP:
+    case EpisodeGraph::LINK_WORLD_LEVEL:
+        return 1;
+    case EpisodeGraph::LINK_FAIL:
+        return 2;
+    case EpisodeGraph::LINK_GAMEOVER:
+    default:
+        return 3;
+    }
+}
+
+PGESTRINGList EpisodeGraph::likelyNext(const PGESTRING &filePath, unsigned int maxCount) const
+{
+    PGESTRINGList ret;
+    const Node *n = node(filePath);
+    if(!n)
+        return ret;
+
+    PGELIST<Link> links = n->links;
+    std::stable_sort(links.begin(), links.end(), [](const Link &a, const Link &b)
+    {
+        int ra = episodeGraphLinkRank(a.type);
+        int rb = episodeGraphLinkRank(b.type);
+        if(ra != rb)
+            return ra < rb;
+        // World map tiles are kept in order of appearance
+        if(a.type == LINK_WARP && b.type == LINK_WARP)
+            return a.weight > b.weight;
+        return false;
+    });
+
+    for(const Link &l : links)
+    {
+        if(l.target == n->path)
+            continue; // Warps inside the same level
+        if(std::find(ret.begin(), ret.end(), l.target) != ret.end())
+            continue;
+        ret.push_back(l.target);
+        if(maxCount > 0 && static_cast<unsigned int>(ret.size()) >= maxCount)
+            break;
+    }
+
+    return ret;
+}
+
+size_t EpisodeGraph::size() const
+{
+    return static_cast<size_t>(m_nodes.size());
+}
+
+void EpisodeGraph::clear()
+{
+    m_nodes.clear();
+}
@@ -0,0 +1,167 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*!
+ * \file episode_graph.h
+ * \brief Contains a graph of links between level and world map files of an episode
+ */
+
+#pragma once
+#ifndef EPISODE_GRAPH_H
+#define EPISODE_GRAPH_H
+
+#include "pge_file_lib_globs.h"
+#include <cstddef>
+
+/*!
+ * \brief Graph of links between level and world map files of an episode
+ *
+ * Nodes are files, edges are warps to other levels, the level to open
+ * on player's fail, world map level tiles, and the intro and game over
+ * levels of a world map. The graph is intended to tell a runtime which
+ * files are worth to be preloaded in background while the player is
+ * inside of the given level.
+ *
+ * PGE-X files are scanned for the interesting sections only, without
+ * building of the full data structure. SMBX64 and SMBX-38A files have no
+ * sections that could be skipped, so they are parsed completely.
+ */
+class EpisodeGraph
+{
+public:
+    //! Kind of the link between two files
+    enum LinkType
+    {
+        //! Warp to another level (LevelDoor::lname)
+        LINK_WARP = 0,
+        //! Level to open on player's fail (LevelData::open_level_on_fail)
+        LINK_FAIL,
+        //! World map level tile (WorldLevelTile::lvlfile)
+        LINK_WORLD_LEVEL,
+        //! World map intro level (WorldData::IntroLevel_file)
+        LINK_INTRO,
+        //! World map game over level (WorldData::GameOverLevel_file)
+        LINK_GAMEOVER
+    };
+
+    /*!
+     * \brief Link to another file
+     */
+    struct Link
+    {
+        //! Full path to the target file
+        PGESTRING target;
+        //! Kind of the link
+        LinkType type = LINK_WARP;
+        //! Number of the same links in the source file (for example, several warps to the same level)
+        unsigned int weight = 0;
+    };
+
+    /*!
+     * \brief Node of the graph
+     */
+    struct Node
+    {
+        //! Full path to the file
+        PGESTRING path;
+        //! Is a world map file
+        bool isWorld = false;
+        //! Is file was scanned successfully
+        bool valid = false;
+        //! Outgoing links in order of their first appearance
+        PGELIST<Link> links;
+    };
+
+    /*!
+     * \brief Scans links of the level file and adds them into the graph
+     * \param [__in] filePath Path to the level file of any supported format
+     * \return true if file was successfully scanned
+     */
+    bool addLevel(const PGESTRING &filePath);
+    /*!
+     * \brief Scans links of the world map file and adds them into the graph
+     * \param [__in] filePath Path to the world map file of any supported format
+     * \return true if file was successfully scanned
+     */
+    bool addWorld(const PGESTRING &filePath);
+    /*!
+     * \brief Scans the entry file and recursively all files reachable from it
+     * \param [__in] entryFile Path to the level or world map file (detected by the file extension)
+     * \param [__in] maxDepth Maximum number of hops from the entry file, 0 means unlimited
+     * \return Number of files which were scanned successfully
+     */
+    unsigned int crawl(const PGESTRING &entryFile, unsigned int maxDepth = 0);
+
+    /*!
+     * \brief Is the file was already added into the graph
+     * \param [__in] filePath Path to the file
+     * \return true if file presented in the graph
+     */
+    bool contains(const PGESTRING &filePath) const;
+    /*!
+     * \brief Gives the node of the file
+     * \param [__in] filePath Path to the file
+     * \return Pointer to the node, or nullptr if file is not in the graph
+     */
+    const Node *node(const PGESTRING &filePath) const;
+    /*!
+     * \brief Files which are most likely to be opened after the given one
+     *
+     * Warps go first ordered by number of warps to the same file, then
+     * the level to open on fail. For world maps, the intro level goes first,
+     * then level tiles in order of their appearance, then the game over level.
+     *
+     * \param [__in] filePath Path to the file
+     * \param [__in] maxCount Maximum number of entries to return, 0 means unlimited
+     * \return List of full paths to the files
+     */
+    PGESTRINGList likelyNext(const PGESTRING &filePath, unsigned int maxCount = 0) const;
+
+    /*!
+     * \brief Number of files in the graph
+     * \return Number of nodes
+     */
+    size_t size() const;
+    /*!
+     * \brief Removes all files from the graph
+     */
+    void clear();
+
+    /*!
+     * \brief Normalizes the file path into the form used as a key of the graph
+     * \param [__in] filePath Path to the file
+     * \return Full path to the file
+     */
+    static PGESTRING normalizePath(const PGESTRING &filePath);
+
+private:
+    Node &addNode(const PGESTRING &path, bool isWorld);
+    void addLink(Node &node, const PGESTRING &dirPath, const PGESTRING &target, LinkType type);
+
+    PGEMAP<PGESTRING, Node> m_nodes;
+};
+
+#endif // EPISODE_GRAPH_H
@@ -0,0 +1,350 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "file_cache.h"
+#include "file_formats.h"
+#include "pge_file_lib_private.h"
+
+#include <mutex>
+#include <list>
+#include <unordered_map>
+#include <functional>
+#include <limits>
+
+#ifdef PGE_FILES_QT
+#include <QFileInfo>
+#endif
+
+/*!
+ * \brief Identity of the file on the disk
+ */
+struct CacheFileStamp
+{
+    //! Canonical path to the file
+    std::string path;
+    //! Size of the file in bytes
+    int64_t size = 0;
+    //! Modification time of the file in the platform-specific units
+    int64_t mtime = 0;
+};
+
+static bool cacheFileStamp(const PGESTRING &filePath, CacheFileStamp &stamp)
+{
+#ifdef PGE_FILES_QT
+    stamp.path = QFileInfo(filePath).canonicalFilePath().toStdString();
+#else
+    PGE_FileFormats_misc::FileInfo info(filePath);
+    stamp.path = info.fullPath();
+#endif
+    return PGE_FileFormats_misc::fileSizeAndTime(filePath, stamp.size, stamp.mtime);
+}
+
+template<class T>
+static size_t cacheListBytes(const PGELIST<T> &list)
+{
+    return static_cast<size_t>(list.size()) * sizeof(T);
+}
+
+/*
+ * Rough estimation: element storage, plus the file size itself as
+ * an approximation of the memory held by strings.
+ */
+static size_t cacheEstimateBytes(const LevelData &d, int64_t fileSize)
+{
+    size_t bytes = sizeof(LevelData) + static_cast<size_t>(fileSize);
+    bytes += cacheListBytes(d.sections);
+    bytes += cacheListBytes(d.players);
+    bytes += cacheListBytes(d.blocks);
+    bytes += cacheListBytes(d.bgo);
+    bytes += cacheListBytes(d.npc);
+    bytes += cacheListBytes(d.doors);
+    bytes += cacheListBytes(d.physez);
+    bytes += cacheListBytes(d.layers);
+    bytes += cacheListBytes(d.events);
+    bytes += cacheListBytes(d.variables);
+    bytes += cacheListBytes(d.arrays);
+    bytes += cacheListBytes(d.scripts);
+    bytes += cacheListBytes(d.custom38A_configs);
+    return bytes;
+}
+
+static size_t cacheEstimateBytes(const WorldData &d, int64_t fileSize)
+{
+    size_t bytes = sizeof(WorldData) + static_cast<size_t>(fileSize);
+    bytes += cacheListBytes(d.tiles);
+    bytes += cacheListBytes(d.scenery);
+    bytes += cacheListBytes(d.paths);
+    bytes += cacheListBytes(d.levels);
+    bytes += cacheListBytes(d.music);
+    bytes += cacheListBytes(d.arearects);
+    bytes += cacheListBytes(d.layers);
+    bytes += cacheListBytes(d.events38A);
+    bytes += cacheListBytes(d.custom38A_configs);
+    return bytes;
+}
+
+
+struct FileFormatsCache::Shard
+{
+    struct Entry
+    {
+        std::string key;
+        int64_t     size = 0;
+        int64_t     mtime = 0;
+        std::shared_ptr<const void> data;
+        size_t      bytes = 0;
+        uint64_t    lastUse = 0;
+    };
+
+    typedef std::list<Entry> EntriesList;
+
+    //! Guards everything below
+    std::mutex lock;
+    //! Most recently used entries are at front
+    EntriesList lru;
+    //! Key to LRU list position
+    std::unordered_map<std::string, EntriesList::iterator> index;
+
+    size_t memoryUsage = 0;
+    unsigned long hits = 0;
+    unsigned long misses = 0;
+    unsigned long evictions = 0;
+
+    //! Must be called with the lock held
+    void remove(EntriesList::iterator it, std::atomic<size_t> &totalUsage)
+    {
+        memoryUsage -= it->bytes;
+        totalUsage -= it->bytes;
+        index.erase(it->key);
+        lru.erase(it);
+    }
+};
+
+
+FileFormatsCache::FileFormatsCache(size_t memoryBudget, unsigned int shards) :
+    m_memoryBudget(memoryBudget),
+    m_memoryUsage(0),
+    m_tick(0)
+{
+    if(shards == 0)
+        shards = 1;
+    m_shards.reserve(shards);
+    for(unsigned int i = 0; i < shards; i++)
+        m_shards.emplace_back(new Shard);
+}
+
+FileFormatsCache::~FileFormatsCache()
+{}
+
+FileFormatsCache::Shard &FileFormatsCache::shardFor(const std::string &key)
+{
+    size_t h = std::hash<std::string>()(key);
+    return *m_shards[h % m_shards.size()];
+}
+
+std::shared_ptr<const void> FileFormatsCache::find(const std::string &key, int64_t size, int64_t mtime)
+{
+    Shard &s = shardFor(key);
+    std::lock_guard<std::mutex> guard(s.lock);
+
+    auto it = s.index.find(key);
+    if(it == s.index.end())
+    {
+        s.misses++;
+        return std::shared_ptr<const void>();
+    }
+
+    Shard::EntriesList::iterator e = it->second;
+    if(e->size != size || e->mtime != mtime)
+    {
+        // File was changed on the disk since it was parsed
+        s.remove(e, m_memoryUsage);
+        s.misses++;
+        return std::shared_ptr<const void>();
+    }
+
+    e->lastUse = ++m_tick;
+    s.lru.splice(s.lru.begin(), s.lru, e);
+    s.hits++;
+    return e->data;
+}
+
+void FileFormatsCache::insert(const std::string &key, int64_t size, int64_t mtime,
+                              const std::shared_ptr<const void> &data, size_t bytes)
+{
+    {
+        Shard &s = shardFor(key);
+        std::lock_guard<std::mutex> guard(s.lock);
+
+        // Another thread may parse the same file at the same time
+        auto it = s.index.find(key);
+        if(it != s.index.end())
+            s.remove(it->second, m_memoryUsage);
+
+        Shard::Entry e;
+        e.key = key;
+        e.size = size;
+        e.mtime = mtime;
+        e.data = data;
+        e.bytes = bytes;
+        e.lastUse = ++m_tick;
+        s.lru.push_front(std::move(e));
+        s.index[key] = s.lru.begin();
+        s.memoryUsage += bytes;
+        m_memoryUsage += bytes;
+    }
+
+    trim();
+}
+
+void FileFormatsCache::trim()
+{
+    while(m_memoryUsage > m_memoryBudget)
+    {
+        // Find the shard which holds the globally oldest entry,
+        // never hold more than one shard lock at a time
+        Shard *oldest = nullptr;
+        uint64_t oldestUse = std::numeric_limits<uint64_t>::max();
+
+        for(auto &sp : m_shards)
+        {
+            std::lock_guard<std::mutex> guard(sp->lock);
+            if(!sp->lru.empty() && sp->lru.back().lastUse < oldestUse)
+            {
+                oldestUse = sp->lru.back().lastUse;
+                oldest = sp.get();
+            }
+        }
+
+        if(!oldest)
+            break; // Nothing to evict
+
+        std::lock_guard<std::mutex> guard(oldest->lock);
+        if(oldest->lru.empty())
+            continue; // Drained by another thread meanwhile
+        oldest->remove(std::prev(oldest->lru.end()), m_memoryUsage);
+        oldest->evictions++;
+    }
+}
+
+FileFormatsCache::LevelHandle FileFormatsCache::openLevel(const PGESTRING &filePath)
+{
+    CacheFileStamp stamp;
+    bool hasStamp = cacheFileStamp(filePath, stamp);
+    std::string key = "L:" + stamp.path;
+
+    if(hasStamp)
+    {
+        std::shared_ptr<const void> cached = find(key, stamp.size, stamp.mtime);
+        if(cached)
+            return std::static_pointer_cast<const LevelData>(cached);
+    }
+
+    std::shared_ptr<LevelData> data = std::make_shared<LevelData>();
+    FileFormats::OpenLevelFile(filePath, *data);
+
+    if(hasStamp && data->meta.ReadFileValid)
+        insert(key, stamp.size, stamp.mtime, data, cacheEstimateBytes(*data, stamp.size));
+
+    return data;
+}
+
+FileFormatsCache::WorldHandle FileFormatsCache::openWorld(const PGESTRING &filePath)
+{
+    CacheFileStamp stamp;
+    bool hasStamp = cacheFileStamp(filePath, stamp);
+    std::string key = "W:" + stamp.path;
+
+    if(hasStamp)
+    {
+        std::shared_ptr<const void> cached = find(key, stamp.size, stamp.mtime);
+        if(cached)
+            return std::static_pointer_cast<const WorldData>(cached);
+    }
+
+    std::shared_ptr<WorldData> data = std::make_shared<WorldData>();
+    FileFormats::OpenWorldFile(filePath, *data);
+
+    if(hasStamp && data->meta.ReadFileValid)
+        insert(key, stamp.size, stamp.mtime, data, cacheEstimateBytes(*data, stamp.size));
+
+    return data;
+}
+
+void FileFormatsCache::invalidate(const PGESTRING &filePath)
+{
+    CacheFileStamp stamp;
+    cacheFileStamp(filePath, stamp);
+
+    const char *prefixes[] = {"L:", "W:"};
+    for(const char *prefix : prefixes)
+    {
+        std::string key = prefix + stamp.path;
+        Shard &s = shardFor(key);
+        std::lock_guard<std::mutex> guard(s.lock);
+        auto it = s.index.find(key);
+        if(it != s.index.end())
+            s.remove(it->second, m_memoryUsage);
+    }
+}
+
+void FileFormatsCache::clear()
+{
+    for(auto &sp : m_shards)
+    {
+        std::lock_guard<std::mutex> guard(sp->lock);
+        m_memoryUsage -= sp->memoryUsage;
+        sp->memoryUsage = 0;
+        sp->index.clear();
+        sp->lru.clear();
+    }
+}
+
+void FileFormatsCache::setMemoryBudget(size_t memoryBudget)
+{
+    m_memoryBudget = memoryBudget;
+    trim();
+}
+
+size_t FileFormatsCache::memoryBudget() const
+{
+    return m_memoryBudget;
+}
+
+FileFormatsCache::Stats FileFormatsCache::stats() const
+{
+    Stats st;
+    for(auto &sp : m_shards)
+    {
+        std::lock_guard<std::mutex> guard(sp->lock);
+        st.hits += sp->hits;
+        st.misses += sp->misses;
+        st.evictions += sp->evictions;
+        st.entries += sp->lru.size();
+        st.memoryUsage += sp->memoryUsage;
+    }
+    return st;
+}
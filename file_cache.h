@@ -0,0 +1,150 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*!
+ * \file file_cache.h
+ * \brief Contains a thread-safe cache of parsed level and world map files
+ */
+
+#pragma once
+#ifndef FILE_CACHE_H
+#define FILE_CACHE_H
+
+#include "pge_file_lib_globs.h"
+#include "lvl_filedata.h"
+#include "wld_filedata.h"
+
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <cstddef>
+
+/*!
+ * \brief Cache of parsed level and world map files
+ *
+ * Entries are keyed by the canonical file path, and validated by file size
+ * and modification time on every lookup, so a file changed on disk will be
+ * re-parsed. Parsed data is shared between callers as immutable handles:
+ * an entry evicted from the cache stays alive while anybody still holds it.
+ *
+ * Entries are spread over several independently locked shards, so lookups
+ * of different files from different threads don't serialize on a single lock.
+ * Every shard is an LRU list, the least recently used entries are evicted
+ * once the total estimated memory usage exceeds the budget.
+ */
+class FileFormatsCache
+{
+public:
+    //! Shared handle of immutable level data
+    typedef std::shared_ptr<const LevelData> LevelHandle;
+    //! Shared handle of immutable world map data
+    typedef std::shared_ptr<const WorldData> WorldHandle;
+
+    /*!
+     * \brief Cache usage statistics
+     */
+    struct Stats
+    {
+        //! Number of lookups served from the cache
+        unsigned long hits = 0;
+        //! Number of lookups which required parsing of the file
+        unsigned long misses = 0;
+        //! Number of entries dropped to fit the memory budget
+        unsigned long evictions = 0;
+        //! Number of entries currently held
+        size_t entries = 0;
+        //! Estimated memory currently held by cached entries in bytes
+        size_t memoryUsage = 0;
+    };
+
+    /*!
+     * \brief Constructor
+     * \param memoryBudget Maximum estimated memory held by the cache in bytes
+     * \param shards Number of independently locked shards (at least one)
+     */
+    explicit FileFormatsCache(size_t memoryBudget = 64 * 1024 * 1024, unsigned int shards = 16);
+    ~FileFormatsCache();
+
+    FileFormatsCache(const FileFormatsCache &) = delete;
+    FileFormatsCache &operator=(const FileFormatsCache &) = delete;
+
+    /*!
+     * \brief Opens a level file through the cache
+     * \param [__in] filePath Path to the level file of any supported format
+     * \return Handle to the level data, never null. Check the meta.ReadFileValid
+     *         field: broken files are returned with an error info but never cached
+     */
+    LevelHandle openLevel(const PGESTRING &filePath);
+    /*!
+     * \brief Opens a world map file through the cache
+     * \param [__in] filePath Path to the world map file of any supported format
+     * \return Handle to the world data, never null. Check the meta.ReadFileValid
+     *         field: broken files are returned with an error info but never cached
+     */
+    WorldHandle openWorld(const PGESTRING &filePath);
+
+    /*!
+     * \brief Drops cached data of the given file
+     * \param [__in] filePath Path to the level or world map file
+     */
+    void invalidate(const PGESTRING &filePath);
+    /*!
+     * \brief Drops all cached data
+     */
+    void clear();
+
+    /*!
+     * \brief Changes the memory budget, evicts entries which no longer fit
+     * \param memoryBudget Maximum estimated memory held by the cache in bytes
+     */
+    void setMemoryBudget(size_t memoryBudget);
+    /*!
+     * \brief Current memory budget
+     * \return Maximum estimated memory held by the cache in bytes
+     */
+    size_t memoryBudget() const;
+
+    /*!
+     * \brief Collects usage statistics from all shards
+     * \return Cache usage statistics
+     */
+    Stats stats() const;
+
+private:
+    struct Shard;
+    Shard &shardFor(const std::string &key);
+    std::shared_ptr<const void> find(const std::string &key, int64_t size, int64_t mtime);
+    void insert(const std::string &key, int64_t size, int64_t mtime,
+                const std::shared_ptr<const void> &data, size_t bytes);
+    void trim();
+
+    std::atomic<size_t> m_memoryBudget;
+    std::atomic<size_t> m_memoryUsage;
+    std::atomic<uint64_t> m_tick;
+    std::vector<std::unique_ptr<Shard> > m_shards;
+};
+
+#endif // FILE_CACHE_H
@@ -39,6 +39,9 @@
 #include "save_filedata.h"
 #include "smbx64_cnf_filedata.h"
 
+class PGE_StringPool;
+class PGE_ParseObserver;
+
 #ifdef __GNUC__
 #define DEPRECATED(func) func __attribute__ ((deprecated))
 #elif defined(_MSC_VER)
@@ -404,6 +407,52 @@ public:
      */
     static bool WriteExtendedLvlFile(PGE_FileFormats_misc::TextOutput &out, LevelData /*output*/ &FileData);
 
+    /******************************Binary level cache***********************************/
+    /*!
+     * \brief Calculates a fast non-cryptographic 64-bit hash of the data
+     * \param [__in] data Pointer to the data
+     * \param [__in] size Size of the data in bytes
+     * \param [__in] seed Initial value of the hash
+     * \return 64-bit hash
+     */
+    static uint64_t Hash64(const char *data, size_t size, uint64_t seed = 0);
+    /*!
+     * \brief Serializes the fully parsed level data into the compact binary blob
+     * \param [__in] FileData Level data structure
+     * \param [__out] out Binary blob
+     * \param [__in] sourceHash Hash of the source file data the level was parsed from
+     * \return true if data successfully serialized
+     */
+    static bool WriteLevelBinary(const LevelData &FileData, std::string &out, uint64_t sourceHash = 0);
+    /*!
+     * \brief Restores the level data from the binary blob made by WriteLevelBinary()
+     * \param [__in] in Binary blob
+     * \param [__out] FileData Level data structure
+     * \param [__out] sourceHash Hash of the source file data stored in the blob (optional)
+     * \return true if blob is valid and has the supported version, false if error occouped
+     */
+    static bool ReadLevelBinary(const std::string &in, LevelData &FileData, uint64_t *sourceHash = nullptr);
+    /*!
+     * \brief Parses a level file with auto-detection of a file type through the binary cache.
+     *        Cache entries are keyed by the hash of the file data (and of the .meta file if exists),
+     *        on cache miss the file gets parsed and the result gets stored in the cache directory.
+     * \param [__in] filePath Full path to file which must be opened
+     * \param [__in] cacheDir Path to the directory with cache entries, must exist
+     * \param [__out] FileData Level data structure
+     * \return true if file successfully opened and parsed, false if error occouped
+     */
+    static bool OpenLevelFileCached(const PGESTRING &filePath, const PGESTRING &cacheDir, LevelData &FileData);
+    /*!
+     * \brief Sets the directory which OpenLevelFile() consults before parsing of the level file
+     * \param [__in] cacheDir Path to the directory with cache entries, empty string disables the cache
+     */
+    static void SetLevelCacheDirectory(const PGESTRING &cacheDir);
+    /*!
+     * \brief Gives the directory which OpenLevelFile() consults before parsing of the level file
+     * \return Path to the directory with cache entries, empty if cache is disabled
+     */
+    static PGESTRING LevelCacheDirectory();
+
     // Lvl Data
     /*!
      * \brief Generates blank initialized level data structure
@@ -484,6 +533,51 @@ public:
      * \param FileData initalized and filled level file
      */
     static void             LevelAddInternalEvents(LevelData &FileData);
+    /*!
+     * \brief Fills lookup tables of layer and event names and resolves
+     *        layer and event references of all elements into indices
+     * \param [__inout] lvl Level data structure object
+     */
+    static void             LevelResolveReferences(LevelData &lvl);
+    /*!
+     * \brief Enables resolving of layer and event references by OpenLevelFile() and OpenLevelRaw()
+     * \param [__in] enabled Resolve references after every successful level load
+     */
+    static void             SetLevelResolveReferences(bool enabled);
+    /*!
+     * \brief Are layer and event references resolved on level load
+     * \return true if enabled
+     */
+    static bool             LevelResolveReferencesEnabled();
+#ifdef PGE_FILES_QT
+    /*!
+     * \brief Sets the string pool which OpenLevelFile(), OpenLevelRaw(), OpenWorldFile()
+     *        and OpenWorldRaw() use to intern strings of every loaded file
+     * \param [__in] pool String pool, nullptr disables interning. Pool must outlive its use by readers
+     *
+     * Available in Qt mode only: std::string can't share its storage, so in STL mode
+     * the interning would only cost the time and the memory of pooled copies.
+     */
+    static void             SetStringPool(PGE_StringPool *pool);
+    /*!
+     * \brief Gives the string pool used by readers
+     * \return String pool, or nullptr if interning is disabled
+     */
+    static PGE_StringPool  *StringPool();
+#endif
+    /*!
+     * \brief Sets the observer which receives per-phase timings and counters
+     *        of file readers running in the calling thread
+     * \param [__in] observer Observer, nullptr disables reporting. Observer must outlive its use by readers
+     *
+     * Reports are produced only when the library is built with PGE_FILES_PARSE_STATS definition
+     */
+    static void             SetParseObserver(PGE_ParseObserver *observer);
+    /*!
+     * \brief Gives the observer of file readers attached to the calling thread
+     * \return Observer, or nullptr if none attached
+     */
+    static PGE_ParseObserver *ParseObserver();
     /*!
      * \brief Optimizing level data for SMBX64 Standard requirements
      * \param [__inout] lvl Level data structure object
@@ -850,6 +944,26 @@ public:
      * \param [__inout] wld World map data structure object
      */
     static void                WorldPrepare(WorldData &wld);
+    /*!
+     * \brief Enables building of the spatial index by world map readers
+     * \param [__in] enabled Build WorldData::spatial_index after every successful world map load
+     */
+    static void                SetWorldBuildSpatialIndex(bool enabled);
+    /*!
+     * \brief Is the spatial index built on world map load
+     * \return true if enabled
+     */
+    static bool                WorldBuildSpatialIndexEnabled();
+    /*!
+     * \brief Enables building of the path graph by world map readers
+     * \param [__in] enabled Build WorldData::path_graph after every successful world map load
+     */
+    static void                SetWorldBuildPathGraph(bool enabled);
+    /*!
+     * \brief Is the path graph built on world map load
+     * \return true if enabled
+     */
+    static bool                WorldBuildPathGraphEnabled();
 
 
     /****************************Save of game file********************************/
@@ -922,6 +1036,32 @@ public:
      * \return true if file successfully saved, false if error occouped
      */
     static bool WriteExtendedSaveFile(PGE_FileFormats_misc::TextOutput &out, GamesaveData &FileData);
+    /*!
+     * \brief Saves changes of the game save by appending them to the journal of PGE-X game save file
+     * \param [__in] filePath Target file path, the file must contain the savedState
+     * \param [__inout] savedState State stored in the file, gets replaced with the new state
+     * \param [__inout] FileData New game save state
+     * \param [__in] maxRecords Maximum number of journal records, the whole file is rewritten once it's exceeded
+     * \return true if file successfully saved, false if error occouped
+     *
+     * Changes are written as compact records which are replayed by the ReadExtendedSaveFile().
+     * When the change can't be expressed by records (for example, elements were reordered)
+     * or journal gets too long, the whole file gets rewritten without a journal.
+     * The reader ignores the last journal section if the append was interrupted before
+     * its end, the next append rewrites such file.
+     */
+    static bool AppendExtendedSaveJournalF(const PGESTRING &filePath, GamesaveData &savedState,
+                                           GamesaveData &FileData, unsigned long maxRecords = 512);
+    /*!
+     * \brief Saves changes of the game save by appending them to the journal of PGE-X game save raw data
+     * \param [__inout] savedState State stored in the raw data, gets replaced with the new state
+     * \param [__inout] FileData New game save state
+     * \param [__inout] rawdata Raw data string in PGE-X Game save format which contains the savedState
+     * \param [__in] maxRecords Maximum number of journal records, the whole data is rewritten once it's exceeded
+     * \return true if data successfully saved, false if error occouped
+     */
+    static bool AppendExtendedSaveJournalRaw(GamesaveData &savedState, GamesaveData &FileData,
+                                             PGESTRING &rawdata, unsigned long maxRecords = 512);
 
     //Save Data
     /*!
@@ -30,6 +30,8 @@
 #include "smbx64.h"
 #include "smbx64_macro.h"
 #include "CSVUtils.h"
+#include "pge_parse_stats_private.h"
+#include "pge_arena_private.h"
 
 
 //*********************************************************
@@ -169,10 +171,12 @@ bool FileFormats::ReadSMBX64LvlFileRaw(PGESTRING &rawdata, const PGESTRING &file
 
 bool FileFormats::ReadSMBX64LvlFile(PGE_FileFormats_misc::TextInput &in, LevelData &FileData)
 {
+    PGE_STATS_BEGIN("SMBX64 LVL", PHASE_FIELDS);
     SMBX64_FileBegin();
     PGESTRING filePath = in.getFilePath();
     //SMBX64_File( RawData );
     int i;                  //counters
+    PGE_ArenaStaging arenaStaging(FileData);
     CreateLevelData(FileData);
     FileData.meta.RecentFormat = LevelData::SMBX64;
     FileData.meta.RecentFormatVersion = 64;
@@ -284,9 +288,9 @@ bool FileFormats::ReadSMBX64LvlFile(PGE_FileFormats_misc::TextInput &in, LevelDa
             section.id = i;
 
             if(i < static_cast<signed>(FileData.sections.size()))
-                FileData.sections[static_cast<pge_size_t>(i)] = section; //Replace if already exists
+                FileData.sections[static_cast<pge_size_t>(i)] = std::move(section); //Replace if already exists
             else
-                FileData.sections.push_back(section); //Add Section in main array
+                FileData.sections.push_back(std::move(section)); //Add Section in main array
         }
 
         if(lt(8))
@@ -296,9 +300,9 @@ bool FileFormats::ReadSMBX64LvlFile(PGE_FileFormats_misc::TextInput &in, LevelDa
                 section.id = i;
 
                 if(i < static_cast<signed>(FileData.sections.size()))
-                    FileData.sections[static_cast<pge_size_t>(i)] = section; //Replace if already exists
+                    FileData.sections[static_cast<pge_size_t>(i)] = std::move(section); //Replace if already exists
                 else
-                    FileData.sections.push_back(section); //Add Section in main array
+                    FileData.sections.push_back(std::move(section)); //Add Section in main array
             }
 
         //Player's point config
@@ -316,7 +320,7 @@ bool FileFormats::ReadSMBX64LvlFile(PGE_FileFormats_misc::TextInput &in, LevelDa
             players.id = static_cast<unsigned int>(i) + 1u;
 
             if(players.x != 0 && players.y != 0 && players.w != 0 && players.h != 0) //Don't add into array non-exist point
-                FileData.players.push_back(players);    //Add player in array
+                FileData.players.push_back(std::move(players));    //Add player in array
         }
 
         ////////////Block Data//////////
@@ -411,7 +415,7 @@ bool FileFormats::ReadSMBX64LvlFile(PGE_FileFormats_misc::TextInput &in, LevelDa
 
             blocks.meta.array_id = FileData.blocks_array_id++;
             blocks.meta.index = static_cast<unsigned int>(FileData.blocks.size()); //Apply element index
-            FileData.blocks.push_back(blocks); //AddBlock into array
+            FileData.blocks.push_back(std::move(blocks)); //AddBlock into array
             nextLine();
         }
 
@@ -443,7 +447,7 @@ bool FileFormats::ReadSMBX64LvlFile(PGE_FileFormats_misc::TextInput &in, LevelDa
 
             bgodata.meta.array_id = FileData.bgo_array_id++;
             bgodata.meta.index = static_cast<unsigned int>(FileData.bgo.size()); //Apply element index
-            FileData.bgo.push_back(bgodata); //Add Background object into array
+            FileData.bgo.push_back(std::move(bgodata)); //Add Background object into array
             nextLine();
         }
 
@@ -597,7 +601,7 @@ bool FileFormats::ReadSMBX64LvlFile(PGE_FileFormats_misc::TextInput &in, LevelDa
             }
             npcdata.meta.array_id = FileData.npc_array_id++;
             npcdata.meta.index = static_cast<unsigned>(FileData.npc.size()); //Apply element index
-            FileData.npc.push_back(npcdata); //Add NPC into array
+            FileData.npc.push_back(std::move(npcdata)); //Add NPC into array
             nextLine();
         }
 
@@ -682,7 +686,7 @@ bool FileFormats::ReadSMBX64LvlFile(PGE_FileFormats_misc::TextInput &in, LevelDa
 
             doors.meta.array_id = FileData.doors_array_id++;
             doors.meta.index = static_cast<unsigned>(FileData.doors.size()); //Apply element index
-            FileData.doors.push_back(doors); //Add NPC into array
+            FileData.doors.push_back(std::move(doors)); //Add NPC into array
             nextLine();
         }
 
@@ -714,7 +718,7 @@ bool FileFormats::ReadSMBX64LvlFile(PGE_FileFormats_misc::TextInput &in, LevelDa
                 SMBX64::ReadStr(&waters.layer, line);
                 waters.meta.array_id = FileData.physenv_array_id++;
                 waters.meta.index = static_cast<unsigned>(FileData.physez.size()); //Apply element index
-                FileData.physez.push_back(waters); //Add Water area into array
+                FileData.physez.push_back(std::move(waters)); //Add Water area into array
                 nextLine();
             }
         }
@@ -874,7 +878,7 @@ bool FileFormats::ReadSMBX64LvlFile(PGE_FileFormats_misc::TextInput &in, LevelDa
                         mvl.name = events.movelayer;
                         mvl.speed_x = events.layer_speed_x;
                         mvl.speed_y = events.layer_speed_y;
-                        events.moving_layers.push_back(mvl);
+                        events.moving_layers.push_back(std::move(mvl));
                     }
                 }
 
@@ -901,13 +905,18 @@ bool FileFormats::ReadSMBX64LvlFile(PGE_FileFormats_misc::TextInput &in, LevelDa
                 }
 
                 events.meta.array_id = FileData.events_array_id++;
-                FileData.events.push_back(events);
+                FileData.events.push_back(std::move(events));
                 nextLine();
             }
         }
 
+        PGE_STATS_COUNT("bytes", in.tell());
+        PGE_STATS_COUNT("lines", in.getCurrentLineNumber());
+        PGE_STATS_COUNT_LEVEL(FileData);
+        PGE_STATS_PHASE(PHASE_POSTPROCESS);
         LevelAddInternalEvents(FileData);
         ///////////////////////////////////////EndFile///////////////////////////////////////
+        arenaStaging.commit(FileData);
         FileData.meta.ReadFileValid = true;
         return true;
     }
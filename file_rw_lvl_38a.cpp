@@ -29,6 +29,8 @@
 #include "file_strlist.h"
 
 #include "smbx38a_private.h"
+#include "pge_parse_stats_private.h"
+#include "pge_arena_private.h"
 
 
 /***********  Pre-defined values dependent to NPC Generator Effect field value  **************/
@@ -154,7 +156,7 @@ bool FileFormats::ReadSMBX38ALvlFileHeaderT(PGE_FileFormats_misc::TextInput &inf
                         mo.type = LevelData::MusicOverrider::SPECIAL;
                         mo.id = (i + 1);
                         mo.fileName = s[i];
-                        FileData.music_overrides.push_back(mo);
+                        FileData.music_overrides.push_back(std::move(mo));
                     }
                 }
             }
@@ -242,9 +244,11 @@ struct LevelEvent_layers
 /**********************************************************************************************/
 bool FileFormats::ReadSMBX38ALvlFile(PGE_FileFormats_misc::TextInput &in, LevelData &FileData)
 {
+    PGE_STATS_BEGIN("SMBX-38A LVL", PHASE_FIELDS);
     SMBX38A_FileBeginN();
     PGESTRING filePath = in.getFilePath();
     FileData.meta.ERROR_info.clear();
+    PGE_ArenaStaging arenaStaging(FileData);
     CreateLevelData(FileData);
     FileData.meta.RecentFormat = LevelData::SMBX38A;
     FileData.meta.RecentFormatVersion = latest_version_38a;
@@ -348,7 +352,7 @@ bool FileFormats::ReadSMBX38ALvlFile(PGE_FileFormats_misc::TextInput &in, LevelD
                         mo.type = LevelData::MusicOverrider::SPECIAL;
                         mo.id = (i + 1);
                         mo.fileName = s[i];
-                        FileData.music_overrides.push_back(mo);
+                        FileData.music_overrides.push_back(std::move(mo));
                     }
                 }
             }
@@ -372,7 +376,7 @@ bool FileFormats::ReadSMBX38ALvlFile(PGE_FileFormats_misc::TextInput &in, LevelD
                 // P1|x1|y1
                 playerdata = CreateLvlPlayerPoint(1);
                 dataReader.ReadDataLine(CSVDiscard(), &playerdata.x, &playerdata.y);
-                FileData.players.push_back(playerdata);
+                FileData.players.push_back(std::move(playerdata));
             }
             else if(identifier == "P2")
             {
@@ -380,7 +384,7 @@ bool FileFormats::ReadSMBX38ALvlFile(PGE_FileFormats_misc::TextInput &in, LevelD
                 // FIXME: Copy from above (can be solved with switch?)
                 playerdata = CreateLvlPlayerPoint(2);
                 dataReader.ReadDataLine(CSVDiscard(), &playerdata.x, &playerdata.y);
-                FileData.players.push_back(playerdata);
+                FileData.players.push_back(std::move(playerdata));
             }
             else if(identifier == "M")
             {
@@ -445,9 +449,9 @@ bool FileFormats::ReadSMBX38ALvlFile(PGE_FileFormats_misc::TextInput &in, LevelD
                 section.PositionY = section.size_top - 10;
 
                 if(section.id < static_cast<signed>(FileData.sections.size()))
-                    FileData.sections[static_cast<pge_size_t>(section.id)] = section;//Replace if already exists
+                    FileData.sections[static_cast<pge_size_t>(section.id)] = std::move(section);//Replace if already exists
                 else
-                    FileData.sections.push_back(section); //Add Section in main array
+                    FileData.sections.push_back(std::move(section)); //Add Section in main array
             }
             else if(identifier == "B")
             {
@@ -511,7 +515,7 @@ bool FileFormats::ReadSMBX38ALvlFile(PGE_FileFormats_misc::TextInput &in, LevelD
                 if(blockdata.w < 0)
                     blockdata.w *= -1;
                 blockdata.meta.array_id = FileData.blocks_array_id++;
-                FileData.blocks.push_back(blockdata);
+                FileData.blocks.push_back(std::move(blockdata));
             }
             else if(identifier == "T")
             {
@@ -527,7 +531,7 @@ bool FileFormats::ReadSMBX38ALvlFile(PGE_FileFormats_misc::TextInput &in, LevelD
                                         &bgodata.x,
                                         &bgodata.y);
                 bgodata.meta.array_id = FileData.bgo_array_id++;
-                FileData.bgo.push_back(bgodata);
+                FileData.bgo.push_back(std::move(bgodata));
             }
             else if(identifier == "N")
             {
@@ -674,7 +678,7 @@ bool FileFormats::ReadSMBX38ALvlFile(PGE_FileFormats_misc::TextInput &in, LevelD
                                            PGE_FileLibrary::TimeUnit::FrameOneOf65sec,
                                            PGE_FileLibrary::TimeUnit::Decisecond);
                 npcdata.meta.array_id = FileData.npc_array_id++;
-                FileData.npc.push_back(npcdata);
+                FileData.npc.push_back(std::move(npcdata));
             }
             else if(identifier == "Q")
             {
@@ -698,7 +702,7 @@ bool FileFormats::ReadSMBX38ALvlFile(PGE_FileFormats_misc::TextInput &in, LevelD
                 MakeCSVPostProcessor(&phyEnv.touch_event, PGEUrlDecodeFunc)
                                        );
                 phyEnv.meta.array_id = FileData.physenv_array_id++;
-                FileData.physez.push_back(phyEnv);
+                FileData.physez.push_back(std::move(phyEnv));
             }
             else if(identifier == "W")
             {
@@ -812,7 +816,7 @@ bool FileFormats::ReadSMBX38ALvlFile(PGE_FileFormats_misc::TextInput &in, LevelD
                 if(doordata.cannon_exit_speed <= 0)
                     doordata.cannon_exit_speed = 10.0;
                 doordata.meta.array_id = FileData.doors_array_id++;
-                FileData.doors.push_back(doordata);
+                FileData.doors.push_back(std::move(doordata));
             }
             else if(identifier == "L")
             {
@@ -823,7 +827,7 @@ bool FileFormats::ReadSMBX38ALvlFile(PGE_FileFormats_misc::TextInput &in, LevelD
                                         MakeCSVPostProcessor(&layerdata.hidden, PGEFilpBool)
                                        );
                 layerdata.meta.array_id = FileData.layers_array_id++;
-                FileData.layers.push_back(layerdata);
+                FileData.layers.push_back(std::move(layerdata));
             }
             else if(identifier == "E")
             {
@@ -837,7 +841,7 @@ bool FileFormats::ReadSMBX38ALvlFile(PGE_FileFormats_misc::TextInput &in, LevelD
                 {
                     LevelEvent_Sets set;
                     set.id = static_cast<long>(q);
-                    eventdata.sets.push_back(set);
+                    eventdata.sets.push_back(std::move(set));
                 }
 
                 // Temp Field 11
@@ -973,7 +977,7 @@ bool FileFormats::ReadSMBX38ALvlFile(PGE_FileFormats_misc::TextInput &in, LevelD
                                 SMBX64::ReadSInt(&stop.y, raw_data[pe + 1]);
                                 SMBX64::ReadSInt(&stop.type, raw_data[pe + 2]);
                                 SMBX64::ReadSInt(&stop.speed, raw_data[pe + 3]);
-                                nextSet.autoscroll_path.push_back(stop);
+                                nextSet.autoscroll_path.push_back(std::move(stop));
                             }
                             nextSet.expression_autoscrool_x.clear();
                         }
@@ -1104,7 +1108,7 @@ bool FileFormats::ReadSMBX38ALvlFile(PGE_FileFormats_misc::TextInput &in, LevelD
                         SMBX38A_Exp2Int(effect.expression_y, effect.y);
                         SMBX38A_Exp2Double(effect.expression_sx, effect.speed_x);
                         SMBX38A_Exp2Double(effect.expression_sy, effect.speed_y);
-                        eventdata.spawn_effects.push_back(effect);
+                        eventdata.spawn_effects.push_back(std::move(effect));
                         break;
                     }
                 }),
@@ -1125,7 +1129,7 @@ bool FileFormats::ReadSMBX38ALvlFile(PGE_FileFormats_misc::TextInput &in, LevelD
                     SMBX38A_Exp2Int(spawnnpc.expression_y, spawnnpc.y);
                     SMBX38A_Exp2Double(spawnnpc.expression_sx, spawnnpc.speed_x);
                     SMBX38A_Exp2Double(spawnnpc.expression_sy, spawnnpc.speed_y);
-                    eventdata.spawn_npc.push_back(spawnnpc);
+                    eventdata.spawn_npc.push_back(std::move(spawnnpc));
                 }),
                 // evc=vc1/vc2...vcn
                 MakeCSVIterator(dataReader, '/', [&eventdata](const PGESTRING & nextFieldStr)
@@ -1136,7 +1140,7 @@ bool FileFormats::ReadSMBX38ALvlFile(PGE_FileFormats_misc::TextInput &in, LevelD
                     fullReader.ReadDataLine(MakeCSVPostProcessor(&updVar.name, PGEUrlDecodeFunc),
                                             MakeCSVPostProcessor(&updVar.newval, PGEUrlDecodeFunc)
                                            );
-                    eventdata.update_variable.push_back(updVar);
+                    eventdata.update_variable.push_back(std::move(updVar));
                 }),
                 // ene=nextevent/timer/apievent/scriptname
                 MakeCSVSubReader(dataReader, '/',
@@ -1162,7 +1166,7 @@ bool FileFormats::ReadSMBX38ALvlFile(PGE_FileFormats_misc::TextInput &in, LevelD
                                                PGE_FileLibrary::TimeUnit::FrameOneOf65sec,
                                                PGE_FileLibrary::TimeUnit::Millisecond);
                 eventdata.meta.array_id = FileData.events_array_id++;
-                FileData.events.push_back(eventdata);
+                FileData.events.push_back(std::move(eventdata));
             }
             else if(identifier == "V")
             {
@@ -1174,7 +1178,7 @@ bool FileFormats::ReadSMBX38ALvlFile(PGE_FileFormats_misc::TextInput &in, LevelD
                                                           because in PGE is planned to have
                                                           variables to be universal */
                                        );
-                FileData.variables.push_back(vardata);
+                FileData.variables.push_back(std::move(vardata));
             }
             else if(identifier == "R")
             {
@@ -1189,7 +1193,7 @@ bool FileFormats::ReadSMBX38ALvlFile(PGE_FileFormats_misc::TextInput &in, LevelD
                     fullReader.ReadDataLine(
                             MakeCSVPostProcessor(&arr.name, PGEUrlDecodeFunc)
                     );
-                    FileData.arrays.push_back(arr);
+                    FileData.arrays.push_back(std::move(arr));
                 });
             }
             else if(identifier == "S")
@@ -1200,7 +1204,7 @@ bool FileFormats::ReadSMBX38ALvlFile(PGE_FileFormats_misc::TextInput &in, LevelD
                                         MakeCSVPostProcessor(&scriptdata.name, PGEUrlDecodeFunc),
                                         MakeCSVPostProcessor(&scriptdata.script, PGEBase64DecodeFunc)
                                        );
-                FileData.scripts.push_back(scriptdata);
+                FileData.scripts.push_back(std::move(scriptdata));
             }
             else if(identifier == "Su")
             {
@@ -1212,7 +1216,7 @@ bool FileFormats::ReadSMBX38ALvlFile(PGE_FileFormats_misc::TextInput &in, LevelD
                                        );
                 //Convert to LF
                 PGE_ReplSTRING(scriptdata.script, "\r\n", "\n");
-                FileData.scripts.push_back(scriptdata);
+                FileData.scripts.push_back(std::move(scriptdata));
             }
             else if((identifier == "CB") || (identifier == "CT") || (identifier == "CE") )
             {
@@ -1232,10 +1236,10 @@ bool FileFormats::ReadSMBX38ALvlFile(PGE_FileFormats_misc::TextInput &in, LevelD
                 {
                     LevelItemSetup38A::Entry e;
                     SMBX38A_CC_decode(e.key, e.value, nextFieldStr);
-                    customcfg.data.push_back(e);
+                    customcfg.data.push_back(std::move(e));
                 })
                                        );
-                FileData.custom38A_configs.push_back(customcfg);
+                FileData.custom38A_configs.push_back(std::move(customcfg));
             }
             else if(identifier == "CW")
             {
@@ -1251,7 +1255,7 @@ bool FileFormats::ReadSMBX38ALvlFile(PGE_FileFormats_misc::TextInput &in, LevelD
                     fullReader.ReadDataLine(&mo.id,
                                             MakeCSVPostProcessor(&mo.fileName, PGEUrlDecodeFunc)
                                            );
-                    FileData.sound_overrides.push_back(mo);
+                    FileData.sound_overrides.push_back(std::move(mo));
                 });
             }
             else
@@ -1259,7 +1263,7 @@ bool FileFormats::ReadSMBX38ALvlFile(PGE_FileFormats_misc::TextInput &in, LevelD
                 // Unsupported line, just keep it
                 PGESTRING str;
                 dataReader.ReadRawLine(str);
-                FileData.unsupported_38a_lines.push_back(str);
+                FileData.unsupported_38a_lines.push_back(std::move(str));
             }
         }//while is not EOF
     }
@@ -1317,9 +1321,14 @@ bool FileFormats::ReadSMBX38ALvlFile(PGE_FileFormats_misc::TextInput &in, LevelD
         return false;
     }
 
+    PGE_STATS_COUNT("bytes", in.tell());
+    PGE_STATS_COUNT("lines", in.getCurrentLineNumber());
+    PGE_STATS_COUNT_LEVEL(FileData);
+    PGE_STATS_PHASE(PHASE_POSTPROCESS);
     LevelAddInternalEvents(FileData);
     FileData.CurSection = 0;
     FileData.playmusic = 0;
+    arenaStaging.commit(FileData);
     FileData.meta.ReadFileValid = true;
     return true;
 #else // MSVC2015+
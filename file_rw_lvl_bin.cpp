@@ -0,0 +1,956 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "file_formats.h"
+#include "pge_string_pool.h"
+#include "pge_file_lib_private.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+
+/*
+ * Binary blob layout:
+ *
+ * - 8 bytes: magic "PGELVLB\0"
+ * - 4 bytes: format version
+ * - 8 bytes: hash of the source file data
+ * - 8 bytes: size of the payload
+ * - 8 bytes: hash of the payload
+ * - payload
+ *
+ * All fixed fields are little-endian. Integers of the payload are stored
+ * as zig-zag LEB128 variable-length numbers, floating point numbers are
+ * stored as raw IEEE-754 bits, strings as a length and UTF-8 bytes,
+ * lists as a length and elements.
+ */
+
+static const char     s_lvlBinMagic[8] = {'P', 'G', 'E', 'L', 'V', 'L', 'B', '\0'};
+//! Increase on any change of the payload layout or of the level data structure
+static const uint32_t s_lvlBinVersion = 1;
+static const size_t   s_lvlBinHeaderSize = 8 + 4 + 8 + 8 + 8;
+
+uint64_t FileFormats::Hash64(const char *data, size_t size, uint64_t seed)
+{
+    // MurmurHash64A by Austin Appleby (public domain)
+    const uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
+    uint64_t h = seed ^ (static_cast<uint64_t>(size) * m);
+
+    const char *end = data + (size & ~static_cast<size_t>(7));
+    for(const char *p = data; p != end; p += 8)
+    {
+        uint64_t k;
+        std::memcpy(&k, p, 8);
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+
+    const unsigned char *tail = reinterpret_cast<const unsigned char *>(end);
+    switch(size & 7)
+    {
+    case 7: h ^= static_cast<uint64_t>(tail[6]) << 48; /* fallthrough */
+    case 6: h ^= static_cast<uint64_t>(tail[5]) << 40; /* fallthrough */
+    case 5: h ^= static_cast<uint64_t>(tail[4]) << 32; /* fallthrough */
+    case 4: h ^= static_cast<uint64_t>(tail[3]) << 24; /* fallthrough */
+    case 3: h ^= static_cast<uint64_t>(tail[2]) << 16; /* fallthrough */
+    case 2: h ^= static_cast<uint64_t>(tail[1]) << 8;  /* fallthrough */
+    case 1: h ^= static_cast<uint64_t>(tail[0]);
+        h *= m;
+    default:
+        break;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+
+/*****************Primitive encoders***************************/
+
+class LvlBinWriter
+{
+public:
+    explicit LvlBinWriter(std::string &out) : m_out(out) {}
+
+    void fixed(uint64_t v, int bytes)
+    {
+        for(int i = 0; i < bytes; i++)
+            m_out.push_back(static_cast<char>((v >> (i * 8)) & 0xFF));
+    }
+
+    void varint(uint64_t v)
+    {
+        while(v >= 0x80)
+        {
+            m_out.push_back(static_cast<char>((v & 0x7F) | 0x80));
+            v >>= 7;
+        }
+        m_out.push_back(static_cast<char>(v));
+    }
+
+    void sint(int64_t v)
+    {
+        varint((static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+    }
+
+    void io(bool &v)
+    {
+        m_out.push_back(v ? 1 : 0);
+    }
+
+    void io(double &v)
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &v, 8);
+        fixed(bits, 8);
+    }
+
+    void io(float &v)
+    {
+        uint32_t bits;
+        std::memcpy(&bits, &v, 4);
+        fixed(bits, 4);
+    }
+
+    void io(PGESTRING &v)
+    {
+#ifdef PGE_FILES_QT
+        QByteArray u = v.toUtf8();
+        varint(static_cast<uint64_t>(u.size()));
+        m_out.append(u.constData(), static_cast<size_t>(u.size()));
+#else
+        varint(v.size());
+        m_out.append(v);
+#endif
+    }
+
+    template<class T>
+    void io(T &v)
+    {
+        static_assert(std::is_integral<T>::value || std::is_enum<T>::value, "Unsupported type");
+        sint(static_cast<int64_t>(v));
+    }
+
+    template<class T>
+    void size(T &list)
+    {
+        varint(static_cast<uint64_t>(list.size()));
+    }
+
+    bool ok() const
+    {
+        return true;
+    }
+
+private:
+    std::string &m_out;
+};
+
+class LvlBinReader
+{
+public:
+    LvlBinReader(const char *data, size_t size) :
+        m_cur(data), m_end(data + size)
+    {}
+
+    uint64_t fixed(int bytes)
+    {
+        if(m_end - m_cur < bytes)
+            return fail();
+        uint64_t v = 0;
+        for(int i = 0; i < bytes; i++)
+            v |= static_cast<uint64_t>(static_cast<unsigned char>(*m_cur++)) << (i * 8);
+        return v;
+    }
+
+    uint64_t varint()
+    {
+        uint64_t v = 0;
+        for(int shift = 0; shift < 64; shift += 7)
+        {
+            if(m_cur == m_end)
+                return fail();
+            unsigned char c = static_cast<unsigned char>(*m_cur++);
+            v |= static_cast<uint64_t>(c & 0x7F) << shift;
+            if(!(c & 0x80))
+                return v;
+        }
+        return fail();
+    }
+
+    int64_t sint()
+    {
+        uint64_t v = varint();
+        return static_cast<int64_t>((v >> 1) ^ (~(v & 1) + 1));
+    }
+
+    void io(bool &v)
+    {
+        v = (fixed(1) != 0);
+    }
+
+    void io(double &v)
+    {
+        uint64_t bits = fixed(8);
+        std::memcpy(&v, &bits, 8);
+    }
+
+    void io(float &v)
+    {
+        uint32_t bits = static_cast<uint32_t>(fixed(4));
+        std::memcpy(&v, &bits, 4);
+    }
+
+    void io(PGESTRING &v)
+    {
+        uint64_t len = varint();
+        if(len > static_cast<uint64_t>(m_end - m_cur))
+        {
+            fail();
+            return;
+        }
+#ifdef PGE_FILES_QT
+        v = QString::fromUtf8(m_cur, static_cast<int>(len));
+#else
+        v.assign(m_cur, static_cast<size_t>(len));
+#endif
+        m_cur += len;
+    }
+
+    template<class T>
+    void io(T &v)
+    {
+        static_assert(std::is_integral<T>::value || std::is_enum<T>::value, "Unsupported type");
+        v = static_cast<T>(sint());
+    }
+
+    template<class T>
+    void size(T &list)
+    {
+        uint64_t count = varint();
+        // Every element takes at least one byte, a bigger count is a damaged blob
+        if(count > static_cast<uint64_t>(m_end - m_cur))
+        {
+            fail();
+            count = 0;
+        }
+        list.clear();
+#ifdef PGE_FILES_QT
+        list.reserve(static_cast<int>(count));
+        for(uint64_t i = 0; i < count; i++)
+            list.push_back(typename T::value_type());
+#else
+        list.resize(static_cast<size_t>(count));
+#endif
+    }
+
+    bool ok() const
+    {
+        return m_ok;
+    }
+
+    bool atEnd() const
+    {
+        return m_cur == m_end;
+    }
+
+private:
+    uint64_t fail()
+    {
+        m_ok = false;
+        m_cur = m_end;
+        return 0;
+    }
+
+    const char *m_cur;
+    const char *m_end;
+    bool m_ok = true;
+};
+
+
+/*****************Structures***************************/
+
+template<class IO, class List>
+static void lvlBinList(IO &s, List &list)
+{
+    s.size(list);
+    for(auto &e : list)
+        lvlBin(s, e);
+}
+
+template<class IO>
+static void lvlBin(IO &s, PGESTRING &v)
+{
+    s.io(v);
+}
+
+template<class IO>
+static void lvlBin(IO &s, ElementMeta &v)
+{
+    s.io(v.array_id);
+    s.io(v.index);
+    s.io(v.custom_params);
+}
+
+template<class IO>
+static void lvlBin(IO &s, FileFormatMeta &v)
+{
+    s.io(v.ReadFileValid);
+    s.io(v.ERROR_info);
+    s.io(v.ERROR_linedata);
+    s.io(v.ERROR_linenum);
+    s.io(v.RecentFormat);
+    s.io(v.RecentFormatVersion);
+    s.io(v.modified);
+    s.io(v.untitled);
+    s.io(v.smbx64strict);
+    s.io(v.filename);
+    s.io(v.path);
+    s.io(v.configPackId);
+}
+
+template<class IO>
+static void lvlBin(IO &s, Bookmark &v)
+{
+    s.io(v.bookmarkName);
+    s.io(v.x);
+    s.io(v.y);
+}
+
+template<class IO>
+static void lvlBin(IO &s, MetaData &v)
+{
+    lvlBinList(s, v.bookmarks);
+    s.io(v.crash.used);
+    s.io(v.crash.untitled);
+    s.io(v.crash.modifyed);
+    s.io(v.crash.strictModeSMBX64);
+    s.io(v.crash.fmtID);
+    s.io(v.crash.fmtVer);
+    s.io(v.crash.fullPath);
+    s.io(v.crash.path);
+    s.io(v.crash.filename);
+    lvlBin(s, v.meta);
+}
+
+template<class IO>
+static void lvlBin(IO &s, LevelData::MusicOverrider &v)
+{
+    s.io(v.type);
+    s.io(v.id);
+    s.io(v.fileName);
+}
+
+template<class IO>
+static void lvlBin(IO &s, LevelSection &v)
+{
+    s.io(v.id);
+    s.io(v.size_top);
+    s.io(v.size_bottom);
+    s.io(v.size_left);
+    s.io(v.size_right);
+    s.io(v.music_id);
+    s.io(v.bgcolor);
+    s.io(v.wrap_h);
+    s.io(v.wrap_v);
+    s.io(v.OffScreenEn);
+    s.io(v.background);
+    s.io(v.lighting_value);
+    s.io(v.lock_left_scroll);
+    s.io(v.lock_right_scroll);
+    s.io(v.lock_up_scroll);
+    s.io(v.lock_down_scroll);
+    s.io(v.underwater);
+    s.io(v.music_file);
+    s.io(v.PositionX);
+    s.io(v.PositionY);
+    s.io(v.custom_params);
+}
+
+template<class IO>
+static void lvlBin(IO &s, PlayerPoint &v)
+{
+    s.io(v.id);
+    s.io(v.x);
+    s.io(v.y);
+    s.io(v.h);
+    s.io(v.w);
+    s.io(v.direction);
+}
+
+template<class IO>
+static void lvlBin(IO &s, LevelBlock &v)
+{
+    s.io(v.x);
+    s.io(v.y);
+    s.io(v.h);
+    s.io(v.w);
+    s.io(v.autoscale);
+    s.io(v.id);
+    s.io(v.npc_id);
+    s.io(v.npc_special_value);
+    s.io(v.invisible);
+    s.io(v.slippery);
+    s.io(v.motion_ai_id);
+    s.io(v.special_data);
+    s.io(v.special_data2);
+    s.io(v.layer);
+    s.io(v.gfx_name);
+    s.io(v.gfx_dx);
+    s.io(v.gfx_dy);
+    s.io(v.event_destroy);
+    s.io(v.event_hit);
+    s.io(v.event_emptylayer);
+    s.io(v.event_on_screen);
+    lvlBin(s, v.meta);
+}
+
+template<class IO>
+static void lvlBin(IO &s, LevelBGO &v)
+{
+    s.io(v.x);
+    s.io(v.y);
+    s.io(v.id);
+    s.io(v.layer);
+    s.io(v.gfx_dx);
+    s.io(v.gfx_dy);
+    s.io(v.z_mode);
+    s.io(v.z_offset);
+    s.io(v.smbx64_sp);
+    s.io(v.smbx64_sp_apply);
+    lvlBin(s, v.meta);
+}
+
+template<class IO>
+static void lvlBin(IO &s, LevelNPC &v)
+{
+    s.io(v.x);
+    s.io(v.y);
+    s.io(v.direct);
+    s.io(v.id);
+    s.io(v.gfx_name);
+    s.io(v.gfx_dx);
+    s.io(v.gfx_dy);
+    s.io(v.contents);
+    s.io(v.gfx_autoscale);
+    s.io(v.override_width);
+    s.io(v.override_height);
+    s.io(v.wings_type);
+    s.io(v.wings_style);
+    s.io(v.special_data);
+    s.io(v.special_data2);
+    s.io(v.generator);
+    s.io(v.generator_direct);
+    s.io(v.generator_type);
+    s.io(v.generator_period_orig_unit);
+    s.io(v.generator_period);
+    s.io(v.generator_period_orig);
+    s.io(v.generator_custom_angle);
+    s.io(v.generator_branches);
+    s.io(v.generator_angle_range);
+    s.io(v.generator_initial_speed);
+    s.io(v.msg);
+    s.io(v.friendly);
+    s.io(v.nomove);
+    s.io(v.is_boss);
+    s.io(v.layer);
+    s.io(v.event_activate);
+    s.io(v.event_die);
+    s.io(v.event_talk);
+    s.io(v.event_emptylayer);
+    s.io(v.event_grab);
+    s.io(v.event_nextframe);
+    s.io(v.event_touch);
+    s.io(v.attach_layer);
+    s.io(v.send_id_to_variable);
+    s.io(v.is_star);
+    lvlBin(s, v.meta);
+}
+
+template<class IO>
+static void lvlBin(IO &s, LevelDoor &v)
+{
+    s.io(v.ix);
+    s.io(v.iy);
+    s.io(v.isSetIn);
+    s.io(v.ox);
+    s.io(v.oy);
+    s.io(v.isSetOut);
+    s.io(v.idirect);
+    s.io(v.odirect);
+    s.io(v.type);
+    s.io(v.transition_effect);
+    s.io(v.lname);
+    s.io(v.warpto);
+    s.io(v.lvl_i);
+    s.io(v.lvl_o);
+    s.io(v.world_x);
+    s.io(v.world_y);
+    s.io(v.stars);
+    s.io(v.stars_msg);
+    s.io(v.star_num_hide);
+    s.io(v.layer);
+    s.io(v.unknown);
+    s.io(v.novehicles);
+    s.io(v.allownpc);
+    s.io(v.locked);
+    s.io(v.need_a_bomb);
+    s.io(v.hide_entering_scene);
+    s.io(v.allownpc_interlevel);
+    s.io(v.special_state_required);
+    s.io(v.length_i);
+    s.io(v.length_o);
+    s.io(v.event_enter);
+    s.io(v.two_way);
+    s.io(v.cannon_exit);
+    s.io(v.cannon_exit_speed);
+    s.io(v.stood_state_required);
+    lvlBin(s, v.meta);
+}
+
+template<class IO>
+static void lvlBin(IO &s, LevelPhysEnv &v)
+{
+    s.io(v.x);
+    s.io(v.y);
+    s.io(v.h);
+    s.io(v.w);
+    s.io(v.buoy);
+    s.io(v.env_type);
+    s.io(v.layer);
+    s.io(v.friction);
+    s.io(v.accel_direct);
+    s.io(v.accel);
+    s.io(v.max_velocity);
+    s.io(v.touch_event);
+    lvlBin(s, v.meta);
+}
+
+template<class IO>
+static void lvlBin(IO &s, LevelLayer &v)
+{
+    s.io(v.name);
+    s.io(v.hidden);
+    s.io(v.locked);
+    lvlBin(s, v.meta);
+}
+
+template<class IO>
+static void lvlBin(IO &s, LevelEvent_Sets::AutoScrollStopPoint &v)
+{
+    s.io(v.x);
+    s.io(v.y);
+    s.io(v.type);
+    s.io(v.speed);
+}
+
+template<class IO>
+static void lvlBin(IO &s, LevelEvent_Sets &v)
+{
+    s.io(v.id);
+    s.io(v.music_id);
+    s.io(v.music_file);
+    s.io(v.background_id);
+    s.io(v.position_left);
+    s.io(v.position_top);
+    s.io(v.position_bottom);
+    s.io(v.position_right);
+    s.io(v.expression_pos_x);
+    s.io(v.expression_pos_y);
+    s.io(v.expression_pos_w);
+    s.io(v.expression_pos_h);
+    s.io(v.autoscrol);
+    s.io(v.autoscroll_style);
+    s.io(v.autoscrol_x);
+    s.io(v.autoscrol_y);
+    lvlBinList(s, v.autoscroll_path);
+    s.io(v.expression_autoscrool_x);
+    s.io(v.expression_autoscrool_y);
+}
+
+template<class IO>
+static void lvlBin(IO &s, LevelEvent_MoveLayer &v)
+{
+    s.io(v.name);
+    s.io(v.speed_x);
+    s.io(v.speed_y);
+    s.io(v.expression_x);
+    s.io(v.expression_y);
+    s.io(v.way);
+}
+
+template<class IO>
+static void lvlBin(IO &s, LevelEvent_SpawnEffect &v)
+{
+    s.io(v.id);
+    s.io(v.x);
+    s.io(v.y);
+    s.io(v.expression_x);
+    s.io(v.expression_y);
+    s.io(v.speed_x);
+    s.io(v.speed_y);
+    s.io(v.expression_sx);
+    s.io(v.expression_sy);
+    s.io(v.gravity);
+    s.io(v.fps);
+    s.io(v.max_life_time);
+}
+
+template<class IO>
+static void lvlBin(IO &s, LevelEvent_SpawnNPC &v)
+{
+    s.io(v.id);
+    s.io(v.x);
+    s.io(v.y);
+    s.io(v.speed_x);
+    s.io(v.speed_y);
+    s.io(v.expression_x);
+    s.io(v.expression_y);
+    s.io(v.expression_sx);
+    s.io(v.expression_sy);
+    s.io(v.special);
+}
+
+template<class IO>
+static void lvlBin(IO &s, LevelEvent_UpdateVariable &v)
+{
+    s.io(v.name);
+    s.io(v.newval);
+}
+
+template<class IO>
+static void lvlBin(IO &s, LevelEvent_SetTimer &v)
+{
+    s.io(v.enable);
+    s.io(v.count);
+    s.io(v.interval);
+    s.io(v.count_dir);
+    s.io(v.show);
+}
+
+template<class IO>
+static void lvlBin(IO &s, LevelSMBX64Event &v)
+{
+    s.io(v.name);
+    s.io(v.msg);
+    s.io(v.sound_id);
+    s.io(v.end_game);
+    s.io(v.nosmoke);
+    lvlBinList(s, v.layers_hide);
+    lvlBinList(s, v.layers_show);
+    lvlBinList(s, v.layers_toggle);
+    lvlBinList(s, v.sets);
+    s.io(v.trigger);
+    s.io(v.trigger_timer_unit);
+    s.io(v.trigger_timer);
+    s.io(v.trigger_timer_orig);
+    s.io(v.ctrls_enable);
+    s.io(v.ctrl_up);
+    s.io(v.ctrl_down);
+    s.io(v.ctrl_left);
+    s.io(v.ctrl_right);
+    s.io(v.ctrl_jump);
+    s.io(v.ctrl_altjump);
+    s.io(v.ctrl_run);
+    s.io(v.ctrl_altrun);
+    s.io(v.ctrl_start);
+    s.io(v.ctrl_drop);
+    s.io(v.ctrl_lock_keyboard);
+    s.io(v.autostart);
+    s.io(v.autostart_condition);
+    lvlBinList(s, v.moving_layers);
+    lvlBinList(s, v.spawn_effects);
+    lvlBinList(s, v.spawn_npc);
+    lvlBinList(s, v.update_variable);
+    lvlBin(s, v.timer_def);
+    s.io(v.trigger_script);
+    s.io(v.trigger_api_id);
+    s.io(v.movelayer);
+    s.io(v.layer_speed_x);
+    s.io(v.layer_speed_y);
+    s.io(v.move_camera_x);
+    s.io(v.move_camera_y);
+    s.io(v.scroll_section);
+    lvlBin(s, v.meta);
+}
+
+template<class IO>
+static void lvlBin(IO &s, LevelVariable &v)
+{
+    s.io(v.name);
+    s.io(v.value);
+    s.io(v.is_global);
+}
+
+template<class IO>
+static void lvlBin(IO &s, LevelScript &v)
+{
+    s.io(v.name);
+    s.io(v.script);
+    s.io(v.language);
+}
+
+template<class IO>
+static void lvlBin(IO &s, LevelArray &v)
+{
+    s.io(v.name);
+}
+
+template<class IO>
+static void lvlBin(IO &s, LevelItemSetup38A::Entry &v)
+{
+    s.io(v.key);
+    s.io(v.value);
+}
+
+template<class IO>
+static void lvlBin(IO &s, LevelItemSetup38A &v)
+{
+    s.io(v.type);
+    s.io(v.id);
+    lvlBinList(s, v.data);
+}
+
+template<class IO>
+static void lvlBin(IO &s, LevelData &v)
+{
+    s.io(v.stars);
+    lvlBin(s, v.meta);
+    s.io(v.LevelName);
+    s.io(v.open_level_on_fail);
+    s.io(v.open_level_on_fail_warpID);
+    lvlBinList(s, v.player_names_overrides);
+    s.io(v.custom_params);
+    lvlBinList(s, v.music_overrides);
+    lvlBinList(s, v.sound_overrides);
+    lvlBinList(s, v.sections);
+    lvlBinList(s, v.players);
+    lvlBinList(s, v.blocks);
+    s.io(v.blocks_array_id);
+    lvlBinList(s, v.bgo);
+    s.io(v.bgo_array_id);
+    lvlBinList(s, v.npc);
+    s.io(v.npc_array_id);
+    lvlBinList(s, v.doors);
+    s.io(v.doors_array_id);
+    lvlBinList(s, v.physez);
+    s.io(v.physenv_array_id);
+    lvlBinList(s, v.layers);
+    s.io(v.layers_array_id);
+    lvlBinList(s, v.events);
+    s.io(v.events_array_id);
+    lvlBinList(s, v.variables);
+    lvlBinList(s, v.scripts);
+    lvlBinList(s, v.arrays);
+    lvlBinList(s, v.unsupported_38a_lines);
+    lvlBinList(s, v.custom38A_configs);
+    lvlBin(s, v.metaData);
+    s.io(v.CurSection);
+    s.io(v.playmusic);
+}
+
+
+/*****************Public API***************************/
+
+bool FileFormats::WriteLevelBinary(const LevelData &FileData, std::string &out, uint64_t sourceHash)
+{
+    out.clear();
+    out.append(s_lvlBinMagic, sizeof(s_lvlBinMagic));
+    out.resize(s_lvlBinHeaderSize);
+
+    LvlBinWriter w(out);
+    // The writer never modifies the data, the same routine is shared with the reader
+    lvlBin(w, const_cast<LevelData &>(FileData));
+
+    std::string header;
+    LvlBinWriter h(header);
+    h.fixed(s_lvlBinVersion, 4);
+    h.fixed(sourceHash, 8);
+    h.fixed(static_cast<uint64_t>(out.size() - s_lvlBinHeaderSize), 8);
+    h.fixed(Hash64(out.data() + s_lvlBinHeaderSize, out.size() - s_lvlBinHeaderSize), 8);
+    out.replace(sizeof(s_lvlBinMagic), header.size(), header);
+
+    return true;
+}
+
+bool FileFormats::ReadLevelBinary(const std::string &in, LevelData &FileData, uint64_t *sourceHash)
+{
+    CreateLevelData(FileData);
+
+    LvlBinReader h(in.data(), in.size());
+    if(in.size() < s_lvlBinHeaderSize || std::memcmp(in.data(), s_lvlBinMagic, sizeof(s_lvlBinMagic)) != 0)
+    {
+        FileData.meta.ERROR_info = "Not a binary level data";
+        FileData.meta.ReadFileValid = false;
+        return false;
+    }
+
+    h.fixed(8);
+    uint32_t version = static_cast<uint32_t>(h.fixed(4));
+    uint64_t srcHash = h.fixed(8);
+    uint64_t payloadSize = h.fixed(8);
+    uint64_t payloadHash = h.fixed(8);
+
+    if(version != s_lvlBinVersion)
+    {
+        FileData.meta.ERROR_info = "Unsupported version of the binary level data";
+        FileData.meta.ReadFileValid = false;
+        return false;
+    }
+
+    const char *payload = in.data() + s_lvlBinHeaderSize;
+    if(payloadSize != in.size() - s_lvlBinHeaderSize ||
+       payloadHash != Hash64(payload, static_cast<size_t>(payloadSize)))
+    {
+        FileData.meta.ERROR_info = "Binary level data is damaged";
+        FileData.meta.ReadFileValid = false;
+        return false;
+    }
+
+    LvlBinReader r(payload, static_cast<size_t>(payloadSize));
+    lvlBin(r, FileData);
+
+    if(!r.ok() || !r.atEnd())
+    {
+        CreateLevelData(FileData);
+        FileData.meta.ERROR_info = "Binary level data is damaged";
+        FileData.meta.ReadFileValid = false;
+        return false;
+    }
+
+    if(sourceHash)
+        *sourceHash = srcHash;
+
+    return true;
+}
+
+
+static std::mutex s_lvlCacheDirLock;
+static PGESTRING  s_lvlCacheDir;
+
+void FileFormats::SetLevelCacheDirectory(const PGESTRING &cacheDir)
+{
+    std::lock_guard<std::mutex> guard(s_lvlCacheDirLock);
+    s_lvlCacheDir = cacheDir;
+}
+
+PGESTRING FileFormats::LevelCacheDirectory()
+{
+    std::lock_guard<std::mutex> guard(s_lvlCacheDirLock);
+    return s_lvlCacheDir;
+}
+
+static PGESTRING lvlBinCacheFileName(uint64_t hash)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string name(16, '0');
+    for(int i = 15; i >= 0; i--)
+    {
+        name[static_cast<size_t>(i)] = digits[hash & 0xF];
+        hash >>= 4;
+    }
+#ifdef PGE_FILES_QT
+    return QString::fromStdString(name) + ".lvlb";
+#else
+    return name + ".lvlb";
+#endif
+}
+
+bool FileFormats::OpenLevelFileCached(const PGESTRING &filePath, const PGESTRING &cacheDir, LevelData &FileData)
+{
+    std::string source;
+    if(!PGE_FileFormats_misc::readBinaryFile(filePath, source))
+    {
+        FileData.meta.ReadFileValid = false;
+        FileData.meta.ERROR_info = "Can't open file";
+        FileData.meta.ERROR_linedata = "";
+        FileData.meta.ERROR_linenum = -1;
+        return false;
+    }
+
+    // Meta-data file gets merged into the level data, therefore it's a part of the key
+    uint64_t hash = Hash64(source.data(), source.size(), s_lvlBinVersion);
+    std::string metaSource;
+    if(PGE_FileFormats_misc::readBinaryFile(filePath + ".meta", metaSource))
+        hash = Hash64(metaSource.data(), metaSource.size(), hash);
+
+    const PGESTRING cacheFile = cacheDir + "/" + lvlBinCacheFileName(hash);
+    std::string blob;
+    uint64_t blobHash = 0;
+
+    if(PGE_FileFormats_misc::readBinaryFile(cacheFile, blob) &&
+       ReadLevelBinary(blob, FileData, &blobHash) && blobHash == hash)
+    {
+        // The same file may be placed at a different location
+        PGE_FileFormats_misc::FileInfo info(filePath);
+        FileData.meta.filename = info.basename();
+        FileData.meta.path = info.dirpath();
+#ifdef PGE_FILES_QT
+        PGE_StringPool *pool = StringPool();
+        if(pool)
+            pool->internLevel(FileData);
+#endif
+        if(LevelResolveReferencesEnabled())
+            LevelResolveReferences(FileData);
+        return true;
+    }
+
+    // Parse the already loaded source, the .meta file is merged by OpenLevelFileT()
+#ifdef PGE_FILES_QT
+    // Same codecs as TextFileInput gives: SMBX64 files are in the local 8-bit encoding
+    const QString head = QString::fromLatin1(source.data(), static_cast<int>(std::min<size_t>(source.size(), 8)));
+    PGESTRING raw = (!head.startsWith("SMBXFile") && PGE_FileFormats_misc::PGE_DetectSMBXFile(head)) ?
+                    QString::fromLocal8Bit(source.data(), static_cast<int>(source.size())) :
+                    QString::fromUtf8(source.data(), static_cast<int>(source.size()));
+#else
+    PGESTRING raw = std::move(source);
+#endif
+    PGE_FileFormats_misc::RawTextInput file;
+    if(!file.open(&raw, filePath))
+    {
+        FileData.meta.ReadFileValid = false;
+        FileData.meta.ERROR_info = "Can't open file";
+        FileData.meta.ERROR_linedata = "";
+        FileData.meta.ERROR_linenum = -1;
+        return false;
+    }
+
+    if(!OpenLevelFileT(file, FileData))
+        return false;
+
+    // Failure to write the cache entry is not an error of the level opening
+    if(WriteLevelBinary(FileData, blob, hash))
+        PGE_FileFormats_misc::writeBinaryFile(cacheFile, blob);
+
+    return true;
+}
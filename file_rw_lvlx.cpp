@@ -29,6 +29,7 @@
 #include "file_strlist.h"
 #include "pge_x.h"
 #include "pge_x_macro.h"
+#include "pge_arena_private.h"
 #include <cfloat>
 
 //*********************************************************
@@ -106,7 +107,7 @@ bool FileFormats::ReadExtendedLvlFileHeaderT(PGE_FileFormats_misc::TextInput &in
 
     for(const auto &header_line : header)
     {
-        PGELIST<PGESTRINGList >data = PGEFile::splitDataLine(header_line, &valid);
+        PGEVECTOR<PGESTRINGList >data = PGEFile::splitDataLine(header_line, &valid);
 
         for(const auto &val : data)
         {
@@ -219,10 +220,12 @@ bool FileFormats::ReadExtendedLvlFileRaw(PGESTRING &rawdata, const PGESTRING &fi
 
 bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, LevelData &FileData)
 {
+    PGE_STATS_BEGIN("PGE-X LVLX", PHASE_IO);
     PGESTRING errorString;
     PGESTRING filePath = in.getFilePath();
     PGESTRING line;  /*Current Line data*/
     //LevelData FileData;
+    PGE_ArenaStaging arenaStaging(FileData);
     CreateLevelData(FileData);
     FileData.meta.RecentFormat = LevelData::PGEX;
 
@@ -278,6 +281,7 @@ bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, Level
         PGEX_Section("META_BOOKMARKS")
         {
             PGEX_SectionBegin(PGEFile::PGEX_Struct)
+            PGEX_ReserveItems(FileData.metaData.bookmarks);
             PGEX_Items()
             {
                 PGEX_ItemBegin(PGEFile::PGEX_Struct)
@@ -292,7 +296,7 @@ bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, Level
                     PGEX_FloatVal("X", meta_bookmark.x) // Position X
                     PGEX_FloatVal("Y", meta_bookmark.y) // Position Y
                 }
-                FileData.metaData.bookmarks.push_back(meta_bookmark);
+                FileData.metaData.bookmarks.push_back(std::move(meta_bookmark));
             }
         }
         ////////////////////////meta bookmarks////////////////////////
@@ -360,12 +364,12 @@ bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, Level
                     {
                         LevelSection dummySct = CreateLvlSection();
                         dummySct.id = (int)FileData.sections.size();
-                        FileData.sections.push_back(dummySct);
+                        FileData.sections.push_back(std::move(dummySct));
                         needToAdd--;
                     }
                 }
 
-                FileData.sections[static_cast<pge_size_t>(lvl_section.id)] = lvl_section;
+                FileData.sections[static_cast<pge_size_t>(lvl_section.id)] = std::move(lvl_section);
             }
         }//SECTION
         ///////////////////STARTPOINT//////////////////////
@@ -402,15 +406,16 @@ bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, Level
                 player.h = sz.h;
 
                 if(found)
-                    FileData.players[q] = player;
+                    FileData.players[q] = std::move(player);
                 else
-                    FileData.players.push_back(player);
+                    FileData.players.push_back(std::move(player));
             }
         }//STARTPOINT
         ///////////////////BLOCK//////////////////////
         PGEX_Section("BLOCK")
         {
             PGEX_SectionBegin(PGEFile::PGEX_Struct)
+            PGEX_ReserveItems(FileData.blocks);
             PGEX_Items()
             {
                 PGEX_ItemBegin(PGEFile::PGEX_Struct)
@@ -442,13 +447,14 @@ bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, Level
                 }
                 block.meta.array_id = FileData.blocks_array_id++;
                 block.meta.index = static_cast<unsigned int>(FileData.blocks.size());
-                FileData.blocks.push_back(block);
+                FileData.blocks.push_back(std::move(block));
             }
         }//BLOCK
         ///////////////////BGO//////////////////////
         PGEX_Section("BGO")
         {
             PGEX_SectionBegin(PGEFile::PGEX_Struct)
+            PGEX_ReserveItems(FileData.bgo);
             PGEX_Items()
             {
                 PGEX_ItemBegin(PGEFile::PGEX_Struct)
@@ -469,13 +475,14 @@ bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, Level
                 }
                 bgodata.meta.array_id = FileData.bgo_array_id++;
                 bgodata.meta.index = static_cast<unsigned int>(FileData.bgo.size());
-                FileData.bgo.push_back(bgodata);
+                FileData.bgo.push_back(std::move(bgodata));
             }
         }//BGO
         ///////////////////NPC//////////////////////
         PGEX_Section("NPC")
         {
             PGEX_SectionBegin(PGEFile::PGEX_Struct)
+            PGEX_ReserveItems(FileData.npc);
             PGEX_Items()
             {
                 PGEX_ItemBegin(PGEFile::PGEX_Struct)
@@ -524,13 +531,14 @@ bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, Level
                 }
                 npcdata.meta.array_id = FileData.npc_array_id++;
                 npcdata.meta.index = static_cast<unsigned int>(FileData.npc.size());
-                FileData.npc.push_back(npcdata);
+                FileData.npc.push_back(std::move(npcdata));
             }
         }//TILES
         ///////////////////PHYSICS//////////////////////
         PGEX_Section("PHYSICS")
         {
             PGEX_SectionBegin(PGEFile::PGEX_Struct)
+            PGEX_ReserveItems(FileData.physez);
             PGEX_Items()
             {
                 PGEX_ItemBegin(PGEFile::PGEX_Struct)
@@ -553,13 +561,14 @@ bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, Level
                 }
                 physiczone.meta.array_id = FileData.physenv_array_id++;
                 physiczone.meta.index = static_cast<unsigned int>(FileData.physez.size());
-                FileData.physez.push_back(physiczone);
+                FileData.physez.push_back(std::move(physiczone));
             }
         }//PHYSICS
         ///////////////////DOORS//////////////////////
         PGEX_Section("DOORS")
         {
             PGEX_SectionBegin(PGEFile::PGEX_Struct)
+            PGEX_ReserveItems(FileData.doors);
             PGEX_Items()
             {
                 PGEX_ItemBegin(PGEFile::PGEX_Struct)
@@ -618,13 +627,14 @@ bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, Level
 
                 door.meta.array_id = FileData.doors_array_id++;
                 door.meta.index = static_cast<unsigned int>(FileData.doors.size());
-                FileData.doors.push_back(door);
+                FileData.doors.push_back(std::move(door));
             }
         }//DOORS
         ///////////////////LAYERS//////////////////////
         PGEX_Section("LAYERS")
         {
             PGEX_SectionBegin(PGEFile::PGEX_Struct)
+            PGEX_ReserveItems(FileData.layers);
             PGEX_Items()
             {
                 PGEX_ItemBegin(PGEFile::PGEX_Struct)
@@ -651,12 +661,12 @@ bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, Level
                 if(found)
                 {
                     layer.meta.array_id = FileData.layers[q].meta.array_id;
-                    FileData.layers[q] = layer;
+                    FileData.layers[q] = std::move(layer);
                 }
                 else
                 {
                     layer.meta.array_id = FileData.layers_array_id++;
-                    FileData.layers.push_back(layer);
+                    FileData.layers.push_back(std::move(layer));
                 }
             }
         }//LAYERS
@@ -687,6 +697,7 @@ bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, Level
         PGEX_Section("EVENTS_CLASSIC")
         {
             PGEX_SectionBegin(PGEFile::PGEX_Struct)
+            PGEX_ReserveItems(FileData.events);
             PGEX_Items()
             {
                 PGEX_ItemBegin(PGEFile::PGEX_Struct)
@@ -752,7 +763,7 @@ bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, Level
                     {
                         LevelEvent_Sets sectionSet;
                         bool valid = false;
-                        PGELIST<PGESTRINGList> sssData = PGEFile::splitDataLine(newSectionSettingsSet, &valid);
+                        PGEVECTOR<PGESTRINGList> sssData = PGEFile::splitDataLine(newSectionSettingsSet, &valid);
 
                         if(!valid)
                         {
@@ -910,7 +921,7 @@ bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, Level
                                         stop.y =     arr[pe + 1];
                                         stop.type =  (int)arr[pe + 2];
                                         stop.speed = arr[pe + 3];
-                                        sectionSet.autoscroll_path.push_back(stop);
+                                        sectionSet.autoscroll_path.push_back(std::move(stop));
                                     }
                                 }
                                 else
@@ -970,12 +981,12 @@ bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, Level
                             {
                                 LevelEvent_Sets set;
                                 set.id = last;
-                                event.sets.push_back(set);
+                                event.sets.push_back(std::move(set));
                                 last++;
                             }
                         }
 
-                        event.sets[static_cast<pge_size_t>(sectionSet.id)] = sectionSet;
+                        event.sets[static_cast<pge_size_t>(sectionSet.id)] = std::move(sectionSet);
                     }//for section settings entries
                 }//If new-styled section settings are gotten
                 //Parse odl-style parameters
@@ -1029,7 +1040,7 @@ bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, Level
                     {
                         LevelEvent_MoveLayer moveLayer;
                         bool valid = false;
-                        PGELIST<PGESTRINGList> mlaData = PGEFile::splitDataLine(movingLayer, &valid);
+                        PGEVECTOR<PGESTRINGList> mlaData = PGEFile::splitDataLine(movingLayer, &valid);
 
                         if(!valid)
                         {
@@ -1095,7 +1106,7 @@ bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, Level
                             }
                         }//for parameters
 
-                        event.moving_layers.push_back(moveLayer);
+                        event.moving_layers.push_back(std::move(moveLayer));
                     }//for moving layers entries
                 }//If SMBX38A moving layers are gotten
 
@@ -1106,7 +1117,7 @@ bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, Level
                     {
                         LevelEvent_SpawnNPC spawnNPC;
                         bool valid = false;
-                        PGELIST<PGESTRINGList> mlaData = PGEFile::splitDataLine(spawnNpc, &valid);
+                        PGEVECTOR<PGESTRINGList> mlaData = PGEFile::splitDataLine(spawnNpc, &valid);
 
                         if(!valid)
                         {
@@ -1208,7 +1219,7 @@ bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, Level
                             }
                         }//for parameters
 
-                        event.spawn_npc.push_back(spawnNPC);
+                        event.spawn_npc.push_back(std::move(spawnNPC));
                     }//for Spawn NPC
                 }//If SMBX38A NPC Spawning lists are gotten
 
@@ -1219,7 +1230,7 @@ bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, Level
                     {
                         LevelEvent_SpawnEffect spawnEffect;
                         bool valid = false;
-                        PGELIST<PGESTRINGList> mlaData = PGEFile::splitDataLine(spawnEffects, &valid);
+                        PGEVECTOR<PGESTRINGList> mlaData = PGEFile::splitDataLine(spawnEffects, &valid);
 
                         if(!valid)
                         {
@@ -1339,7 +1350,7 @@ bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, Level
                             }
                         }//for parameters
 
-                        event.spawn_effects.push_back(spawnEffect);
+                        event.spawn_effects.push_back(std::move(spawnEffect));
                     }//for Spawn Effect
                 }//If SMBX38A Effect Spawning lists are gotten
 
@@ -1350,7 +1361,7 @@ bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, Level
                     {
                         LevelEvent_UpdateVariable variableToUpdate;
                         bool valid = false;
-                        PGELIST<PGESTRINGList> mlaData = PGEFile::splitDataLine(updVar, &valid);
+                        PGEVECTOR<PGESTRINGList> mlaData = PGEFile::splitDataLine(updVar, &valid);
 
                         if(!valid)
                         {
@@ -1380,7 +1391,7 @@ bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, Level
                             }
                         }//for parameters
 
-                        event.update_variable.push_back(variableToUpdate);
+                        event.update_variable.push_back(std::move(variableToUpdate));
                     }//for Variable update events
                 }//If SMBX38A variable update lists are gotten
 
@@ -1418,12 +1429,12 @@ bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, Level
                 if(found)
                 {
                     event.meta.array_id = FileData.events[q].meta.array_id;
-                    FileData.events[q] = event;
+                    FileData.events[q] = std::move(event);
                 }
                 else
                 {
                     event.meta.array_id = FileData.events_array_id++;
-                    FileData.events.push_back(event);
+                    FileData.events.push_back(std::move(event));
                 }
             }
         }//EVENTS_CLASSIC
@@ -1431,6 +1442,7 @@ bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, Level
         PGEX_Section("VARIABLES")
         {
             PGEX_SectionBegin(PGEFile::PGEX_Struct)
+            PGEX_ReserveItems(FileData.variables);
             PGEX_Items()
             {
                 PGEX_ItemBegin(PGEFile::PGEX_Struct)
@@ -1449,6 +1461,7 @@ bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, Level
         PGEX_Section("ARRAYS")
         {
             PGEX_SectionBegin(PGEFile::PGEX_Struct)
+            PGEX_ReserveItems(FileData.arrays);
             PGEX_Items()
             {
                 PGEX_ItemBegin(PGEFile::PGEX_Struct)
@@ -1458,7 +1471,7 @@ bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, Level
                     PGEX_ValueBegin()
                     PGEX_StrVal("N", array_field.name) //Variable name
                 }
-                FileData.arrays.push_back(array_field);
+                FileData.arrays.push_back(std::move(array_field));
             }
         }//ARRAYS
         ///////////////////SCRIPTS//////////////////////
@@ -1495,6 +1508,7 @@ bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, Level
         PGEX_Section("CUSTOM_ITEMS_38A")
         {
             PGEX_SectionBegin(PGEFile::PGEX_Struct)
+            PGEX_ReserveItems(FileData.custom38A_configs);
             PGEX_Items()
             {
                 PGEX_ItemBegin(PGEFile::PGEX_Struct)
@@ -1525,15 +1539,17 @@ bool FileFormats::ReadExtendedLvlFile(PGE_FileFormats_misc::TextInput &in, Level
                         e.value = toLong(pair[1]);
                     else goto badfile;
 
-                    customcfg38A.data.push_back(e);
+                    customcfg38A.data.push_back(std::move(e));
                 }
                 customcfg38A.type = (LevelItemSetup38A::ItemType)type;
-                FileData.custom38A_configs.push_back(customcfg38A);
+                FileData.custom38A_configs.push_back(std::move(customcfg38A));
             }
         }//CUSTOM_ITEMS_38A
     }
     ///////////////////////////////////////EndFile///////////////////////////////////////
+    PGE_STATS_COUNT_LEVEL(FileData);
     errorString.clear(); //If no errors, clear string;
+    arenaStaging.commit(FileData);
     FileData.meta.ReadFileValid = true;
     return true;
 
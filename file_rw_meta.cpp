@@ -28,6 +28,7 @@
 #include "file_strlist.h"
 #include "pge_file_lib_private.h"
 #include "pge_x.h"
+#include "pge_parse_stats_private.h"
 
 //*********************************************************
 //****************READ FILE FORMAT*************************
@@ -69,6 +70,7 @@ bool FileFormats::ReadNonSMBX64MetaDataRaw(PGESTRING &rawdata, const PGESTRING &
 
 bool FileFormats::ReadNonSMBX64MetaDataFile(PGE_FileFormats_misc::TextInput &in, MetaData &FileData)
 {
+    PGE_STATS_BEGIN("PGE-X META", PHASE_IO);
     PGESTRING errorString;
     int str_count = 0;      //Line Counter
     PGESTRING line;           //Current Line data
@@ -80,6 +82,7 @@ bool FileFormats::ReadNonSMBX64MetaDataFile(PGE_FileFormats_misc::TextInput &in,
         errorString = pgeX_Data.lastError();
         goto badfile;
     }
+    PGE_STATS_PHASE(PHASE_FIELDS);
 
     for(pge_size_t section = 0; section < pgeX_Data.dataTree.size(); section++) //look sections
     {
@@ -103,7 +106,7 @@ bool FileFormats::ReadNonSMBX64MetaDataFile(PGE_FileFormats_misc::TextInput &in,
                     goto badfile;
                 }
 
-                PGEFile::PGEX_Item x = f_section.data[sdata];
+                const PGEFile::PGEX_Item &x = f_section.data[sdata];
                 Bookmark meta_bookmark;
                 meta_bookmark.bookmarkName.clear();
                 meta_bookmark.x = 0;
@@ -111,11 +114,7 @@ bool FileFormats::ReadNonSMBX64MetaDataFile(PGE_FileFormats_misc::TextInput &in,
 
                 for(const auto &v : x.values) //Look markers and values
                 {
-                    errorString = PGESTRING("Wrong value syntax\nSection [") +
-                                  f_section.name + "]\nData line " +
-                                  fromNum(sdata) + "\nMarker " +
-                                  v.marker + "\nValue " +
-                                  v.value;
+                    PGEFile::valueSyntaxError(errorString, f_section.name, sdata, v);
 
                     if(v.marker == "BM") //Bookmark name
                     {
@@ -140,12 +139,13 @@ bool FileFormats::ReadNonSMBX64MetaDataFile(PGE_FileFormats_misc::TextInput &in,
                     }
                 }
 
-                FileData.bookmarks.push_back(meta_bookmark);
+                FileData.bookmarks.push_back(std::move(meta_bookmark));
             }
         }
     }
 
     ///////////////////////////////////////EndFile///////////////////////////////////////
+    PGE_STATS_COUNT("bookmarks", FileData.bookmarks.size());
     errorString.clear(); //If no errors, clear string;
     FileData.meta.ReadFileValid = true;
     return true;
@@ -27,8 +27,9 @@
 #include "file_formats.h"
 #include "file_strlist.h"
 #include "smbx64.h"
+#include "pge_parse_stats_private.h"
 
-#include <functional>
+#include <cstring>
 
 //*********************************************************
 //****************READ FILE FORMAT*************************
@@ -81,149 +82,185 @@ static inline PGESTRING invalidLine_BOOL(long line, const PGESTRING &data)
     return fromNum(line) + ": " + data + " <Should be 1 or 0!>\n";
 }
 
-bool FileFormats::ReadNpcTXTFile(PGE_FileFormats_misc::TextInput &inf, NPCConfigFile &fileData, bool ignoreBad)
+namespace
 {
-    PGESTRING line;           //Current Line data
-    PGESTRINGList params;
-    fileData = CreateEmpytNpcTXT();
-    bool doLog = !ignoreBad;
 
-    auto handlerSInt = [&](bool &dest_en, int32_t &dest, PGESTRING &input)
+//! Type of the value of known NPC.txt field
+enum NpcTxtFieldType
+{
+    NPCTXT_SINT = 0,
+    NPCTXT_UINT,
+    NPCTXT_BOOL,
+    NPCTXT_FLOAT,
+    NPCTXT_STRING
+};
+
+/*!
+ * \brief Known NPC.txt field and it's place at the NPCConfigFile structure
+ */
+struct NpcTxtKeyword
+{
+    constexpr NpcTxtKeyword(const char *n, size_t l, bool NPCConfigFile::*e, int32_t NPCConfigFile::*f) :
+        name(n), len(l), type(NPCTXT_SINT), enabled(e), sint(f) {}
+    constexpr NpcTxtKeyword(const char *n, size_t l, bool NPCConfigFile::*e, uint32_t NPCConfigFile::*f) :
+        name(n), len(l), type(NPCTXT_UINT), enabled(e), uint(f) {}
+    constexpr NpcTxtKeyword(const char *n, size_t l, bool NPCConfigFile::*e, bool NPCConfigFile::*f) :
+        name(n), len(l), type(NPCTXT_BOOL), enabled(e), flag(f) {}
+    constexpr NpcTxtKeyword(const char *n, size_t l, bool NPCConfigFile::*e, double NPCConfigFile::*f) :
+        name(n), len(l), type(NPCTXT_FLOAT), enabled(e), flt(f) {}
+    constexpr NpcTxtKeyword(const char *n, size_t l, bool NPCConfigFile::*e, PGESTRING NPCConfigFile::*f) :
+        name(n), len(l), type(NPCTXT_STRING), enabled(e), str(f) {}
+
+    //! Name of the field in lower case
+    const char *name;
+    //! Length of the name
+    size_t len;
+    //! Type of the value
+    NpcTxtFieldType type;
+    //! Flag of the field presence
+    bool NPCConfigFile::*enabled;
+    //! Destination of the value, only one which matches the type is set
+    int32_t NPCConfigFile::*sint = nullptr;
+    uint32_t NPCConfigFile::*uint = nullptr;
+    bool NPCConfigFile::*flag = nullptr;
+    double NPCConfigFile::*flt = nullptr;
+    PGESTRING NPCConfigFile::*str = nullptr;
+};
+
+#define NPCTXT_ENTRY(param_name) NpcTxtKeyword(#param_name, sizeof(#param_name) - 1, &NPCConfigFile::en_##param_name, &NPCConfigFile::param_name),
+
+static const NpcTxtKeyword s_npcTxtKeywords[] =
+{
+    PGE_NPCTXT_FIELDS(NPCTXT_ENTRY)
+};
+
+#undef NPCTXT_ENTRY
+
+//! Longest name of the known field plus one
+static const size_t c_npcTxtKeyMax = 32;
+
+/*!
+ * \brief Open addressing hash table of known fields, built once per process
+ */
+class NpcTxtKeywordTable
+{
+    //! Number of slots, the power of two, big enough to keep probe sequences short
+    static const size_t c_slots = 128;
+    const NpcTxtKeyword *m_slots[c_slots];
+
+    static inline size_t hash(const char *key, size_t len)
     {
-        input = PGESTR_Simpl(input);
-        input = PGE_RemSubSTRING(input, " ");//Delete spaces
-        if(!SMBX64::IsSInt(input))
+        // FNV-1a
+        uint32_t h = 2166136261u;
+        for(size_t i = 0; i < len; i++)
         {
-            if(doLog)
-                fileData.unknownLines += invalidLine_SINT(inf.getCurrentLineNumber(), line);
+            h ^= static_cast<unsigned char>(key[i]);
+            h *= 16777619u;
         }
-        else
-        {
-            if(input.size() > 9)
-                dest = 0;
-            else
-            {
-                dest = toInt(input);
-                dest_en = true;
-            }
-        }
-    };
+        return static_cast<size_t>(h) & (c_slots - 1);
+    }
 
-    auto handlerUInt = [&](bool &dest_en, uint32_t &dest, PGESTRING &input)
+public:
+    NpcTxtKeywordTable()
     {
-        input = PGESTR_Simpl(input);
-        input = PGE_RemSubSTRING(input, " ");//Delete spaces
-        if(!SMBX64::IsUInt(input))
-        {
-            if(doLog)
-                fileData.unknownLines += invalidLine_UINT(inf.getCurrentLineNumber(), line);
-        }
-        else
+        for(size_t i = 0; i < c_slots; i++)
+            m_slots[i] = nullptr;
+
+        for(const NpcTxtKeyword &k : s_npcTxtKeywords)
         {
-            if(input.size() > 9)
-                dest = 0;
-            else
-            {
-                dest = toUInt(input);
-                dest_en = true;
-            }
+            size_t i = hash(k.name, k.len);
+            while(m_slots[i])
+                i = (i + 1) & (c_slots - 1);
+            m_slots[i] = &k;
         }
-    };
+    }
 
-    auto handlerBool = [&](bool &dest_en, bool &dest, PGESTRING &input)
+    const NpcTxtKeyword *find(const char *key, size_t len) const
     {
-        input = PGESTR_Simpl(input);
-        input = PGE_RemSubSTRING(input, " ");//Delete spaces
-        if(!SMBX64::IsBool(input))
+        for(size_t i = hash(key, len); m_slots[i]; i = (i + 1) & (c_slots - 1))
         {
-            if(doLog)
-                fileData.unknownLines += invalidLine_BOOL(inf.getCurrentLineNumber(), line);
-        }
-        else
-        {
-            if(input.size() > 9)
-                dest = 0;
-            else
-            {
-                dest = static_cast<bool>(toInt(input) != 0);
-                dest_en = true;
-            }
+            const NpcTxtKeyword *k = m_slots[i];
+            if(k->len == len && std::memcmp(k->name, key, len) == 0)
+                return k;
         }
-    };
+        return nullptr;
+    }
 
-    auto handlerDouble = [&](bool &dest_en, double &dest, PGESTRING &input)
+    static const NpcTxtKeywordTable &get()
     {
-        input = PGESTR_Simpl(input);
-        input = PGE_RemSubSTRING(input, " ");//Delete spaces
-        if(!SMBX64::IsFloat(input))
-        {
-            if(doLog)
-                fileData.unknownLines += invalidLine_FLT(inf.getCurrentLineNumber(), line);
-        }
-        else
-        {
-            dest = toDouble(input);
-            dest_en = true;
-        }
-    };
+        static const NpcTxtKeywordTable table;
+        return table;
+    }
+};
+
+static inline bool npcTxtIsSpace(const PGEChar &c)
+{
+#ifdef PGE_FILES_QT
+    return c.isSpace();
+#else
+    return ::isspace(c) != 0;
+#endif
+}
 
-    auto handlerString = [&](bool &dest_en, PGESTRING &dest, PGESTRING &input)
+/*!
+ * \brief Copies the field name into the buffer with no spaces and in lower case
+ * \param [__in] line Line of the file
+ * \param [__in] end Position of the "=" sign
+ * \param [__out] key Target buffer of c_npcTxtKeyMax size
+ * \return Length of the name, or 0 if name can't be a known field
+ */
+static size_t npcTxtKey(const PGESTRING &line, pge_size_t end, char *key)
+{
+    size_t len = 0;
+    for(pge_size_t i = 0; i < end; i++)
     {
-        dest    = removeQuotes(input);
-        dest_en = !IsEmpty(input);
-    };
-
-    typedef PGEHASH<PGESTRING, std::function<void(PGESTRING&)>> NpcCfgHandlerMap;
-    #define SINT_ENTRY(param_name) { #param_name, [&](PGESTRING &param) { handlerSInt(fileData.en_##param_name, fileData.param_name, param);} }
-    #define UINT_ENTRY(param_name) { #param_name, [&](PGESTRING &param) { handlerUInt(fileData.en_##param_name, fileData.param_name, param);} }
-    #define BOOL_ENTRY(param_name) { #param_name, [&](PGESTRING &param) { handlerBool(fileData.en_##param_name, fileData.param_name, param);} }
-    #define STR_ENTRY(param_name)  { #param_name, [&](PGESTRING &param) { handlerString(fileData.en_##param_name, fileData.param_name, param);} }
-    #define FLT_ENTRY(param_name)  { #param_name, [&](PGESTRING &param) { handlerDouble(fileData.en_##param_name, fileData.param_name, param);} }
-
-    NpcCfgHandlerMap paramsHandler =
+        const PGEChar &c = line[i];
+        if(npcTxtIsSpace(c))
+            continue;
+#ifdef PGE_FILES_QT
+        if(c.unicode() > 127)
+            return 0;
+        char ch = c.toLatin1();
+#else
+        char ch = c;
+#endif
+        if(len >= c_npcTxtKeyMax - 1)
+            return 0;
+        if(ch >= 'A' && ch <= 'Z')
+            ch = static_cast<char>(ch - 'A' + 'a');
+        key[len++] = ch;
+    }
+    return len;
+}
+
+/*!
+ * \brief Copies the value with all spaces removed
+ * \param [__out] dst Target string, it's buffer is reused
+ * \param [__in] line Line of the file
+ * \param [__in] begin Begin of the value
+ * \param [__in] end End of the value
+ */
+static void npcTxtNumber(PGESTRING &dst, const PGESTRING &line, pge_size_t begin, pge_size_t end)
+{
+    dst.clear();
+    for(pge_size_t i = begin; i < end; i++)
     {
-        SINT_ENTRY(gfxoffsetx),
-        SINT_ENTRY(gfxoffsety),
-        UINT_ENTRY(width),
-        UINT_ENTRY(height),
-        UINT_ENTRY(gfxwidth),
-        UINT_ENTRY(gfxheight),
-        UINT_ENTRY(score),
-        UINT_ENTRY(health),
-        BOOL_ENTRY(playerblock),
-        BOOL_ENTRY(playerblocktop),
-        BOOL_ENTRY(npcblock),
-        BOOL_ENTRY(npcblocktop),
-        BOOL_ENTRY(grabside),
-        BOOL_ENTRY(grabtop),
-        BOOL_ENTRY(jumphurt),
-        BOOL_ENTRY(nohurt),
-        BOOL_ENTRY(noblockcollision),
-        BOOL_ENTRY(cliffturn),
-        BOOL_ENTRY(noyoshi),
-        BOOL_ENTRY(foreground),
-        FLT_ENTRY(speed),
-        BOOL_ENTRY(nofireball),
-        BOOL_ENTRY(nogravity),
-        UINT_ENTRY(frames),
-        UINT_ENTRY(framespeed),
-        UINT_ENTRY(framestyle),
-        BOOL_ENTRY(noiceball),
-        // Non-SMBX64 parameters (not working in SMBX <=1.3)
-        BOOL_ENTRY(nohammer),
-        BOOL_ENTRY(noshell),
-        STR_ENTRY(name),
-        STR_ENTRY(description),
-        STR_ENTRY(image),
-        STR_ENTRY(icon),
-        STR_ENTRY(script),
-        STR_ENTRY(group),
-        STR_ENTRY(category),
-        UINT_ENTRY(grid),
-        SINT_ENTRY(gridoffsetx),
-        SINT_ENTRY(gridoffsety),
-        UINT_ENTRY(gridalign),
-    };
+        if(!npcTxtIsSpace(line[i]))
+            dst.push_back(line[i]);
+    }
+}
+
+} // namespace
+
+bool FileFormats::ReadNpcTXTFile(PGE_FileFormats_misc::TextInput &inf, NPCConfigFile &fileData, bool ignoreBad)
+{
+    PGE_STATS_BEGIN("SMBX64 NPC.txt", PHASE_FIELDS);
+    const NpcTxtKeywordTable &keywords = NpcTxtKeywordTable::get();
+    PGESTRING line;           //Current Line data
+    PGESTRING value;          //Reusable buffer of the value
+    char key[c_npcTxtKeyMax];
+    fileData = CreateEmpytNpcTXT();
+    bool doLog = !ignoreBad;
 
     //Read NPC.TXT File config
 #define NextLine(line) line = inf.readCVSLine();
@@ -231,65 +268,124 @@ bool FileFormats::ReadNpcTXTFile(PGE_FileFormats_misc::TextInput &inf, NPCConfig
     do
     {
         NextLine(line)
-        if(IsEmpty(PGE_RemSubSTRING(line, " ")))
-            continue;//Skip empty strings
 
-        params.clear();
+        bool isEmptyLine = true;
+        for(pge_size_t i = 0; isEmptyLine && i < static_cast<pge_size_t>(line.size()); i++)
+            isEmptyLine = (line[i] == PGEChar(' '));
+        if(isEmptyLine)
+            continue;//Skip empty strings
 
         // split the Parameter and value (example: chicken=2)
 #ifdef PGE_FILES_QT
         int splitSign = line.indexOf('=');
         if(splitSign < 0) // Invalid line
-        {
-            if(doLog)
-                fileData.unknownLines += fromNum(inf.getCurrentLineNumber()) + ": " + line + " <wrong syntax!>\n";
-            continue;
-        }
-        params.push_back(line.mid(0, splitSign));
-        params.push_back(line.mid(splitSign + 1, -1));
 #else
         size_t splitSign = line.find('=');
         if(splitSign == std::string::npos)
+#endif
         {
             if(doLog)
                 fileData.unknownLines += fromNum(inf.getCurrentLineNumber()) + ": " + line + " <wrong syntax!>\n";
             continue;
         }
-        params.emplace_back(line.substr(0, splitSign));
-        params.emplace_back(line.substr(splitSign + 1, std::string::npos));
-#endif
-
-// Note: This whole condition is always false
-//        if(params.size() != 2) // If string does not contain strings with "=" as separator
-//        {
-//            if(doLog)
-//                fileData.unknownLines += fromNum(inf.getCurrentLineNumber()) + ": " + line + " <wrong syntax!>\n";
-//            if(doLog || (params.size() < 2))
-//                continue;
-//        }
 
-        params[0] = PGESTR_Trim(params[0]);
-        params[0] = PGESTR_Simpl(params[0]);
-        params[0] = PGE_RemSubSTRING(params[0], " "); //Delete spaces
-        params[0] = PGESTR_toLower(params[0]);//To lower case
+        // Trim the value
+        pge_size_t valBegin = static_cast<pge_size_t>(splitSign) + 1;
+        pge_size_t valEnd = static_cast<pge_size_t>(line.size());
+        while(valBegin < valEnd && npcTxtIsSpace(line[valBegin]))
+            valBegin++;
+        while(valEnd > valBegin && npcTxtIsSpace(line[valEnd - 1]))
+            valEnd--;
 
-        params[1] = PGESTR_Trim(params[1]); // Trim it!
+        size_t keyLen = npcTxtKey(line, static_cast<pge_size_t>(splitSign), key);
+        const NpcTxtKeyword *k = keyLen ? keywords.find(key, keyLen) : nullptr;
 
-        auto hand = paramsHandler.find(params[0]);
-        if(hand != paramsHandler.end())
-        {
-            PGEMAPVAL(hand)(params[1]);
-        }
-        else
+        if(!k)
         {
             // Custom value
-            fileData.entries[params[0]] = params[1];
+            PGESTRING name = PGESTR_Trim(PGE_SubStr(line, 0, static_cast<int>(splitSign)));
+            name = PGESTR_Simpl(name);
+            name = PGE_RemSubSTRING(name, " "); //Delete spaces
+            name = PGESTR_toLower(name);//To lower case
+            fileData.entries[name] = PGE_SubStr(line, static_cast<int>(valBegin), static_cast<int>(valEnd - valBegin));
             if(doLog) //[DEPRECATED] Store unknown value into warnings list
                 fileData.unknownLines += fromNum(inf.getCurrentLineNumber()) + ": " + line + "\n";
+            continue;
+        }
+
+        switch(k->type)
+        {
+        case NPCTXT_SINT:
+            npcTxtNumber(value, line, valBegin, valEnd);
+            if(!SMBX64::IsSInt(value))
+            {
+                if(doLog)
+                    fileData.unknownLines += invalidLine_SINT(inf.getCurrentLineNumber(), line);
+            }
+            else if(value.size() > 9)
+                fileData.*(k->sint) = 0;
+            else
+            {
+                fileData.*(k->sint) = toInt(value);
+                fileData.*(k->enabled) = true;
+            }
+            break;
+
+        case NPCTXT_UINT:
+            npcTxtNumber(value, line, valBegin, valEnd);
+            if(!SMBX64::IsUInt(value))
+            {
+                if(doLog)
+                    fileData.unknownLines += invalidLine_UINT(inf.getCurrentLineNumber(), line);
+            }
+            else if(value.size() > 9)
+                fileData.*(k->uint) = 0;
+            else
+            {
+                fileData.*(k->uint) = toUInt(value);
+                fileData.*(k->enabled) = true;
+            }
+            break;
+
+        case NPCTXT_BOOL:
+            npcTxtNumber(value, line, valBegin, valEnd);
+            if(!SMBX64::IsBool(value))
+            {
+                if(doLog)
+                    fileData.unknownLines += invalidLine_BOOL(inf.getCurrentLineNumber(), line);
+            }
+            else
+            {
+                fileData.*(k->flag) = (toInt(value) != 0);
+                fileData.*(k->enabled) = true;
+            }
+            break;
+
+        case NPCTXT_FLOAT:
+            npcTxtNumber(value, line, valBegin, valEnd);
+            if(!SMBX64::IsFloat(value))
+            {
+                if(doLog)
+                    fileData.unknownLines += invalidLine_FLT(inf.getCurrentLineNumber(), line);
+            }
+            else
+            {
+                fileData.*(k->flt) = toDouble(value);
+                fileData.*(k->enabled) = true;
+            }
+            break;
+
+        case NPCTXT_STRING:
+            value = PGE_SubStr(line, static_cast<int>(valBegin), static_cast<int>(valEnd - valBegin));
+            fileData.*(k->str) = removeQuotes(value);
+            fileData.*(k->enabled) = !IsEmpty(value);
+            break;
         }
     }
     while(!inf.eof());
 
+    PGE_STATS_COUNT("bytes", inf.tell());
+    PGE_STATS_COUNT("lines", inf.getCurrentLineNumber());
     fileData.ReadFileValid = true;
     return true;
 }
@@ -38,6 +38,7 @@
 #include "smbx64.h"
 #include "smbx64_macro.h"
 #include "CSVUtils.h"
+#include "pge_parse_stats_private.h"
 
 //*********************************************************
 //****************READ FILE FORMAT*************************
@@ -75,6 +76,7 @@ bool FileFormats::ReadSMBX64SavFileRaw(PGESTRING &rawdata, const PGESTRING &file
 
 bool FileFormats::ReadSMBX64SavFile(PGE_FileFormats_misc::TextInput &in, GamesaveData &FileData)
 {
+    PGE_STATS_BEGIN("SMBX64 SAV", PHASE_FIELDS);
     SMBX64_FileBegin();
     PGESTRING filePath = in.getFilePath();
     FileData.meta.ERROR_info.clear();
@@ -137,7 +139,7 @@ bool FileFormats::ReadSMBX64SavFile(PGE_FileFormats_misc::TextInput &in, Gamesav
                 nextLine();    //ID of mount
                 SMBX64::ReadUInt(&charState.health, line);
             }
-            FileData.characterStates.push_back(charState);
+            FileData.characterStates.push_back(std::move(charState));
         }
 
         nextLine();
@@ -210,7 +212,7 @@ bool FileFormats::ReadSMBX64SavFile(PGE_FileFormats_misc::TextInput &in, Gamesav
                     SMBX64::ReadUInt(&gottenStar.second, line);
                 }
 
-                FileData.gottenStars.push_back(gottenStar);
+                FileData.gottenStars.push_back(std::move(gottenStar));
                 nextLine();
             }
         }
@@ -225,6 +227,15 @@ bool FileFormats::ReadSMBX64SavFile(PGE_FileFormats_misc::TextInput &in, Gamesav
 
 successful:
         ///////////////////////////////////////EndFile///////////////////////////////////////
+        PGE_STATS_COUNT("bytes", in.tell());
+        PGE_STATS_COUNT("lines", in.getCurrentLineNumber());
+        PGE_STATS_COUNT("characterStates", FileData.characterStates.size());
+        PGE_STATS_COUNT("visibleLevels", FileData.visibleLevels.size());
+        PGE_STATS_COUNT("visiblePaths", FileData.visiblePaths.size());
+        PGE_STATS_COUNT("visibleScenery", FileData.visibleScenery.size());
+        PGE_STATS_COUNT("gottenStars", FileData.gottenStars.size());
+        PGE_STATS_PHASE(PHASE_POSTPROCESS);
+        FileData.buildLookupMaps();
         FileData.meta.ReadFileValid = true;
         return true;
     }
@@ -34,6 +34,682 @@
 #include <QFileInfo>
 #endif
 
+//*********************************************************
+//****************JOURNAL RECORDS**************************
+//*********************************************************
+
+/*
+ * The journal is a sequence of JOURNAL sections appended to the end of the
+ * game save file. Each item of the section is one change record, identified
+ * by the "OP" marker, which is replayed over the state described by all
+ * previous sections of the file:
+ *
+ *  HDR - set all header values
+ *  CHN, PLN - resize the list of character states / characters per players
+ *  CHR, PLR - set the entry of character states / characters per players
+ *  VLV, VPA, VSC - set visibility of the level / path / scenery
+ *  VLX, VPX, VSX - remove the visibility entry of level / path / scenery
+ *  STR, STX - add / remove the gotten star
+ *  USC, USX - create / remove the user data section
+ *  UDS, UDX - set / remove the user data entry
+ */
+
+/*!
+ * \brief One change record of the game save journal
+ */
+struct SavxJournalRecord
+{
+    //! Kind of record
+    PGESTRING op;
+    //! Header values
+    int lives = 0;
+    unsigned int coins = 0;
+    unsigned int points = 0;
+    unsigned int totalStars = 0;
+    long worldPosX = 0;
+    long worldPosY = 0;
+    unsigned long lastHubWarp = 0;
+    unsigned int musicID = 0;
+    PGESTRING musicFile;
+    bool gameCompleted = false;
+    //! Index of element, or new size of the list
+    unsigned long index = 0;
+    //! Character state
+    saveCharState character;
+    //! ID of character or of visible element
+    unsigned long id = 0;
+    //! Visibility of element
+    bool visible = false;
+    //! Gotten star
+    starOnLevel star;
+    //! User data section
+    int location = saveUserData::DATA_WORLD;
+    PGESTRING locationName;
+    PGESTRING sectionName = "default";
+    //! User data entry
+    PGESTRING key;
+    PGESTRING value;
+};
+
+static void savxJournalWrite(PGESTRING &out, const SavxJournalRecord &r)
+{
+    out += PGEFile::value("OP", PGEFile::WriteStr(r.op));
+
+    if(r.op == "HDR")
+    {
+        out += PGEFile::value("LV", PGEFile::WriteInt(r.lives));
+        out += PGEFile::value("CN", PGEFile::WriteInt(r.coins));
+        out += PGEFile::value("PT", PGEFile::WriteInt(r.points));
+        out += PGEFile::value("TS", PGEFile::WriteInt(r.totalStars));
+        out += PGEFile::value("WX", PGEFile::WriteInt(r.worldPosX));
+        out += PGEFile::value("WY", PGEFile::WriteInt(r.worldPosY));
+        out += PGEFile::value("HW", PGEFile::WriteInt(r.lastHubWarp));
+        out += PGEFile::value("MI", PGEFile::WriteInt(r.musicID));
+        out += PGEFile::value("MF", PGEFile::WriteStr(r.musicFile));
+        out += PGEFile::value("GC", PGEFile::WriteBool(r.gameCompleted));
+    }
+    else if(r.op == "CHN" || r.op == "PLN")
+        out += PGEFile::value("I", PGEFile::WriteInt(r.index));
+    else if(r.op == "CHR")
+    {
+        out += PGEFile::value("I", PGEFile::WriteInt(r.index));
+        out += PGEFile::value("CI", PGEFile::WriteInt(r.character.id));
+        out += PGEFile::value("ST", PGEFile::WriteInt(r.character.state));
+        out += PGEFile::value("IT", PGEFile::WriteInt(r.character.itemID));
+        out += PGEFile::value("MT", PGEFile::WriteInt(r.character.mountType));
+        out += PGEFile::value("MO", PGEFile::WriteInt(r.character.mountID));
+        out += PGEFile::value("HL", PGEFile::WriteInt(r.character.health));
+    }
+    else if(r.op == "PLR")
+    {
+        out += PGEFile::value("I", PGEFile::WriteInt(r.index));
+        out += PGEFile::value("ID", PGEFile::WriteInt(r.id));
+    }
+    else if(r.op == "VLV" || r.op == "VPA" || r.op == "VSC")
+    {
+        out += PGEFile::value("ID", PGEFile::WriteInt(r.id));
+        out += PGEFile::value("V", PGEFile::WriteBool(r.visible));
+    }
+    else if(r.op == "VLX" || r.op == "VPX" || r.op == "VSX")
+        out += PGEFile::value("ID", PGEFile::WriteInt(r.id));
+    else if(r.op == "STR" || r.op == "STX")
+    {
+        out += PGEFile::value("L", PGEFile::WriteStr(r.star.first));
+        out += PGEFile::value("S", PGEFile::WriteInt(r.star.second));
+    }
+    else
+    {
+        out += PGEFile::value("UL", PGEFile::WriteInt(r.location));
+        out += PGEFile::value("LN", PGEFile::WriteStr(r.locationName));
+        out += PGEFile::value("SN", PGEFile::WriteStr(r.sectionName));
+        if(r.op == "UDS" || r.op == "UDX")
+            out += PGEFile::value("UK", PGEFile::WriteStr(r.key));
+        if(r.op == "UDS")
+            out += PGEFile::value("UV", PGEFile::WriteStr(r.value));
+    }
+
+    out += "\n";
+}
+
+static long savxFindSection(const saveUserData &u, const SavxJournalRecord &r)
+{
+    return u.findSection(r.location, r.locationName, r.sectionName);
+}
+
+/*!
+ * \brief Applies the journal record to the game save
+ * \param d Game save data
+ * \param r Journal record
+ * \return false if record is unknown or its index is out of range
+ */
+static bool savxJournalApply(GamesaveData &d, const SavxJournalRecord &r)
+{
+    if(r.op == "HDR")
+    {
+        d.lives = r.lives;
+        d.coins = r.coins;
+        d.points = r.points;
+        d.totalStars = r.totalStars;
+        d.worldPosX = r.worldPosX;
+        d.worldPosY = r.worldPosY;
+        d.last_hub_warp = r.lastHubWarp;
+        d.musicID = r.musicID;
+        d.musicFile = r.musicFile;
+        d.gameCompleted = r.gameCompleted;
+    }
+    // Lists grow by one element with every next record, the new size
+    // given by the file is never allocated at once
+    else if(r.op == "CHN")
+    {
+        if(r.index < static_cast<unsigned long>(d.characterStates.size()))
+            d.characterStates.resize(static_cast<pge_size_t>(r.index));
+    }
+    else if(r.op == "CHR")
+    {
+        if(r.index > static_cast<unsigned long>(d.characterStates.size()))
+            return false;
+        if(r.index == static_cast<unsigned long>(d.characterStates.size()))
+            d.characterStates.push_back(r.character);
+        else
+            d.characterStates[static_cast<pge_size_t>(r.index)] = r.character;
+    }
+    else if(r.op == "PLN")
+    {
+        if(r.index < static_cast<unsigned long>(d.currentCharacter.size()))
+            d.currentCharacter.resize(static_cast<pge_size_t>(r.index));
+    }
+    else if(r.op == "PLR")
+    {
+        if(r.index > static_cast<unsigned long>(d.currentCharacter.size()))
+            return false;
+        if(r.index == static_cast<unsigned long>(d.currentCharacter.size()))
+            d.currentCharacter.push_back(r.id);
+        else
+            d.currentCharacter[static_cast<pge_size_t>(r.index)] = r.id;
+    }
+    else if(r.op == "VLV")
+        d.visibleLevels_map.set(d.visibleLevels, static_cast<unsigned int>(r.id), r.visible);
+    else if(r.op == "VPA")
+        d.visiblePaths_map.set(d.visiblePaths, static_cast<unsigned int>(r.id), r.visible);
+    else if(r.op == "VSC")
+        d.visibleScenery_map.set(d.visibleScenery, static_cast<unsigned int>(r.id), r.visible);
+    else if(r.op == "VLX")
+        d.visibleLevels_map.erase(d.visibleLevels, static_cast<unsigned int>(r.id));
+    else if(r.op == "VPX")
+        d.visiblePaths_map.erase(d.visiblePaths, static_cast<unsigned int>(r.id));
+    else if(r.op == "VSX")
+        d.visibleScenery_map.erase(d.visibleScenery, static_cast<unsigned int>(r.id));
+    else if(r.op == "STR")
+        d.gottenStars_map.insert(d.gottenStars, r.star);
+    else if(r.op == "STX")
+        d.gottenStars_map.erase(d.gottenStars, r.star);
+    else if(r.op == "USC")
+        d.userData.addSection(r.location, r.locationName, r.sectionName);
+    else if(r.op == "UDS")
+        d.userData.setValue(d.userData.addSection(r.location, r.locationName, r.sectionName), r.key, r.value);
+    else if(r.op == "USX")
+        d.userData.removeSection(savxFindSection(d.userData, r));
+    else if(r.op == "UDX")
+        d.userData.removeValue(savxFindSection(d.userData, r), r.key);
+    else
+        return false;
+
+    return true;
+}
+
+static bool savxEqualChar(const saveCharState &a, const saveCharState &b)
+{
+    return a.id == b.id && a.state == b.state && a.itemID == b.itemID &&
+           a.mountType == b.mountType && a.mountID == b.mountID && a.health == b.health;
+}
+
+/*!
+ * \brief Normalized location of user data section, as it gets after the save and load
+ */
+static int savxSectionLocation(const saveUserData::DataSection &s)
+{
+    return s.location & saveUserData::DATA_LOCATION_MASK;
+}
+
+static bool savxSectionIsVolatile(const saveUserData::DataSection &s)
+{
+    return (s.location & saveUserData::DATA_VOLATILE_FLAG) != 0;
+}
+
+/*!
+ * \brief Finds the user data section by the normalized identity of the journal record
+ * \param u User data
+ * \param r Journal record
+ * \return Index of the first matching section or -1 if not found
+ */
+static long savxFindNormalizedSection(const saveUserData &u, const SavxJournalRecord &r)
+{
+    long i = savxFindSection(u, r);
+    if(i >= 0)
+        return i;
+
+    // Sections with empty names or extra location bits aren't found by their saved identity
+    for(i = 0; i < static_cast<long>(u.store.size()); i++)
+    {
+        const saveUserData::DataSection &s = u.store[i];
+        if(!savxSectionIsVolatile(s) && savxSectionLocation(s) == r.location &&
+           s.location_name == r.locationName &&
+           (IsEmpty(s.name) ? PGESTRING("default") : s.name) == r.sectionName)
+            return i;
+    }
+
+    return -1;
+}
+
+/*!
+ * \brief Checks that the order of elements is reproducible by the journal
+ *
+ * Journal removes elements in place and appends new ones to the end. The
+ * elements kept in the new state must therefore follow in their old order,
+ * and all new elements must go after them.
+ */
+struct SavxJournalOrder
+{
+    long last = -1;
+    bool added = false;
+
+    /*!
+     * \brief Takes the next element of the new state
+     * \param oldIndex Index of the element in the old state, -1 for the new element
+     * \return false if order can't be reproduced
+     */
+    bool next(long oldIndex)
+    {
+        if(oldIndex < 0)
+        {
+            added = true;
+            return true;
+        }
+        if(added || oldIndex <= last)
+            return false;
+        last = oldIndex;
+        return true;
+    }
+};
+
+/*!
+ * \brief Gives the lookup map of the list, filling the local one if the list has no map built
+ */
+template<class Map, class List>
+static const Map &savxLookup(const Map &map, const List &list, Map &local)
+{
+    if(map.isEnabled())
+        return map;
+    local.rebuild(list);
+    return local;
+}
+
+static bool savxDiffVisible(PGELIST<SavxJournalRecord> &out,
+                            const PGELIST<visibleItem> &from, const VisibleItemsMap &fromMap,
+                            const PGELIST<visibleItem> &to, const VisibleItemsMap &toMap,
+                            const char *setOp, const char *removeOp)
+{
+    VisibleItemsMap fromLocal, toLocal;
+    const VisibleItemsMap &fromLookup = savxLookup(fromMap, from, fromLocal);
+    const VisibleItemsMap &toLookup = savxLookup(toMap, to, toLocal);
+    SavxJournalRecord r;
+
+    for(long i = 0; i < static_cast<long>(from.size()); i++)
+    {
+        const visibleItem &v = from[i];
+        // Duplicated entries can't be removed one by one
+        if(fromLookup.find(from, v.first) != i)
+            return false;
+        if(toLookup.find(to, v.first) < 0)
+        {
+            r.op = removeOp;
+            r.id = v.first;
+            out.push_back(r);
+        }
+    }
+
+    SavxJournalOrder order;
+    for(long i = 0; i < static_cast<long>(to.size()); i++)
+    {
+        const visibleItem &v = to[i];
+        long oi = fromLookup.find(from, v.first);
+        if(toLookup.find(to, v.first) != i || !order.next(oi))
+            return false;
+        if(oi < 0 || from[oi].second != v.second)
+        {
+            r.op = setOp;
+            r.id = v.first;
+            r.visible = v.second;
+            out.push_back(r);
+        }
+    }
+
+    return true;
+}
+
+static bool savxDiffStars(PGELIST<SavxJournalRecord> &out, const GamesaveData &from, const GamesaveData &to)
+{
+    GottenStarsMap fromLocal, toLocal;
+    const GottenStarsMap &fromLookup = savxLookup(from.gottenStars_map, from.gottenStars, fromLocal);
+    const GottenStarsMap &toLookup = savxLookup(to.gottenStars_map, to.gottenStars, toLocal);
+    SavxJournalRecord r;
+
+    for(long i = 0; i < static_cast<long>(from.gottenStars.size()); i++)
+    {
+        const starOnLevel &s = from.gottenStars[i];
+        if(fromLookup.find(from.gottenStars, s) != i)
+            return false;
+        if(!toLookup.contains(to.gottenStars, s))
+        {
+            r.op = "STX";
+            r.star = s;
+            out.push_back(r);
+        }
+    }
+
+    SavxJournalOrder order;
+    for(long i = 0; i < static_cast<long>(to.gottenStars.size()); i++)
+    {
+        const starOnLevel &s = to.gottenStars[i];
+        long oi = fromLookup.find(from.gottenStars, s);
+        if(toLookup.find(to.gottenStars, s) != i || !order.next(oi))
+            return false;
+        if(oi < 0)
+        {
+            r.op = "STR";
+            r.star = s;
+            out.push_back(r);
+        }
+    }
+
+    return true;
+}
+
+static void savxSectionRecord(SavxJournalRecord &r, const char *op, const saveUserData::DataSection &s)
+{
+    r.op = op;
+    r.location = savxSectionLocation(s);
+    r.locationName = s.location_name;
+    r.sectionName = IsEmpty(s.name) ? PGESTRING("default") : s.name;
+}
+
+static bool savxDiffUserData(PGELIST<SavxJournalRecord> &out, const saveUserData &from, const saveUserData &to)
+{
+    SavxJournalRecord r;
+
+    for(long si = 0; si < static_cast<long>(from.store.size()); si++)
+    {
+        const saveUserData::DataSection &s = from.store[si];
+        if(savxSectionIsVolatile(s))
+            continue;
+        savxSectionRecord(r, "USX", s);
+        if(savxFindNormalizedSection(from, r) != si)
+            return false;
+        if(savxFindNormalizedSection(to, r) < 0)
+            out.push_back(r);
+    }
+
+    SavxJournalOrder sectionOrder;
+    for(long si = 0; si < static_cast<long>(to.store.size()); si++)
+    {
+        const saveUserData::DataSection &s = to.store[si];
+        if(savxSectionIsVolatile(s))
+            continue;
+        savxSectionRecord(r, "USC", s);
+        long oi = savxFindNormalizedSection(from, r);
+        if(savxFindNormalizedSection(to, r) != si || !sectionOrder.next(oi))
+            return false;
+
+        if(oi < 0)
+        {
+            out.push_back(r);
+            for(long ei = 0; ei < static_cast<long>(s.data.size()); ei++)
+            {
+                const saveUserData::DataEntry &e = s.data[ei];
+                if(to.findKey(si, e.key) != ei)
+                    return false;
+                savxSectionRecord(r, "UDS", s);
+                r.key = e.key;
+                r.value = e.value;
+                out.push_back(r);
+            }
+            continue;
+        }
+
+        const saveUserData::DataSection &o = from.store[oi];
+        for(long ei = 0; ei < static_cast<long>(o.data.size()); ei++)
+        {
+            const saveUserData::DataEntry &e = o.data[ei];
+            if(from.findKey(oi, e.key) != ei)
+                return false;
+            if(to.findKey(si, e.key) < 0)
+            {
+                savxSectionRecord(r, "UDX", s);
+                r.key = e.key;
+                out.push_back(r);
+            }
+        }
+
+        SavxJournalOrder keyOrder;
+        for(long ei = 0; ei < static_cast<long>(s.data.size()); ei++)
+        {
+            const saveUserData::DataEntry &e = s.data[ei];
+            long ok = from.findKey(oi, e.key);
+            if(to.findKey(si, e.key) != ei || !keyOrder.next(ok))
+                return false;
+            if(ok < 0 || o.data[ok].value != e.value)
+            {
+                savxSectionRecord(r, "UDS", s);
+                r.key = e.key;
+                r.value = e.value;
+                out.push_back(r);
+            }
+        }
+    }
+
+    return true;
+}
+
+#ifndef NDEBUG
+/*!
+ * \brief Brings the user data to the form it gets after the save and load
+ * \param u User data
+ */
+static void savxNormalizeUserData(saveUserData &u)
+{
+    for(auto it = u.store.begin(); it != u.store.end();)
+    {
+        if((it->location & saveUserData::DATA_VOLATILE_FLAG) != 0)
+        {
+            it = u.store.erase(it);
+            continue;
+        }
+        it->location &= saveUserData::DATA_LOCATION_MASK;
+        if(IsEmpty(it->name))
+            it->name = "default";
+        ++it;
+    }
+}
+
+static bool savxEqualSection(const saveUserData::DataSection &a, const saveUserData::DataSection &b)
+{
+    if(a.location != b.location || a.location_name != b.location_name ||
+       a.name != b.name || a.data.size() != b.data.size())
+        return false;
+    for(pge_size_t i = 0; i < a.data.size(); i++)
+    {
+        if(a.data[i].key != b.data[i].key || a.data[i].value != b.data[i].value)
+            return false;
+    }
+    return true;
+}
+
+/*!
+ * \brief Compares everything stored into the PGE-X game save
+ */
+static bool savxEqual(const GamesaveData &a, const GamesaveData &b)
+{
+    if(a.lives != b.lives || a.coins != b.coins || a.points != b.points ||
+       a.totalStars != b.totalStars || a.worldPosX != b.worldPosX ||
+       a.worldPosY != b.worldPosY || a.last_hub_warp != b.last_hub_warp ||
+       a.musicID != b.musicID || a.musicFile != b.musicFile ||
+       a.gameCompleted != b.gameCompleted)
+        return false;
+
+    if(a.characterStates.size() != b.characterStates.size() ||
+       a.userData.store.size() != b.userData.store.size())
+        return false;
+    for(pge_size_t i = 0; i < a.characterStates.size(); i++)
+    {
+        if(!savxEqualChar(a.characterStates[i], b.characterStates[i]))
+            return false;
+    }
+    for(pge_size_t i = 0; i < a.userData.store.size(); i++)
+    {
+        if(!savxEqualSection(a.userData.store[i], b.userData.store[i]))
+            return false;
+    }
+
+    return a.currentCharacter == b.currentCharacter &&
+           a.visibleLevels == b.visibleLevels &&
+           a.visiblePaths == b.visiblePaths &&
+           a.visibleScenery == b.visibleScenery &&
+           a.gottenStars == b.gottenStars;
+}
+
+/*!
+ * \brief Replays the journal records over the copy of the old state
+ * \return true if records give the new state
+ */
+static bool savxJournalVerify(const GamesaveData &from, const GamesaveData &to, const PGELIST<SavxJournalRecord> &records)
+{
+    GamesaveData src = from, dst = to;
+    savxNormalizeUserData(src.userData);
+    savxNormalizeUserData(dst.userData);
+    src.buildLookupMaps();
+    for(const SavxJournalRecord &rec : records)
+        savxJournalApply(src, rec);
+    return savxEqual(src, dst);
+}
+#endif
+
+/*!
+ * \brief Makes the journal records which turn one game save state into another
+ * \param [__in] from State stored in the file
+ * \param [__in] to New state
+ * \param [__out] out Journal records
+ * \return false if change can't be expressed by the journal, and the file should be rewritten
+ *
+ * States are compared in place through their lookup maps. Debug builds also
+ * replay the records over a copy of the old state to check them.
+ */
+static bool savxJournalDiff(const GamesaveData &from, const GamesaveData &to, PGELIST<SavxJournalRecord> &out)
+{
+    out.clear();
+
+    SavxJournalRecord r;
+
+    if(from.lives != to.lives || from.coins != to.coins || from.points != to.points ||
+       from.totalStars != to.totalStars || from.worldPosX != to.worldPosX ||
+       from.worldPosY != to.worldPosY || from.last_hub_warp != to.last_hub_warp ||
+       from.musicID != to.musicID || from.musicFile != to.musicFile ||
+       from.gameCompleted != to.gameCompleted)
+    {
+        r.op = "HDR";
+        r.lives = to.lives;
+        r.coins = to.coins;
+        r.points = to.points;
+        r.totalStars = to.totalStars;
+        r.worldPosX = to.worldPosX;
+        r.worldPosY = to.worldPosY;
+        r.lastHubWarp = to.last_hub_warp;
+        r.musicID = to.musicID;
+        r.musicFile = to.musicFile;
+        r.gameCompleted = to.gameCompleted;
+        out.push_back(r);
+    }
+
+    if(from.characterStates.size() != to.characterStates.size())
+    {
+        r.op = "CHN";
+        r.index = static_cast<unsigned long>(to.characterStates.size());
+        out.push_back(r);
+    }
+    for(pge_size_t i = 0; i < to.characterStates.size(); i++)
+    {
+        if(i < from.characterStates.size() && savxEqualChar(from.characterStates[i], to.characterStates[i]))
+            continue;
+        r.op = "CHR";
+        r.index = static_cast<unsigned long>(i);
+        r.character = to.characterStates[i];
+        out.push_back(r);
+    }
+
+    if(from.currentCharacter.size() != to.currentCharacter.size())
+    {
+        r.op = "PLN";
+        r.index = static_cast<unsigned long>(to.currentCharacter.size());
+        out.push_back(r);
+    }
+    for(pge_size_t i = 0; i < to.currentCharacter.size(); i++)
+    {
+        if(i < from.currentCharacter.size() && from.currentCharacter[i] == to.currentCharacter[i])
+            continue;
+        r.op = "PLR";
+        r.index = static_cast<unsigned long>(i);
+        r.id = to.currentCharacter[i];
+        out.push_back(r);
+    }
+
+    if(!savxDiffVisible(out, from.visibleLevels, from.visibleLevels_map,
+                        to.visibleLevels, to.visibleLevels_map, "VLV", "VLX") ||
+       !savxDiffVisible(out, from.visiblePaths, from.visiblePaths_map,
+                        to.visiblePaths, to.visiblePaths_map, "VPA", "VPX") ||
+       !savxDiffVisible(out, from.visibleScenery, from.visibleScenery_map,
+                        to.visibleScenery, to.visibleScenery_map, "VSC", "VSX") ||
+       !savxDiffStars(out, from, to) ||
+       !savxDiffUserData(out, from.userData, to.userData))
+        return false;
+
+#ifndef NDEBUG
+    if(!savxJournalVerify(from, to, out))
+        return false;
+#endif
+
+    return true;
+}
+
+/*!
+ * \brief Drops the JOURNAL section which was cut before its end by an interrupted append
+ * \param raw Content of the game save file
+ * \return true if the section was dropped
+ */
+static bool savxDropUnclosedJournal(PGESTRING &raw)
+{
+    static const PGESTRING sectionBegin = "JOURNAL";
+    bool dropped = false;
+#ifdef PGE_FILES_QT
+    // Append was cut inside the line of section header or end
+    if(!raw.isEmpty() && !raw.endsWith('\n'))
+    {
+        int lineBegin = raw.lastIndexOf('\n') + 1;
+        PGESTRING line = raw.mid(lineBegin);
+        if(sectionBegin.startsWith(line))
+        {
+            raw.truncate(lineBegin);
+            dropped = true;
+        }
+    }
+
+    int begin = raw.lastIndexOf("\nJOURNAL\n");
+    if(begin >= 0 && raw.indexOf("\nJOURNAL_END", begin) < 0)
+    {
+        raw.truncate(begin + 1);
+        dropped = true;
+    }
+#else
+    // Append was cut inside the line of section header or end
+    if(!raw.empty() && raw.back() != '\n')
+    {
+        size_t lineBegin = raw.rfind('\n');
+        lineBegin = (lineBegin == std::string::npos) ? 0 : lineBegin + 1;
+        if(sectionBegin.compare(0, raw.size() - lineBegin, raw, lineBegin, std::string::npos) == 0)
+        {
+            raw.resize(lineBegin);
+            dropped = true;
+        }
+    }
+
+    size_t begin = raw.rfind("\nJOURNAL\n");
+    if(begin != std::string::npos && raw.find("\nJOURNAL_END", begin) == std::string::npos)
+    {
+        raw.resize(begin + 1);
+        dropped = true;
+    }
+#endif
+    return dropped;
+}
+
 //*********************************************************
 //****************READ FILE FORMAT*************************
 //*********************************************************
@@ -73,6 +749,7 @@ bool FileFormats::ReadExtendedSaveFileRaw(PGESTRING &rawdata, const PGESTRING &f
 
 bool FileFormats::ReadExtendedSaveFile(PGE_FileFormats_misc::TextInput &in, GamesaveData &FileData)
 {
+    PGE_STATS_BEGIN("PGE-X SAVX", PHASE_IO);
     FileData = CreateGameSaveData();
     PGESTRING errorString;
     PGEX_FileBegin();
@@ -80,6 +757,9 @@ bool FileFormats::ReadExtendedSaveFile(PGE_FileFormats_misc::TextInput &in, Game
     visibleItem        vz_item;
     starOnLevel        star_level;
     saveUserData::DataSection user_data_entry;
+    SavxJournalRecord journal_record;
+    //! Lookup maps are built once before replay of journal, data sections after it make them stale
+    bool lookupMapsBuilt = false;
     //Add path data
     PGESTRING fPath = in.getFilePath();
 
@@ -95,7 +775,9 @@ bool FileFormats::ReadExtendedSaveFile(PGE_FileFormats_misc::TextInput &in, Game
     FileData.meta.untitled = false;
     FileData.meta.modified = false;
     ///////////////////////////////////////Begin file///////////////////////////////////////
-    PGEX_FileParseTree(in.readAll());
+    PGESTRING rawData = in.readAll();
+    FileData.journalTruncated = savxDropUnclosedJournal(rawData);
+    PGEX_FileParseTree(rawData);
     PGEX_FetchSection()
     {
         PGEX_FetchSection_begin()
@@ -126,6 +808,7 @@ bool FileFormats::ReadExtendedSaveFile(PGE_FileFormats_misc::TextInput &in, Game
         PGEX_Section("CHARACTERS")
         {
             PGEX_SectionBegin(PGEFile::PGEX_Struct);
+            PGEX_ReserveItems(FileData.characterStates);
             PGEX_Items()
             {
                 PGEX_ItemBegin(PGEFile::PGEX_Struct);
@@ -140,13 +823,14 @@ bool FileFormats::ReadExtendedSaveFile(PGE_FileFormats_misc::TextInput &in, Game
                     PGEX_UIntVal("MI", plr_state.mountID)
                     PGEX_UIntVal("HL", plr_state.health)
                 }
-                FileData.characterStates.push_back(plr_state);
+                FileData.characterStates.push_back(std::move(plr_state));
             }
         }//CHARACTERS
         ///////////////////CHARACTERS_PER_PLAYERS//////////////////////
         PGEX_Section("CHARACTERS_PER_PLAYERS")
         {
             PGEX_SectionBegin(PGEFile::PGEX_Struct);
+            PGEX_ReserveItems(FileData.currentCharacter);
             PGEX_Items()
             {
                 PGEX_ItemBegin(PGEFile::PGEX_Struct);
@@ -163,6 +847,8 @@ bool FileFormats::ReadExtendedSaveFile(PGE_FileFormats_misc::TextInput &in, Game
         PGEX_Section("VIZ_LEVELS")
         {
             PGEX_SectionBegin(PGEFile::PGEX_Struct);
+            lookupMapsBuilt = false;
+            PGEX_ReserveItems(FileData.visibleLevels);
             PGEX_Items()
             {
                 PGEX_ItemBegin(PGEFile::PGEX_Struct);
@@ -181,6 +867,8 @@ bool FileFormats::ReadExtendedSaveFile(PGE_FileFormats_misc::TextInput &in, Game
         PGEX_Section("VIZ_PATHS")
         {
             PGEX_SectionBegin(PGEFile::PGEX_Struct);
+            lookupMapsBuilt = false;
+            PGEX_ReserveItems(FileData.visiblePaths);
             PGEX_Items()
             {
                 PGEX_ItemBegin(PGEFile::PGEX_Struct);
@@ -199,6 +887,8 @@ bool FileFormats::ReadExtendedSaveFile(PGE_FileFormats_misc::TextInput &in, Game
         PGEX_Section("VIZ_SCENERY")
         {
             PGEX_SectionBegin(PGEFile::PGEX_Struct);
+            lookupMapsBuilt = false;
+            PGEX_ReserveItems(FileData.visibleScenery);
             PGEX_Items()
             {
                 PGEX_ItemBegin(PGEFile::PGEX_Struct);
@@ -217,6 +907,8 @@ bool FileFormats::ReadExtendedSaveFile(PGE_FileFormats_misc::TextInput &in, Game
         PGEX_Section("STARS")
         {
             PGEX_SectionBegin(PGEFile::PGEX_Struct);
+            lookupMapsBuilt = false;
+            PGEX_ReserveItems(FileData.gottenStars);
             PGEX_Items()
             {
                 PGEX_ItemBegin(PGEFile::PGEX_Struct);
@@ -228,13 +920,15 @@ bool FileFormats::ReadExtendedSaveFile(PGE_FileFormats_misc::TextInput &in, Game
                     PGEX_StrVal("L", star_level.first)
                     PGEX_USIntVal("S", star_level.second)
                 }
-                FileData.gottenStars.push_back(star_level);
+                FileData.gottenStars.push_back(std::move(star_level));
             }
         }//STARS
         ///////////////////USERDATA//////////////////////
         PGEX_Section("USERDATA")
         {
             PGEX_SectionBegin(PGEFile::PGEX_Struct);
+            lookupMapsBuilt = false;
+            PGEX_ReserveItems(FileData.userData.store);
             PGEX_Items()
             {
                 PGEX_ItemBegin(PGEFile::PGEX_Struct);
@@ -260,14 +954,74 @@ bool FileFormats::ReadExtendedSaveFile(PGE_FileFormats_misc::TextInput &in, Game
                         goto badfile;
                     e.key = PGE_ReplSTRING(PGEFile::X2STRING(dp[0]), "\\q", "=");
                     e.value = PGE_ReplSTRING(PGEFile::X2STRING(dp[1]), "\\q", "=");
-                    user_data_entry.data.push_back(e);
+                    user_data_entry.data.push_back(std::move(e));
                 }
-                FileData.userData.store.push_back(user_data_entry);
+                FileData.userData.store.push_back(std::move(user_data_entry));
             }
         }//USERDATA
+
+        ///////////////////JOURNAL//////////////////////
+        PGEX_Section("JOURNAL")
+        {
+            if(!lookupMapsBuilt)
+                FileData.buildLookupMaps();
+            lookupMapsBuilt = true;
+            PGEX_SectionBegin(PGEFile::PGEX_Struct);
+            PGEX_Items()
+            {
+                PGEX_ItemBegin(PGEFile::PGEX_Struct);
+                journal_record = SavxJournalRecord();
+                PGEX_Values() //Look markers and values
+                {
+                    PGEX_ValueBegin()
+                    PGEX_StrVal("OP", journal_record.op)
+                    PGEX_SIntVal("LV", journal_record.lives)
+                    PGEX_UIntVal("CN", journal_record.coins)
+                    PGEX_UIntVal("PT", journal_record.points)
+                    PGEX_UIntVal("TS", journal_record.totalStars)
+                    PGEX_SLongVal("WX", journal_record.worldPosX)
+                    PGEX_SLongVal("WY", journal_record.worldPosY)
+                    PGEX_ULongVal("HW", journal_record.lastHubWarp)
+                    PGEX_UIntVal("MI", journal_record.musicID)
+                    PGEX_StrVal("MF", journal_record.musicFile)
+                    PGEX_BoolVal("GC", journal_record.gameCompleted)
+                    PGEX_ULongVal("I", journal_record.index)
+                    PGEX_ULongVal("CI", journal_record.character.id)
+                    PGEX_ULongVal("ST", journal_record.character.state)
+                    PGEX_ULongVal("IT", journal_record.character.itemID)
+                    PGEX_UIntVal("MT", journal_record.character.mountType)
+                    PGEX_UIntVal("MO", journal_record.character.mountID)
+                    PGEX_UIntVal("HL", journal_record.character.health)
+                    PGEX_ULongVal("ID", journal_record.id)
+                    PGEX_BoolVal("V", journal_record.visible)
+                    PGEX_StrVal("L", journal_record.star.first)
+                    PGEX_SIntVal("S", journal_record.star.second)
+                    PGEX_SIntVal("UL", journal_record.location)
+                    PGEX_StrVal("LN", journal_record.locationName)
+                    PGEX_StrVal("SN", journal_record.sectionName)
+                    PGEX_StrVal("UK", journal_record.key)
+                    PGEX_StrVal("UV", journal_record.value)
+                }
+                if(!savxJournalApply(FileData, journal_record))
+                {
+                    errorString = "Invalid journal record: " + journal_record.op;
+                    goto badfile;
+                }
+                FileData.journalRecords++;
+            }
+        }//JOURNAL
     }
     ///////////////////////////////////////EndFile///////////////////////////////////////
+    PGE_STATS_COUNT("characterStates", FileData.characterStates.size());
+    PGE_STATS_COUNT("visibleLevels", FileData.visibleLevels.size());
+    PGE_STATS_COUNT("visiblePaths", FileData.visiblePaths.size());
+    PGE_STATS_COUNT("visibleScenery", FileData.visibleScenery.size());
+    PGE_STATS_COUNT("gottenStars", FileData.gottenStars.size());
+    PGE_STATS_COUNT("journalRecords", FileData.journalRecords);
+    PGE_STATS_PHASE(PHASE_POSTPROCESS);
     errorString.clear(); //If no errors, clear string;
+    if(!lookupMapsBuilt)
+        FileData.buildLookupMaps();
     FileData.meta.ReadFileValid = true;
     return true;
 badfile:    //If file format not corrects
@@ -452,3 +1206,114 @@ bool FileFormats::WriteExtendedSaveFile(PGE_FileFormats_misc::TextOutput &out, G
     out << "\n";
     return true;
 }
+
+/*!
+ * \brief Updates lookups of the state which went stale after direct modifications
+ * \param data Game save state
+ */
+static void savxUpdateLookups(GamesaveData &data)
+{
+    data.visibleLevels_map.update(data.visibleLevels);
+    data.visiblePaths_map.update(data.visiblePaths);
+    data.visibleScenery_map.update(data.visibleScenery);
+    data.gottenStars_map.update(data.gottenStars);
+    data.userData.updateIndex();
+}
+
+/*!
+ * \brief Makes the JOURNAL section or tells that file should be rewritten
+ * \param [__in] savedState State stored in the file, its lookups get updated
+ * \param [__in] FileData New state, its lookups get updated
+ * \param [__in] maxRecords Maximum number of journal records in the file
+ * \param [__out] journal Section to append, empty if nothing changed
+ * \param [__out] records Number of records in the section
+ * \return false if file should be compacted
+ */
+static bool savxMakeJournalSection(GamesaveData &savedState, GamesaveData &FileData,
+                                   unsigned long maxRecords, PGESTRING &journal, unsigned long &records)
+{
+    PGELIST<SavxJournalRecord> diff;
+    journal.clear();
+    records = 0;
+
+    // Records appended after the cut section would be read as a part of it
+    if(savedState.journalTruncated)
+        return false;
+
+    savxUpdateLookups(savedState);
+    savxUpdateLookups(FileData);
+    if(!savxJournalDiff(savedState, FileData, diff))
+        return false;
+
+    records = static_cast<unsigned long>(diff.size());
+    if(savedState.journalRecords + records > maxRecords)
+        return false;
+
+    if(records == 0)
+        return true;
+
+    journal = "JOURNAL\n";
+    for(const SavxJournalRecord &r : diff)
+        savxJournalWrite(journal, r);
+    journal += "JOURNAL_END\n";
+    return true;
+}
+
+bool FileFormats::AppendExtendedSaveJournalF(const PGESTRING &filePath, GamesaveData &savedState,
+                                             GamesaveData &FileData, unsigned long maxRecords)
+{
+    PGESTRING journal;
+    unsigned long records;
+    FileData.meta.ERROR_info.clear();
+
+    if(!savxMakeJournalSection(savedState, FileData, maxRecords, journal, records))
+    {
+        // Compact the journal by writing the whole file
+        if(!WriteExtendedSaveFileF(filePath, FileData))
+            return false;
+        FileData.journalRecords = 0;
+        FileData.journalTruncated = false;
+        savedState = FileData;
+        return true;
+    }
+
+    if(records > 0)
+    {
+        PGE_FileFormats_misc::TextFileOutput file;
+        if(!file.open(filePath, true, false, PGE_FileFormats_misc::TextOutput::append))
+        {
+            FileData.meta.ERROR_info = "Failed to open file for write";
+            return false;
+        }
+        file << journal;
+    }
+
+    records += savedState.journalRecords;
+    FileData.journalRecords = records;
+    savedState = FileData;
+    return true;
+}
+
+bool FileFormats::AppendExtendedSaveJournalRaw(GamesaveData &savedState, GamesaveData &FileData,
+                                               PGESTRING &rawdata, unsigned long maxRecords)
+{
+    PGESTRING journal;
+    unsigned long records;
+    FileData.meta.ERROR_info.clear();
+
+    if(!savxMakeJournalSection(savedState, FileData, maxRecords, journal, records))
+    {
+        if(!WriteExtendedSaveFileRaw(FileData, rawdata))
+            return false;
+        FileData.journalRecords = 0;
+        FileData.journalTruncated = false;
+        savedState = FileData;
+        return true;
+    }
+
+    rawdata += journal;
+    records += savedState.journalRecords;
+    FileData.journalRecords = records;
+    savedState = FileData;
+    return true;
+}
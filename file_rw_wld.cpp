@@ -31,6 +31,8 @@
 #include "smbx64.h"
 #include "smbx64_macro.h"
 #include "CSVUtils.h"
+#include "pge_parse_stats_private.h"
+#include "pge_arena_private.h"
 
 //*********************************************************
 //****************READ FILE FORMAT*************************
@@ -215,9 +217,11 @@ bool FileFormats::ReadSMBX64WldFileRaw(PGESTRING &rawdata, const PGESTRING &file
 
 bool FileFormats::ReadSMBX64WldFile(PGE_FileFormats_misc::TextInput &in, WorldData &FileData)
 {
+    PGE_STATS_BEGIN("SMBX64 WLD", PHASE_FIELDS);
     SMBX64_FileBegin();
     PGESTRING filePath = in.getFilePath();
 
+    PGE_ArenaStaging arenaStaging(FileData);
     CreateWorldData(FileData);
 
     FileData.meta.RecentFormat = WorldData::SMBX64;
@@ -331,7 +335,7 @@ bool FileFormats::ReadSMBX64WldFile(PGE_FileFormats_misc::TextInput &in, WorldDa
             FileData.tile_array_id++;
             tile.meta.index = (unsigned int)FileData.tiles.size(); //Apply element index
 
-            FileData.tiles.push_back(tile);
+            FileData.tiles.push_back(std::move(tile));
             nextLine();
         }
 
@@ -350,7 +354,7 @@ bool FileFormats::ReadSMBX64WldFile(PGE_FileFormats_misc::TextInput &in, WorldDa
             FileData.scene_array_id++;
             scen.meta.index = (unsigned int)FileData.scenery.size(); //Apply element index
 
-            FileData.scenery.push_back(scen);
+            FileData.scenery.push_back(std::move(scen));
 
             nextLine();
         }
@@ -370,7 +374,7 @@ bool FileFormats::ReadSMBX64WldFile(PGE_FileFormats_misc::TextInput &in, WorldDa
             FileData.path_array_id++;
             pathitem.meta.index = (unsigned int)FileData.paths.size(); //Apply element index
 
-            FileData.paths.push_back(pathitem);
+            FileData.paths.push_back(std::move(pathitem));
 
             nextLine();
         }
@@ -429,7 +433,7 @@ bool FileFormats::ReadSMBX64WldFile(PGE_FileFormats_misc::TextInput &in, WorldDa
             FileData.level_array_id++;
             lvlitem.meta.index = (unsigned int)FileData.levels.size(); //Apply element index
 
-            FileData.levels.push_back(lvlitem);
+            FileData.levels.push_back(std::move(lvlitem));
 
             nextLine();
         }
@@ -449,12 +453,21 @@ bool FileFormats::ReadSMBX64WldFile(PGE_FileFormats_misc::TextInput &in, WorldDa
             FileData.musicbox_array_id++;
             musicbox.meta.index = (unsigned int)FileData.music.size(); //Apply element index
 
-            FileData.music.push_back(musicbox);
+            FileData.music.push_back(std::move(musicbox));
 
             nextLine();
         }
         nextLine(); // Read last line
         ///////////////////////////////////////EndFile///////////////////////////////////////
+        PGE_STATS_COUNT("bytes", in.tell());
+        PGE_STATS_COUNT("lines", in.getCurrentLineNumber());
+        PGE_STATS_COUNT_WORLD(FileData);
+        PGE_STATS_PHASE(PHASE_POSTPROCESS);
+        if(WorldBuildSpatialIndexEnabled())
+            FileData.spatial_index.build(FileData);
+        if(WorldBuildPathGraphEnabled())
+            FileData.path_graph.build(FileData);
+        arenaStaging.commit(FileData);
         FileData.meta.ReadFileValid = true;
         return true;
     }
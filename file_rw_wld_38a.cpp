@@ -29,6 +29,8 @@
 #include "file_strlist.h"
 
 #include "smbx38a_private.h"
+#include "pge_parse_stats_private.h"
+#include "pge_arena_private.h"
 
 
 //*********************************************************
@@ -259,10 +261,12 @@ bool FileFormats::ReadSMBX38AWldFileRaw(PGESTRING& rawdata, const PGESTRING &fil
 
 bool FileFormats::ReadSMBX38AWldFile(PGE_FileFormats_misc::TextInput& in, WorldData& FileData)
 {
+    PGE_STATS_BEGIN("SMBX-38A WLD", PHASE_FIELDS);
     SMBX38A_FileBeginN();
     PGESTRING filePath = in.getFilePath();
     FileData.meta.ERROR_info.clear();
 
+    PGE_ArenaStaging arenaStaging(FileData);
     CreateWorldData(FileData);
 
     FileData.meta.RecentFormat = WorldData::SMBX38A;
@@ -435,7 +439,7 @@ bool FileFormats::ReadSMBX38AWldFile(PGE_FileFormats_misc::TextInput& in, WorldD
                                         MakeCSVPostProcessor(&tile.layer, PGELayerOrDefault)
                                         );
                 tile.meta.array_id = FileData.tile_array_id++;
-                FileData.tiles.push_back(tile);
+                FileData.tiles.push_back(std::move(tile));
             }
             else if(identifier == "S")
             {
@@ -451,7 +455,7 @@ bool FileFormats::ReadSMBX38AWldFile(PGE_FileFormats_misc::TextInput& in, WorldD
                                         MakeCSVPostProcessor(&scen.layer, PGELayerOrDefault)
                                         );
                 scen.meta.array_id = FileData.scene_array_id++;
-                FileData.scenery.push_back(scen);
+                FileData.scenery.push_back(std::move(scen));
             }
             else if(identifier == "P")
             {
@@ -467,7 +471,7 @@ bool FileFormats::ReadSMBX38AWldFile(PGE_FileFormats_misc::TextInput& in, WorldD
                                         MakeCSVPostProcessor(&pathitem.layer, PGELayerOrDefault)
                                         );
                 pathitem.meta.array_id = FileData.path_array_id++;
-                FileData.paths.push_back(pathitem);
+                FileData.paths.push_back(std::move(pathitem));
             }
             else if(identifier == "M")
             {
@@ -527,13 +531,13 @@ bool FileFormats::ReadSMBX38AWldFile(PGE_FileFormats_misc::TextInput& in, WorldD
                     musicbox.y          = arearect.y;
                     musicbox.layer      = arearect.layer;
                     musicbox.meta.array_id = FileData.musicbox_array_id++;
-                    FileData.music.push_back(musicbox);
+                    FileData.music.push_back(std::move(musicbox));
                 }
                 else
                 {
                     //Store as separated "Area-rect" type
                     arearect.meta.array_id = FileData.arearect_array_id++;
-                    FileData.arearects.push_back(arearect);
+                    FileData.arearects.push_back(std::move(arearect));
                 }
             }
             else if(identifier == "L")
@@ -633,7 +637,7 @@ bool FileFormats::ReadSMBX38AWldFile(PGE_FileFormats_misc::TextInput& in, WorldD
                                                         MakeCSVPostProcessor(&e.condition,  PGEUrlDecodeFunc),
                                                         MakeCSVPostProcessor(&e.levelIndex, PGEUrlDecodeFunc)
                                                         );
-                                            lvlitem.enter_cond.push_back(e);
+                                            lvlitem.enter_cond.push_back(std::move(e));
                                         }),
                                         //layer=layer name["" == "Default"][***urlencode!***]
                                         MakeCSVOptional(&lvlitem.layer, "Default", nullptr, PGELayerOrDefault),
@@ -655,7 +659,7 @@ bool FileFormats::ReadSMBX38AWldFile(PGE_FileFormats_misc::TextInput& in, WorldD
                                                                                  &node.y,
                                                                                  &node.chance
                                                                                  );
-                                                                     lvlitem.movement.nodes.push_back(node);
+                                                                     lvlitem.movement.nodes.push_back(std::move(node));
                                                                  }),
                                                                  MakeCSVOptionalIterator(dataReader, ':', [&lvlitem](const PGESTRING & nextFieldStr)
                                                                  {
@@ -666,12 +670,12 @@ bool FileFormats::ReadSMBX38AWldFile(PGE_FileFormats_misc::TextInput& in, WorldD
                                                                                  &line.node1,
                                                                                  &line.node2
                                                                                  );
-                                                                     lvlitem.movement.paths.push_back(line);
+                                                                     lvlitem.movement.paths.push_back(std::move(line));
                                                                  })
                                                                  )
                                         );
                 lvlitem.meta.array_id = FileData.level_array_id++;
-                FileData.levels.push_back(lvlitem);
+                FileData.levels.push_back(std::move(lvlitem));
             }
             else if(identifier == "WL")
             {
@@ -681,7 +685,7 @@ bool FileFormats::ReadSMBX38AWldFile(PGE_FileFormats_misc::TextInput& in, WorldD
                                         &layer.hidden
                                         );
                 layer.meta.array_id = FileData.layers_array_id++;
-                FileData.layers.push_back(layer);
+                FileData.layers.push_back(std::move(layer));
             }
             else if(identifier == "WE")
             {
@@ -730,7 +734,7 @@ bool FileFormats::ReadSMBX38AWldFile(PGE_FileFormats_misc::TextInput& in, WorldD
                                         //        lockl=[Level ID]Affected by Anchor
                                                             );
                 event.meta.array_id = FileData.events38A_array_id++;
-                FileData.events38A.push_back(event);
+                FileData.events38A.push_back(std::move(event));
             }
             else if((identifier == "WCT") || (identifier == "WCS") || (identifier == "WCL") )
             {
@@ -757,17 +761,17 @@ bool FileFormats::ReadSMBX38AWldFile(PGE_FileFormats_misc::TextInput& in, WorldD
                                                         {
                                                             WorldItemSetup38A::Entry e;
                                                             SMBX38A_CC_decode(e.key, e.value, nextFieldStr);
-                                                            customcfg.data.push_back(e);
+                                                            customcfg.data.push_back(std::move(e));
                                                         })
                                        );
-                FileData.custom38A_configs.push_back(customcfg);
+                FileData.custom38A_configs.push_back(std::move(customcfg));
             }
             else
             {
                 // Unsupported line, just keep it
                 PGESTRING str;
                 dataReader.ReadRawLine(str);
-                FileData.unsupported_38a_lines.push_back(str);
+                FileData.unsupported_38a_lines.push_back(std::move(str));
             }
         }//while is not EOF
     }
@@ -823,8 +827,17 @@ bool FileFormats::ReadSMBX38AWldFile(PGE_FileFormats_misc::TextInput& in, WorldD
         return false;
     }
 
+    PGE_STATS_COUNT("bytes", in.tell());
+    PGE_STATS_COUNT("lines", in.getCurrentLineNumber());
+    PGE_STATS_COUNT_WORLD(FileData);
+    PGE_STATS_PHASE(PHASE_POSTPROCESS);
     FileData.CurSection = 0;
     FileData.playmusic = 0;
+    if(WorldBuildSpatialIndexEnabled())
+        FileData.spatial_index.build(FileData);
+    if(WorldBuildPathGraphEnabled())
+        FileData.path_graph.build(FileData);
+    arenaStaging.commit(FileData);
     FileData.meta.ReadFileValid = true;
     return true;
 #else
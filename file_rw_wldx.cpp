@@ -30,6 +30,7 @@
 #include "pge_x.h"
 #include "pge_x_macro.h"
 #include "pge_file_lib_sys.h"
+#include "pge_arena_private.h"
 
 //*********************************************************
 //****************READ FILE FORMAT*************************
@@ -120,7 +121,7 @@ bool FileFormats::ReadExtendedWldFileHeaderT(PGE_FileFormats_misc::TextInput &in
     for(pge_size_t zzz = 0; zzz < header.size(); zzz++)
     {
         PGESTRING &header_line = header[zzz];
-        PGELIST<PGESTRINGList >data = PGEFile::splitDataLine(header_line, &valid);
+        PGEVECTOR<PGESTRINGList >data = PGEFile::splitDataLine(header_line, &valid);
 
         for(pge_size_t i = 0; i < data.size(); i++)
         {
@@ -264,9 +265,11 @@ bool FileFormats::ReadExtendedWldFileRaw(PGESTRING &rawdata, const PGESTRING &fi
 
 bool FileFormats::ReadExtendedWldFile(PGE_FileFormats_misc::TextInput &in, WorldData &FileData)
 {
+    PGE_STATS_BEGIN("PGE-X WLDX", PHASE_IO);
     PGESTRING errorString;
     PGEX_FileBegin();
     PGESTRING filePath = in.getFilePath();
+    PGE_ArenaStaging arenaStaging(FileData);
     CreateWorldData(FileData);
     FileData.meta.RecentFormat = WorldData::PGEX;
 
@@ -322,6 +325,7 @@ bool FileFormats::ReadExtendedWldFile(PGE_FileFormats_misc::TextInput &in, World
         {
             str_count++;
             PGEX_SectionBegin(PGEFile::PGEX_Struct);
+            PGEX_ReserveItems(FileData.metaData.bookmarks);
             PGEX_Items()
             {
                 str_count++;
@@ -337,7 +341,7 @@ bool FileFormats::ReadExtendedWldFile(PGE_FileFormats_misc::TextInput &in, World
                     PGEX_SIntVal("X", meta_bookmark.x) // Position X
                     PGEX_SIntVal("Y", meta_bookmark.y) // Position Y
                 }
-                FileData.metaData.bookmarks.push_back(meta_bookmark);
+                FileData.metaData.bookmarks.push_back(std::move(meta_bookmark));
             }
         }
         ////////////////////////meta bookmarks////////////////////////
@@ -369,6 +373,7 @@ bool FileFormats::ReadExtendedWldFile(PGE_FileFormats_misc::TextInput &in, World
         {
             str_count++;
             PGEX_SectionBegin(PGEFile::PGEX_Struct);
+            PGEX_ReserveItems(FileData.tiles);
             PGEX_Items()
             {
                 str_count++;
@@ -384,7 +389,7 @@ bool FileFormats::ReadExtendedWldFile(PGE_FileFormats_misc::TextInput &in, World
                 }
                 tile.meta.array_id = FileData.tile_array_id++;
                 tile.meta.index = static_cast<unsigned int>(FileData.tiles.size());
-                FileData.tiles.push_back(tile);
+                FileData.tiles.push_back(std::move(tile));
             }
         }//TILES
         ///////////////////SCENERY//////////////////////
@@ -392,6 +397,7 @@ bool FileFormats::ReadExtendedWldFile(PGE_FileFormats_misc::TextInput &in, World
         {
             str_count++;
             PGEX_SectionBegin(PGEFile::PGEX_Struct);
+            PGEX_ReserveItems(FileData.scenery);
             PGEX_Items()
             {
                 str_count++;
@@ -407,7 +413,7 @@ bool FileFormats::ReadExtendedWldFile(PGE_FileFormats_misc::TextInput &in, World
                 }
                 scen.meta.array_id = FileData.scene_array_id++;
                 scen.meta.index = static_cast<unsigned int>(FileData.scenery.size());
-                FileData.scenery.push_back(scen);
+                FileData.scenery.push_back(std::move(scen));
             }
         }//SCENERY
         ///////////////////PATHS//////////////////////
@@ -415,6 +421,7 @@ bool FileFormats::ReadExtendedWldFile(PGE_FileFormats_misc::TextInput &in, World
         {
             str_count++;
             PGEX_SectionBegin(PGEFile::PGEX_Struct);
+            PGEX_ReserveItems(FileData.paths);
             PGEX_Items()
             {
                 str_count++;
@@ -430,7 +437,7 @@ bool FileFormats::ReadExtendedWldFile(PGE_FileFormats_misc::TextInput &in, World
                 }
                 pathitem.meta.array_id = FileData.path_array_id++;
                 pathitem.meta.index =  static_cast<unsigned int>(FileData.paths.size());
-                FileData.paths.push_back(pathitem);
+                FileData.paths.push_back(std::move(pathitem));
             }
         }//PATHS
         ///////////////////MUSICBOXES//////////////////////
@@ -438,6 +445,7 @@ bool FileFormats::ReadExtendedWldFile(PGE_FileFormats_misc::TextInput &in, World
         {
             str_count++;
             PGEX_SectionBegin(PGEFile::PGEX_Struct);
+            PGEX_ReserveItems(FileData.music);
             PGEX_Items()
             {
                 str_count++;
@@ -454,7 +462,7 @@ bool FileFormats::ReadExtendedWldFile(PGE_FileFormats_misc::TextInput &in, World
                 }
                 musicbox.meta.array_id = FileData.musicbox_array_id++;
                 musicbox.meta.index =  static_cast<unsigned int>(FileData.music.size());
-                FileData.music.push_back(musicbox);
+                FileData.music.push_back(std::move(musicbox));
             }
         }//MUSICBOXES
         ///////////////////LEVELS//////////////////////
@@ -462,6 +470,7 @@ bool FileFormats::ReadExtendedWldFile(PGE_FileFormats_misc::TextInput &in, World
         {
             str_count++;
             PGEX_SectionBegin(PGEFile::PGEX_Struct);
+            PGEX_ReserveItems(FileData.levels);
             PGEX_Items()
             {
                 str_count++;
@@ -491,12 +500,19 @@ bool FileFormats::ReadExtendedWldFile(PGE_FileFormats_misc::TextInput &in, World
                 }
                 lvlitem.meta.array_id = FileData.level_array_id++;
                 lvlitem.meta.index = static_cast<unsigned int>(FileData.levels.size());
-                FileData.levels.push_back(lvlitem);
+                FileData.levels.push_back(std::move(lvlitem));
             }
         }//LEVELS
     }
     ///////////////////////////////////////EndFile///////////////////////////////////////
+    PGE_STATS_COUNT_WORLD(FileData);
+    PGE_STATS_PHASE(PHASE_POSTPROCESS);
     FileData.meta.ERROR_info.clear(); //If no errors, clear string;
+    if(WorldBuildSpatialIndexEnabled())
+        FileData.spatial_index.build(FileData);
+    if(WorldBuildPathGraphEnabled())
+        FileData.path_graph.build(FileData);
+    arenaStaging.commit(FileData);
     FileData.meta.ReadFileValid = true;
     return true;
 badfile:    //If file format not corrects
@@ -30,10 +30,44 @@
 #endif
 
 #include "file_formats.h"
+#include "pge_string_pool.h"
 #include "pge_file_lib_private.h"
+#include "pge_parse_stats_private.h"
+
+#ifdef PGE_FILES_PARSE_STATS
+static const char *parseStatsLevelFormat(const LevelData &data)
+{
+    switch(data.meta.RecentFormat)
+    {
+    case LevelData::SMBX64:
+        return "SMBX64 LVL";
+    case LevelData::SMBX38A:
+        return "SMBX-38A LVL";
+    default:
+        return "PGE-X LVLX";
+    }
+}
+
+static const char *parseStatsWorldFormat(const WorldData &data)
+{
+    switch(data.meta.RecentFormat)
+    {
+    case WorldData::SMBX64:
+        return "SMBX64 WLD";
+    case WorldData::SMBX38A:
+        return "SMBX-38A WLD";
+    default:
+        return "PGE-X WLDX";
+    }
+}
+#endif
 
 bool FileFormats::OpenLevelFile(const PGESTRING &filePath, LevelData &FileData)
 {
+    PGESTRING cacheDir = LevelCacheDirectory();
+    if(!IsEmpty(cacheDir))
+        return OpenLevelFileCached(filePath, cacheDir, FileData);
+
     PGE_FileFormats_misc::TextFileInput file;
 
     if(!file.open(filePath, true))
@@ -98,12 +132,22 @@ bool FileFormats::OpenLevelFileT(PGE_FileFormats_misc::TextInput &file, LevelDat
             return false;
     }
 
+    PGE_STATS_BEGIN(parseStatsLevelFormat(FileData), PHASE_POSTPROCESS);
     if(PGE_FileFormats_misc::TextFileInput::exists(file.getFilePath() + ".meta"))
     {
         if(!ReadNonSMBX64MetaDataF(file.getFilePath() + ".meta", FileData.metaData))
             FileData.meta.ERROR_info = "Can't open meta-file";
     }
 
+#ifdef PGE_FILES_QT
+    PGE_StringPool *pool = StringPool();
+    if(pool)
+        pool->internLevel(FileData);
+#endif
+
+    if(LevelResolveReferencesEnabled())
+        LevelResolveReferences(FileData);
+
     return true;
 }
 
@@ -326,12 +370,19 @@ bool FileFormats::OpenWorldFileT(PGE_FileFormats_misc::TextInput &file, WorldDat
             return false;
     }
 
+    PGE_STATS_BEGIN(parseStatsWorldFormat(data), PHASE_POSTPROCESS);
     if(PGE_FileFormats_misc::TextFileInput::exists(file.getFilePath() + ".meta"))
     {
         if(!ReadNonSMBX64MetaDataF(file.getFilePath() + ".meta", data.metaData))
             data.meta.ERROR_info = "Can't open meta-file";
     }
 
+#ifdef PGE_FILES_QT
+    PGE_StringPool *pool = StringPool();
+    if(pool)
+        pool->internWorld(data);
+#endif
+
     return true;
 }
 
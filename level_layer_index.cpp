@@ -0,0 +1,213 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "level_layer_index.h"
+#include "pge_file_lib_private.h"
+
+static inline uint64_t layerMemberKey(int type, unsigned int arrayId)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(type)) << 32) | arrayId;
+}
+
+void LevelLayerIndex::build(const LevelData &lvl)
+{
+    clear();
+
+    m_positions.reserve(static_cast<size_t>(lvl.blocks.size() + lvl.bgo.size() + lvl.npc.size() +
+                                            lvl.doors.size() + lvl.physez.size()));
+
+    // Keep slots in order of the layers array
+    for(const LevelLayer &l : lvl.layers)
+        slotOf(l.name);
+
+    for(const LevelBlock &b : lvl.blocks)
+        add(MEMBER_BLOCK, b.meta.array_id, b.layer);
+    for(const LevelBGO &b : lvl.bgo)
+        add(MEMBER_BGO, b.meta.array_id, b.layer);
+    for(const LevelNPC &n : lvl.npc)
+        add(MEMBER_NPC, n.meta.array_id, n.layer);
+    for(const LevelDoor &d : lvl.doors)
+        add(MEMBER_WARP, d.meta.array_id, d.layer);
+    for(const LevelPhysEnv &p : lvl.physez)
+        add(MEMBER_PHYSENV, p.meta.array_id, p.layer);
+}
+
+void LevelLayerIndex::clear()
+{
+    m_layers.clear();
+    m_slots.clear();
+    m_positions.clear();
+}
+
+uint32_t LevelLayerIndex::slotOf(const PGESTRING &layer)
+{
+    auto it = m_slots.find(layer);
+    if(it != m_slots.end())
+        return PGEMAPVAL(it);
+
+    uint32_t slot = static_cast<uint32_t>(m_layers.size());
+    m_layers.push_back(Layer());
+    m_layers.back().name = layer;
+    m_slots[layer] = slot;
+    return slot;
+}
+
+void LevelLayerIndex::unlink(int type, unsigned int arrayId, const Position &p)
+{
+    std::vector<unsigned int> &list = m_layers[p.slot].members[type];
+    const unsigned int last = list.back();
+    list[p.pos] = last;
+    list.pop_back();
+
+    if(last != arrayId)
+        m_positions[layerMemberKey(type, last)].pos = p.pos;
+}
+
+bool LevelLayerIndex::add(int type, unsigned int arrayId, const PGESTRING &layer)
+{
+    if(type < 0 || type >= MEMBER_TYPES_COUNT)
+        return false;
+
+    const uint64_t key = layerMemberKey(type, arrayId);
+    if(m_positions.find(key) != m_positions.end())
+        return false;
+
+    Position p;
+    p.slot = slotOf(layer);
+    std::vector<unsigned int> &list = m_layers[p.slot].members[type];
+    p.pos = static_cast<uint32_t>(list.size());
+    list.push_back(arrayId);
+    m_positions[key] = p;
+    return true;
+}
+
+bool LevelLayerIndex::remove(int type, unsigned int arrayId)
+{
+    auto it = m_positions.find(layerMemberKey(type, arrayId));
+    if(it == m_positions.end())
+        return false;
+
+    Position p = it->second;
+    m_positions.erase(it);
+    unlink(type, arrayId, p);
+    return true;
+}
+
+bool LevelLayerIndex::setLayer(int type, unsigned int arrayId, const PGESTRING &layer)
+{
+    auto it = m_positions.find(layerMemberKey(type, arrayId));
+    if(it == m_positions.end())
+        return false;
+
+    const uint32_t slot = slotOf(layer);
+    if(it->second.slot == slot)
+        return true;
+
+    Position old = it->second;
+    std::vector<unsigned int> &list = m_layers[slot].members[type];
+    it->second.slot = slot;
+    it->second.pos = static_cast<uint32_t>(list.size());
+    list.push_back(arrayId);
+
+    unlink(type, arrayId, old);
+    return true;
+}
+
+bool LevelLayerIndex::renameLayer(const PGESTRING &oldName, const PGESTRING &newName)
+{
+    auto it = m_slots.find(oldName);
+    if(it == m_slots.end())
+        return false;
+
+    if(oldName == newName)
+        return true;
+
+    const uint32_t from = PGEMAPVAL(it);
+    m_slots.erase(it);
+
+    auto target = m_slots.find(newName);
+    if(target == m_slots.end())
+    {
+        m_layers[from].name = newName;
+        m_slots[newName] = from;
+        return true;
+    }
+
+    // Merge members into the existing layer
+    const uint32_t to = PGEMAPVAL(target);
+    for(int type = 0; type < MEMBER_TYPES_COUNT; type++)
+    {
+        std::vector<unsigned int> &src = m_layers[from].members[type];
+        std::vector<unsigned int> &dst = m_layers[to].members[type];
+        for(unsigned int arrayId : src)
+        {
+            Position &p = m_positions[layerMemberKey(type, arrayId)];
+            p.slot = to;
+            p.pos = static_cast<uint32_t>(dst.size());
+            dst.push_back(arrayId);
+        }
+        std::vector<unsigned int>().swap(src);
+    }
+
+    m_layers[from].name = PGESTRING();
+    return true;
+}
+
+const std::vector<unsigned int> &LevelLayerIndex::members(const PGESTRING &layer, int type) const
+{
+    static const std::vector<unsigned int> none;
+
+    if(type < 0 || type >= MEMBER_TYPES_COUNT)
+        return none;
+
+    auto it = m_slots.find(layer);
+    if(it == m_slots.end())
+        return none;
+
+    return m_layers[PGEMAPVAL(it)].members[type];
+}
+
+size_t LevelLayerIndex::membersCount(const PGESTRING &layer) const
+{
+    auto it = m_slots.find(layer);
+    if(it == m_slots.end())
+        return 0;
+
+    size_t count = 0;
+    for(const std::vector<unsigned int> &list : m_layers[PGEMAPVAL(it)].members)
+        count += list.size();
+    return count;
+}
+
+bool LevelLayerIndex::layerOf(int type, unsigned int arrayId, PGESTRING &layer) const
+{
+    auto it = m_positions.find(layerMemberKey(type, arrayId));
+    if(it == m_positions.end())
+        return false;
+
+    layer = m_layers[it->second.slot].name;
+    return true;
+}
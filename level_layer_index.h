@@ -0,0 +1,161 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*!
+ * \file level_layer_index.h
+ * \brief Contains the index of layer members for fast layer-wide operations
+ */
+
+#pragma once
+#ifndef LEVEL_LAYER_INDEX_H
+#define LEVEL_LAYER_INDEX_H
+
+#include "pge_file_lib_globs.h"
+#include "lvl_filedata.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/*!
+ * \brief Index of blocks, BGO, NPC, warps and physical environment zones by their parent layer
+ *
+ * Layer operations (show, hide, toggle and motion of layers by events) need
+ * the members of the given layer only, so the index allows to avoid scans
+ * of all element arrays. Elements are identified by their type and
+ * ElementMeta::array_id, the index must be updated by the caller on every
+ * change of element's layer, on insertion and on removal of elements.
+ */
+class LevelLayerIndex
+{
+public:
+    //! Type of the layer member
+    enum MemberType
+    {
+        MEMBER_BLOCK = 0,
+        MEMBER_BGO,
+        MEMBER_NPC,
+        MEMBER_WARP,
+        MEMBER_PHYSENV,
+        MEMBER_TYPES_COUNT
+    };
+
+    /*!
+     * \brief Fills the index with all elements of the level, previous content gets removed
+     * \param lvl Level data
+     */
+    void build(const LevelData &lvl);
+    /*!
+     * \brief Removes all layers and members
+     */
+    void clear();
+
+    /*!
+     * \brief Adds the element into the layer
+     * \param type Type of the element (MemberType)
+     * \param arrayId Array ID of the element
+     * \param layer Name of the parent layer
+     * \return false if element is already indexed or the type is invalid
+     */
+    bool add(int type, unsigned int arrayId, const PGESTRING &layer);
+    /*!
+     * \brief Removes the element from the index
+     * \param type Type of the element (MemberType)
+     * \param arrayId Array ID of the element
+     * \return false if element is not indexed
+     */
+    bool remove(int type, unsigned int arrayId);
+    /*!
+     * \brief Moves the element into another layer
+     * \param type Type of the element (MemberType)
+     * \param arrayId Array ID of the element
+     * \param layer Name of the new parent layer
+     * \return false if element is not indexed
+     */
+    bool setLayer(int type, unsigned int arrayId, const PGESTRING &layer);
+    /*!
+     * \brief Renames the layer, members are merged if layer with the new name already exists
+     * \param oldName Current name of the layer
+     * \param newName New name of the layer
+     * \return false if there is no layer with the current name
+     */
+    bool renameLayer(const PGESTRING &oldName, const PGESTRING &newName);
+
+    /*!
+     * \brief Array IDs of the layer members of the given type, in no particular order
+     * \param layer Name of the layer
+     * \param type Type of elements (MemberType)
+     * \return Array IDs of the members, empty if layer has no members of this type
+     */
+    const std::vector<unsigned int> &members(const PGESTRING &layer, int type) const;
+    /*!
+     * \brief Number of all members of the layer
+     * \param layer Name of the layer
+     * \return Total number of elements in the layer
+     */
+    size_t membersCount(const PGESTRING &layer) const;
+    /*!
+     * \brief Finds the parent layer of the element
+     * \param type Type of the element (MemberType)
+     * \param arrayId Array ID of the element
+     * \param [__out] layer Name of the parent layer
+     * \return false if element is not indexed
+     */
+    bool layerOf(int type, unsigned int arrayId, PGESTRING &layer) const;
+    /*!
+     * \brief Number of indexed elements
+     */
+    size_t size() const
+    {
+        return m_positions.size();
+    }
+
+private:
+    struct Layer
+    {
+        PGESTRING name;
+        std::vector<unsigned int> members[MEMBER_TYPES_COUNT];
+    };
+
+    struct Position
+    {
+        uint32_t slot;
+        uint32_t pos;
+    };
+
+    uint32_t slotOf(const PGESTRING &layer);
+    void unlink(int type, unsigned int arrayId, const Position &p);
+
+    //! Layers storage, slots of renamed-away layers stay empty
+    std::vector<Layer> m_layers;
+    //! Layer name to slot in the layers storage
+    PGEMAP<PGESTRING, uint32_t> m_slots;
+    //! Element key to location in the layer storage
+    std::unordered_map<uint64_t, Position> m_positions;
+};
+
+#endif // LEVEL_LAYER_INDEX_H
@@ -0,0 +1,106 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "level_snapshot.h"
+#include "file_formats.h"
+#include "pge_file_lib_private.h"
+
+#include <utility>
+
+LevelDataSnapshot::LevelDataSnapshot()
+{
+    LevelData empty;
+    take(empty);
+}
+
+void LevelDataSnapshot::take(LevelData &data)
+{
+#define PGE_LVLSNAP_SPLIT(T, name) \
+    m_##name = std::make_shared<PGELIST<T> >(std::move(data.name)); \
+    data.name.clear();
+    PGE_LEVEL_SHARED_COLLECTIONS(PGE_LVLSNAP_SPLIT)
+#undef PGE_LVLSNAP_SPLIT
+    m_header = std::make_shared<LevelData>(std::move(data));
+}
+
+LevelData LevelDataSnapshot::toLevelData() const
+{
+    LevelData out = *m_header;
+#define PGE_LVLSNAP_JOIN(T, name) out.name = *m_##name;
+    PGE_LEVEL_SHARED_COLLECTIONS(PGE_LVLSNAP_JOIN)
+#undef PGE_LVLSNAP_JOIN
+
+    // Maps of the header were built for the collections it was taken with
+    if(!out.layers_lookup.empty() || !out.events_lookup.empty())
+        FileFormats::LevelResolveReferences(out);
+
+#define PGE_LVLSNAP_REMAP(name) \
+    if(out.name##_arrayid_map.isEnabled()) \
+        out.name##_arrayid_map.rebuild(out.name);
+    PGE_LVLSNAP_REMAP(blocks)
+    PGE_LVLSNAP_REMAP(bgo)
+    PGE_LVLSNAP_REMAP(npc)
+    PGE_LVLSNAP_REMAP(doors)
+    PGE_LVLSNAP_REMAP(physez)
+    PGE_LVLSNAP_REMAP(layers)
+    PGE_LVLSNAP_REMAP(events)
+#undef PGE_LVLSNAP_REMAP
+
+    return out;
+}
+
+
+LevelDataCow::LevelDataCow()
+{
+    LevelData data = FileFormats::CreateLevelData();
+    m_data.take(data);
+    setShared(false);
+}
+
+LevelDataCow::LevelDataCow(const LevelData &data)
+{
+    LevelData copy = data;
+    m_data.take(copy);
+    setShared(false);
+}
+
+LevelDataCow::LevelDataCow(LevelData &&data)
+{
+    m_data.take(data);
+    setShared(false);
+}
+
+LevelDataSnapshot LevelDataCow::snapshot()
+{
+    setShared(true);
+    return m_data;
+}
+
+void LevelDataCow::setShared(bool shared)
+{
+    for(int i = 0; i < SHARED_SLOTS_COUNT; i++)
+        m_shared[i] = shared;
+}
@@ -0,0 +1,215 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*!
+ * \file level_snapshot.h
+ * \brief Contains copy-on-write level data with cheap immutable snapshots
+ */
+
+#pragma once
+#ifndef LEVEL_SNAPSHOT_H
+#define LEVEL_SNAPSHOT_H
+
+#include "pge_file_lib_globs.h"
+#include "lvl_filedata.h"
+
+#include <memory>
+
+/*!
+ * \brief List of level data collections shared between working copy and snapshots
+ *
+ * Every entry is X(element type, field name of LevelData), all collections are shared
+ */
+#define PGE_LEVEL_SHARED_COLLECTIONS(X) PGE_LEVEL_COLLECTIONS(X)
+
+class LevelDataCow;
+
+/*!
+ * \brief Immutable snapshot of the level data
+ *
+ * Snapshot holds references to collections of the working copy it was taken from,
+ * the collections are never modified after the snapshot got them. Therefore,
+ * snapshots and their copies can be read and destroyed from any thread while the
+ * working copy keeps changing.
+ */
+class LevelDataSnapshot
+{
+    friend class LevelDataCow;
+public:
+    //! Creates an empty snapshot
+    LevelDataSnapshot();
+
+    /*!
+     * \brief All non-collection fields of the level (name, meta-data, lookup maps, etc.)
+     *
+     * Collections of the returned object are always empty, use dedicated accessors.
+     * Lookup maps (layers_lookup, events_lookup, *_arrayid_map) are kept as they were
+     * given and don't follow changes of collections, toLevelData() rebuilds them.
+     */
+    const LevelData &header() const
+    {
+        return *m_header;
+    }
+
+#define PGE_LVLSNAP_GETTER(T, name) \
+    const PGELIST<T> &name() const { return *m_##name; }
+    PGE_LEVEL_SHARED_COLLECTIONS(PGE_LVLSNAP_GETTER)
+#undef PGE_LVLSNAP_GETTER
+
+    /*!
+     * \brief Assembles the plain deep copy of the level data
+     * \return Level data
+     *
+     * Lookup maps which were filled in the header are rebuilt for the current collections.
+     */
+    LevelData toLevelData() const;
+
+private:
+    /*!
+     * \brief Replaces the content by the level data
+     * \param data Level data to take, collections are moved and left empty
+     */
+    void take(LevelData &data);
+
+    std::shared_ptr<const LevelData> m_header;
+#define PGE_LVLSNAP_FIELD(T, name) \
+    std::shared_ptr<const PGELIST<T> > m_##name;
+    PGE_LEVEL_SHARED_COLLECTIONS(PGE_LVLSNAP_FIELD)
+#undef PGE_LVLSNAP_FIELD
+};
+
+/*!
+ * \brief Working copy of the level data with structural sharing of collections
+ *
+ * Taking a snapshot costs the copy of one pointer per collection. The first
+ * edit of a collection after the snapshot makes a private copy of this
+ * collection only, untouched collections remain shared between the working
+ * copy and all snapshots. Working copy itself is not thread-safe, it must be
+ * used by one thread only (for example, by the editor's main thread).
+ */
+class LevelDataCow
+{
+public:
+    //! Creates an empty level, same as FileFormats::CreateLevelData() without extra sections
+    LevelDataCow();
+    /*!
+     * \brief Creates the working copy from the level data
+     * \param data Level data to copy
+     */
+    explicit LevelDataCow(const LevelData &data);
+    /*!
+     * \brief Creates the working copy from the level data
+     * \param data Level data to take, collections are moved without copying
+     */
+    explicit LevelDataCow(LevelData &&data);
+
+    /*!
+     * \brief Read access to non-collection fields of the level
+     *
+     * Lookup maps of the header go stale after changes made through edit_*() accessors,
+     * use toLevelData() to get the level with the rebuilt maps.
+     */
+    const LevelData &header() const
+    {
+        return *m_data.m_header;
+    }
+    /*!
+     * \brief Write access to non-collection fields of the level, detaches them from snapshots
+     *
+     * Collections of the header must stay empty, use dedicated accessors to modify them.
+     */
+    LevelData &editHeader()
+    {
+        return detach(m_data.m_header, SHARED_HEADER);
+    }
+
+    /*
+     * name() gives the read access to the collection, edit_name() gives the write
+     * access and detaches the collection from snapshots. The reference returned by
+     * edit_name() is valid until the next snapshot() call only: after it, the
+     * collection is shared with the snapshot, and writing through the old reference
+     * would change data which other threads are reading. Call edit_name() again.
+     */
+#define PGE_LVLCOW_ACCESSOR(T, name) \
+    const PGELIST<T> &name() const { return *m_data.m_##name; } \
+    PGELIST<T> &edit_##name() { return detach(m_data.m_##name, SHARED_##name); }
+    PGE_LEVEL_SHARED_COLLECTIONS(PGE_LVLCOW_ACCESSOR)
+#undef PGE_LVLCOW_ACCESSOR
+
+    /*!
+     * \brief Takes the immutable snapshot of the current state
+     * \return Snapshot which is safe to pass into other threads
+     *
+     * Ends the validity of all references returned by edit_*() and editHeader() before.
+     */
+    LevelDataSnapshot snapshot();
+
+    /*!
+     * \brief Assembles the plain deep copy of the level data
+     * \return Level data, lookup maps which were filled in the header are rebuilt
+     */
+    LevelData toLevelData() const
+    {
+        return m_data.toLevelData();
+    }
+
+private:
+    enum SharedSlot
+    {
+        SHARED_HEADER = 0,
+#define PGE_LVLCOW_SLOT(T, name) SHARED_##name,
+        PGE_LEVEL_SHARED_COLLECTIONS(PGE_LVLCOW_SLOT)
+#undef PGE_LVLCOW_SLOT
+        SHARED_SLOTS_COUNT
+    };
+
+    /*!
+     * \brief Makes a private copy of the value if it was given to any snapshot
+     * \param ptr Pointer to the value
+     * \param slot Sharing flag index
+     * \return Writable value
+     */
+    template<class T>
+    T &detach(std::shared_ptr<const T> &ptr, int slot)
+    {
+        if(m_shared[slot])
+        {
+            ptr = std::make_shared<T>(*ptr);
+            m_shared[slot] = false;
+        }
+        // Objects are always created as non-const and never shared after detach
+        return const_cast<T &>(*ptr);
+    }
+
+    void setShared(bool shared);
+
+    //! Current state, values that are not marked as shared are owned by the working copy only
+    LevelDataSnapshot m_data;
+    //! Flags of values referenced by snapshots
+    bool m_shared[SHARED_SLOTS_COUNT];
+};
+
+#endif // LEVEL_SNAPSHOT_H
@@ -0,0 +1,257 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "level_soa.h"
+#include "pge_file_lib_private.h"
+
+void LevelElementsSoA::clear()
+{
+    x.clear();
+    y.clear();
+    w.clear();
+    h.clear();
+    id.clear();
+    index.clear();
+}
+
+void LevelElementsSoA::reserve(size_t count)
+{
+    x.reserve(count);
+    y.reserve(count);
+    w.reserve(count);
+    h.reserve(count);
+    id.reserve(count);
+    index.reserve(count);
+}
+
+void LevelElementsSoA::push_back(long ex, long ey, long ew, long eh, uint64_t eid, size_t eindex)
+{
+    x.push_back(ex);
+    y.push_back(ey);
+    w.push_back(ew);
+    h.push_back(eh);
+    id.push_back(eid);
+    index.push_back(eindex);
+}
+
+bool LevelElementsSoA::bounds(long &left, long &top, long &right, long &bottom) const
+{
+    const size_t n = size();
+    if(n == 0)
+        return false;
+
+    const long *px = x.data(), *py = y.data(), *pw = w.data(), *ph = h.data();
+    long l = px[0], t = py[0], r = px[0] + pw[0], b = py[0] + ph[0];
+
+    for(size_t i = 1; i < n; i++)
+    {
+        const long ex = px[i], ey = py[i];
+        const long er = ex + pw[i], eb = ey + ph[i];
+        l = (ex < l) ? ex : l;
+        t = (ey < t) ? ey : t;
+        r = (er > r) ? er : r;
+        b = (eb > b) ? eb : b;
+    }
+
+    left = l;
+    top = t;
+    right = r;
+    bottom = b;
+    return true;
+}
+
+void LevelElementsSoA::selectInRect(long left, long top, long right, long bottom, std::vector<size_t> &out) const
+{
+    const size_t n = size();
+    const long *px = x.data(), *py = y.data(), *pw = w.data(), *ph = h.data();
+
+    out.clear();
+    for(size_t i = 0; i < n; i++)
+    {
+        if(px[i] < right && px[i] + pw[i] > left &&
+           py[i] < bottom && py[i] + ph[i] > top)
+            out.push_back(i);
+    }
+}
+
+void LevelElementsSoA::classifySections(const PGELIST<LevelSection> &sections, std::vector<int> &out) const
+{
+    struct Rect
+    {
+        long l, t, r, b;
+        int index;
+    };
+
+    std::vector<Rect> rects;
+    rects.reserve(static_cast<size_t>(sections.size()));
+    for(pge_size_t s = 0; s < sections.size(); s++)
+    {
+        const LevelSection &sct = sections[s];
+        if(sct.size_left == sct.size_right || sct.size_top == sct.size_bottom)
+            continue; // Unused section
+        rects.push_back({sct.size_left, sct.size_top, sct.size_right, sct.size_bottom, static_cast<int>(s)});
+    }
+
+    const size_t n = size();
+    const long *px = x.data(), *py = y.data(), *pw = w.data(), *ph = h.data();
+    out.assign(n, -1);
+
+    for(size_t i = 0; i < n; i++)
+    {
+        const long cx = px[i] + pw[i] / 2;
+        const long cy = py[i] + ph[i] / 2;
+        for(const Rect &r : rects)
+        {
+            if(cx >= r.l && cx <= r.r && cy >= r.t && cy <= r.b)
+            {
+                out[i] = r.index;
+                break;
+            }
+        }
+    }
+}
+
+
+void LevelDataSoA::build(const LevelData &lvl, long objW, long objH)
+{
+    clear();
+
+    blocks.reserve(static_cast<size_t>(lvl.blocks.size()));
+    for(pge_size_t i = 0; i < lvl.blocks.size(); i++)
+    {
+        const LevelBlock &b = lvl.blocks[i];
+        blocks.push_back(b.x, b.y, b.w, b.h, b.id, static_cast<size_t>(i));
+    }
+
+    bgo.reserve(static_cast<size_t>(lvl.bgo.size()));
+    for(pge_size_t i = 0; i < lvl.bgo.size(); i++)
+    {
+        const LevelBGO &b = lvl.bgo[i];
+        bgo.push_back(b.x, b.y, objW, objH, b.id, static_cast<size_t>(i));
+    }
+
+    npc.reserve(static_cast<size_t>(lvl.npc.size()));
+    for(pge_size_t i = 0; i < lvl.npc.size(); i++)
+    {
+        const LevelNPC &n = lvl.npc[i];
+        npc.push_back(n.x, n.y, objW, objH, n.id, static_cast<size_t>(i));
+    }
+
+    m_blocksCount = static_cast<size_t>(lvl.blocks.size());
+    m_bgoCount = static_cast<size_t>(lvl.bgo.size());
+    m_npcCount = static_cast<size_t>(lvl.npc.size());
+}
+
+template<class T>
+static bool soaIndicesFit(const LevelElementsSoA &soa, const PGELIST<T> &arr, size_t builtCount)
+{
+    // Grown arrays may have elements inserted before the indexed ones
+    const size_t total = static_cast<size_t>(arr.size());
+    if(total != builtCount)
+        return false;
+    for(size_t i : soa.index)
+    {
+        if(i >= total)
+            return false;
+    }
+    return true;
+}
+
+bool LevelDataSoA::syncTo(LevelData &lvl) const
+{
+    if(!soaIndicesFit(blocks, lvl.blocks, m_blocksCount) ||
+       !soaIndicesFit(bgo, lvl.bgo, m_bgoCount) ||
+       !soaIndicesFit(npc, lvl.npc, m_npcCount))
+        return false;
+
+    for(size_t i = 0; i < blocks.size(); i++)
+    {
+        LevelBlock &b = lvl.blocks[static_cast<pge_size_t>(blocks.index[i])];
+        b.x = blocks.x[i];
+        b.y = blocks.y[i];
+        b.w = blocks.w[i];
+        b.h = blocks.h[i];
+        b.id = blocks.id[i];
+    }
+
+    for(size_t i = 0; i < bgo.size(); i++)
+    {
+        LevelBGO &b = lvl.bgo[static_cast<pge_size_t>(bgo.index[i])];
+        b.x = bgo.x[i];
+        b.y = bgo.y[i];
+        b.id = bgo.id[i];
+    }
+
+    for(size_t i = 0; i < npc.size(); i++)
+    {
+        LevelNPC &n = lvl.npc[static_cast<pge_size_t>(npc.index[i])];
+        n.x = npc.x[i];
+        n.y = npc.y[i];
+        n.id = npc.id[i];
+    }
+
+    return true;
+}
+
+bool LevelDataSoA::bounds(long &left, long &top, long &right, long &bottom) const
+{
+    const LevelElementsSoA *all[] = {&blocks, &bgo, &npc};
+    bool found = false;
+
+    for(const LevelElementsSoA *soa : all)
+    {
+        long l, t, r, b;
+        if(!soa->bounds(l, t, r, b))
+            continue;
+
+        if(!found)
+        {
+            left = l;
+            top = t;
+            right = r;
+            bottom = b;
+            found = true;
+            continue;
+        }
+
+        left = (l < left) ? l : left;
+        top = (t < top) ? t : top;
+        right = (r > right) ? r : right;
+        bottom = (b > bottom) ? b : bottom;
+    }
+
+    return found;
+}
+
+void LevelDataSoA::clear()
+{
+    blocks.clear();
+    bgo.clear();
+    npc.clear();
+    m_blocksCount = 0;
+    m_bgoCount = 0;
+    m_npcCount = 0;
+}
@@ -0,0 +1,181 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*!
+ * \file level_soa.h
+ * \brief Contains the struct-of-arrays projection of level elements
+ *
+ * Level elements are heavy structures: every block carries several strings
+ * next to its coordinates. Passes which need geometry and IDs only (bounds,
+ * selection by rectangle, minimap, section classification) are much faster
+ * over the compact columns than over the element arrays themselves.
+ */
+
+#pragma once
+#ifndef LEVEL_SOA_H
+#define LEVEL_SOA_H
+
+#include "pge_file_lib_globs.h"
+#include "lvl_filedata.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*!
+ * \brief Geometry and ID columns of one kind of level elements
+ */
+class LevelElementsSoA
+{
+public:
+    //! X position of the element
+    std::vector<long> x;
+    //! Y position of the element
+    std::vector<long> y;
+    //! Width of the element
+    std::vector<long> w;
+    //! Height of the element
+    std::vector<long> h;
+    //! ID of the element
+    std::vector<uint64_t> id;
+    //! Index of the element in the source array of the LevelData
+    std::vector<size_t> index;
+
+    /*!
+     * \brief Number of elements
+     */
+    size_t size() const
+    {
+        return x.size();
+    }
+    /*!
+     * \brief Is no elements here
+     */
+    bool empty() const
+    {
+        return x.empty();
+    }
+
+    /*!
+     * \brief Removes all elements
+     */
+    void clear();
+    /*!
+     * \brief Reserves memory for the given number of elements in all columns
+     * \param count Number of elements
+     */
+    void reserve(size_t count);
+    /*!
+     * \brief Appends the element
+     * \param ex X position
+     * \param ey Y position
+     * \param ew Width
+     * \param eh Height
+     * \param eid ID of the element
+     * \param eindex Index of the element in the source array
+     */
+    void push_back(long ex, long ey, long ew, long eh, uint64_t eid, size_t eindex);
+
+    /*!
+     * \brief Computes the bounding rectangle of all elements
+     * \param [__out] left Left edge
+     * \param [__out] top Top edge
+     * \param [__out] right Right edge
+     * \param [__out] bottom Bottom edge
+     * \return false if there are no elements, output values are untouched
+     */
+    bool bounds(long &left, long &top, long &right, long &bottom) const;
+    /*!
+     * \brief Finds all elements which are intersecting the given rectangle
+     * \param left Left edge of the rectangle
+     * \param top Top edge of the rectangle
+     * \param right Right edge of the rectangle
+     * \param bottom Bottom edge of the rectangle
+     * \param [__out] out Positions of found elements in these columns (not the source indices)
+     */
+    void selectInRect(long left, long top, long right, long bottom, std::vector<size_t> &out) const;
+    /*!
+     * \brief Finds the section of every element
+     * \param sections Level sections
+     * \param [__out] out Index of the section in the sections array per element, -1 if element is outside of all sections
+     *
+     * Element belongs to the first section which contains the element's center.
+     * Sections which have zero size (unused) are never matched.
+     */
+    void classifySections(const PGELIST<LevelSection> &sections, std::vector<int> &out) const;
+};
+
+/*!
+ * \brief Struct-of-arrays projection of blocks, BGO and NPC collections of the level
+ */
+class LevelDataSoA
+{
+public:
+    LevelElementsSoA blocks;
+    LevelElementsSoA bgo;
+    LevelElementsSoA npc;
+
+    /*!
+     * \brief Builds columns from the level data
+     * \param lvl Level data
+     * \param objW Width to assign to BGO and NPC which have no size in the level data
+     * \param objH Height to assign to BGO and NPC which have no size in the level data
+     *
+     * Sizes of BGO and NPC are depend on the game configuration, therefore
+     * the caller is free to fill the actual sizes into columns after the build.
+     */
+    void build(const LevelData &lvl, long objW = 32, long objH = 32);
+    /*!
+     * \brief Writes positions, sizes and IDs back into the level data
+     * \param [__inout] lvl Level data these columns were built from
+     * \return false if element arrays of the level data were resized since the build,
+     *         nothing is written then
+     *
+     * Sizes of BGO and NPC are not written as these elements have no size fields.
+     */
+    bool syncTo(LevelData &lvl) const;
+    /*!
+     * \brief Computes the bounding rectangle of all blocks, BGO and NPC
+     * \param [__out] left Left edge
+     * \param [__out] top Top edge
+     * \param [__out] right Right edge
+     * \param [__out] bottom Bottom edge
+     * \return false if level has no elements
+     */
+    bool bounds(long &left, long &top, long &right, long &bottom) const;
+    /*!
+     * \brief Removes all elements
+     */
+    void clear();
+
+private:
+    //! Sizes of element arrays of the level data at the time of build
+    size_t m_blocksCount = 0;
+    size_t m_bgoCount = 0;
+    size_t m_npcCount = 0;
+};
+
+#endif // LEVEL_SOA_H
@@ -0,0 +1,682 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "level_spatial_index.h"
+#include "pge_file_lib_private.h"
+
+typedef LevelSpatialIndex::Rect SpatialRect;
+
+//! Largest number of grid cells covered by one element, larger ones are kept aside
+static const double c_levelElementMaxCells = 1024.0;
+
+static inline bool spatialIntersects(const SpatialRect &a, const SpatialRect &b)
+{
+    return (a.left < b.right) && (a.right > b.left) &&
+           (a.top < b.bottom) && (a.bottom > b.top);
+}
+
+static inline bool spatialContains(const SpatialRect &outer, const SpatialRect &inner)
+{
+    return (outer.left <= inner.left) && (outer.right >= inner.right) &&
+           (outer.top <= inner.top) && (outer.bottom >= inner.bottom);
+}
+
+static inline SpatialRect spatialUnion(const SpatialRect &a, const SpatialRect &b)
+{
+    SpatialRect r;
+    r.left = (a.left < b.left) ? a.left : b.left;
+    r.top = (a.top < b.top) ? a.top : b.top;
+    r.right = (a.right > b.right) ? a.right : b.right;
+    r.bottom = (a.bottom > b.bottom) ? a.bottom : b.bottom;
+    return r;
+}
+
+static inline double spatialArea(const SpatialRect &r)
+{
+    return static_cast<double>(r.right - r.left) * static_cast<double>(r.bottom - r.top);
+}
+
+static inline uint64_t spatialKey(int type, unsigned int arrayId)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(type)) << 32) | arrayId;
+}
+
+
+class LevelSpatialIndexBackend
+{
+public:
+    virtual ~LevelSpatialIndexBackend() = default;
+    virtual void insert(uint64_t key, const SpatialRect &r) = 0;
+    virtual void remove(uint64_t key, const SpatialRect &r) = 0;
+    virtual void query(const SpatialRect &q, std::vector<uint64_t> &out) const = 0;
+    virtual void clear() = 0;
+};
+
+
+/*****************Uniform grid***************************/
+
+class SpatialGrid : public LevelSpatialIndexBackend
+{
+    struct Entry
+    {
+        uint64_t key;
+        SpatialRect r;
+    };
+
+    long m_cellSize;
+    std::unordered_map<uint64_t, std::vector<Entry> > m_cells;
+    //! Elements which cover too many cells, checked by every query
+    std::vector<Entry> m_far;
+
+    long cellOf(long v) const
+    {
+        // Floor division to keep negative coordinates in their own cells
+        return (v >= 0) ? (v / m_cellSize) : -((-v + m_cellSize - 1) / m_cellSize);
+    }
+
+    static uint64_t cellKey(long cx, long cy)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+    }
+
+    bool isFar(const SpatialRect &r) const
+    {
+        return (static_cast<double>(cellOf(r.right - 1)) - static_cast<double>(cellOf(r.left)) + 1.0) *
+               (static_cast<double>(cellOf(r.bottom - 1)) - static_cast<double>(cellOf(r.top)) + 1.0) > c_levelElementMaxCells;
+    }
+
+    static void cellFromKey(uint64_t key, long &cx, long &cy)
+    {
+        cx = static_cast<int32_t>(static_cast<uint32_t>(key >> 32));
+        cy = static_cast<int32_t>(static_cast<uint32_t>(key & 0xFFFFFFFF));
+    }
+
+    /*
+     * Element which covers several cells is reported from one cell only:
+     * the top-left cell of the intersection of the element and the query
+     */
+    void scanCell(long cx, long cy, const std::vector<Entry> &cell,
+                  const SpatialRect &q, long qcx, long qcy,
+                  std::vector<uint64_t> &out) const
+    {
+        for(const Entry &e : cell)
+        {
+            if(!spatialIntersects(e.r, q))
+                continue;
+            long ecx = cellOf(e.r.left), ecy = cellOf(e.r.top);
+            long firstX = (ecx > qcx) ? ecx : qcx;
+            long firstY = (ecy > qcy) ? ecy : qcy;
+            if(firstX == cx && firstY == cy)
+                out.push_back(e.key);
+        }
+    }
+
+public:
+    explicit SpatialGrid(long cellSize) : m_cellSize(cellSize > 0 ? cellSize : 128)
+    {}
+
+    void insert(uint64_t key, const SpatialRect &r) override
+    {
+        if(isFar(r))
+        {
+            m_far.push_back({key, r});
+            return;
+        }
+
+        const long cx1 = cellOf(r.right - 1), cy1 = cellOf(r.bottom - 1);
+        for(long cy = cellOf(r.top); cy <= cy1; cy++)
+        {
+            for(long cx = cellOf(r.left); cx <= cx1; cx++)
+                m_cells[cellKey(cx, cy)].push_back({key, r});
+        }
+    }
+
+    void remove(uint64_t key, const SpatialRect &r) override
+    {
+        if(isFar(r))
+        {
+            for(size_t i = 0; i < m_far.size(); i++)
+            {
+                if(m_far[i].key == key)
+                {
+                    m_far[i] = m_far.back();
+                    m_far.pop_back();
+                    break;
+                }
+            }
+            return;
+        }
+
+        const long cx1 = cellOf(r.right - 1), cy1 = cellOf(r.bottom - 1);
+        for(long cy = cellOf(r.top); cy <= cy1; cy++)
+        {
+            for(long cx = cellOf(r.left); cx <= cx1; cx++)
+            {
+                auto it = m_cells.find(cellKey(cx, cy));
+                if(it == m_cells.end())
+                    continue;
+
+                std::vector<Entry> &cell = it->second;
+                for(size_t i = 0; i < cell.size(); i++)
+                {
+                    if(cell[i].key == key)
+                    {
+                        cell[i] = cell.back();
+                        cell.pop_back();
+                        break;
+                    }
+                }
+
+                if(cell.empty())
+                    m_cells.erase(it);
+            }
+        }
+    }
+
+    void query(const SpatialRect &q, std::vector<uint64_t> &out) const override
+    {
+        for(const Entry &e : m_far)
+        {
+            if(spatialIntersects(e.r, q))
+                out.push_back(e.key);
+        }
+
+        const long qcx = cellOf(q.left), qcy = cellOf(q.top);
+        const long qcx1 = cellOf(q.right - 1), qcy1 = cellOf(q.bottom - 1);
+        const double cellsCount = static_cast<double>(qcx1 - qcx + 1) * static_cast<double>(qcy1 - qcy + 1);
+
+        if(cellsCount > static_cast<double>(m_cells.size()))
+        {
+            // Query is larger than the populated area: scan the populated cells
+            for(const auto &c : m_cells)
+            {
+                long cx, cy;
+                cellFromKey(c.first, cx, cy);
+                if(cx < qcx || cx > qcx1 || cy < qcy || cy > qcy1)
+                    continue;
+                scanCell(cx, cy, c.second, q, qcx, qcy, out);
+            }
+            return;
+        }
+
+        for(long cy = qcy; cy <= qcy1; cy++)
+        {
+            for(long cx = qcx; cx <= qcx1; cx++)
+            {
+                auto it = m_cells.find(cellKey(cx, cy));
+                if(it != m_cells.end())
+                    scanCell(cx, cy, it->second, q, qcx, qcy, out);
+            }
+        }
+    }
+
+    void clear() override
+    {
+        m_cells.clear();
+        m_far.clear();
+    }
+};
+
+
+/*****************R-tree***************************/
+
+class SpatialRTree : public LevelSpatialIndexBackend
+{
+    enum
+    {
+        MAX_ENTRIES = 8,
+        MIN_ENTRIES = 3
+    };
+
+    struct Node;
+
+    struct Entry
+    {
+        SpatialRect box;
+        uint64_t key = 0;
+        std::unique_ptr<Node> child;
+    };
+
+    struct Node
+    {
+        bool leaf = true;
+        Node *parent = nullptr;
+        std::vector<Entry> entries;
+    };
+
+    std::unique_ptr<Node> m_root;
+
+    static SpatialRect cover(const Node *n)
+    {
+        SpatialRect r = n->entries.front().box;
+        for(size_t i = 1; i < n->entries.size(); i++)
+            r = spatialUnion(r, n->entries[i].box);
+        return r;
+    }
+
+    static void updateEntryBox(Node *parent, const Node *child)
+    {
+        for(Entry &e : parent->entries)
+        {
+            if(e.child.get() == child)
+            {
+                e.box = cover(child);
+                return;
+            }
+        }
+    }
+
+    static double enlargement(const SpatialRect &box, const SpatialRect &r)
+    {
+        return spatialArea(spatialUnion(box, r)) - spatialArea(box);
+    }
+
+    Node *chooseLeaf(const SpatialRect &r) const
+    {
+        Node *n = m_root.get();
+        while(!n->leaf)
+        {
+            Entry *best = nullptr;
+            double bestGrow = 0.0, bestArea = 0.0;
+            for(Entry &e : n->entries)
+            {
+                double grow = enlargement(e.box, r);
+                double area = spatialArea(e.box);
+                if(!best || grow < bestGrow || (grow == bestGrow && area < bestArea))
+                {
+                    best = &e;
+                    bestGrow = grow;
+                    bestArea = area;
+                }
+            }
+            n = best->child.get();
+        }
+        return n;
+    }
+
+    static void assign(Node *n, Entry &&e, SpatialRect &box, bool &hasBox)
+    {
+        box = hasBox ? spatialUnion(box, e.box) : e.box;
+        hasBox = true;
+        if(e.child)
+            e.child->parent = n;
+        n->entries.push_back(std::move(e));
+    }
+
+    // Quadratic split: the most wasteful pair becomes seeds of two groups
+    std::unique_ptr<Node> split(Node *n)
+    {
+        std::vector<Entry> all = std::move(n->entries);
+        n->entries.clear();
+
+        std::unique_ptr<Node> sib(new Node);
+        sib->leaf = n->leaf;
+        sib->parent = n->parent;
+
+        size_t seedA = 0, seedB = 1;
+        double worst = -1.0;
+        for(size_t i = 0; i < all.size(); i++)
+        {
+            for(size_t j = i + 1; j < all.size(); j++)
+            {
+                double d = spatialArea(spatialUnion(all[i].box, all[j].box)) -
+                           spatialArea(all[i].box) - spatialArea(all[j].box);
+                if(d > worst)
+                {
+                    worst = d;
+                    seedA = i;
+                    seedB = j;
+                }
+            }
+        }
+
+        SpatialRect boxA, boxB;
+        bool hasA = false, hasB = false;
+        assign(n, std::move(all[seedA]), boxA, hasA);
+        assign(sib.get(), std::move(all[seedB]), boxB, hasB);
+
+        size_t left = all.size() - 2;
+        for(size_t i = 0; i < all.size(); i++)
+        {
+            if(i == seedA || i == seedB)
+                continue;
+
+            bool toA;
+            if(n->entries.size() + left <= MIN_ENTRIES)
+                toA = true;
+            else if(sib->entries.size() + left <= MIN_ENTRIES)
+                toA = false;
+            else
+            {
+                double growA = enlargement(boxA, all[i].box);
+                double growB = enlargement(boxB, all[i].box);
+                toA = (growA < growB) || (growA == growB && n->entries.size() <= sib->entries.size());
+            }
+
+            if(toA)
+                assign(n, std::move(all[i]), boxA, hasA);
+            else
+                assign(sib.get(), std::move(all[i]), boxB, hasB);
+            left--;
+        }
+
+        return sib;
+    }
+
+    void insertEntry(Node *node, Entry &&e)
+    {
+        if(e.child)
+            e.child->parent = node;
+        node->entries.push_back(std::move(e));
+
+        Node *n = node;
+        while(n)
+        {
+            if(n->entries.size() <= MAX_ENTRIES)
+            {
+                if(n->parent)
+                    updateEntryBox(n->parent, n);
+                n = n->parent;
+                continue;
+            }
+
+            std::unique_ptr<Node> sib = split(n);
+
+            if(!n->parent)
+            {
+                std::unique_ptr<Node> root(new Node);
+                root->leaf = false;
+
+                Entry a;
+                a.box = cover(n);
+                a.child = std::move(m_root);
+                a.child->parent = root.get();
+
+                Entry b;
+                b.box = cover(sib.get());
+                b.child = std::move(sib);
+                b.child->parent = root.get();
+
+                root->entries.push_back(std::move(a));
+                root->entries.push_back(std::move(b));
+                m_root = std::move(root);
+                return;
+            }
+
+            Node *p = n->parent;
+            updateEntryBox(p, n);
+
+            Entry b;
+            b.box = cover(sib.get());
+            b.child = std::move(sib);
+            b.child->parent = p;
+            p->entries.push_back(std::move(b));
+            n = p;
+        }
+    }
+
+    Node *findLeaf(Node *n, uint64_t key, const SpatialRect &r) const
+    {
+        for(Entry &e : n->entries)
+        {
+            if(n->leaf)
+            {
+                if(e.key == key)
+                    return n;
+            }
+            else if(spatialContains(e.box, r))
+            {
+                Node *found = findLeaf(e.child.get(), key, r);
+                if(found)
+                    return found;
+            }
+        }
+        return nullptr;
+    }
+
+    static void collectLeaves(Node *n, std::vector<Entry> &out)
+    {
+        for(Entry &e : n->entries)
+        {
+            if(n->leaf)
+                out.push_back(std::move(e));
+            else
+                collectLeaves(e.child.get(), out);
+        }
+        n->entries.clear();
+    }
+
+public:
+    SpatialRTree() : m_root(new Node)
+    {}
+
+    void insert(uint64_t key, const SpatialRect &r) override
+    {
+        Entry e;
+        e.box = r;
+        e.key = key;
+        insertEntry(chooseLeaf(r), std::move(e));
+    }
+
+    void remove(uint64_t key, const SpatialRect &r) override
+    {
+        Node *leaf = findLeaf(m_root.get(), key, r);
+        if(!leaf)
+            return;
+
+        for(size_t i = 0; i < leaf->entries.size(); i++)
+        {
+            if(leaf->entries[i].key == key)
+            {
+                leaf->entries.erase(leaf->entries.begin() + static_cast<std::ptrdiff_t>(i));
+                break;
+            }
+        }
+
+        // Condense: detach underflown nodes and re-insert their elements
+        std::vector<Entry> orphans;
+        Node *n = leaf;
+        while(n->parent)
+        {
+            Node *p = n->parent;
+            if(n->entries.size() < MIN_ENTRIES)
+            {
+                for(size_t i = 0; i < p->entries.size(); i++)
+                {
+                    if(p->entries[i].child.get() == n)
+                    {
+                        std::unique_ptr<Node> detached = std::move(p->entries[i].child);
+                        p->entries.erase(p->entries.begin() + static_cast<std::ptrdiff_t>(i));
+                        collectLeaves(detached.get(), orphans);
+                        break;
+                    }
+                }
+            }
+            else
+                updateEntryBox(p, n);
+            n = p;
+        }
+
+        while(!m_root->leaf && m_root->entries.size() == 1)
+        {
+            std::unique_ptr<Node> child = std::move(m_root->entries.front().child);
+            child->parent = nullptr;
+            m_root = std::move(child);
+        }
+
+        if(!m_root->leaf && m_root->entries.empty())
+            m_root.reset(new Node);
+
+        for(Entry &o : orphans)
+            insertEntry(chooseLeaf(o.box), std::move(o));
+    }
+
+    void query(const SpatialRect &q, std::vector<uint64_t> &out) const override
+    {
+        std::vector<const Node *> stack;
+        stack.push_back(m_root.get());
+
+        while(!stack.empty())
+        {
+            const Node *n = stack.back();
+            stack.pop_back();
+            for(const Entry &e : n->entries)
+            {
+                if(!spatialIntersects(e.box, q))
+                    continue;
+                if(n->leaf)
+                    out.push_back(e.key);
+                else
+                    stack.push_back(e.child.get());
+            }
+        }
+    }
+
+    void clear() override
+    {
+        m_root.reset(new Node);
+    }
+};
+
+
+/*****************Index***************************/
+
+LevelSpatialIndex::LevelSpatialIndex(Backend backend, long cellSize) :
+    m_backend(backend)
+{
+    if(backend == BACKEND_RTREE)
+        m_impl.reset(new SpatialRTree);
+    else
+        m_impl.reset(new SpatialGrid(cellSize));
+}
+
+LevelSpatialIndex::~LevelSpatialIndex()
+{}
+
+void LevelSpatialIndex::build(const LevelData &lvl, long objW, long objH)
+{
+    clear();
+
+    m_items.reserve(static_cast<size_t>(lvl.blocks.size() + lvl.bgo.size() + lvl.npc.size() +
+                                        lvl.doors.size() * 2 + lvl.physez.size()));
+
+    for(const LevelBlock &b : lvl.blocks)
+        insert(ITEM_BLOCK, b.meta.array_id, b.x, b.y, b.w, b.h);
+
+    for(const LevelBGO &b : lvl.bgo)
+        insert(ITEM_BGO, b.meta.array_id, b.x, b.y, objW, objH);
+
+    for(const LevelNPC &n : lvl.npc)
+        insert(ITEM_NPC, n.meta.array_id, n.x, n.y, objW, objH);
+
+    for(const LevelDoor &d : lvl.doors)
+    {
+        if(d.isSetIn)
+            insert(ITEM_WARP_ENTRANCE, d.meta.array_id, d.ix, d.iy, objW, objH);
+        if(d.isSetOut)
+            insert(ITEM_WARP_EXIT, d.meta.array_id, d.ox, d.oy, objW, objH);
+    }
+
+    for(const LevelPhysEnv &p : lvl.physez)
+        insert(ITEM_PHYSENV, p.meta.array_id, p.x, p.y, p.w, p.h);
+}
+
+void LevelSpatialIndex::clear()
+{
+    m_items.clear();
+    m_impl->clear();
+}
+
+size_t LevelSpatialIndex::size() const
+{
+    return m_items.size();
+}
+
+bool LevelSpatialIndex::insert(int type, unsigned int arrayId, long x, long y, long w, long h)
+{
+    const uint64_t key = spatialKey(type, arrayId);
+    Rect r = {x, y, x + (w > 0 ? w : 1), y + (h > 0 ? h : 1)};
+
+    if(!m_items.insert({key, r}).second)
+        return false;
+
+    m_impl->insert(key, r);
+    return true;
+}
+
+bool LevelSpatialIndex::remove(int type, unsigned int arrayId)
+{
+    auto it = m_items.find(spatialKey(type, arrayId));
+    if(it == m_items.end())
+        return false;
+
+    m_impl->remove(it->first, it->second);
+    m_items.erase(it);
+    return true;
+}
+
+bool LevelSpatialIndex::move(int type, unsigned int arrayId, long x, long y, long w, long h)
+{
+    auto it = m_items.find(spatialKey(type, arrayId));
+    if(it == m_items.end())
+        return false;
+
+    Rect r = {x, y, x + (w > 0 ? w : 1), y + (h > 0 ? h : 1)};
+    m_impl->remove(it->first, it->second);
+    it->second = r;
+    m_impl->insert(it->first, r);
+    return true;
+}
+
+bool LevelSpatialIndex::contains(int type, unsigned int arrayId, Rect *rect) const
+{
+    auto it = m_items.find(spatialKey(type, arrayId));
+    if(it == m_items.end())
+        return false;
+
+    if(rect)
+        *rect = it->second;
+    return true;
+}
+
+void LevelSpatialIndex::queryRect(long left, long top, long right, long bottom, std::vector<Item> &out) const
+{
+    out.clear();
+    if(right <= left || bottom <= top)
+        return;
+
+    std::vector<uint64_t> keys;
+    m_impl->query({left, top, right, bottom}, keys);
+
+    out.reserve(keys.size());
+    for(uint64_t k : keys)
+        out.push_back({static_cast<int>(k >> 32), static_cast<unsigned int>(k & 0xFFFFFFFF)});
+}
+
+void LevelSpatialIndex::queryPoint(long x, long y, std::vector<Item> &out) const
+{
+    queryRect(x, y, x + 1, y + 1, out);
+}
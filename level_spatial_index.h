@@ -0,0 +1,192 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*!
+ * \file level_spatial_index.h
+ * \brief Contains the spatial index of level elements for "what is here" queries
+ */
+
+#pragma once
+#ifndef LEVEL_SPATIAL_INDEX_H
+#define LEVEL_SPATIAL_INDEX_H
+
+#include "pge_file_lib_globs.h"
+#include "lvl_filedata.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+class LevelSpatialIndexBackend;
+
+/*!
+ * \brief Spatial index over blocks, BGO, NPC, warps and physical environment zones of the level
+ *
+ * Elements are identified by their type and ElementMeta::array_id.
+ * All rectangles are half-open: the right and bottom edges are excluded.
+ */
+class LevelSpatialIndex
+{
+public:
+    //! Storage algorithm of the index
+    enum Backend
+    {
+        //! Uniform grid of square cells, best for the dense tile-aligned levels
+        BACKEND_GRID = 0,
+        //! R-tree, best for sparse levels and elements of very different sizes
+        BACKEND_RTREE
+    };
+
+    //! Type of the indexed element
+    enum ItemType
+    {
+        ITEM_BLOCK = 0,
+        ITEM_BGO,
+        ITEM_NPC,
+        //! Entrance point of the warp
+        ITEM_WARP_ENTRANCE,
+        //! Exit point of the warp
+        ITEM_WARP_EXIT,
+        ITEM_PHYSENV
+    };
+
+    //! Found element
+    struct Item
+    {
+        //! Type of the element (ItemType)
+        int type;
+        //! Array ID of the element
+        unsigned int arrayId;
+    };
+
+    //! Rectangle of the element
+    struct Rect
+    {
+        long left;
+        long top;
+        long right;
+        long bottom;
+    };
+
+    /*!
+     * \brief Constructor
+     * \param backend Storage algorithm
+     * \param cellSize Size of the grid cell, used by the grid backend only
+     */
+    explicit LevelSpatialIndex(Backend backend = BACKEND_GRID, long cellSize = 128);
+    ~LevelSpatialIndex();
+    LevelSpatialIndex(const LevelSpatialIndex &) = delete;
+    LevelSpatialIndex &operator=(const LevelSpatialIndex &) = delete;
+
+    /*!
+     * \brief Current storage algorithm
+     */
+    Backend backend() const
+    {
+        return m_backend;
+    }
+
+    /*!
+     * \brief Fills the index with all elements of the level, previous content gets removed
+     * \param lvl Level data
+     * \param objW Width of BGO, NPC and warp points which have no size in the level data
+     * \param objH Height of BGO, NPC and warp points which have no size in the level data
+     */
+    void build(const LevelData &lvl, long objW = 32, long objH = 32);
+    /*!
+     * \brief Removes all elements
+     */
+    void clear();
+    /*!
+     * \brief Number of indexed elements
+     */
+    size_t size() const;
+
+    /*!
+     * \brief Adds the element
+     * \param type Type of the element (ItemType)
+     * \param arrayId Array ID of the element
+     * \param x X position
+     * \param y Y position
+     * \param w Width, less than 1 is treated as 1
+     * \param h Height, less than 1 is treated as 1
+     * \return false if element with same type and array ID is already indexed
+     */
+    bool insert(int type, unsigned int arrayId, long x, long y, long w, long h);
+    /*!
+     * \brief Removes the element
+     * \param type Type of the element (ItemType)
+     * \param arrayId Array ID of the element
+     * \return false if element is not indexed
+     */
+    bool remove(int type, unsigned int arrayId);
+    /*!
+     * \brief Changes position and size of the element
+     * \param type Type of the element (ItemType)
+     * \param arrayId Array ID of the element
+     * \param x New X position
+     * \param y New Y position
+     * \param w New width
+     * \param h New height
+     * \return false if element is not indexed
+     */
+    bool move(int type, unsigned int arrayId, long x, long y, long w, long h);
+    /*!
+     * \brief Is element indexed
+     * \param type Type of the element (ItemType)
+     * \param arrayId Array ID of the element
+     * \param [__out] rect Rectangle of the element (optional)
+     * \return true if element is indexed
+     */
+    bool contains(int type, unsigned int arrayId, Rect *rect = nullptr) const;
+
+    /*!
+     * \brief Finds all elements which are intersecting the rectangle
+     * \param left Left edge
+     * \param top Top edge
+     * \param right Right edge (excluded)
+     * \param bottom Bottom edge (excluded)
+     * \param [__out] out Found elements, in no particular order
+     */
+    void queryRect(long left, long top, long right, long bottom, std::vector<Item> &out) const;
+    /*!
+     * \brief Finds all elements which are covering the point
+     * \param x X position
+     * \param y Y position
+     * \param [__out] out Found elements, in no particular order
+     */
+    void queryPoint(long x, long y, std::vector<Item> &out) const;
+
+private:
+    Backend m_backend;
+    //! Rectangles of all indexed elements by the element key
+    std::unordered_map<uint64_t, Rect> m_items;
+    std::unique_ptr<LevelSpatialIndexBackend> m_impl;
+};
+
+#endif // LEVEL_SPATIAL_INDEX_H
@@ -27,8 +27,9 @@
 #include "file_formats.h"
 #include "lvl_filedata.h"
 #include "pge_file_lib_private.h"
+#include "pge_sort_private.h"
 
-#include <stack>
+#include <atomic>
 
 /*********************************************************************************/
 /***************************SMBX64-Specific features******************************/
@@ -78,162 +79,64 @@ int FileFormats::smbx64CountStars(LevelData &lvl)
     return stars;
 }
 
-template<class T, class U>
-void quickSort(T &array, bool (*qLess)(const U&, const U&), bool (*qMore)(const U&, const U&))
-{
-    if(array.size() <= 1)
-        return; //Nothing to sort!
-
-    class my_stack : public std::stack< int >
-    {
-    public:
-        using std::stack<int>::c; // expose the container
-    };
-
-    my_stack beg;
-    my_stack end;
-    U piv;
-    int i = 0, L, R, swapv;
-    beg.push(0);
-    end.push((int)array.size());
-#define ST(x) static_cast<pge_size_t>(x)
-    while(i >= 0)
-    {
-        L = beg.c[ST(i)];
-        R = end.c[ST(i)] - 1;
-        if(L < R)
-        {
-            piv = array[ST(L)];
-            while(L < R)
-            {
-                while(qMore(array[ST(R)], piv) && (L < R))
-                    R--;
-                if(L < R)
-                    array[ST(L++)] = array[ST(R)];
-                while(qLess(array[ST(L)], piv) && (L < R))
-                    L++;
-                if(L < R)
-                    array[ST(R--)] = array[ST(L)];
-            }
-            array[ST(L)] = piv;
-            beg.push(L + 1);
-            end.push(end.c[ST(i)]);
-            end.c[ST(i++)] = (L);
-            if((end.c[ST(i)] - beg.c[ST(i)]) > (end.c[ST(i - 1)] - beg.c[ST(i - 1)]))
-            {
-                swapv = beg.c[ST(i)];
-                beg.c[ST(i)] = beg.c[ST(i - 1)];
-                beg.c[ST(i - 1)] = swapv;
-                swapv = end.c[ST(i)];
-                end.c[ST(i)] = end.c[ST(i - 1)];
-                end.c[ST(i - 1)] = swapv;
-            }
-        }
-        else
-        {
-            i--;
-            beg.pop();
-            end.pop();
-        }
-    }
-#undef ST
-}
-
-
-/* Blocks sorting conditions for SMBX-64 standard*/
-
-static inline bool blkMore(const LevelBlock &a, const LevelBlock &b)
-{
-    return (a.x > b.x) ||
-          ((a.x == b.x) && (a.y >  b.y)) ||
-          ((a.x == b.x) && (a.y == b.y) && (a.meta.array_id >= b.meta.array_id));
-}
-
-static inline bool blkLess(const LevelBlock &a, const LevelBlock &b)
-{
-    return (a.x < b.x) ||
-          ((a.x == b.x) && (a.y <  b.y)) ||
-          ((a.x == b.x) && (a.y == b.y) && (a.meta.array_id <= b.meta.array_id));
-}
+/* Blocks sorting conditions for SMBX-64 standard: X, then Y, then array ID */
 
 void FileFormats::smbx64LevelSortBlocks(LevelData &lvl)
 {
-    quickSort<PGELIST<LevelBlock>, LevelBlock>(lvl.blocks, blkLess, blkMore);
-}
-
-
-/* BGO sorting conditions for SMBX-64 standard*/
-
-static inline bool smbx64BgoMore(const LevelBGO &a, const LevelBGO &b)
-{
-    bool sp_gr = (a.smbx64_sp_apply > b.smbx64_sp_apply);
-    bool sp_eq = (a.smbx64_sp_apply == b.smbx64_sp_apply);
-
-    bool arrayId_ge = a.meta.array_id >= b.meta.array_id;
-
-    return  sp_gr || (sp_eq && arrayId_ge);
+    PGE_SortElements<3>(lvl.blocks, [](const LevelBlock &b, uint64_t *w)
+    {
+        w[0] = PGE_SortKeySigned(b.x);
+        w[1] = PGE_SortKeySigned(b.y);
+        w[2] = b.meta.array_id;
+    });
+    lvl.blocks_arrayid_map.refresh(lvl.blocks);
 }
 
-static inline bool smbx64BgoLess(const LevelBGO &a, const LevelBGO &b)
-{
-    bool sp_lt = (a.smbx64_sp_apply < b.smbx64_sp_apply);
-    bool sp_eq = (a.smbx64_sp_apply == b.smbx64_sp_apply);
-
-    bool arrayId_le = a.meta.array_id <= b.meta.array_id;
 
-    return  sp_lt || (sp_eq && arrayId_le);
-}
+/* BGO sorting conditions for SMBX-64 standard: order priority, then array ID */
 
 void FileFormats::smbx64LevelSortBGOs(LevelData &lvl)
 {
-    quickSort<PGELIST<LevelBGO>, LevelBGO>(lvl.bgo, smbx64BgoLess, smbx64BgoMore);
+    PGE_SortElements<2>(lvl.bgo, [](const LevelBGO &b, uint64_t *w)
+    {
+        w[0] = PGE_SortKeySigned(b.smbx64_sp_apply);
+        w[1] = b.meta.array_id;
+    });
+    lvl.bgo_arrayid_map.refresh(lvl.bgo);
 }
 
 
-/* BGO sorting conditions for SMBX2 */
+/* BGO sorting conditions for SMBX2: order priority, then Z-offset, then array ID */
 
-static inline bool sbx2BgoMore(const LevelBGO &a, const LevelBGO &b)
+static inline int64_t smbx2BgoZOffsetKey(double zOffset)
 {
-    bool sp_gr = (a.smbx64_sp_apply > b.smbx64_sp_apply);
-    bool sp_eq = (a.smbx64_sp_apply == b.smbx64_sp_apply);
-    bool zOffset_gr = a.z_offset > b.z_offset;
-    bool zOffset_eq = PGE_floatEqual(a.z_offset, b.z_offset, 8);
-
-    bool arrayId_ge = a.meta.array_id >= b.meta.array_id;
-
-    return sp_gr || (sp_eq && (zOffset_gr || (zOffset_eq && arrayId_ge)));
-}
-
-static inline bool smbx2BgoLess(const LevelBGO &a, const LevelBGO &b)
-{
-    bool sp_lt = (a.smbx64_sp_apply < b.smbx64_sp_apply);
-    bool sp_eq = (a.smbx64_sp_apply == b.smbx64_sp_apply);
-    bool zOffset_lt = a.z_offset < b.z_offset;
-    bool zOffset_eq = PGE_floatEqual(a.z_offset, b.z_offset, 8);
-
-    bool arrayId_le = a.meta.array_id <= b.meta.array_id;
-
-    return sp_lt || (sp_eq && (zOffset_lt || (zOffset_eq && arrayId_le)));
+    // Same precision as PGE_floatEqual(a, b, 8): offsets are equal when their scaled integer parts are equal
+    const double scaled = zOffset * 1e8;
+    if(scaled >= 9.2e18)
+        return INT64_MAX;
+    if(scaled <= -9.2e18)
+        return INT64_MIN;
+    return static_cast<int64_t>(scaled);
 }
 
 void FileFormats::smbx2bLevelSortBGOs(LevelData &lvl)
 {
-    quickSort<PGELIST<LevelBGO>, LevelBGO>(lvl.bgo, smbx2BgoLess, sbx2BgoMore);
-}
-
-static inline bool arrayIdBgoMore(const LevelBGO &a, const LevelBGO &b)
-{
-    return a.meta.array_id >= b.meta.array_id;
-}
-
-static inline bool arrayIdBgoLess(const LevelBGO &a, const LevelBGO &b)
-{
-    return a.meta.array_id <= b.meta.array_id;
+    PGE_SortElements<3>(lvl.bgo, [](const LevelBGO &b, uint64_t *w)
+    {
+        w[0] = PGE_SortKeySigned(b.smbx64_sp_apply);
+        w[1] = PGE_SortKeySigned(smbx2BgoZOffsetKey(b.z_offset));
+        w[2] = b.meta.array_id;
+    });
+    lvl.bgo_arrayid_map.refresh(lvl.bgo);
 }
 
 void FileFormats::arrayIdLevelSortBGOs(LevelData &lvl)
 {
-    quickSort<PGELIST<LevelBGO>, LevelBGO>(lvl.bgo, arrayIdBgoLess, arrayIdBgoMore);
+    PGE_SortElements<1>(lvl.bgo, [](const LevelBGO &b, uint64_t *w)
+    {
+        w[0] = b.meta.array_id;
+    });
+    lvl.bgo_arrayid_map.refresh(lvl.bgo);
 }
 
 int FileFormats::smbx64LevelCheckLimits(LevelData &lvl)
@@ -462,6 +365,9 @@ void FileFormats::LevelAddInternalEvents(LevelData &FileData)
         events.name = "P Switch - End";
         FileData.events.push_back(events);
     }
+
+    FileData.layers_arrayid_map.refresh(FileData.layers);
+    FileData.events_arrayid_map.refresh(FileData.events);
 }
 
 
@@ -591,6 +497,143 @@ bool LevelData::layerIsExist(const PGESTRING &title)
     return false;
 }
 
+int LevelData::layerIndex(const PGESTRING &title) const
+{
+    for(pge_size_t i = 0; i < layers.size(); i++)
+    {
+        if(layers[i].name == title)
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+
+int LevelData::eventIndex(const PGESTRING &title) const
+{
+    for(pge_size_t i = 0; i < events.size(); i++)
+    {
+        if(events[i].name == title)
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+
+
+void LevelData::buildArrayIdMaps()
+{
+    blocks_arrayid_map.rebuild(blocks);
+    bgo_arrayid_map.rebuild(bgo);
+    npc_arrayid_map.rebuild(npc);
+    doors_arrayid_map.rebuild(doors);
+    physez_arrayid_map.rebuild(physez);
+    layers_arrayid_map.rebuild(layers);
+    events_arrayid_map.rebuild(events);
+}
+
+void LevelData::refreshArrayIdMaps()
+{
+    blocks_arrayid_map.refresh(blocks);
+    bgo_arrayid_map.refresh(bgo);
+    npc_arrayid_map.refresh(npc);
+    doors_arrayid_map.refresh(doors);
+    physez_arrayid_map.refresh(physez);
+    layers_arrayid_map.refresh(layers);
+    events_arrayid_map.refresh(events);
+}
+
+
+static std::atomic<bool> s_lvlResolveReferences(false);
+
+void FileFormats::SetLevelResolveReferences(bool enabled)
+{
+    s_lvlResolveReferences = enabled;
+}
+
+bool FileFormats::LevelResolveReferencesEnabled()
+{
+    return s_lvlResolveReferences;
+}
+
+static inline int lvlRefIndex(const PGEHASH<PGESTRING, int> &lookup, const PGESTRING &name)
+{
+    if(IsEmpty(name))
+        return -1;
+    auto it = lookup.find(name);
+    return (it == lookup.end()) ? -1 : PGEMAPVAL(it);
+}
+
+static void lvlRefIndices(const PGEHASH<PGESTRING, int> &lookup, const PGESTRINGList &names, PGELIST<int> &out)
+{
+    out.clear();
+    for(const PGESTRING &n : names)
+        out.push_back(lvlRefIndex(lookup, n));
+}
+
+void FileFormats::LevelResolveReferences(LevelData &lvl)
+{
+    lvl.layers_lookup.clear();
+    lvl.events_lookup.clear();
+
+    // On duplicated names, the first entry wins
+    for(pge_size_t i = 0; i < lvl.layers.size(); i++)
+    {
+        if(lvl.layers_lookup.find(lvl.layers[i].name) == lvl.layers_lookup.end())
+            lvl.layers_lookup[lvl.layers[i].name] = static_cast<int>(i);
+    }
+
+    for(pge_size_t i = 0; i < lvl.events.size(); i++)
+    {
+        if(lvl.events_lookup.find(lvl.events[i].name) == lvl.events_lookup.end())
+            lvl.events_lookup[lvl.events[i].name] = static_cast<int>(i);
+    }
+
+    const PGEHASH<PGESTRING, int> &l = lvl.layers_lookup;
+    const PGEHASH<PGESTRING, int> &e = lvl.events_lookup;
+
+    for(auto &b : lvl.blocks)
+    {
+        b.layer_index = lvlRefIndex(l, b.layer);
+        b.event_destroy_index = lvlRefIndex(e, b.event_destroy);
+        b.event_hit_index = lvlRefIndex(e, b.event_hit);
+        b.event_emptylayer_index = lvlRefIndex(e, b.event_emptylayer);
+    }
+
+    for(auto &b : lvl.bgo)
+        b.layer_index = lvlRefIndex(l, b.layer);
+
+    for(auto &n : lvl.npc)
+    {
+        n.layer_index = lvlRefIndex(l, n.layer);
+        n.attach_layer_index = lvlRefIndex(l, n.attach_layer);
+        n.event_activate_index = lvlRefIndex(e, n.event_activate);
+        n.event_die_index = lvlRefIndex(e, n.event_die);
+        n.event_talk_index = lvlRefIndex(e, n.event_talk);
+        n.event_emptylayer_index = lvlRefIndex(e, n.event_emptylayer);
+    }
+
+    for(auto &d : lvl.doors)
+    {
+        d.layer_index = lvlRefIndex(l, d.layer);
+        d.event_enter_index = lvlRefIndex(e, d.event_enter);
+    }
+
+    for(auto &p : lvl.physez)
+    {
+        p.layer_index = lvlRefIndex(l, p.layer);
+        p.touch_event_index = lvlRefIndex(e, p.touch_event);
+    }
+
+    for(auto &ev : lvl.events)
+    {
+        ev.trigger_index = lvlRefIndex(e, ev.trigger);
+        ev.movelayer_index = lvlRefIndex(l, ev.movelayer);
+        for(auto &ml : ev.moving_layers)
+            ml.layer_index = lvlRefIndex(l, ml.name);
+        lvlRefIndices(l, ev.layers_hide, ev.layers_hide_index);
+        lvlRefIndices(l, ev.layers_show, ev.layers_show_index);
+        lvlRefIndices(l, ev.layers_toggle, ev.layers_toggle_index);
+    }
+}
+
 bool LevelSMBX64Event::ctrlKeyPressed() const
 {
     return ctrl_up ||
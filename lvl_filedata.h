@@ -181,6 +181,14 @@ struct LevelBlock
     /*
      * Editor-only parameters which are not saving into file
      */
+    //! Resolved index of the parent layer in the LevelData::layers array (-1 if unresolved, see FileFormats::LevelResolveReferences())
+    int layer_index = -1;
+    //! Resolved index of the destroy event in the LevelData::events array (-1 if none or unresolved)
+    int event_destroy_index = -1;
+    //! Resolved index of the hit event in the LevelData::events array (-1 if none or unresolved)
+    int event_hit_index = -1;
+    //! Resolved index of the empty layer event in the LevelData::events array (-1 if none or unresolved)
+    int event_emptylayer_index = -1;
     //! Helper meta-data
     ElementMeta meta;
     //! Array-ID is an unique key value identificates each unique block object.
@@ -247,6 +255,8 @@ struct LevelBGO
      */
     //! Automatically calculated value of SMBX64 Order priority
     long smbx64_sp_apply = -1;
+    //! Resolved index of the parent layer in the LevelData::layers array (-1 if unresolved, see FileFormats::LevelResolveReferences())
+    int layer_index = -1;
     //! Helper meta-data
     ElementMeta meta;
 };
@@ -401,6 +411,18 @@ struct LevelNPC
      */
     //!< Is this NPC a star (Copying from lvl_npc.ini config on file read). Stars are special bonus which required by player to be able enter into some doors/warps
     bool is_star = false;
+    //! Resolved index of the parent layer in the LevelData::layers array (-1 if unresolved, see FileFormats::LevelResolveReferences())
+    int layer_index = -1;
+    //! Resolved index of the attached layer in the LevelData::layers array (-1 if none or unresolved)
+    int attach_layer_index = -1;
+    //! Resolved index of the activation event in the LevelData::events array (-1 if none or unresolved)
+    int event_activate_index = -1;
+    //! Resolved index of the death event in the LevelData::events array (-1 if none or unresolved)
+    int event_die_index = -1;
+    //! Resolved index of the talk event in the LevelData::events array (-1 if none or unresolved)
+    int event_talk_index = -1;
+    //! Resolved index of the empty layer event in the LevelData::events array (-1 if none or unresolved)
+    int event_emptylayer_index = -1;
     //! Helper meta-data
     ElementMeta meta;
 };
@@ -527,6 +549,10 @@ struct LevelDoor
     /*
      * Editor-only parameters which are not saving into file
      */
+    //! Resolved index of the parent layer in the LevelData::layers array (-1 if unresolved, see FileFormats::LevelResolveReferences())
+    int layer_index = -1;
+    //! Resolved index of the enter event in the LevelData::events array (-1 if none or unresolved)
+    int event_enter_index = -1;
     //! Helper meta-data
     ElementMeta meta;
     //! User data pointer for entrance, Useful in the editors to have direct pointer to pre-placed elements
@@ -588,6 +614,10 @@ struct LevelPhysEnv
     /*
      * Editor-only parameters which are not saving into file
      */
+    //! Resolved index of the parent layer in the LevelData::layers array (-1 if unresolved, see FileFormats::LevelResolveReferences())
+    int layer_index = -1;
+    //! Resolved index of the touch event in the LevelData::events array (-1 if none or unresolved)
+    int touch_event_index = -1;
     //! Helper meta-data
     ElementMeta meta;
 };
@@ -715,6 +745,12 @@ struct LevelEvent_MoveLayer
     };
     //! Way to do layer motion
     int way = LM_Speed;
+
+    /*
+     * Editor-only parameters which are not saving into file
+     */
+    //! Resolved index of the moving layer in the LevelData::layers array (-1 if unknown or unresolved, see FileFormats::LevelResolveReferences())
+    int layer_index = -1;
 };
 
 /*!
@@ -912,6 +948,16 @@ struct LevelSMBX64Event
     /*
      * Editor-only parameters which are not saving into file
      */
+    //! Resolved index of the triggered event in the LevelData::events array (-1 if none or unresolved, see FileFormats::LevelResolveReferences())
+    int trigger_index = -1;
+    //! Resolved index of the moving layer in the LevelData::layers array (-1 if none or unresolved)
+    int movelayer_index = -1;
+    //! Resolved indices of layers to hide, parallel to layers_hide, -1 for unknown layers
+    PGELIST<int> layers_hide_index;
+    //! Resolved indices of layers to show, parallel to layers_show, -1 for unknown layers
+    PGELIST<int> layers_show_index;
+    //! Resolved indices of layers to toggle, parallel to layers_toggle, -1 for unknown layers
+    PGELIST<int> layers_toggle_index;
     //! Helper meta-data
     ElementMeta meta;
 };
@@ -1114,8 +1160,72 @@ struct LevelData
      * \return true if requested event is exists
      */
     bool layerIsExist(const PGESTRING &title);
+
+    /*
+     * Resolved references (see FileFormats::LevelResolveReferences())
+     */
+    //! Layer name to index in the layers array lookup table, as it was at the time of resolving
+    PGEHASH<PGESTRING, int> layers_lookup;
+    //! Event name to index in the events array lookup table, as it was at the time of resolving
+    PGEHASH<PGESTRING, int> events_lookup;
+
+    /*!
+     * \brief Finds index of the layer by name
+     * \param title Layer name
+     * \return Index in the layers array or -1 if layer is not exists
+     */
+    int layerIndex(const PGESTRING &title) const;
+    /*!
+     * \brief Finds index of the event by name
+     * \param title Event name
+     * \return Index in the events array or -1 if event is not exists
+     */
+    int eventIndex(const PGESTRING &title) const;
+
+    /*
+     * Array-ID to index maps (disabled until buildArrayIdMaps() call)
+     */
+    ElementArrayIdMap blocks_arrayid_map;
+    ElementArrayIdMap bgo_arrayid_map;
+    ElementArrayIdMap npc_arrayid_map;
+    ElementArrayIdMap doors_arrayid_map;
+    ElementArrayIdMap physez_arrayid_map;
+    ElementArrayIdMap layers_arrayid_map;
+    ElementArrayIdMap events_arrayid_map;
+
+    /*!
+     * \brief Enables and fills Array-ID to index maps of all element collections
+     */
+    void buildArrayIdMaps();
+    /*!
+     * \brief Refills enabled Array-ID to index maps after reordering of element collections
+     */
+    void refreshArrayIdMaps();
 };
 
 
 
+/*!
+ * \brief List of element collections of the LevelData
+ *
+ * Every entry is X(element type, field name of LevelData)
+ */
+#define PGE_LEVEL_COLLECTIONS(X) \
+    X(LevelData::MusicOverrider, music_overrides) \
+    X(LevelData::MusicOverrider, sound_overrides) \
+    X(LevelSection, sections) \
+    X(PlayerPoint, players) \
+    X(LevelBlock, blocks) \
+    X(LevelBGO, bgo) \
+    X(LevelNPC, npc) \
+    X(LevelDoor, doors) \
+    X(LevelPhysEnv, physez) \
+    X(LevelLayer, layers) \
+    X(LevelSMBX64Event, events) \
+    X(LevelVariable, variables) \
+    X(LevelScript, scripts) \
+    X(LevelArray, arrays) \
+    X(PGESTRING, unsupported_38a_lines) \
+    X(LevelItemSetup38A, custom38A_configs)
+
 #endif // LVL_FILEDATA_H
@@ -99,6 +99,154 @@ struct ElementMeta
     void *userdata;
 };
 
+/**
+ * @brief Array-ID to array index lookup of one element collection
+ *
+ * The map is disabled by default. Once it's built with rebuild(), library
+ * functions which reorder the collection (sorting, internal events insertion)
+ * keep it up to date. When elements are added or removed by the caller,
+ * append() and erase() should be used to keep the map correct.
+ */
+class ElementArrayIdMap
+{
+public:
+    /*!
+     * \brief Is map built and maintained
+     */
+    bool isEnabled() const
+    {
+        return m_enabled;
+    }
+
+    /*!
+     * \brief Clears the map and stops it's maintenance
+     */
+    void disable()
+    {
+        m_map.clear();
+        m_enabled = false;
+    }
+
+    /*!
+     * \brief Enables the map and fills it from the collection
+     * \param arr Element collection
+     */
+    template<class Array>
+    void rebuild(const Array &arr)
+    {
+        m_map.clear();
+        m_map.reserve(static_cast<int>(arr.size()));
+        long i = 0;
+        for(const auto &e : arr)
+            m_map[e.meta.array_id] = i++;
+        m_enabled = true;
+    }
+
+    /*!
+     * \brief Fills the map from the collection when map is enabled
+     * \param arr Element collection
+     */
+    template<class Array>
+    void refresh(const Array &arr)
+    {
+        if(m_enabled)
+            rebuild(arr);
+    }
+
+    /*!
+     * \brief Finds the index of element
+     * \param arrayId Array-ID of the element
+     * \return Index of element in the collection, or -1 if not found or the map is disabled
+     */
+    long find(unsigned int arrayId) const
+    {
+        auto it = m_map.find(arrayId);
+        return (it == m_map.end()) ? -1 : PGEMAPVAL(it);
+    }
+
+    /*!
+     * \brief Appends the element to the end of collection
+     * \param arr Element collection
+     * \param elem Element to append
+     */
+    template<class Array, class T>
+    void append(Array &arr, const T &elem)
+    {
+        if(m_enabled)
+            m_map[elem.meta.array_id] = static_cast<long>(arr.size());
+        arr.push_back(elem);
+    }
+
+    /*!
+     * \brief Removes the element from the collection by Array-ID
+     * \param arr Element collection
+     * \param arrayId Array-ID of the element to remove
+     * \return true if element was found and removed
+     *
+     * When the map is disabled, the collection gets scanned to find the element.
+     * Indices of all next elements are shifted, so it takes time proportional
+     * to the number of elements after the removed one.
+     */
+    template<class Array>
+    bool erase(Array &arr, unsigned int arrayId)
+    {
+        long index = -1;
+        if(m_enabled)
+            index = find(arrayId);
+        else
+        {
+            long i = 0;
+            for(const auto &e : arr)
+            {
+                if(e.meta.array_id == arrayId)
+                {
+                    index = i;
+                    break;
+                }
+                i++;
+            }
+        }
+
+        if(index < 0)
+            return false;
+
+        arr.erase(arr.begin() + index);
+
+        if(m_enabled)
+        {
+            m_map.erase(m_map.find(arrayId));
+            for(long i = index; i < static_cast<long>(arr.size()); i++)
+                m_map[arr[i].meta.array_id] = i;
+        }
+
+        return true;
+    }
+
+    /*!
+     * \brief Number of indexed elements
+     */
+    size_t size() const
+    {
+        return static_cast<size_t>(m_map.size());
+    }
+
+    /*!
+     * \brief Number of hash buckets allocated by the map
+     */
+    size_t bucketsCount() const
+    {
+#ifdef PGE_FILES_QT
+        return static_cast<size_t>(m_map.capacity());
+#else
+        return m_map.bucket_count();
+#endif
+    }
+
+private:
+    bool m_enabled = false;
+    PGEHASH<unsigned int, long> m_map;
+};
+
 /*!
  * \brief Position bookmark entry structure
  */
@@ -0,0 +1,434 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "npc_config_set.h"
+#include "file_formats.h"
+#include "pge_file_lib_private.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <cstring>
+
+static const char     s_ncsMagic[8] = {'P', 'G', 'E', 'N', 'P', 'C', 'S', '\0'};
+static const uint32_t s_ncsVersion = 2;
+static const uint32_t s_ncsByteOrder = 0x01020304;
+
+/*!
+ * \brief Takes NPC ID from the name of npc-<ID>.txt file
+ * \param [__in] fileName Name of the file
+ * \param [__out] id NPC ID
+ * \return true if the name matches
+ */
+static bool ncsFileId(const PGESTRING &fileName, unsigned long &id)
+{
+#ifdef PGE_FILES_QT
+    const std::string name = fileName.toLower().toStdString();
+#else
+    const std::string name = PGESTR_toLower(fileName);
+#endif
+    const size_t prefix = 4, suffix = 4; // "npc-" and ".txt"
+    if(name.size() <= prefix + suffix)
+        return false;
+    if(name.compare(0, prefix, "npc-") != 0 || name.compare(name.size() - suffix, suffix, ".txt") != 0)
+        return false;
+
+    id = 0;
+    for(size_t i = prefix; i < name.size() - suffix; i++)
+    {
+        char c = name[i];
+        if(c < '0' || c > '9')
+            return false;
+        id = id * 10 + static_cast<unsigned long>(c - '0');
+        if(id > NPCConfigSet::maxNpcId)
+            return false;
+    }
+    return id > 0;
+}
+
+/*****************Snapshot***************************/
+
+class NPCConfigSnapshotWriter
+{
+public:
+    std::string out;
+
+    template<class T>
+    void pod(const T &v)
+    {
+        out.append(reinterpret_cast<const char *>(&v), sizeof(T));
+    }
+
+    void str(const PGESTRING &s)
+    {
+#ifdef PGE_FILES_QT
+        QByteArray u = s.toUtf8();
+        pod(static_cast<uint32_t>(u.size()));
+        out.append(u.constData(), static_cast<size_t>(u.size()));
+#else
+        pod(static_cast<uint32_t>(s.size()));
+        out.append(s);
+#endif
+    }
+
+    void field(const int32_t &v) { pod(v); }
+    void field(const uint32_t &v) { pod(v); }
+    void field(const bool &v) { pod(static_cast<uint8_t>(v)); }
+    void field(const double &v) { pod(v); }
+    void field(const PGESTRING &v) { str(v); }
+};
+
+class NPCConfigSnapshotReader
+{
+    const std::string &m_data;
+    size_t m_pos = 0;
+    bool m_ok = true;
+
+public:
+    explicit NPCConfigSnapshotReader(const std::string &data) : m_data(data) {}
+
+    bool ok() const
+    {
+        return m_ok;
+    }
+
+    bool atEnd() const
+    {
+        return m_pos == m_data.size();
+    }
+
+    bool raw(void *dst, size_t size)
+    {
+        if(!m_ok || m_data.size() - m_pos < size)
+        {
+            m_ok = false;
+            return false;
+        }
+        std::memcpy(dst, m_data.data() + m_pos, size);
+        m_pos += size;
+        return true;
+    }
+
+    template<class T>
+    void pod(T &v)
+    {
+        if(!raw(&v, sizeof(T)))
+            v = T();
+    }
+
+    void str(PGESTRING &s)
+    {
+        uint32_t len = 0;
+        pod(len);
+        if(!m_ok || m_data.size() - m_pos < len)
+        {
+            m_ok = false;
+            s.clear();
+            return;
+        }
+#ifdef PGE_FILES_QT
+        s = QString::fromUtf8(m_data.data() + m_pos, static_cast<int>(len));
+#else
+        s.assign(m_data, m_pos, len);
+#endif
+        m_pos += len;
+    }
+
+    void field(int32_t &v) { pod(v); }
+    void field(uint32_t &v) { pod(v); }
+    void field(bool &v)
+    {
+        uint8_t b = 0;
+        pod(b);
+        v = (b != 0);
+    }
+    void field(double &v) { pod(v); }
+    void field(PGESTRING &v) { str(v); }
+};
+
+template<class Stream, class Config>
+static void ncsConfig(Stream &s, Config &c)
+{
+#define NCS_FIELD(param_name) \
+    s.field(c.en_##param_name); \
+    s.field(c.param_name);
+    PGE_NPCTXT_FIELDS(NCS_FIELD)
+#undef NCS_FIELD
+    s.str(c.unknownLines);
+}
+
+/*****************Set***************************/
+
+bool NPCConfigSet::scanFolder(const PGESTRING &dirPath, std::vector<FileStamp> &stamps) const
+{
+    stamps.clear();
+    PGESTRINGList files;
+    if(!PGE_FileFormats_misc::listDirectoryFiles(dirPath, files))
+        return false;
+
+    for(const PGESTRING &f : files)
+    {
+        FileStamp st;
+        st.valid = true;
+        if(!ncsFileId(f, st.id))
+            continue;
+        st.fileName = f;
+        if(!PGE_FileFormats_misc::fileSizeAndTime(dirPath + "/" + f, st.size, st.mtime))
+            continue;
+        stamps.push_back(st);
+    }
+
+    // Keep the first file name of each ID, like "npc-1.txt" before "npc-01.txt"
+    std::sort(stamps.begin(), stamps.end(), [](const FileStamp &a, const FileStamp &b)
+    {
+        if(a.id != b.id)
+            return a.id < b.id;
+        if(a.fileName.size() != b.fileName.size())
+            return a.fileName.size() < b.fileName.size();
+        return a.fileName < b.fileName;
+    });
+    stamps.erase(std::unique(stamps.begin(), stamps.end(), [](const FileStamp &a, const FileStamp &b)
+    {
+        return a.id == b.id;
+    }), stamps.end());
+
+    return true;
+}
+
+void NPCConfigSet::buildIndex()
+{
+    m_index.clear();
+    m_merged.clear();
+
+    if(m_stamps.empty())
+        return;
+
+    m_index.resize(m_stamps.back().id + 1, -1);
+    size_t i = 0;
+    for(const FileStamp &st : m_stamps)
+    {
+        if(!st.valid)
+            continue;
+        const unsigned long id = st.id;
+        const NPCConfigFile &c = m_configs[i];
+        m_index[id] = static_cast<long>(i++);
+        for(auto it = c.entries.begin(); it != c.entries.end(); ++it)
+            m_merged[PGEMAPKEY(it)][id] = PGEMAPVAL(it);
+    }
+
+    // Unreadable files at the end don't count into the maximum ID
+    while(!m_index.empty() && m_index.back() < 0)
+        m_index.pop_back();
+}
+
+void NPCConfigSet::clear()
+{
+    m_folder.clear();
+    m_stamps.clear();
+    m_configs.clear();
+    m_index.clear();
+    m_merged.clear();
+    m_fromSnapshot = false;
+}
+
+bool NPCConfigSet::loadFolder(const PGESTRING &dirPath, unsigned int threads)
+{
+    clear();
+
+    std::vector<FileStamp> stamps;
+    if(!scanFolder(dirPath, stamps))
+        return false;
+
+    std::vector<NPCConfigFile> configs(stamps.size());
+
+    if(threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = static_cast<unsigned int>(std::min<size_t>(threads, stamps.size()));
+
+    std::atomic<size_t> next(0);
+    auto worker = [&]()
+    {
+        size_t i;
+        while((i = next.fetch_add(1)) < stamps.size())
+            FileFormats::ReadNpcTXTFileF(dirPath + "/" + stamps[i].fileName, configs[i]);
+    };
+
+    std::vector<std::thread> pool;
+    for(unsigned int t = 1; t < threads; t++)
+        pool.emplace_back(worker);
+    worker();
+    for(std::thread &t : pool)
+        t.join();
+
+    m_folder = dirPath;
+    for(size_t i = 0; i < stamps.size(); i++)
+    {
+        // Stamps of unreadable files are kept to tell when they get changed
+        stamps[i].valid = configs[i].ReadFileValid;
+        if(stamps[i].valid)
+            m_configs.push_back(std::move(configs[i]));
+    }
+    m_stamps = std::move(stamps);
+
+    buildIndex();
+    return true;
+}
+
+bool NPCConfigSet::isUpToDate() const
+{
+    std::vector<FileStamp> stamps;
+    if(!scanFolder(m_folder, stamps))
+        return false;
+
+    if(stamps.size() != m_stamps.size())
+        return false;
+
+    for(size_t i = 0; i < stamps.size(); i++)
+    {
+        const FileStamp &a = stamps[i], &b = m_stamps[i];
+        if(a.id != b.id || a.fileName != b.fileName || a.size != b.size || a.mtime != b.mtime)
+            return false;
+    }
+
+    return true;
+}
+
+bool NPCConfigSet::saveSnapshot(const PGESTRING &snapshotPath) const
+{
+    NPCConfigSnapshotWriter w;
+    w.out.append(s_ncsMagic, sizeof(s_ncsMagic));
+    w.pod(s_ncsVersion);
+    w.pod(s_ncsByteOrder);
+    w.pod(static_cast<uint32_t>(m_stamps.size()));
+
+    size_t i = 0;
+    for(const FileStamp &st : m_stamps)
+    {
+        w.pod(static_cast<uint32_t>(st.id));
+        w.str(st.fileName);
+        w.pod(st.size);
+        w.pod(st.mtime);
+        w.pod(static_cast<uint8_t>(st.valid ? 1 : 0));
+        if(!st.valid)
+            continue;
+        const NPCConfigFile &c = m_configs[i++];
+        ncsConfig(w, c);
+        w.pod(static_cast<uint32_t>(c.entries.size()));
+        for(auto it = c.entries.begin(); it != c.entries.end(); ++it)
+        {
+            w.str(PGEMAPKEY(it));
+            w.str(PGEMAPVAL(it));
+        }
+    }
+
+    return PGE_FileFormats_misc::writeBinaryFile(snapshotPath, w.out);
+}
+
+bool NPCConfigSet::loadSnapshot(const PGESTRING &dirPath, const PGESTRING &snapshotPath)
+{
+    clear();
+
+    std::string data;
+    if(!PGE_FileFormats_misc::readBinaryFile(snapshotPath, data))
+        return false;
+
+    NPCConfigSnapshotReader r(data);
+    char magic[sizeof(s_ncsMagic)];
+    uint32_t version = 0, byteOrder = 0, count = 0;
+    r.raw(magic, sizeof(magic));
+    r.pod(version);
+    r.pod(byteOrder);
+    r.pod(count);
+
+    if(!r.ok() || std::memcmp(magic, s_ncsMagic, sizeof(s_ncsMagic)) != 0 ||
+       version != s_ncsVersion || byteOrder != s_ncsByteOrder)
+        return false;
+
+    std::vector<FileStamp> stamps;
+    std::vector<NPCConfigFile> configs;
+
+    for(uint32_t i = 0; i < count && r.ok(); i++)
+    {
+        FileStamp st;
+        uint32_t id = 0;
+        r.pod(id);
+        st.id = id;
+        r.str(st.fileName);
+        r.pod(st.size);
+        r.pod(st.mtime);
+        uint8_t valid = 0;
+        r.pod(valid);
+        st.valid = (valid != 0);
+
+        // IDs must be valid and unique, in the same order as at the scanned folder
+        if(id == 0 || id > maxNpcId || (!stamps.empty() && stamps.back().id >= id))
+            return false;
+
+        if(!st.valid)
+        {
+            stamps.push_back(std::move(st));
+            continue;
+        }
+
+        NPCConfigFile c;
+        ncsConfig(r, c);
+        uint32_t entries = 0;
+        r.pod(entries);
+        for(uint32_t e = 0; e < entries && r.ok(); e++)
+        {
+            PGESTRING key, value;
+            r.str(key);
+            r.str(value);
+            c.entries[key] = value;
+        }
+        c.ReadFileValid = true;
+
+        stamps.push_back(std::move(st));
+        configs.push_back(std::move(c));
+    }
+
+    if(!r.ok() || !r.atEnd())
+        return false;
+
+    m_folder = dirPath;
+    m_stamps = std::move(stamps);
+    m_configs = std::move(configs);
+    m_fromSnapshot = true;
+    buildIndex();
+    return true;
+}
+
+bool NPCConfigSet::loadFolderCached(const PGESTRING &dirPath, const PGESTRING &snapshotPath, unsigned int threads)
+{
+    if(loadSnapshot(dirPath, snapshotPath) && isUpToDate())
+        return true;
+
+    if(!loadFolder(dirPath, threads))
+        return false;
+
+    saveSnapshot(snapshotPath);
+    return true;
+}
@@ -0,0 +1,180 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*!
+ * \file npc_config_set.h
+ * \brief Contains the set of NPC.txt configurations of one folder
+ */
+
+#pragma once
+#ifndef NPC_CONFIG_SET_H
+#define NPC_CONFIG_SET_H
+
+#include "pge_file_lib_globs.h"
+#include "npc_filedata.h"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/*!
+ * \brief NPC configurations of the episode folder or of the level custom folder
+ *
+ * All npc-<ID>.txt files of the folder are parsed at once, in parallel, and
+ * are stored into the table indexed by NPC ID, so the engine doesn't need to
+ * open any of them during the gameplay.
+ *
+ * The whole set can be saved into the binary snapshot, which gets loaded
+ * instead of parsing while none of files was changed, added or removed.
+ * The snapshot uses the native byte order and is rejected on the machine
+ * with a different byte order: it's a cache, not an interchange format.
+ */
+class NPCConfigSet
+{
+public:
+    //! Custom entries of all configurations: entry name, then NPC ID and value
+    typedef PGEMAP<PGESTRING, PGEMAP<unsigned long, PGESTRING> > MergedEntries;
+
+    //! Configurations of NPC IDs above this are ignored
+    static const unsigned long maxNpcId = 1000000;
+
+    NPCConfigSet() = default;
+
+    /*!
+     * \brief Parses all npc-*.txt files of the folder
+     * \param [__in] dirPath Path to the folder
+     * \param [__in] threads Number of parsing threads, 0 to use all hardware threads
+     * \return true if folder was read, even if there are no configs
+     */
+    bool loadFolder(const PGESTRING &dirPath, unsigned int threads = 0);
+
+    /*!
+     * \brief Loads the folder through the snapshot file
+     * \param [__in] dirPath Path to the folder
+     * \param [__in] snapshotPath Path to the snapshot file
+     * \param [__in] threads Number of parsing threads, 0 to use all hardware threads
+     * \return true if folder was read, even if there are no configs
+     *
+     * The snapshot gets used when it was made from the same set of files
+     * with the same sizes and modification times. Otherwise the folder is parsed
+     * and the snapshot is rewritten.
+     */
+    bool loadFolderCached(const PGESTRING &dirPath, const PGESTRING &snapshotPath, unsigned int threads = 0);
+
+    /*!
+     * \brief Saves the loaded set into the snapshot file
+     * \param [__in] snapshotPath Path to the snapshot file
+     * \return true if file was written
+     */
+    bool saveSnapshot(const PGESTRING &snapshotPath) const;
+
+    /*!
+     * \brief Loads the set from the snapshot file without any checks of the folder
+     * \param [__in] dirPath Path to the folder the snapshot was made from
+     * \param [__in] snapshotPath Path to the snapshot file
+     * \return true if snapshot is valid, otherwise the set is left empty
+     */
+    bool loadSnapshot(const PGESTRING &dirPath, const PGESTRING &snapshotPath);
+
+    /*!
+     * \brief Checks that files of the folder weren't changed since the set was loaded
+     * \return true if the same set of files has the same sizes and modification times
+     */
+    bool isUpToDate() const;
+
+    /*!
+     * \brief Drops all loaded configurations
+     */
+    void clear();
+
+    /*!
+     * \brief Configuration of the NPC
+     * \param id NPC ID
+     * \return Pointer to the configuration or null if there is no config for this NPC
+     */
+    const NPCConfigFile *get(unsigned long id) const
+    {
+        if(id >= m_index.size() || m_index[id] < 0)
+            return nullptr;
+        return &m_configs[static_cast<size_t>(m_index[id])];
+    }
+
+    //! Number of loaded configurations
+    size_t size() const
+    {
+        return m_configs.size();
+    }
+
+    //! Biggest NPC ID which has a configuration, or 0 if set is empty
+    unsigned long maxId() const
+    {
+        return m_index.empty() ? 0 : static_cast<unsigned long>(m_index.size() - 1);
+    }
+
+    //! Custom entries of all loaded configurations
+    const MergedEntries &mergedEntries() const
+    {
+        return m_merged;
+    }
+
+    //! Folder the set was loaded from
+    const PGESTRING &folder() const
+    {
+        return m_folder;
+    }
+
+    //! Was the set taken from the snapshot by the recent load
+    bool loadedFromSnapshot() const
+    {
+        return m_fromSnapshot;
+    }
+
+private:
+    //! Identity of the config file
+    struct FileStamp
+    {
+        unsigned long id;
+        PGESTRING fileName;
+        int64_t size;
+        int64_t mtime;
+        //! File was parsed, unreadable files have no configuration
+        bool valid;
+    };
+
+    bool scanFolder(const PGESTRING &dirPath, std::vector<FileStamp> &stamps) const;
+    void buildIndex();
+
+    PGESTRING m_folder;
+    //! Stamps of all files, configurations of valid ones follow in the same order
+    std::vector<FileStamp> m_stamps;
+    std::vector<NPCConfigFile> m_configs;
+    //! NPC ID to index of configuration, -1 if none
+    std::vector<long> m_index;
+    MergedEntries m_merged;
+    bool m_fromSnapshot = false;
+};
+
+#endif // NPC_CONFIG_SET_H
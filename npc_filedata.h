@@ -35,6 +35,54 @@
 
 #include "pge_file_lib_globs.h"
 
+/*!
+ * \brief Calls X(name) for every known field of NPC.txt
+ *
+ * Each field has the value member "name" and the "en_name" flag of presence
+ * at the NPCConfigFile structure.
+ */
+#define PGE_NPCTXT_FIELDS(X) \
+    X(gfxoffsetx) \
+    X(gfxoffsety) \
+    X(width) \
+    X(height) \
+    X(gfxwidth) \
+    X(gfxheight) \
+    X(score) \
+    X(health) \
+    X(playerblock) \
+    X(playerblocktop) \
+    X(npcblock) \
+    X(npcblocktop) \
+    X(grabside) \
+    X(grabtop) \
+    X(jumphurt) \
+    X(nohurt) \
+    X(noblockcollision) \
+    X(cliffturn) \
+    X(noyoshi) \
+    X(foreground) \
+    X(speed) \
+    X(nofireball) \
+    X(nogravity) \
+    X(frames) \
+    X(framespeed) \
+    X(framestyle) \
+    X(noiceball) \
+    X(nohammer) \
+    X(noshell) \
+    X(name) \
+    X(description) \
+    X(image) \
+    X(icon) \
+    X(script) \
+    X(group) \
+    X(category) \
+    X(grid) \
+    X(gridoffsetx) \
+    X(gridoffsety) \
+    X(gridalign)
+
 /*!
  * \brief SMBX64-NPC.txt File Data structure
  */
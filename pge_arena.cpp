@@ -0,0 +1,150 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "pge_arena.h"
+
+#include <cstdint>
+#include <cstdlib>
+
+static thread_local PGE_Arena *s_currentArena = nullptr;
+
+PGE_Arena::PGE_Arena(size_t blockSize) :
+    m_blockSize(blockSize > 0 ? blockSize : 1)
+{}
+
+PGE_Arena::~PGE_Arena()
+{
+    release();
+}
+
+void PGE_Arena::addBlock(size_t minSize)
+{
+    // Try to reuse blocks kept by rewind()
+    while(m_active + 1 < m_blocks.size())
+    {
+        m_active++;
+        if(m_blocks[m_active].size >= minSize)
+        {
+            m_offset = 0;
+            return;
+        }
+    }
+
+    Block b;
+    b.size = minSize > m_blockSize ? minSize : m_blockSize;
+    b.data = static_cast<char *>(std::malloc(b.size));
+    if(!b.data)
+        throw std::bad_alloc();
+
+    m_blocks.push_back(b);
+    m_active = m_blocks.size() - 1;
+    m_offset = 0;
+}
+
+void *PGE_Arena::allocate(size_t size, size_t align)
+{
+    if(size == 0)
+        size = 1;
+
+    size_t offset = 0;
+    bool fits = false;
+    if(!m_blocks.empty())
+    {
+        const Block &b = m_blocks[m_active];
+        uintptr_t base = reinterpret_cast<uintptr_t>(b.data);
+        offset = ((base + m_offset + align - 1) & ~static_cast<uintptr_t>(align - 1)) - base;
+        fits = offset + size <= b.size;
+    }
+
+    if(!fits)
+    {
+        // Blocks are taken by malloc() and therefore aligned for any fundamental type
+        addBlock(size + align);
+        offset = 0;
+    }
+
+    char *p = m_blocks[m_active].data + offset;
+    m_offset = offset + size;
+    m_last = p;
+    m_used += size;
+    m_allocations++;
+    return p;
+}
+
+void PGE_Arena::deallocate(void *p, size_t size) noexcept
+{
+    if(size == 0)
+        size = 1;
+
+    // Roll back the most recent allocation, the rest is freed by release()
+    if(p && p == m_last && m_last + size == m_blocks[m_active].data + m_offset)
+    {
+        m_offset -= size;
+        m_used -= size;
+        m_last = nullptr;
+    }
+}
+
+void PGE_Arena::release() noexcept
+{
+    for(Block &b : m_blocks)
+        std::free(b.data);
+    m_blocks.clear();
+    m_active = 0;
+    m_offset = 0;
+    m_last = nullptr;
+    m_used = 0;
+    m_allocations = 0;
+}
+
+void PGE_Arena::rewind() noexcept
+{
+    m_active = 0;
+    m_offset = 0;
+    m_last = nullptr;
+    m_used = 0;
+    m_allocations = 0;
+}
+
+size_t PGE_Arena::bytesReserved() const
+{
+    size_t total = 0;
+    for(const Block &b : m_blocks)
+        total += b.size;
+    return total;
+}
+
+PGE_Arena *PGE_Arena::current()
+{
+    return s_currentArena;
+}
+
+PGE_Arena *PGE_Arena::setCurrent(PGE_Arena *arena)
+{
+    PGE_Arena *previous = s_currentArena;
+    s_currentArena = arena;
+    return previous;
+}
@@ -0,0 +1,234 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*!
+ * \file pge_arena.h
+ * \brief Contains the monotonic memory arena and the allocator for element lists
+ */
+
+#pragma once
+#ifndef PGE_ARENA_H
+#define PGE_ARENA_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/*!
+ * \brief Monotonic memory arena
+ *
+ * Memory is taken from big blocks by moving the pointer, individual
+ * deallocations are ignored except of the most recent allocation which gets
+ * rolled back (that makes growing of the last list cheap). All memory is
+ * returned in one shot by release() or by the destructor. The arena is not
+ * thread-safe, one arena must be used by one loading thread at a time.
+ *
+ * Only the top-level element lists of loaded files are kept in the arena,
+ * strings and lists nested into elements are taken from the heap.
+ */
+class PGE_Arena
+{
+public:
+    /*!
+     * \brief Constructor
+     * \param blockSize Size of every memory block taken from the heap
+     */
+    explicit PGE_Arena(size_t blockSize = 64 * 1024);
+    ~PGE_Arena();
+
+    PGE_Arena(const PGE_Arena &) = delete;
+    PGE_Arena &operator=(const PGE_Arena &) = delete;
+
+    /*!
+     * \brief Takes the memory from the arena
+     * \param size Number of bytes
+     * \param align Alignment of the memory
+     * \return Pointer to the memory, never null (throws std::bad_alloc on failure)
+     */
+    void *allocate(size_t size, size_t align);
+    /*!
+     * \brief Returns the memory back, only the most recent allocation is actually reused
+     * \param p Pointer given by allocate()
+     * \param size Number of bytes given to allocate()
+     */
+    void deallocate(void *p, size_t size) noexcept;
+
+    /*!
+     * \brief Frees all blocks, everything allocated from the arena becomes invalid
+     */
+    void release() noexcept;
+    /*!
+     * \brief Rewinds the arena to keep its blocks for the next use, everything allocated becomes invalid
+     */
+    void rewind() noexcept;
+
+    //! Number of bytes given by allocate() since the last release() or rewind()
+    size_t bytesUsed() const
+    {
+        return m_used;
+    }
+    //! Number of bytes taken from the heap
+    size_t bytesReserved() const;
+    //! Number of allocate() calls since the last release() or rewind()
+    size_t allocationsCount() const
+    {
+        return m_allocations;
+    }
+
+    /*!
+     * \brief Arena used by default-constructed allocators of the calling thread
+     * \return Current arena or null when the heap is used
+     */
+    static PGE_Arena *current();
+    /*!
+     * \brief Sets the arena for default-constructed allocators of the calling thread
+     * \param arena Arena or null to use the heap
+     * \return Previous arena
+     */
+    static PGE_Arena *setCurrent(PGE_Arena *arena);
+
+private:
+    struct Block
+    {
+        char  *data;
+        size_t size;
+    };
+
+    void addBlock(size_t minSize);
+
+    //! Allocated blocks, the last one is active
+    std::vector<Block> m_blocks;
+    //! Index of the active block
+    size_t m_active = 0;
+    //! Offset of the free memory in the active block
+    size_t m_offset = 0;
+    //! Pointer to the most recent allocation
+    char  *m_last = nullptr;
+    //! Default size of the block
+    size_t m_blockSize;
+    size_t m_used = 0;
+    size_t m_allocations = 0;
+};
+
+/*!
+ * \brief Makes the arena current for the calling thread during the lifetime of the object
+ */
+class PGE_ArenaScope
+{
+public:
+    explicit PGE_ArenaScope(PGE_Arena *arena) :
+        m_previous(PGE_Arena::setCurrent(arena))
+    {}
+    ~PGE_ArenaScope()
+    {
+        PGE_Arena::setCurrent(m_previous);
+    }
+
+    PGE_ArenaScope(const PGE_ArenaScope &) = delete;
+    PGE_ArenaScope &operator=(const PGE_ArenaScope &) = delete;
+
+private:
+    PGE_Arena *m_previous;
+};
+
+/*!
+ * \brief Allocator which takes the memory from the arena
+ *
+ * Default-constructed allocator binds to the current arena of the thread
+ * (PGE_Arena::current()) or to the heap when there is no current arena.
+ * Copies of containers are bound to the arena that is current at the moment
+ * of copying, moved containers keep their memory and arena.
+ */
+template<class T>
+class PGE_ArenaAllocator
+{
+    template<class U> friend class PGE_ArenaAllocator;
+public:
+    typedef T value_type;
+    typedef std::false_type propagate_on_container_copy_assignment;
+    typedef std::true_type  propagate_on_container_move_assignment;
+    typedef std::true_type  propagate_on_container_swap;
+
+    PGE_ArenaAllocator() noexcept :
+        m_arena(PGE_Arena::current())
+    {}
+    explicit PGE_ArenaAllocator(PGE_Arena *arena) noexcept :
+        m_arena(arena)
+    {}
+    template<class U>
+    PGE_ArenaAllocator(const PGE_ArenaAllocator<U> &o) noexcept :
+        m_arena(o.m_arena)
+    {}
+
+    T *allocate(size_t n)
+    {
+        if(m_arena)
+            return static_cast<T *>(m_arena->allocate(n * sizeof(T), alignof(T)));
+        return static_cast<T *>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, size_t n) noexcept
+    {
+        if(m_arena)
+            m_arena->deallocate(p, n * sizeof(T));
+        else
+            ::operator delete(p);
+    }
+
+    PGE_ArenaAllocator select_on_container_copy_construction() const
+    {
+        return PGE_ArenaAllocator();
+    }
+
+    //! Arena of this allocator, null for the heap
+    PGE_Arena *arena() const
+    {
+        return m_arena;
+    }
+
+    template<class U>
+    bool operator==(const PGE_ArenaAllocator<U> &o) const
+    {
+        return m_arena == o.m_arena;
+    }
+    template<class U>
+    bool operator!=(const PGE_ArenaAllocator<U> &o) const
+    {
+        return m_arena != o.m_arena;
+    }
+
+private:
+    PGE_Arena *m_arena;
+};
+
+/*!
+ * \brief List which takes the memory from the arena, PGELIST in the arena mode (PGE_FILES_ARENA)
+ */
+template<class T>
+using PGE_ArenaList = std::vector<T, PGE_ArenaAllocator<T> >;
+
+#endif // PGE_ARENA_H
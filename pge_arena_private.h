@@ -0,0 +1,129 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Keeps readers away from the arena while they fill element lists
+ */
+
+#pragma once
+#ifndef PGE_ARENA_PRIVATE_H
+#define PGE_ARENA_PRIVATE_H
+
+#include "lvl_filedata.h"
+#include "wld_filedata.h"
+
+#ifdef PGE_FILES_ARENA
+
+#include "pge_arena.h"
+#include <iterator>
+
+/*
+ * Readers grow lists one element at a time and build temporary data, while
+ * the arena reuses the most recent allocation only: every buffer left behind
+ * by the growth would stay in the arena until its release. During the
+ * lifetime of this object readers work on the heap, and commit() moves
+ * finished lists into the arena of the caller with their exact sizes.
+ * Lists nested into elements stay on the heap.
+ */
+class PGE_ArenaStaging
+{
+public:
+    explicit PGE_ArenaStaging(LevelData &data) :
+        m_arena(PGE_Arena::setCurrent(nullptr))
+    {
+#define PGE_ARENA_STAGE(T, name) stage(data.name);
+        PGE_LEVEL_COLLECTIONS(PGE_ARENA_STAGE)
+    }
+
+    explicit PGE_ArenaStaging(WorldData &data) :
+        m_arena(PGE_Arena::setCurrent(nullptr))
+    {
+        PGE_WORLD_COLLECTIONS(PGE_ARENA_STAGE)
+#undef PGE_ARENA_STAGE
+    }
+
+    ~PGE_ArenaStaging()
+    {
+        PGE_Arena::setCurrent(m_arena);
+    }
+
+    PGE_ArenaStaging(const PGE_ArenaStaging &) = delete;
+    PGE_ArenaStaging &operator=(const PGE_ArenaStaging &) = delete;
+
+    //! Moves element lists of the successfully read level into the arena
+    void commit(LevelData &data) const
+    {
+#define PGE_ARENA_COMMIT(T, name) commit(data.name);
+        PGE_LEVEL_COLLECTIONS(PGE_ARENA_COMMIT)
+    }
+
+    //! Moves element lists of the successfully read world map into the arena
+    void commit(WorldData &data) const
+    {
+        PGE_WORLD_COLLECTIONS(PGE_ARENA_COMMIT)
+#undef PGE_ARENA_COMMIT
+    }
+
+private:
+    template<class T>
+    static void stage(PGE_ArenaList<T> &list)
+    {
+        list = PGE_ArenaList<T>(PGE_ArenaAllocator<T>(nullptr));
+    }
+
+    template<class T>
+    void commit(PGE_ArenaList<T> &list) const
+    {
+        if(!m_arena || list.empty())
+            return;
+        PGE_ArenaList<T> exact{PGE_ArenaAllocator<T>(m_arena)};
+        exact.reserve(list.size());
+        exact.insert(exact.end(), std::make_move_iterator(list.begin()), std::make_move_iterator(list.end()));
+        list = std::move(exact);
+    }
+
+    //! Arena of the caller
+    PGE_Arena *m_arena;
+};
+
+#else // PGE_FILES_ARENA
+
+class PGE_ArenaStaging
+{
+public:
+    explicit PGE_ArenaStaging(LevelData &)
+    {}
+    explicit PGE_ArenaStaging(WorldData &)
+    {}
+    void commit(LevelData &) const
+    {}
+    void commit(WorldData &) const
+    {}
+};
+
+#endif // PGE_FILES_ARENA
+
+#endif // PGE_ARENA_PRIVATE_H
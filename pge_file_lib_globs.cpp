@@ -43,8 +43,15 @@
  */
 #define PATH_MAX 2048
 #endif
+#   ifndef _WIN32
+#   include <sys/types.h>
+#   include <sys/stat.h>
+#   include <dirent.h>
+#   endif
 #else
 #include <QFileInfo>
+#include <QDateTime>
+#include <QDir>
 #endif
 #include <memory>
 
@@ -484,6 +491,119 @@ std::string base64_decode(std::string const &encoded_string)
     return ret;
 }
 
+bool readBinaryFile(const PGESTRING &filePath, std::string &out)
+{
+    out.clear();
+#ifdef PGE_FILES_QT
+    QFile f(filePath);
+    if(!f.open(QIODevice::ReadOnly))
+        return false;
+    QByteArray data = f.readAll();
+    out.assign(data.constData(), static_cast<size_t>(data.size()));
+    return true;
+#else
+    FILE *f = utf8_fopen(filePath.c_str(), "rb");
+    if(!f)
+        return false;
+
+    char buf[16384];
+    size_t got;
+    while((got = fread(buf, 1, sizeof(buf), f)) > 0)
+        out.append(buf, got);
+
+    bool ok = (ferror(f) == 0);
+    fclose(f);
+    return ok;
+#endif
+}
+
+bool writeBinaryFile(const PGESTRING &filePath, const std::string &data)
+{
+#ifdef PGE_FILES_QT
+    QFile f(filePath);
+    if(!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    return f.write(data.data(), static_cast<qint64>(data.size())) == static_cast<qint64>(data.size());
+#else
+    FILE *f = utf8_fopen(filePath.c_str(), "wb");
+    if(!f)
+        return false;
+
+    bool ok = (fwrite(data.data(), 1, data.size(), f) == data.size());
+    ok &= (fclose(f) == 0);
+    return ok;
+#endif
+}
+
+bool fileSizeAndTime(const PGESTRING &filePath, int64_t &size, int64_t &mtime)
+{
+#ifdef PGE_FILES_QT
+    QFileInfo info(filePath);
+    if(!info.exists() || !info.isFile())
+        return false;
+    size = static_cast<int64_t>(info.size());
+    mtime = static_cast<int64_t>(info.lastModified().toMSecsSinceEpoch());
+#elif defined(_WIN32)
+    WIN32_FILE_ATTRIBUTE_DATA attr;
+    if(!GetFileAttributesExW(Str2WStr(filePath).c_str(), GetFileExInfoStandard, &attr))
+        return false;
+    if(attr.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        return false;
+    size = (static_cast<int64_t>(attr.nFileSizeHigh) << 32) | attr.nFileSizeLow;
+    mtime = (static_cast<int64_t>(attr.ftLastWriteTime.dwHighDateTime) << 32) | attr.ftLastWriteTime.dwLowDateTime;
+#else
+    struct stat st;
+    if(stat(filePath.c_str(), &st) != 0)
+        return false;
+    if(!S_ISREG(st.st_mode))
+        return false;
+    size = static_cast<int64_t>(st.st_size);
+#   if defined(__linux__)
+    mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#   else
+    mtime = static_cast<int64_t>(st.st_mtime);
+#   endif
+#endif
+    return true;
+}
+
+bool listDirectoryFiles(const PGESTRING &dirPath, PGESTRINGList &out)
+{
+    out.clear();
+#ifdef PGE_FILES_QT
+    QDir dir(dirPath);
+    if(!dir.exists())
+        return false;
+    out = dir.entryList(QDir::Files | QDir::Hidden | QDir::System);
+#elif defined(_WIN32)
+    WIN32_FIND_DATAW data;
+    HANDLE h = FindFirstFileW(Str2WStr(dirPath + "/*").c_str(), &data);
+    if(h == INVALID_HANDLE_VALUE)
+        return false;
+    do
+    {
+        if(!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+            out.push_back(WStr2Str(data.cFileName));
+    }
+    while(FindNextFileW(h, &data));
+    FindClose(h);
+#else
+    DIR *dir = opendir(dirPath.c_str());
+    if(!dir)
+        return false;
+    struct dirent *e;
+    while((e = readdir(dir)) != nullptr)
+    {
+        std::string path = dirPath + "/" + e->d_name;
+        struct stat st;
+        if(stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode))
+            out.push_back(e->d_name);
+    }
+    closedir(dir);
+#endif
+    return true;
+}
+
 bool TextFileInput::exists(PGESTRING filePath)
 {
 #ifdef PGE_FILES_QT
@@ -779,27 +899,30 @@ void RawTextOutput::close()
 int RawTextOutput::write(PGESTRING buffer)
 {
     if(!m_data) return -1;
-    int64_t written = 0;
-fillEnd:
-    if(m_pos >= static_cast<int64_t>(m_data->size()))
+    const int64_t size = static_cast<int64_t>(m_data->size());
+    const int64_t length = static_cast<int64_t>(buffer.size());
+
+    if(m_pos >= size)
     {
-        int64_t oldSize = static_cast<int64_t>(m_data->size());
         m_data->append(buffer);
         m_pos = static_cast<int64_t>(m_data->size());
-        written += (static_cast<int64_t>(m_data->size()) - oldSize);
-    }
-    else
-    {
-        while((m_pos < static_cast<int64_t>(m_data->size())) && (!IsEmpty(buffer)))
-        {
-            m_data[m_pos++] = buffer[0];
-            written++;
-            PGE_RemStrRng(buffer, 0, 1);
-        }
-        if(!IsEmpty(buffer))
-            goto fillEnd;
+        return static_cast<int>(m_pos - size);
     }
-    return static_cast<int>(written);
+
+    // Overwrite the tail of data, then append the rest of buffer
+    const int64_t overwrite = std::min<int64_t>(length, size - m_pos);
+#ifdef PGE_FILES_QT
+    m_data->replace(static_cast<int>(m_pos), static_cast<int>(overwrite), buffer.left(static_cast<int>(overwrite)));
+    if(overwrite < length)
+        m_data->append(buffer.mid(static_cast<int>(overwrite)));
+#else
+    m_data->replace(static_cast<size_t>(m_pos), static_cast<size_t>(overwrite),
+                    buffer, 0, static_cast<size_t>(overwrite));
+    if(overwrite < length)
+        m_data->append(buffer, static_cast<size_t>(overwrite), std::string::npos);
+#endif
+    m_pos += length;
+    return static_cast<int>(length);
 }
 
 int64_t RawTextOutput::tell()
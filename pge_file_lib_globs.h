@@ -55,7 +55,8 @@
 
 /*! \def PGELIST
     \brief A macro which equal to std::vector if PGE File Library built in the STL mode
-           and equal to QList if PGE File Library built in the Qt mode
+           and equal to QList if PGE File Library built in the Qt mode. When STL mode is
+           built with PGE_FILES_ARENA, lists take the memory from the current PGE_Arena
 */
 
 /*! \def PGEVECTOR
@@ -63,7 +64,13 @@
            and equal to QVector if PGE File Library built in the Qt mode
 */
 
+/*! \def PGEHASH
+    \brief A macro which equal to std::unordered_map if PGE File Library built in the STL mode
+           and equal to QHash if PGE File Library built in the Qt mode
+*/
+
 #include <cstdint>
+#include <string>
 
 #ifdef PGE_FILES_QT
 #include <QString>
@@ -73,6 +80,7 @@
 #include <QPair>
 #include <QFile>
 #include <QMap>
+#include <QHash>
 #include <QTextStream>
 
 #define PGE_FILES_INHERED : public QObject
@@ -84,6 +92,7 @@ typedef QChar   PGEChar;
 #define PGEVECTOR QVector
 #define PGEPAIR QPair
 #define PGEMAP QMap
+#define PGEHASH QHash
 #define PGEMAPKEY(it) (it.key())
 #define PGEMAPVAL(it) (it.value())
 
@@ -94,16 +103,23 @@ typedef QChar   PGEChar;
 #include <cstdio>
 #include <utility>
 #include <map>
+#include <unordered_map>
 
 #define PGE_FILES_INHERED
 
 typedef std::string                 PGESTRING;
 typedef std::vector<std::string>    PGESTRINGList;
 typedef char PGEChar;
+#ifdef PGE_FILES_ARENA
+#include "pge_arena.h"
+#define PGELIST PGE_ArenaList
+#else
 #define PGELIST std::vector
+#endif
 #define PGEVECTOR std::vector
 #define PGEPAIR std::pair
 #define PGEMAP std::map
+#define PGEHASH std::unordered_map
 #define PGEMAPKEY(it) (it->first)
 #define PGEMAPVAL(it) (it->second)
 
@@ -121,6 +137,39 @@ namespace PGE_FileFormats_misc
  */
 bool PGE_DetectSMBXFile(PGESTRING src);
 
+/*!
+ * \brief Reads the whole file as binary data
+ * @param filePath Path to the file
+ * @param out Output buffer
+ * @return true if file was successfully read
+ */
+bool readBinaryFile(const PGESTRING &filePath, std::string &out);
+
+/*!
+ * \brief Writes binary data into the file, replacing the old content
+ * @param filePath Path to the file
+ * @param data Data to write
+ * @return true if data was successfully written
+ */
+bool writeBinaryFile(const PGESTRING &filePath, const std::string &data);
+
+/*!
+ * \brief Reads size and modification time of the file
+ * @param filePath Path to the file
+ * @param size Size of the file in bytes
+ * @param mtime Modification time of the file in the platform-specific units
+ * @return true if path points to the existing regular file
+ */
+bool fileSizeAndTime(const PGESTRING &filePath, int64_t &size, int64_t &mtime);
+
+/*!
+ * \brief Lists names of regular files in the directory
+ * @param dirPath Path to the directory
+ * @param out Names of files, without the directory path, in unspecified order
+ * @return true if directory was successfully read
+ */
+bool listDirectoryFiles(const PGESTRING &dirPath, PGESTRINGList &out);
+
 /*!
  * \brief Provides cross-platform file path calculation for a file names or paths
  */
@@ -5,9 +5,13 @@ set(PGE_FILE_LIBRARY_SRCS)
 
 list(APPEND PGE_FILE_LIBRARY_SRCS
     ${CMAKE_CURRENT_LIST_DIR}/ConvertUTF_PGEFF.c
+    ${CMAKE_CURRENT_LIST_DIR}/compiled_level.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/episode_graph.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/file_cache.cpp
     ${CMAKE_CURRENT_LIST_DIR}/file_formats.cpp
     ${CMAKE_CURRENT_LIST_DIR}/file_rw_lvl.cpp
     ${CMAKE_CURRENT_LIST_DIR}/file_rw_lvl_38a.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/file_rw_lvl_bin.cpp
     ${CMAKE_CURRENT_LIST_DIR}/file_rw_lvlx.cpp
     ${CMAKE_CURRENT_LIST_DIR}/file_rw_meta.cpp
     ${CMAKE_CURRENT_LIST_DIR}/file_rw_npc_txt.cpp
@@ -17,14 +21,25 @@ list(APPEND PGE_FILE_LIBRARY_SRCS
     ${CMAKE_CURRENT_LIST_DIR}/file_rw_smbx64_cnf.cpp
     ${CMAKE_CURRENT_LIST_DIR}/file_rwopen.cpp
     ${CMAKE_CURRENT_LIST_DIR}/file_strlist.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/level_layer_index.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/level_snapshot.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/level_soa.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/level_spatial_index.cpp
     ${CMAKE_CURRENT_LIST_DIR}/lvl_filedata.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/npc_config_set.cpp
     ${CMAKE_CURRENT_LIST_DIR}/npc_filedata.cpp
     ${CMAKE_CURRENT_LIST_DIR}/pge_x.cpp
     ${CMAKE_CURRENT_LIST_DIR}/save_filedata.cpp
     ${CMAKE_CURRENT_LIST_DIR}/smbx64.cpp
     ${CMAKE_CURRENT_LIST_DIR}/smbx64_cnf_filedata.cpp
     ${CMAKE_CURRENT_LIST_DIR}/wld_filedata.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/world_spatial_index.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/world_path_graph.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/pge_arena.cpp
     ${CMAKE_CURRENT_LIST_DIR}/pge_file_lib_globs.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/pge_memory_usage.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/pge_parse_stats.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/pge_string_pool.cpp
     ${CMAKE_CURRENT_LIST_DIR}/file_rw_savx.cpp
 #    ${CMAKE_CURRENT_LIST_DIR}/file_rw_lvl_38a_old.cpp
     ${CMAKE_CURRENT_LIST_DIR}/file_rw_wld_38a.cpp
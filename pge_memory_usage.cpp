@@ -0,0 +1,608 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "pge_memory_usage.h"
+#include "pge_string_pool.h"
+#include "pge_file_lib_private.h"
+
+#include <cstring>
+#include <type_traits>
+
+namespace
+{
+
+//! Bytes gathered for one collection
+struct Acc
+{
+    size_t elements = 0;
+    size_t strings = 0;
+};
+
+//! Estimated overhead of the node of a tree map or of a hash
+static const size_t c_mapNodeOverhead = 4 * sizeof(void *);
+
+template<class T>
+inline void count(Acc &, const T &)
+{
+    static_assert(std::is_trivially_destructible<T>::value,
+                  "Type owns heap memory, add the count() overload for it");
+}
+
+inline void count(Acc &a, const PGESTRING &s)
+{
+    a.strings += PGE_StringPool::heapBytes(s);
+}
+
+inline void count(Acc &a, const starOnLevel &s)
+{
+    count(a, s.first);
+}
+
+template<class List>
+inline size_t listStorage(const List &l)
+{
+    typedef typename List::value_type T;
+#ifdef PGE_FILES_QT
+    // QList keeps pointers, big and non-movable types are allocated separately
+    size_t out = static_cast<size_t>(l.size()) * sizeof(void *);
+    if(QTypeInfo<T>::isLarge || QTypeInfo<T>::isStatic)
+        out += static_cast<size_t>(l.size()) * sizeof(T);
+    return out;
+#else
+    return l.capacity() * sizeof(T);
+#endif
+}
+
+template<class List>
+inline void nested(Acc &a, const List &l)
+{
+    a.elements += listStorage(l);
+    for(const auto &e : l)
+        count(a, e);
+}
+
+template<class Map>
+inline void map(Acc &a, const Map &m)
+{
+    a.elements += static_cast<size_t>(m.size()) * (c_mapNodeOverhead + sizeof(typename Map::key_type) + sizeof(typename Map::mapped_type));
+    for(auto it = m.begin(); it != m.end(); ++it)
+    {
+        count(a, PGEMAPKEY(it));
+        count(a, PGEMAPVAL(it));
+    }
+}
+
+template<class Hash>
+inline void hash(Acc &a, const Hash &h)
+{
+    map(a, h);
+#ifdef PGE_FILES_QT
+    a.elements += static_cast<size_t>(h.capacity()) * sizeof(void *);
+#else
+    a.elements += h.bucket_count() * sizeof(void *);
+#endif
+}
+
+inline void count(Acc &a, const ElementArrayIdMap &m)
+{
+    a.elements += m.size() * (c_mapNodeOverhead + sizeof(unsigned int) + sizeof(long)) +
+                  m.bucketsCount() * sizeof(void *);
+}
+
+inline void count(Acc &a, const ElementMeta &m)
+{
+    count(a, m.custom_params);
+}
+
+inline void count(Acc &a, const FileFormatMeta &m)
+{
+    count(a, m.ERROR_info);
+    count(a, m.ERROR_linedata);
+    count(a, m.filename);
+    count(a, m.path);
+    count(a, m.configPackId);
+}
+
+inline void count(Acc &a, const Bookmark &b)
+{
+    count(a, b.bookmarkName);
+}
+
+inline void count(Acc &a, const MetaData &m)
+{
+    nested(a, m.bookmarks);
+    count(a, m.crash.fullPath);
+    count(a, m.crash.path);
+    count(a, m.crash.filename);
+    count(a, m.meta);
+}
+
+/*****************Level***************************/
+
+inline void count(Acc &a, const LevelData::MusicOverrider &m)
+{
+    count(a, m.fileName);
+}
+
+inline void count(Acc &a, const LevelSection &s)
+{
+    count(a, s.music_file);
+    count(a, s.custom_params);
+}
+
+inline void count(Acc &a, const LevelBlock &b)
+{
+    count(a, b.layer);
+    count(a, b.gfx_name);
+    count(a, b.event_destroy);
+    count(a, b.event_hit);
+    count(a, b.event_emptylayer);
+    count(a, b.event_on_screen);
+    count(a, b.meta);
+}
+
+inline void count(Acc &a, const LevelBGO &b)
+{
+    count(a, b.layer);
+    count(a, b.meta);
+}
+
+inline void count(Acc &a, const LevelNPC &n)
+{
+    count(a, n.gfx_name);
+    count(a, n.msg);
+    count(a, n.layer);
+    count(a, n.event_activate);
+    count(a, n.event_die);
+    count(a, n.event_talk);
+    count(a, n.event_emptylayer);
+    count(a, n.event_grab);
+    count(a, n.event_nextframe);
+    count(a, n.event_touch);
+    count(a, n.attach_layer);
+    count(a, n.send_id_to_variable);
+    count(a, n.meta);
+}
+
+inline void count(Acc &a, const LevelDoor &d)
+{
+    count(a, d.lname);
+    count(a, d.stars_msg);
+    count(a, d.layer);
+    count(a, d.event_enter);
+    count(a, d.meta);
+}
+
+inline void count(Acc &a, const LevelPhysEnv &p)
+{
+    count(a, p.layer);
+    count(a, p.touch_event);
+    count(a, p.meta);
+}
+
+inline void count(Acc &a, const LevelLayer &l)
+{
+    count(a, l.name);
+    count(a, l.meta);
+}
+
+inline void count(Acc &a, const LevelEvent_Sets &s)
+{
+    count(a, s.music_file);
+    count(a, s.expression_pos_x);
+    count(a, s.expression_pos_y);
+    count(a, s.expression_pos_w);
+    count(a, s.expression_pos_h);
+    nested(a, s.autoscroll_path);
+    count(a, s.expression_autoscrool_x);
+    count(a, s.expression_autoscrool_y);
+}
+
+inline void count(Acc &a, const LevelEvent_MoveLayer &m)
+{
+    count(a, m.name);
+    count(a, m.expression_x);
+    count(a, m.expression_y);
+}
+
+inline void count(Acc &a, const LevelEvent_SpawnEffect &e)
+{
+    count(a, e.expression_x);
+    count(a, e.expression_y);
+    count(a, e.expression_sx);
+    count(a, e.expression_sy);
+}
+
+inline void count(Acc &a, const LevelEvent_SpawnNPC &n)
+{
+    count(a, n.expression_x);
+    count(a, n.expression_y);
+    count(a, n.expression_sx);
+    count(a, n.expression_sy);
+}
+
+inline void count(Acc &a, const LevelEvent_UpdateVariable &v)
+{
+    count(a, v.name);
+    count(a, v.newval);
+}
+
+inline void count(Acc &a, const LevelSMBX64Event &e)
+{
+    count(a, e.name);
+    count(a, e.msg);
+    nested(a, e.layers_hide);
+    nested(a, e.layers_show);
+    nested(a, e.layers_toggle);
+    nested(a, e.sets);
+    count(a, e.trigger);
+    count(a, e.autostart_condition);
+    nested(a, e.moving_layers);
+    nested(a, e.spawn_effects);
+    nested(a, e.spawn_npc);
+    nested(a, e.update_variable);
+    count(a, e.trigger_script);
+    count(a, e.movelayer);
+    nested(a, e.layers_hide_index);
+    nested(a, e.layers_show_index);
+    nested(a, e.layers_toggle_index);
+    count(a, e.meta);
+}
+
+inline void count(Acc &a, const LevelVariable &v)
+{
+    count(a, v.name);
+    count(a, v.value);
+}
+
+inline void count(Acc &a, const LevelArray &arr)
+{
+    count(a, arr.name);
+}
+
+inline void count(Acc &a, const LevelScript &s)
+{
+    count(a, s.name);
+    count(a, s.script);
+}
+
+inline void count(Acc &a, const LevelItemSetup38A &c)
+{
+    nested(a, c.data);
+}
+
+/*****************World***************************/
+
+inline void count(Acc &a, const WorldTerrainTile &t)
+{
+    count(a, t.layer);
+    count(a, t.meta);
+}
+
+inline void count(Acc &a, const WorldScenery &s)
+{
+    count(a, s.layer);
+    count(a, s.meta);
+}
+
+inline void count(Acc &a, const WorldPathTile &p)
+{
+    count(a, p.layer);
+    count(a, p.meta);
+}
+
+inline void count(Acc &a, const WorldLevelTile::OpenCondition &c)
+{
+    nested(a, c.exit_codes);
+    count(a, c.expression);
+}
+
+inline void count(Acc &a, const WorldLevelTile::EnterCondition &c)
+{
+    count(a, c.condition);
+    count(a, c.levelIndex);
+}
+
+inline void count(Acc &a, const WorldLevelTile &l)
+{
+    count(a, l.lvlfile);
+    count(a, l.title);
+    count(a, l.top_exit_extra);
+    count(a, l.left_exit_extra);
+    count(a, l.bottom_exit_extra);
+    count(a, l.right_exit_extra);
+    nested(a, l.enter_cond);
+    count(a, l.layer);
+    nested(a, l.movement.nodes);
+    nested(a, l.movement.paths);
+    count(a, l.meta);
+}
+
+inline void count(Acc &a, const WorldMusicBox &m)
+{
+    count(a, m.music_file);
+    count(a, m.layer);
+    count(a, m.meta);
+}
+
+inline void count(Acc &a, const WorldAreaRect &r)
+{
+    count(a, r.music_file);
+    count(a, r.layer);
+    count(a, r.eventTouch);
+    count(a, r.eventBreak);
+    count(a, r.eventWarp);
+    count(a, r.eventAnchor);
+    count(a, r.meta);
+}
+
+inline void count(Acc &a, const WorldLayer &l)
+{
+    count(a, l.name);
+    count(a, l.meta);
+}
+
+inline void count(Acc &a, const WorldEvent38A &e)
+{
+    count(a, e.name);
+    count(a, e.meta);
+}
+
+inline void count(Acc &a, const WorldItemSetup38A &c)
+{
+    nested(a, c.data);
+}
+
+/*****************Game save***************************/
+
+inline void count(Acc &a, const saveUserData::DataEntry &e)
+{
+    count(a, e.key);
+    count(a, e.value);
+}
+
+inline void count(Acc &a, const saveUserData::DataSection &s)
+{
+    count(a, s.location_name);
+    count(a, s.name);
+    nested(a, s.data);
+}
+
+/*****************Entries***************************/
+
+inline void addEntry(PGE_MemoryUsage &u, const char *name, size_t count, const Acc &a)
+{
+    PGE_MemoryUsage::Entry e;
+    e.name = name;
+    e.count = count;
+    e.elementBytes = a.elements;
+    e.stringBytes = a.strings;
+    u.entries.push_back(e);
+}
+
+template<class List>
+inline void addList(PGE_MemoryUsage &u, const char *name, const List &l)
+{
+    Acc a;
+    nested(a, l);
+    addEntry(u, name, static_cast<size_t>(l.size()), a);
+}
+
+} // namespace
+
+size_t PGE_MemoryUsage::elementBytes() const
+{
+    size_t out = 0;
+    for(const Entry &e : entries)
+        out += e.elementBytes;
+    return out;
+}
+
+size_t PGE_MemoryUsage::stringBytes() const
+{
+    size_t out = 0;
+    for(const Entry &e : entries)
+        out += e.stringBytes;
+    return out;
+}
+
+size_t PGE_MemoryUsage::total() const
+{
+    return elementBytes() + stringBytes();
+}
+
+const PGE_MemoryUsage::Entry *PGE_MemoryUsage::find(const char *name) const
+{
+    for(const Entry &e : entries)
+    {
+        if(std::strcmp(e.name, name) == 0)
+            return &e;
+    }
+    return nullptr;
+}
+
+PGE_MemoryUsage PGE_MemoryUsage::ofLevel(const LevelData &data)
+{
+    PGE_MemoryUsage u;
+
+    Acc header;
+    count(header, data.meta);
+    count(header, data.LevelName);
+    count(header, data.open_level_on_fail);
+    nested(header, data.player_names_overrides);
+    count(header, data.custom_params);
+    addEntry(u, "header", 1, header);
+
+    addList(u, "music_overrides", data.music_overrides);
+    addList(u, "sound_overrides", data.sound_overrides);
+    addList(u, "sections", data.sections);
+    addList(u, "players", data.players);
+    addList(u, "blocks", data.blocks);
+    addList(u, "bgo", data.bgo);
+    addList(u, "npc", data.npc);
+    addList(u, "doors", data.doors);
+    addList(u, "physez", data.physez);
+    addList(u, "layers", data.layers);
+    addList(u, "events", data.events);
+    addList(u, "variables", data.variables);
+    addList(u, "scripts", data.scripts);
+    addList(u, "arrays", data.arrays);
+    addList(u, "unsupported_38a_lines", data.unsupported_38a_lines);
+    addList(u, "custom38A_configs", data.custom38A_configs);
+
+    Acc meta;
+    count(meta, data.metaData);
+    addEntry(u, "metaData", static_cast<size_t>(data.metaData.bookmarks.size()), meta);
+
+    Acc lookups;
+    hash(lookups, data.layers_lookup);
+    hash(lookups, data.events_lookup);
+    addEntry(u, "lookups", static_cast<size_t>(data.layers_lookup.size() + data.events_lookup.size()), lookups);
+
+    Acc idMaps;
+    const ElementArrayIdMap *maps[] =
+    {
+        &data.blocks_arrayid_map, &data.bgo_arrayid_map, &data.npc_arrayid_map,
+        &data.doors_arrayid_map, &data.physez_arrayid_map, &data.layers_arrayid_map,
+        &data.events_arrayid_map
+    };
+    size_t idMapsCount = 0;
+    for(const ElementArrayIdMap *m : maps)
+    {
+        count(idMaps, *m);
+        idMapsCount += m->size();
+    }
+    addEntry(u, "arrayid_maps", idMapsCount, idMaps);
+
+    return u;
+}
+
+PGE_MemoryUsage PGE_MemoryUsage::ofWorld(const WorldData &data)
+{
+    PGE_MemoryUsage u;
+
+    Acc header;
+    count(header, data.meta);
+    count(header, data.EpisodeTitle);
+    nested(header, data.nocharacter);
+    count(header, data.IntroLevel_file);
+    count(header, data.GameOverLevel_file);
+    nested(header, data.cheatsList);
+    count(header, data.saveLockerEx);
+    count(header, data.saveLockerMsg);
+    count(header, data.authors);
+    count(header, data.author1);
+    count(header, data.author2);
+    count(header, data.author3);
+    count(header, data.author4);
+    count(header, data.author5);
+    count(header, data.authors_music);
+    count(header, data.custom_params);
+    addEntry(u, "header", 1, header);
+
+    addList(u, "tiles", data.tiles);
+    addList(u, "scenery", data.scenery);
+    addList(u, "paths", data.paths);
+    addList(u, "levels", data.levels);
+    addList(u, "music", data.music);
+    addList(u, "arearects", data.arearects);
+    addList(u, "layers", data.layers);
+    addList(u, "events38A", data.events38A);
+    addList(u, "custom38A_configs", data.custom38A_configs);
+    addList(u, "unsupported_38a_lines", data.unsupported_38a_lines);
+
+    Acc meta;
+    count(meta, data.metaData);
+    addEntry(u, "metaData", static_cast<size_t>(data.metaData.bookmarks.size()), meta);
+
+    Acc idMaps;
+    const ElementArrayIdMap *maps[] =
+    {
+        &data.tiles_arrayid_map, &data.scenery_arrayid_map, &data.paths_arrayid_map,
+        &data.levels_arrayid_map, &data.music_arrayid_map, &data.arearects_arrayid_map,
+        &data.layers_arrayid_map
+    };
+    size_t idMapsCount = 0;
+    for(const ElementArrayIdMap *m : maps)
+    {
+        count(idMaps, *m);
+        idMapsCount += m->size();
+    }
+    addEntry(u, "arrayid_maps", idMapsCount, idMaps);
+
+    Acc spatial;
+    spatial.elements = data.spatial_index.memoryBytes();
+    addEntry(u, "spatial_index", data.spatial_index.size(), spatial);
+
+    Acc pathGraph;
+    pathGraph.elements = data.path_graph.memoryBytes();
+    addEntry(u, "path_graph", data.path_graph.size(), pathGraph);
+
+    return u;
+}
+
+PGE_MemoryUsage PGE_MemoryUsage::ofGamesave(const GamesaveData &data)
+{
+    PGE_MemoryUsage u;
+
+    Acc header;
+    count(header, data.meta);
+    count(header, data.musicFile);
+    addEntry(u, "header", 1, header);
+
+    addList(u, "userData", data.userData.store);
+    addList(u, "characterStates", data.characterStates);
+    addList(u, "currentCharacter", data.currentCharacter);
+    addList(u, "visibleLevels", data.visibleLevels);
+    addList(u, "visiblePaths", data.visiblePaths);
+    addList(u, "visibleScenery", data.visibleScenery);
+    addList(u, "gottenStars", data.gottenStars);
+
+    return u;
+}
+
+PGE_MemoryUsage PGE_MemoryUsage::ofNpcConfig(const NPCConfigFile &data)
+{
+    PGE_MemoryUsage u;
+
+    Acc header;
+    count(header, data.errorString);
+    count(header, data.unknownLines);
+    count(header, data.name);
+    count(header, data.description);
+    count(header, data.image);
+    count(header, data.icon);
+    count(header, data.script);
+    count(header, data.group);
+    count(header, data.category);
+    addEntry(u, "header", 1, header);
+
+    Acc entries;
+    map(entries, data.entries);
+    addEntry(u, "entries", static_cast<size_t>(data.entries.size()), entries);
+
+    return u;
+}
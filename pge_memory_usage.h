@@ -0,0 +1,116 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*!
+ * \file pge_memory_usage.h
+ * \brief Contains the heap footprint calculation of loaded data structures
+ */
+
+#pragma once
+#ifndef PGE_MEMORY_USAGE_H
+#define PGE_MEMORY_USAGE_H
+
+#include "pge_file_lib_globs.h"
+#include "lvl_filedata.h"
+#include "wld_filedata.h"
+#include "save_filedata.h"
+#include "npc_filedata.h"
+
+#include <cstddef>
+#include <vector>
+
+/*!
+ * \brief Heap footprint of the data structure, broken down by collections
+ *
+ * Numbers are computed from the sizes and capacities of containers and
+ * strings, the bookkeeping of the heap allocator itself is not counted, as
+ * well as the size of the top-level structure which may be placed anywhere.
+ * Nodes of maps and hashes are estimated from their element count.
+ */
+struct PGE_MemoryUsage
+{
+    //! Footprint of one collection
+    struct Entry
+    {
+        //! Name of the collection, usually the name of the field
+        const char *name = "";
+        //! Number of elements in the collection
+        size_t count = 0;
+        //! Bytes taken by storage of elements, including nested lists and map nodes
+        size_t elementBytes = 0;
+        //! Bytes taken by string buffers owned by elements
+        size_t stringBytes = 0;
+
+        //! Total bytes of the collection
+        size_t total() const
+        {
+            return elementBytes + stringBytes;
+        }
+    };
+
+    //! Collections in order of declaration in the structure, scalar fields are gathered into "header"
+    std::vector<Entry> entries;
+
+    //! Bytes taken by element storage of all collections
+    size_t elementBytes() const;
+    //! Bytes taken by string buffers of all collections
+    size_t stringBytes() const;
+    //! Total bytes of the structure
+    size_t total() const;
+    /*!
+     * \brief Finds the collection by name
+     * \param name Name of the collection
+     * \return Pointer to the entry or null if there is no such collection
+     */
+    const Entry *find(const char *name) const;
+
+    /*!
+     * \brief Calculates the footprint of the level
+     * \param data Level data
+     * \return Footprint
+     */
+    static PGE_MemoryUsage ofLevel(const LevelData &data);
+    /*!
+     * \brief Calculates the footprint of the world map
+     * \param data World map data
+     * \return Footprint
+     */
+    static PGE_MemoryUsage ofWorld(const WorldData &data);
+    /*!
+     * \brief Calculates the footprint of the game save
+     * \param data Game save data
+     * \return Footprint
+     */
+    static PGE_MemoryUsage ofGamesave(const GamesaveData &data);
+    /*!
+     * \brief Calculates the footprint of the NPC configuration
+     * \param data NPC configuration
+     * \return Footprint
+     */
+    static PGE_MemoryUsage ofNpcConfig(const NPCConfigFile &data);
+};
+
+#endif // PGE_MEMORY_USAGE_H
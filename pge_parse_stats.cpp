@@ -0,0 +1,197 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "pge_parse_stats.h"
+#include "pge_parse_stats_private.h"
+#include "file_formats.h"
+
+#include <chrono>
+#include <cstdio>
+
+static thread_local PGE_ParseObserver *s_parseObserver = nullptr;
+
+void FileFormats::SetParseObserver(PGE_ParseObserver *observer)
+{
+    s_parseObserver = observer;
+}
+
+PGE_ParseObserver *FileFormats::ParseObserver()
+{
+    return s_parseObserver;
+}
+
+
+PGE_ParseObserver::~PGE_ParseObserver()
+{}
+
+const char *PGE_ParseObserver::phaseName(Phase phase)
+{
+    switch(phase)
+    {
+    case PHASE_IO:
+        return "io";
+    case PHASE_SPLIT:
+        return "split";
+    case PHASE_TREE:
+        return "tree";
+    case PHASE_FIELDS:
+        return "fields";
+    case PHASE_POSTPROCESS:
+        return "postprocess";
+    default:
+        break;
+    }
+    return "unknown";
+}
+
+
+void PGE_ParseStats::onPhase(const char *format, Phase phase, uint64_t nanoseconds)
+{
+    if(phase >= 0 && phase < PHASE_COUNT)
+        formats[format ? format : ""].phaseNs[phase] += nanoseconds;
+}
+
+void PGE_ParseStats::onCounter(const char *format, const char *name, uint64_t value)
+{
+    formats[format ? format : ""].counters[name] += value;
+}
+
+void PGE_ParseStats::reset()
+{
+    formats.clear();
+}
+
+uint64_t PGE_ParseStats::totalNs(Phase phase) const
+{
+    uint64_t sum = 0;
+    if(phase < 0 || phase >= PHASE_COUNT)
+        return sum;
+    for(const auto &f : formats)
+        sum += f.second.phaseNs[phase];
+    return sum;
+}
+
+uint64_t PGE_ParseStats::counter(const std::string &name) const
+{
+    uint64_t sum = 0;
+    for(const auto &f : formats)
+    {
+        auto c = f.second.counters.find(name);
+        if(c != f.second.counters.end())
+            sum += c->second;
+    }
+    return sum;
+}
+
+std::string PGE_ParseStats::report() const
+{
+    std::string out;
+    char buf[128];
+    for(const auto &f : formats)
+    {
+        out += f.first + ":\n";
+        for(int p = 0; p < PHASE_COUNT; p++)
+        {
+            std::snprintf(buf, sizeof(buf), "  %-12s %12.3f ms\n",
+                          phaseName(static_cast<Phase>(p)), double(f.second.phaseNs[p]) / 1000000.0);
+            out += buf;
+        }
+        for(const auto &c : f.second.counters)
+        {
+            std::snprintf(buf, sizeof(buf), "  %-12s %12llu\n",
+                          c.first.c_str(), static_cast<unsigned long long>(c.second));
+            out += buf;
+        }
+    }
+    return out;
+}
+
+
+#ifdef PGE_FILES_PARSE_STATS
+
+//! Innermost running timer of the current thread
+static thread_local PGE_ParseTimer *s_activeParseTimer = nullptr;
+
+static uint64_t parseTimerNow()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+PGE_ParseTimer::PGE_ParseTimer(const char *format, PGE_ParseObserver::Phase phase) :
+    m_observer(s_parseObserver),
+    m_format(format),
+    m_phase(phase)
+{
+    if(!m_observer)
+        return;
+
+    m_parent = s_activeParseTimer;
+    if(m_parent)
+    {
+        m_parent->flush();
+        if(!m_format)
+            m_format = m_parent->m_format;
+    }
+    if(!m_format)
+        m_format = "unknown";
+    s_activeParseTimer = this;
+    m_begin = parseTimerNow();
+}
+
+PGE_ParseTimer::~PGE_ParseTimer()
+{
+    if(!m_observer)
+        return;
+
+    flush();
+    s_activeParseTimer = m_parent;
+    if(m_parent)
+        m_parent->m_begin = parseTimerNow();
+}
+
+void PGE_ParseTimer::setPhase(PGE_ParseObserver::Phase phase)
+{
+    if(!m_observer)
+        return;
+    flush();
+    m_phase = phase;
+}
+
+void PGE_ParseTimer::count(const char *name, uint64_t value)
+{
+    if(m_observer)
+        m_observer->onCounter(m_format, name, value);
+}
+
+void PGE_ParseTimer::flush()
+{
+    const uint64_t now = parseTimerNow();
+    m_observer->onPhase(m_format, m_phase, now - m_begin);
+    m_begin = now;
+}
+
+#endif // PGE_FILES_PARSE_STATS
@@ -0,0 +1,145 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*!
+ * \file pge_parse_stats.h
+ * \brief Contains the interface which receives per-phase timings and counters of file readers
+ */
+
+#pragma once
+#ifndef PGE_PARSE_STATS_H
+#define PGE_PARSE_STATS_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+/*!
+ * \brief Receiver of timings and counters of file readers
+ *
+ * Attach the observer with FileFormats::SetParseObserver() to the thread
+ * which loads files. Readers report every phase they pass and counters of
+ * read data, tagged with the name of file format ("PGE-X LVLX", "SMBX64 LVL",
+ * "SMBX-38A WLD", etc.). Nested work, like the reading of the .meta file
+ * next to the level, is reported separately and doesn't count into the
+ * phases of the outer reader.
+ *
+ * Reports are produced only when the library is built with the
+ * PGE_FILES_PARSE_STATS definition (PGEFL_PARSE_STATS CMake option),
+ * otherwise the instrumentation of readers is compiled out completely.
+ */
+class PGE_ParseObserver
+{
+public:
+    //! Phases of the file reading
+    enum Phase
+    {
+        //! Reading of raw data from the file or the input string
+        PHASE_IO = 0,
+        //! Splitting of PGE-X data into lines and sections
+        PHASE_SPLIT,
+        //! Building of the PGE-X data tree
+        PHASE_TREE,
+        //! Conversion of values into fields of elements. Line-based readers
+        //! of SMBX64 and SMBX-38A formats also read and split their data here
+        PHASE_FIELDS,
+        //! Post-processing of read data: internal events, stars counting,
+        //! lookup tables and indices, string interning
+        PHASE_POSTPROCESS,
+        //! Total number of phases
+        PHASE_COUNT
+    };
+
+    virtual ~PGE_ParseObserver();
+
+    /*!
+     * \brief Reader has passed the phase, one phase may be reported several times per file
+     * \param format Name of file format
+     * \param phase Phase of the reading
+     * \param nanoseconds Time spent in the phase
+     */
+    virtual void onPhase(const char *format, Phase phase, uint64_t nanoseconds) = 0;
+    /*!
+     * \brief Reader reports the counter: "bytes", "lines", or number of elements per collection
+     * \param format Name of file format
+     * \param name Name of the counter
+     * \param value Value of the counter
+     */
+    virtual void onCounter(const char *format, const char *name, uint64_t value) = 0;
+
+    /*!
+     * \brief Gives the name of the phase
+     * \param phase Phase of the reading
+     * \return Lowercase name of the phase ("io", "split", "tree", "fields", "postprocess")
+     */
+    static const char *phaseName(Phase phase);
+};
+
+/*!
+ * \brief Observer which sums timings and counters of all reports per file format
+ */
+class PGE_ParseStats : public PGE_ParseObserver
+{
+public:
+    //! Sums of one file format
+    struct Format
+    {
+        //! Total time per phase
+        uint64_t phaseNs[PHASE_COUNT] = {0, 0, 0, 0, 0};
+        //! Sums of counters by name
+        std::map<std::string, uint64_t> counters;
+    };
+
+    void onPhase(const char *format, Phase phase, uint64_t nanoseconds) override;
+    void onCounter(const char *format, const char *name, uint64_t value) override;
+
+    //! Removes all collected data
+    void reset();
+
+    /*!
+     * \brief Total time of the phase over all formats
+     * \param phase Phase of the reading
+     * \return Nanoseconds
+     */
+    uint64_t totalNs(Phase phase) const;
+    /*!
+     * \brief Sum of the counter over all formats
+     * \param name Name of the counter
+     * \return Sum of reported values
+     */
+    uint64_t counter(const std::string &name) const;
+
+    /*!
+     * \brief Human-readable table of collected data
+     * \return Multiline text
+     */
+    std::string report() const;
+
+    //! Collected sums by name of file format
+    std::map<std::string, Format> formats;
+};
+
+#endif // PGE_PARSE_STATS_H
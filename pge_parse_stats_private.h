@@ -0,0 +1,102 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Instrumentation of file readers, compiled only when PGE_FILES_PARSE_STATS is defined.
+ *
+ * PGE_STATS_BEGIN(format, phase) declares the timer of the reader, which
+ * reports to the observer attached to the current thread. The format may
+ * be nullptr to take the one of the enclosing timer. Timers are nesting:
+ * the inner timer pauses the outer one until it ends.
+ */
+
+#pragma once
+#ifndef PGE_PARSE_STATS_PRIVATE_H
+#define PGE_PARSE_STATS_PRIVATE_H
+
+#ifdef PGE_FILES_PARSE_STATS
+
+#include "pge_parse_stats.h"
+
+#include <cstdint>
+
+class PGE_ParseTimer
+{
+public:
+    PGE_ParseTimer(const char *format, PGE_ParseObserver::Phase phase);
+    ~PGE_ParseTimer();
+
+    //! Reports the time of current phase and starts the next one
+    void setPhase(PGE_ParseObserver::Phase phase);
+    //! Reports the counter
+    void count(const char *name, uint64_t value);
+
+private:
+    PGE_ParseTimer(const PGE_ParseTimer &) = delete;
+    PGE_ParseTimer &operator=(const PGE_ParseTimer &) = delete;
+
+    //! Reports the time of current phase and restarts the clock
+    void flush();
+
+    PGE_ParseObserver *m_observer;
+    const char *m_format;
+    PGE_ParseObserver::Phase m_phase;
+    uint64_t m_begin = 0;
+    PGE_ParseTimer *m_parent = nullptr;
+};
+
+#   define PGE_STATS_BEGIN(format, ph) PGE_ParseTimer pge_parse_timer(format, PGE_ParseObserver::ph)
+#   define PGE_STATS_PHASE(ph) pge_parse_timer.setPhase(PGE_ParseObserver::ph)
+#   define PGE_STATS_COUNT(name, value) pge_parse_timer.count(name, static_cast<uint64_t>(value))
+
+#   define PGE_STATS_COUNT_LEVEL(data) \
+        PGE_STATS_COUNT("sections", (data).sections.size());\
+        PGE_STATS_COUNT("blocks", (data).blocks.size());\
+        PGE_STATS_COUNT("bgo", (data).bgo.size());\
+        PGE_STATS_COUNT("npc", (data).npc.size());\
+        PGE_STATS_COUNT("doors", (data).doors.size());\
+        PGE_STATS_COUNT("physez", (data).physez.size());\
+        PGE_STATS_COUNT("layers", (data).layers.size());\
+        PGE_STATS_COUNT("events", (data).events.size())
+
+#   define PGE_STATS_COUNT_WORLD(data) \
+        PGE_STATS_COUNT("tiles", (data).tiles.size());\
+        PGE_STATS_COUNT("scenery", (data).scenery.size());\
+        PGE_STATS_COUNT("paths", (data).paths.size());\
+        PGE_STATS_COUNT("levels", (data).levels.size());\
+        PGE_STATS_COUNT("music", (data).music.size())
+
+#else
+
+#   define PGE_STATS_BEGIN(format, ph)
+#   define PGE_STATS_PHASE(ph)
+#   define PGE_STATS_COUNT(name, value)
+#   define PGE_STATS_COUNT_LEVEL(data)
+#   define PGE_STATS_COUNT_WORLD(data)
+
+#endif // PGE_FILES_PARSE_STATS
+
+#endif // PGE_PARSE_STATS_PRIVATE_H
@@ -0,0 +1,192 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Sorting of element arrays by compact keys: the order gets computed over
+ * the small key records, then elements are moved into their places once.
+ * Elements themselves are heavy (many strings), so they never get copied
+ * or swapped during the sorting itself.
+ */
+
+#pragma once
+#ifndef PGE_SORT_PRIVATE_H
+#define PGE_SORT_PRIVATE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*!
+ * \brief Sorting key record
+ *
+ * Words are compared from the first to the last one (the first one is the
+ * most significant), the index is the position of element in the source array.
+ */
+template<size_t N>
+struct PGE_SortKey
+{
+    uint64_t w[N];
+    uint32_t index;
+};
+
+//! Maps signed value into unsigned one keeping the order
+inline uint64_t PGE_SortKeySigned(int64_t v)
+{
+    return static_cast<uint64_t>(v) ^ (static_cast<uint64_t>(1) << 63);
+}
+
+template<size_t N>
+inline bool PGE_SortKeyLess(const PGE_SortKey<N> &a, const PGE_SortKey<N> &b)
+{
+    for(size_t i = 0; i < N; i++)
+    {
+        if(a.w[i] != b.w[i])
+            return a.w[i] < b.w[i];
+    }
+    return false;
+}
+
+/*!
+ * \brief Stable sort of key records
+ *
+ * LSD radix sort by bytes, passes where all keys have the same byte value
+ * are skipped, so keys with a narrow range of values take a few passes only.
+ */
+template<size_t N>
+void PGE_SortKeys(std::vector<PGE_SortKey<N> > &keys)
+{
+    const size_t n = keys.size();
+    if(n < 64)
+    {
+        std::stable_sort(keys.begin(), keys.end(), PGE_SortKeyLess<N>);
+        return;
+    }
+
+    std::vector<PGE_SortKey<N> > tmp(n);
+    size_t count[256];
+
+    for(size_t word = N; word-- > 0;)
+    {
+        for(unsigned shift = 0; shift < 64; shift += 8)
+        {
+            std::fill(count, count + 256, 0);
+            for(size_t i = 0; i < n; i++)
+                count[(keys[i].w[word] >> shift) & 0xFF]++;
+
+            if(count[(keys[0].w[word] >> shift) & 0xFF] == n)
+                continue; // All keys have the same byte
+
+            size_t sum = 0;
+            for(size_t &c : count)
+            {
+                size_t v = c;
+                c = sum;
+                sum += v;
+            }
+
+            for(size_t i = 0; i < n; i++)
+                tmp[count[(keys[i].w[word] >> shift) & 0xFF]++] = keys[i];
+
+            keys.swap(tmp);
+        }
+    }
+}
+
+/*!
+ * \brief Puts elements into the given order
+ * \param array Array of elements
+ * \param order Position i receives the element from position order[i]
+ *
+ * Follows the permutation cycles, every element is moved once.
+ */
+template<class Array>
+void PGE_ApplySortOrder(Array &array, const std::vector<uint32_t> &order)
+{
+    typedef decltype(array.size()) Index;
+    typedef typename std::remove_reference<decltype(array[0])>::type Elem;
+
+    const size_t n = order.size();
+    std::vector<bool> done(n, false);
+
+    for(size_t start = 0; start < n; start++)
+    {
+        if(done[start] || order[start] == start)
+        {
+            done[start] = true;
+            continue;
+        }
+
+        Elem tmp = std::move(array[static_cast<Index>(start)]);
+        size_t j = start;
+        while(true)
+        {
+            done[j] = true;
+            size_t k = order[j];
+            if(k == start)
+            {
+                array[static_cast<Index>(j)] = std::move(tmp);
+                break;
+            }
+            array[static_cast<Index>(j)] = std::move(array[static_cast<Index>(k)]);
+            j = k;
+        }
+    }
+}
+
+/*!
+ * \brief Sorts array of elements by keys
+ * \param array Array of elements
+ * \param makeKey Function which fills words of the key record for the element
+ */
+template<size_t N, class Array, class KeyFunc>
+void PGE_SortElements(Array &array, KeyFunc makeKey)
+{
+    typedef decltype(array.size()) Index;
+
+    const size_t n = static_cast<size_t>(array.size());
+    if(n <= 1)
+        return; //Nothing to sort!
+
+    std::vector<PGE_SortKey<N> > keys(n);
+    for(size_t i = 0; i < n; i++)
+    {
+        makeKey(array[static_cast<Index>(i)], keys[i].w);
+        keys[i].index = static_cast<uint32_t>(i);
+    }
+
+    PGE_SortKeys<N>(keys);
+
+    std::vector<uint32_t> order(n);
+    for(size_t i = 0; i < n; i++)
+        order[i] = keys[i].index;
+
+    PGE_ApplySortOrder(array, order);
+}
+
+#endif // PGE_SORT_PRIVATE_H
@@ -0,0 +1,225 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "pge_string_pool.h"
+#include "file_formats.h"
+#include "pge_file_lib_private.h"
+
+#include <atomic>
+#include <functional>
+
+#ifdef PGE_FILES_QT
+static std::atomic<PGE_StringPool *> s_readersStringPool(nullptr);
+
+void FileFormats::SetStringPool(PGE_StringPool *pool)
+{
+    s_readersStringPool = pool;
+}
+
+PGE_StringPool *FileFormats::StringPool()
+{
+    return s_readersStringPool;
+}
+#endif
+
+size_t PGE_StringPool::heapBytes(const PGESTRING &str)
+{
+#ifdef PGE_FILES_QT
+    if(str.isEmpty())
+        return 0;
+    // Header of QArrayData plus UTF-16 content with terminator
+    return 24 + static_cast<size_t>(str.capacity() + 1) * sizeof(QChar);
+#else
+    // Strings which fit into the small buffer have no heap storage
+    static const size_t smallCapacity = std::string().capacity();
+    return (str.capacity() > smallCapacity) ? str.capacity() + 1 : 0;
+#endif
+}
+
+void PGE_StringPool::intern(PGESTRING &str)
+{
+    if(IsEmpty(str))
+        return;
+
+#ifdef PGE_FILES_QT
+    Stripe &st = m_stripes[qHash(str) % c_stripes];
+#else
+    Stripe &st = m_stripes[std::hash<std::string>()(str) % c_stripes];
+#endif
+    std::lock_guard<std::mutex> guard(st.lock);
+
+    st.stats.references++;
+
+    auto it = st.pool.find(str);
+    if(it == st.pool.end())
+    {
+        st.pool[str] = 0;
+        st.stats.uniqueStrings++;
+        st.stats.bytesUnique += heapBytes(str);
+        return;
+    }
+
+    const PGESTRING &pooled = PGEMAPKEY(it);
+    const size_t bytes = heapBytes(str);
+    st.stats.bytesDuplicated += bytes;
+
+#ifdef PGE_FILES_QT
+    if(str.constData() != pooled.constData())
+    {
+        str = pooled;
+        st.stats.bytesSaved += bytes;
+    }
+#else
+    (void)pooled;
+#endif
+}
+
+void PGE_StringPool::internLevel(LevelData &lvl)
+{
+    for(auto &s : lvl.sections)
+        intern(s.music_file);
+
+    for(auto &b : lvl.blocks)
+    {
+        intern(b.layer);
+        intern(b.gfx_name);
+        intern(b.event_destroy);
+        intern(b.event_hit);
+        intern(b.event_emptylayer);
+        intern(b.event_on_screen);
+    }
+
+    for(auto &b : lvl.bgo)
+        intern(b.layer);
+
+    for(auto &n : lvl.npc)
+    {
+        intern(n.layer);
+        intern(n.gfx_name);
+        intern(n.event_activate);
+        intern(n.event_die);
+        intern(n.event_talk);
+        intern(n.event_emptylayer);
+        intern(n.event_grab);
+        intern(n.event_nextframe);
+        intern(n.event_touch);
+        intern(n.attach_layer);
+    }
+
+    for(auto &d : lvl.doors)
+    {
+        intern(d.layer);
+        intern(d.lname);
+        intern(d.event_enter);
+    }
+
+    for(auto &p : lvl.physez)
+    {
+        intern(p.layer);
+        intern(p.touch_event);
+    }
+
+    for(auto &l : lvl.layers)
+        intern(l.name);
+
+    for(auto &e : lvl.events)
+    {
+        intern(e.name);
+        intern(e.trigger);
+        intern(e.movelayer);
+        for(auto &l : e.layers_hide)
+            intern(l);
+        for(auto &l : e.layers_show)
+            intern(l);
+        for(auto &l : e.layers_toggle)
+            intern(l);
+        for(auto &s : e.sets)
+            intern(s.music_file);
+    }
+}
+
+void PGE_StringPool::internWorld(WorldData &wld)
+{
+    intern(wld.IntroLevel_file);
+    intern(wld.GameOverLevel_file);
+
+    for(auto &t : wld.tiles)
+        intern(t.layer);
+    for(auto &s : wld.scenery)
+        intern(s.layer);
+    for(auto &p : wld.paths)
+        intern(p.layer);
+
+    for(auto &l : wld.levels)
+    {
+        intern(l.layer);
+        intern(l.lvlfile);
+    }
+
+    for(auto &m : wld.music)
+    {
+        intern(m.layer);
+        intern(m.music_file);
+    }
+
+    for(auto &a : wld.arearects)
+    {
+        intern(a.layer);
+        intern(a.music_file);
+        intern(a.eventTouch);
+        intern(a.eventBreak);
+        intern(a.eventWarp);
+        intern(a.eventAnchor);
+    }
+
+    for(auto &l : wld.layers)
+        intern(l.name);
+}
+
+PGE_StringPool::Stats PGE_StringPool::stats() const
+{
+    Stats out;
+    for(const Stripe &st : m_stripes)
+    {
+        std::lock_guard<std::mutex> guard(st.lock);
+        out.uniqueStrings += st.stats.uniqueStrings;
+        out.references += st.stats.references;
+        out.bytesUnique += st.stats.bytesUnique;
+        out.bytesDuplicated += st.stats.bytesDuplicated;
+        out.bytesSaved += st.stats.bytesSaved;
+    }
+    return out;
+}
+
+void PGE_StringPool::clear()
+{
+    for(Stripe &st : m_stripes)
+    {
+        std::lock_guard<std::mutex> guard(st.lock);
+        st.pool.clear();
+        st.stats = Stats();
+    }
+}
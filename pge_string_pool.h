@@ -0,0 +1,128 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*!
+ * \file pge_string_pool.h
+ * \brief Contains the pool of interned strings shared across loaded files
+ */
+
+#pragma once
+#ifndef PGE_STRING_POOL_H
+#define PGE_STRING_POOL_H
+
+#include "pge_file_lib_globs.h"
+#include "lvl_filedata.h"
+#include "wld_filedata.h"
+
+#include <cstddef>
+#include <mutex>
+
+/*!
+ * \brief Pool of interned strings
+ *
+ * Layer names, event names, music and graphics file names are repeated in
+ * many elements of many files. Interning replaces every such string with
+ * the pooled instance, so identical strings share one storage.
+ *
+ * Sharing of the storage requires implicitly shared strings (Qt mode).
+ * In STL mode std::string always owns its own buffer, so the pool
+ * only measures duplicates and the bytesSaved counter stays zero. Readers
+ * intern loaded files in Qt mode only, see FileFormats::SetStringPool().
+ *
+ * The pool is thread-safe and may be shared by several loader threads.
+ * It is split into independently locked stripes, so parallel loads
+ * don't wait for each other's whole level or world walk.
+ */
+class PGE_StringPool
+{
+public:
+    //! Memory report
+    struct Stats
+    {
+        //! Number of unique strings in the pool
+        size_t uniqueStrings = 0;
+        //! Number of interned string references
+        size_t references = 0;
+        //! Heap bytes of unique strings stored in the pool
+        size_t bytesUnique = 0;
+        //! Heap bytes of references which duplicated the pooled string
+        size_t bytesDuplicated = 0;
+        //! Heap bytes released because of the storage sharing
+        size_t bytesSaved = 0;
+    };
+
+    /*!
+     * \brief Replaces the string with the pooled instance of same value
+     * \param [__inout] str String to intern
+     */
+    void intern(PGESTRING &str);
+    /*!
+     * \brief Interns names and file names of all elements of the level
+     * \param [__inout] lvl Level data structure
+     */
+    void internLevel(LevelData &lvl);
+    /*!
+     * \brief Interns names and file names of all elements of the world map
+     * \param [__inout] wld World map data structure
+     */
+    void internWorld(WorldData &wld);
+
+    /*!
+     * \brief Gives the memory report
+     * \return Statistics of the pool
+     */
+    Stats stats() const;
+    /*!
+     * \brief Removes all strings from the pool and resets the statistics
+     *
+     * Strings already interned into the loaded data are staying valid.
+     */
+    void clear();
+
+    /*!
+     * \brief Estimates heap bytes used by the string
+     * \param str String
+     * \return Number of bytes allocated for the string content, 0 if string has no heap storage
+     */
+    static size_t heapBytes(const PGESTRING &str);
+
+private:
+    //! Number of independently locked parts of the pool
+    static const size_t c_stripes = 16;
+
+    //! Part of the pool which holds strings of the same hash remainder
+    struct Stripe
+    {
+        mutable std::mutex lock;
+        //! Pooled strings are the keys, values are unused
+        PGEHASH<PGESTRING, char> pool;
+        Stats stats;
+    };
+
+    Stripe m_stripes[c_stripes];
+};
+
+#endif // PGE_STRING_POOL_H
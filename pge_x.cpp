@@ -33,6 +33,7 @@
 
 #include "pge_x.h"
 #include "file_strlist.h"
+#include "pge_parse_stats_private.h"
 
 namespace PGEExtendedFormat
 {
@@ -113,6 +114,8 @@ void PGEFile::setRawData(const PGESTRING &_rawData)
 
 bool PGEFile::buildTreeFromRaw()
 {
+    PGE_STATS_BEGIN(nullptr, PHASE_SPLIT);
+    PGE_STATS_COUNT("bytes", m_rawData.size());
     PGEXSct PGEXsection;
 
     FileStringList in;
@@ -131,29 +134,41 @@ bool PGEFile::buildTreeFromRaw()
 
         sectionOpened = true;
         PGESTRING data;
+        const PGESTRING sectionEnd = PGEXsection.first + "_END";
         while(!in.atEnd())
         {
             data = in.readLine();
-            if(data == PGEXsection.first + "_END")
+            if(data == sectionEnd)
             {
                 sectionOpened = false;    // Close Section
                 break;
             }
-            PGEXsection.second.push_back(data);
+            PGEXsection.second.push_back(std::move(data));
         }
-        m_rawDataTree.push_back(PGEXsection);
+        m_rawDataTree.push_back(std::move(PGEXsection));
     }
 
     if(sectionOpened)
     {
-        PGESTRING errSect = PGEXsection.first;
+        PGESTRING errSect = m_rawDataTree.back().first;
         PGE_CutLength(errSect, 20);
         PGE_FilterBinary(errSect);
         m_lastError = PGESTRING("Section [" + errSect + "] is not closed");
         return false;
     }
 
+#ifdef PGE_FILES_PARSE_STATS
+    {
+        // Every section has its header and footer lines
+        pge_size_t lines = m_rawDataTree.size() * 2;
+        for(const PGEXSct &sct : m_rawDataTree)
+            lines += sct.second.size();
+        PGE_STATS_COUNT("lines", lines);
+    }
+#endif
+
     //Building tree
+    PGE_STATS_PHASE(PHASE_TREE);
 
     for(pge_size_t z = 0; z < m_rawDataTree.size(); z++)
     {
@@ -164,7 +179,7 @@ bool PGEFile::buildTreeFromRaw()
             //Store like subtree
             subTree.type = PGEX_Struct;
             subTree.name = m_rawDataTree[z].first;
-            dataTree.push_back(subTree);
+            dataTree.push_back(std::move(subTree));
         }
         else
         {
@@ -177,11 +192,11 @@ bool PGEFile::buildTreeFromRaw()
             dataValue.marker = "PlainText";
             for(pge_size_t i = 0; i < m_rawDataTree[z].second.size(); i++)
                 dataValue.value += m_rawDataTree[z].second[i] + "\n";
-            dataItem.values.push_back(dataValue);
+            dataItem.values.push_back(std::move(dataValue));
             subTree.name = m_rawDataTree[z].first;
             subTree.type = PGEX_PlainText;
-            subTree.data.push_back(dataItem);
-            dataTree.push_back(subTree);
+            subTree.data.push_back(std::move(dataItem));
+            dataTree.push_back(std::move(subTree));
             valid = true;
         }
     }
@@ -201,9 +216,10 @@ PGEFile::PGEX_Entry PGEFile::buildTree(PGESTRINGList &src_data, bool *_valid)
         {
             //Build and store subTree
             PGESTRING nameOfTree = removeSpaces(src_data[q]);
+            const PGESTRING nameOfTreeEnd = nameOfTree + "_END";
             PGESTRINGList rawSubTree;
             q++;
-            for(; q < src_data.size() && src_data[q] != nameOfTree + "_END" ; q++)
+            for(; q < src_data.size() && src_data[q] != nameOfTreeEnd; q++)
             {
                 rawSubTree.push_back(src_data[q]);
             }
@@ -212,7 +228,7 @@ PGEFile::PGEX_Entry PGEFile::buildTree(PGESTRINGList &src_data, bool *_valid)
             {
                 //Store like subtree
                 subTree.name = nameOfTree;
-                entryData.subTree.push_back(subTree);
+                entryData.subTree.push_back(std::move(subTree));
                 entryData.type = PGEX_Struct;
             }
             else
@@ -231,9 +247,9 @@ PGEFile::PGEX_Entry PGEFile::buildTree(PGESTRINGList &src_data, bool *_valid)
                 //foreach(PGESTRING x, rawSubTree) dataValue.value += x+"\n";
                 for(auto &st : rawSubTree)
                     dataValue.value += st + "\n";
-                dataItem.values.push_back(dataValue);
-                subTree.data.push_back(dataItem);
-                entryData.subTree.push_back(subTree);
+                dataItem.values.push_back(std::move(dataValue));
+                subTree.data.push_back(std::move(dataItem));
+                entryData.subTree.push_back(std::move(subTree));
                 entryData.type = PGEX_Struct;
                 valid = true;
             }
@@ -252,6 +268,15 @@ PGEFile::PGEX_Entry PGEFile::buildTree(PGESTRINGList &src_data, bool *_valid)
             pge_size_t state = 0, size = srcData_nc.size(), tail = srcData_nc.size() - 1;
             PGEX_Val dataValue;
             int escape = 0;
+
+            // Every value ends with ';', reserve the list to avoid re-allocations while filling
+            pge_size_t valuesCount = 0;
+            for(pge_size_t i = 0; i < size; i++)
+            {
+                if(srcData_nc[i] == ';')
+                    valuesCount++;
+            }
+            dataItem.values.reserve(valuesCount + 1);
             for(pge_size_t i = 0; i < size; i++)
             {
                 if(state == STATE_ERROR)
@@ -307,7 +332,7 @@ PGEFile::PGEX_Entry PGEFile::buildTree(PGESTRINGList &src_data, bool *_valid)
             }
             dataItem.type = PGEX_Struct;
             entryData.type = PGEX_Struct;
-            entryData.data.push_back(dataItem);
+            entryData.data.push_back(std::move(dataItem));
             //            PGE_SPLITSTRING(fields, srcData_nc, ";");
             //            PGEX_Item dataItem;
             //            dataItem.type = PGEX_Struct;
@@ -728,9 +753,27 @@ PGELIST<bool > PGEFile::X2BollArr(const PGESTRING &src)
     return arr;
 }
 
-PGELIST<PGESTRINGList > PGEFile::splitDataLine(const PGESTRING &src_data, bool *_valid)
+void PGEFile::valueSyntaxError(PGESTRING &out, const PGESTRING &section, pge_size_t line, const PGEX_Val &v)
+{
+    // Called for every parsed value, so, keep the buffer to avoid allocations
+#ifdef PGE_FILES_QT
+    out.resize(0);
+#else
+    out.clear();
+#endif
+    out.append("Wrong value syntax\nSection [");
+    out.append(section);
+    out.append("]\nData line ");
+    out.append(fromNum(line));
+    out.append("\nMarker ");
+    out.append(v.marker);
+    out.append("\nValue ");
+    out.append(v.value);
+}
+
+PGEVECTOR<PGESTRINGList > PGEFile::splitDataLine(const PGESTRING &src_data, bool *_valid)
 {
-    PGELIST<PGESTRINGList > entryData;
+    PGEVECTOR<PGESTRINGList > entryData;
     bool valid = true;
     enum States
     {
@@ -796,7 +839,7 @@ PGELIST<PGESTRINGList > PGEFile::splitDataLine(const PGESTRING &src_data, bool *
                 PGESTRINGList fields;
                 fields.push_back(marker);
                 fields.push_back(value);
-                entryData.push_back(fields);
+                entryData.push_back(std::move(fields));
                 marker.clear();
                 value.clear();
                 state = STATE_MARKER;
@@ -81,7 +81,7 @@ public:
         //! Type of entry
         PGEX_Item_type type;
         //! List of available values
-        PGELIST<PGEX_Val > values;
+        PGEVECTOR<PGEX_Val > values;
     };
 
     /*!
@@ -94,9 +94,9 @@ public:
         //! Type of contained items
         PGEX_Item_type type;
         //! List of contained items except subtrees
-        PGELIST<PGEX_Item > data;
+        PGEVECTOR<PGEX_Item > data;
         //! List of contained sub-branches
-        PGELIST<PGEX_Entry > subTree;
+        PGEVECTOR<PGEX_Entry > subTree;
     };
 
 #ifdef PGE_FILES_QT
@@ -144,7 +144,7 @@ public:
     PGESTRING lastError();
 
     //! Full data tree of all parsed data
-    PGELIST<PGEX_Entry > dataTree;
+    PGEVECTOR<PGEX_Entry > dataTree;
 
 private:
     //! Last occouped error
@@ -152,7 +152,7 @@ private:
     //! Stored raw data set
     PGESTRING m_rawData;
     //! Unparsed data separated to their data sections
-    PGELIST<PGEXSct > m_rawDataTree;
+    PGEVECTOR<PGEXSct > m_rawDataTree;
 
     //Static functions
 public:
@@ -228,8 +228,17 @@ public:
      */
     static bool IsStringArray(const PGESTRING &in);//String array
 
+    /*!
+     * \brief Writes the "Wrong value syntax" error message, memory of the output string gets reused
+     * \param [__out] out Target string
+     * \param [__in] section Name of the section
+     * \param [__in] line Number of the data line in the section
+     * \param [__in] v Value which is being parsed
+     */
+    static void valueSyntaxError(PGESTRING &out, const PGESTRING &section, pge_size_t line, const PGEX_Val &v);
+
     //Split string into data values
-    static PGELIST<PGESTRINGList> splitDataLine(const PGESTRING &src_data, bool *valid = nullptr);
+    static PGEVECTOR<PGESTRINGList> splitDataLine(const PGESTRING &src_data, bool *valid = nullptr);
 
     //PGE Extended File parameter string generators
     /*!
@@ -35,6 +35,8 @@
 #ifndef PGE_X_MACRO_H
 #define PGE_X_MACRO_H
 
+#include "pge_parse_stats_private.h"
+
 /*! \def PGEX_FileBegin()
     \brief Placing at begin of the parsing function
 */
@@ -42,14 +44,15 @@
                          PGESTRING line;  /*Current Line data*/
 
 /*! \def PGEX_FileParseTree(raw)
-    \brief Parse PGE-X Tree from raw data
+    \brief Parse PGE-X Tree from raw data, then switch the timer declared by PGE_STATS_BEGIN() to fields conversion
 */
 #define PGEX_FileParseTree(raw)  PGEFile pgeX_Data(raw);\
                             if( !pgeX_Data.buildTreeFromRaw() )\
                             {\
                                 errorString = pgeX_Data.lastError();\
                                 goto badfile;\
-                            }
+                            }\
+                            PGE_STATS_PHASE(PHASE_FIELDS);
 
 /*! \def PGEX_FetchSection()
     \brief Prepare to fetch all data from specified section
@@ -76,6 +79,10 @@
     \brief Prepare to read items from this section
 */
 #define PGEX_Items() for(pge_size_t sdata = 0; sdata < f_section.data.size(); sdata++)
+/*! \def PGEX_ReserveItems(list)
+    \brief Reserves the target list for all items of this section
+*/
+#define PGEX_ReserveItems(list) (list).reserve(static_cast<pge_size_t>((list).size() + f_section.data.size()))
 /*! \def PGEX_ItemBegin(stype)
     \brief Declares block with a list of values
 */
@@ -84,7 +91,7 @@
     errorString=PGESTRING("Wrong data item syntax:\nSection ["+f_section.name+"]\nData line "+fromNum(sdata));\
     goto badfile;\
 }\
-PGEFile::PGEX_Item x = f_section.data[sdata];
+PGEFile::PGEX_Item &x = f_section.data[sdata];
 
 /*! \def PGEX_Values()
     \brief Declares block with a list of values
@@ -93,10 +100,8 @@ PGEFile::PGEX_Item x = f_section.data[sdata];
 /*! \def PGEX_ValueBegin()
     \brief Initializes getting of the values
 */
-#define PGEX_ValueBegin()  PGEFile::PGEX_Val v = x.values[sval];\
-                           errorString=PGESTRING("Wrong value syntax\nSection ["+f_section.name+ \
-                           "]\nData line "+fromNum(sdata) \
-                           +"\nMarker "+v.marker+"\nValue "+v.value);\
+#define PGEX_ValueBegin()  PGEFile::PGEX_Val &v = x.values[sval];\
+                           PGEFile::valueSyntaxError(errorString, f_section.name, sdata, v);\
                            if(IsEmpty(v.marker)) continue;
 
 /*! \def PGEX_StrVal(Mark, targetValue)
@@ -26,6 +26,555 @@
 
 #include "file_formats.h"
 
+//*********************************************************
+//****************Visible states and stars lookup**********
+//*********************************************************
+
+//! Array-IDs starting from this one are kept in the hash to don't allocate huge tables
+static const unsigned int c_visibleDenseLimit = 0x100000;
+
+void VisibleItemsMap::disable()
+{
+    m_dense.clear();
+    m_sparse.clear();
+    m_entries = 0;
+    m_enabled = false;
+}
+
+void VisibleItemsMap::rebuild(const PGELIST<visibleItem> &list)
+{
+    disable();
+
+    unsigned int maxId = 0;
+    for(const visibleItem &v : list)
+    {
+        if(v.first < c_visibleDenseLimit && v.first > maxId)
+            maxId = v.first;
+    }
+    m_dense.resize(static_cast<size_t>(maxId) + 1, 0);
+
+    for(long i = 0; i < static_cast<long>(list.size()); i++)
+        store(list[i].first, i);
+
+    m_entries = static_cast<size_t>(list.size());
+    m_enabled = true;
+}
+
+void VisibleItemsMap::update(const PGELIST<visibleItem> &list)
+{
+    if(m_enabled && m_entries != static_cast<size_t>(list.size()))
+        rebuild(list);
+}
+
+void VisibleItemsMap::store(unsigned int arrayId, long index)
+{
+    if(arrayId < c_visibleDenseLimit)
+    {
+        if(arrayId >= m_dense.size())
+            m_dense.resize(static_cast<size_t>(arrayId) + 1, 0);
+        if(m_dense[arrayId] == 0)
+            m_dense[arrayId] = static_cast<unsigned int>(index + 1);
+    }
+    else if(m_sparse.find(arrayId) == m_sparse.end())
+        m_sparse[arrayId] = index;
+}
+
+long VisibleItemsMap::lookup(unsigned int arrayId) const
+{
+    if(arrayId < c_visibleDenseLimit)
+        return (arrayId < m_dense.size()) ? static_cast<long>(m_dense[arrayId]) - 1 : -1;
+    auto it = m_sparse.find(arrayId);
+    return (it == m_sparse.end()) ? -1 : PGEMAPVAL(it);
+}
+
+long VisibleItemsMap::find(const PGELIST<visibleItem> &list, unsigned int arrayId) const
+{
+    if(m_enabled && m_entries == static_cast<size_t>(list.size()))
+    {
+        long i = lookup(arrayId);
+        if(i < 0 || list[i].first == arrayId)
+            return i;
+        // Entry was changed in place, the map is stale
+    }
+
+    for(long i = 0; i < static_cast<long>(list.size()); i++)
+    {
+        if(list[i].first == arrayId)
+            return i;
+    }
+
+    return -1;
+}
+
+bool VisibleItemsMap::isVisible(const PGELIST<visibleItem> &list, unsigned int arrayId) const
+{
+    long i = find(list, arrayId);
+    return (i >= 0) && list[i].second;
+}
+
+void VisibleItemsMap::set(PGELIST<visibleItem> &list, unsigned int arrayId, bool visible)
+{
+    update(list);
+    long i = find(list, arrayId);
+    if(i >= 0)
+    {
+        list[i].second = visible;
+        return;
+    }
+
+    list.push_back(visibleItem(arrayId, visible));
+    if(m_enabled)
+    {
+        store(arrayId, static_cast<long>(list.size()) - 1);
+        m_entries++;
+    }
+}
+
+bool VisibleItemsMap::erase(PGELIST<visibleItem> &list, unsigned int arrayId)
+{
+    update(list);
+    long i = find(list, arrayId);
+    if(i < 0)
+        return false;
+
+    list.erase(list.begin() + i);
+
+    if(m_enabled)
+    {
+        if(lookup(arrayId) != i)
+        {
+            // Entries were changed in place, indices can't be shifted
+            rebuild(list);
+            return true;
+        }
+        if(arrayId < c_visibleDenseLimit)
+            m_dense[arrayId] = 0;
+        else
+            m_sparse.erase(m_sparse.find(arrayId));
+        m_entries--;
+        shift(list, i);
+    }
+
+    return true;
+}
+
+void VisibleItemsMap::shift(const PGELIST<visibleItem> &list, long removed)
+{
+    // The next duplicate of removed entry takes it's place
+    for(long j = removed; j < static_cast<long>(list.size()); j++)
+    {
+        const visibleItem &v = list[j];
+        if(v.first < c_visibleDenseLimit)
+        {
+            if(m_dense[v.first] == static_cast<unsigned int>(j + 2))
+                m_dense[v.first] = static_cast<unsigned int>(j + 1);
+            else if(m_dense[v.first] == 0)
+                store(v.first, j);
+        }
+        else
+        {
+            auto it = m_sparse.find(v.first);
+            if(it == m_sparse.end())
+                m_sparse[v.first] = j;
+            else if(PGEMAPVAL(it) == j + 1)
+                PGEMAPVAL(it) = j;
+        }
+    }
+}
+
+
+static PGESTRING gottenStarKey(const starOnLevel &star)
+{
+#ifdef PGE_FILES_QT
+    return star.first + QChar(0x1F) + QString::number(star.second);
+#else
+    return star.first + '\x1F' + std::to_string(star.second);
+#endif
+}
+
+void GottenStarsMap::disable()
+{
+    m_map.clear();
+    m_entries = 0;
+    m_enabled = false;
+}
+
+void GottenStarsMap::rebuild(const PGELIST<starOnLevel> &list)
+{
+    m_map.clear();
+    m_map.reserve(static_cast<int>(list.size()));
+    for(long i = 0; i < static_cast<long>(list.size()); i++)
+    {
+        PGESTRING key = gottenStarKey(list[i]);
+        if(m_map.find(key) == m_map.end())
+            m_map[key] = i;
+    }
+    m_entries = static_cast<size_t>(list.size());
+    m_enabled = true;
+}
+
+void GottenStarsMap::update(const PGELIST<starOnLevel> &list)
+{
+    if(m_enabled && m_entries != static_cast<size_t>(list.size()))
+        rebuild(list);
+}
+
+long GottenStarsMap::find(const PGELIST<starOnLevel> &list, const starOnLevel &star) const
+{
+    if(m_enabled && m_entries == static_cast<size_t>(list.size()))
+    {
+        auto it = m_map.find(gottenStarKey(star));
+        if(it == m_map.end())
+            return -1;
+        long i = PGEMAPVAL(it);
+        if(list[i] == star)
+            return i;
+        // Star was changed in place, the map is stale
+    }
+
+    for(long i = 0; i < static_cast<long>(list.size()); i++)
+    {
+        if(list[i] == star)
+            return i;
+    }
+
+    return -1;
+}
+
+bool GottenStarsMap::insert(PGELIST<starOnLevel> &list, const starOnLevel &star)
+{
+    update(list);
+    if(find(list, star) >= 0)
+        return false;
+
+    list.push_back(star);
+    if(m_enabled)
+    {
+        PGESTRING key = gottenStarKey(star);
+        if(m_map.find(key) == m_map.end())
+            m_map[key] = static_cast<long>(list.size()) - 1;
+        m_entries++;
+    }
+
+    return true;
+}
+
+bool GottenStarsMap::erase(PGELIST<starOnLevel> &list, const starOnLevel &star)
+{
+    update(list);
+    long i = find(list, star);
+    if(i < 0)
+        return false;
+
+    list.erase(list.begin() + i);
+
+    if(m_enabled)
+    {
+        auto removed = m_map.find(gottenStarKey(star));
+        if(removed == m_map.end() || PGEMAPVAL(removed) != i)
+        {
+            // Stars were changed in place, indices can't be shifted
+            rebuild(list);
+            return true;
+        }
+        m_map.erase(removed);
+        m_entries--;
+        // The next duplicate of removed star takes it's place
+        for(long j = i; j < static_cast<long>(list.size()); j++)
+        {
+            PGESTRING key = gottenStarKey(list[j]);
+            auto it = m_map.find(key);
+            if(it == m_map.end())
+                m_map[key] = j;
+            else if(PGEMAPVAL(it) == j + 1)
+                PGEMAPVAL(it) = j;
+        }
+    }
+
+    return true;
+}
+
+void GamesaveData::buildLookupMaps()
+{
+    visibleLevels_map.rebuild(visibleLevels);
+    visiblePaths_map.rebuild(visiblePaths);
+    visibleScenery_map.rebuild(visibleScenery);
+    gottenStars_map.rebuild(gottenStars);
+    userData.rebuildIndex();
+}
+
+
+//*********************************************************
+//****************User data lookup index*******************
+//*********************************************************
+
+static PGESTRING userDataSectionId(int location, const PGESTRING &location_name, const PGESTRING &name)
+{
+#ifdef PGE_FILES_QT
+    return QString::number(location) + QChar(0x1F) + location_name + QChar(0x1F) + name;
+#else
+    return std::to_string(location) + '\x1F' + location_name + '\x1F' + name;
+#endif
+}
+
+void saveUserData::rebuildIndex()
+{
+    m_sections.clear();
+    m_sections.reserve(static_cast<int>(store.size()));
+    m_keys.clear();
+    m_keys.resize(static_cast<size_t>(store.size()));
+
+    for(long i = 0; i < static_cast<long>(store.size()); i++)
+    {
+        const DataSection &s = store[i];
+        PGESTRING id = userDataSectionId(s.location, s.location_name, s.name);
+        // With duplicated sections, the first one is found, like by the scan
+        if(m_sections.find(id) == m_sections.end())
+            m_sections[id] = i;
+        rebuildKeys(i);
+    }
+
+    m_indexed = true;
+}
+
+void saveUserData::rebuildKeys(long section)
+{
+    KeyIndex &index = m_keys[static_cast<size_t>(section)];
+    const DataSection &s = store[section];
+    index.keys.clear();
+    index.keys.reserve(static_cast<int>(s.data.size()));
+    index.entries = static_cast<size_t>(s.data.size());
+    for(long i = 0; i < static_cast<long>(s.data.size()); i++)
+    {
+        if(index.keys.find(s.data[i].key) == index.keys.end())
+            index.keys[s.data[i].key] = i;
+    }
+}
+
+const saveUserData::KeyIndex *saveUserData::keyIndex(long section) const
+{
+    if(!m_indexed || sectionsStale())
+        return nullptr;
+    const KeyIndex &index = m_keys[static_cast<size_t>(section)];
+    if(index.entries != static_cast<size_t>(store[section].data.size()))
+        return nullptr;
+    return &index;
+}
+
+void saveUserData::syncIndex(long section)
+{
+    if(!m_indexed)
+        return;
+    if(sectionsStale())
+        rebuildIndex();
+    else if(m_keys[static_cast<size_t>(section)].entries != static_cast<size_t>(store[section].data.size()))
+        rebuildKeys(section);
+}
+
+void saveUserData::updateIndex()
+{
+    if(!m_indexed)
+        return;
+    if(sectionsStale())
+    {
+        rebuildIndex();
+        return;
+    }
+    for(long i = 0; i < static_cast<long>(store.size()); i++)
+    {
+        if(m_keys[static_cast<size_t>(i)].entries != static_cast<size_t>(store[i].data.size()))
+            rebuildKeys(i);
+    }
+}
+
+void saveUserData::disableIndex()
+{
+    m_sections.clear();
+    m_keys.clear();
+    m_indexed = false;
+}
+
+long saveUserData::findSection(int location, const PGESTRING &location_name, const PGESTRING &name) const
+{
+    if(m_indexed && !sectionsStale())
+    {
+        auto it = m_sections.find(userDataSectionId(location, location_name, name));
+        if(it == m_sections.end())
+            return -1;
+        long i = PGEMAPVAL(it);
+        if(i < static_cast<long>(store.size()))
+        {
+            const DataSection &s = store[i];
+            if(s.location == location && s.location_name == location_name && s.name == name)
+                return i;
+        }
+        // Section was changed in place, the index is stale
+    }
+
+    for(long i = 0; i < static_cast<long>(store.size()); i++)
+    {
+        const DataSection &s = store[i];
+        if(s.location == location && s.location_name == location_name && s.name == name)
+            return i;
+    }
+
+    return -1;
+}
+
+long saveUserData::addSection(int location, const PGESTRING &location_name, const PGESTRING &name)
+{
+    long i = findSection(location, location_name, name);
+    if(i >= 0)
+        return i;
+
+    if(m_indexed && sectionsStale())
+        rebuildIndex();
+
+    DataSection s;
+    s.location = location;
+    s.location_name = location_name;
+    s.name = name;
+    store.push_back(std::move(s));
+
+    i = static_cast<long>(store.size()) - 1;
+    if(m_indexed)
+    {
+        m_sections[userDataSectionId(location, location_name, name)] = i;
+        m_keys.emplace_back();
+    }
+
+    return i;
+}
+
+bool saveUserData::removeSection(long section)
+{
+    if(section < 0 || section >= static_cast<long>(store.size()))
+        return false;
+
+    if(m_indexed && sectionsStale())
+        rebuildIndex();
+
+    DataSection removed = std::move(store[section]);
+    store.erase(store.begin() + section);
+
+    if(m_indexed)
+    {
+        m_keys.erase(m_keys.begin() + section);
+        auto removedIt = m_sections.find(userDataSectionId(removed.location, removed.location_name, removed.name));
+        if(removedIt != m_sections.end() && PGEMAPVAL(removedIt) == section)
+            m_sections.erase(removedIt);
+        // Shift indices of next sections, the next duplicate takes the place of removed one
+        for(long i = section; i < static_cast<long>(store.size()); i++)
+        {
+            const DataSection &s = store[i];
+            PGESTRING id = userDataSectionId(s.location, s.location_name, s.name);
+            auto it = m_sections.find(id);
+            if(it == m_sections.end())
+                m_sections[id] = i;
+            else if(PGEMAPVAL(it) == i + 1)
+                PGEMAPVAL(it) = i;
+        }
+    }
+
+    return true;
+}
+
+long saveUserData::findKey(long section, const PGESTRING &key) const
+{
+    if(section < 0 || section >= static_cast<long>(store.size()))
+        return -1;
+
+    const DataSection &s = store[section];
+    const KeyIndex *index = keyIndex(section);
+    if(index)
+    {
+        auto it = index->keys.find(key);
+        if(it == index->keys.end())
+            return -1;
+        long i = PGEMAPVAL(it);
+        if(i < static_cast<long>(s.data.size()) && s.data[i].key == key)
+            return i;
+        // Entry was changed in place, the index is stale
+    }
+
+    for(long i = 0; i < static_cast<long>(s.data.size()); i++)
+    {
+        if(s.data[i].key == key)
+            return i;
+    }
+
+    return -1;
+}
+
+const PGESTRING *saveUserData::value(long section, const PGESTRING &key) const
+{
+    long i = findKey(section, key);
+    return (i < 0) ? nullptr : &store[section].data[i].value;
+}
+
+void saveUserData::setValue(long section, const PGESTRING &key, const PGESTRING &value)
+{
+    if(section < 0 || section >= static_cast<long>(store.size()))
+        return;
+
+    syncIndex(section);
+    DataSection &s = store[section];
+    long i = findKey(section, key);
+    if(i >= 0)
+    {
+        s.data[i].value = value;
+        return;
+    }
+
+    DataEntry e;
+    e.key = key;
+    e.value = value;
+    s.data.push_back(std::move(e));
+
+    if(m_indexed)
+    {
+        KeyIndex &index = m_keys[static_cast<size_t>(section)];
+        index.keys[key] = static_cast<long>(s.data.size()) - 1;
+        index.entries++;
+    }
+}
+
+bool saveUserData::removeValue(long section, const PGESTRING &key)
+{
+    if(section < 0 || section >= static_cast<long>(store.size()))
+        return false;
+
+    syncIndex(section);
+    long i = findKey(section, key);
+    if(i < 0)
+        return false;
+
+    DataSection &s = store[section];
+    s.data.erase(s.data.begin() + i);
+
+    if(m_indexed)
+    {
+        KeyIndex &index = m_keys[static_cast<size_t>(section)];
+        PGEHASH<PGESTRING, long> &keys = index.keys;
+        auto removedIt = keys.find(key);
+        if(removedIt != keys.end() && PGEMAPVAL(removedIt) == i)
+            keys.erase(removedIt);
+        index.entries--;
+        // Shift indices of next entries, the next duplicate takes the place of removed one
+        for(long j = i; j < static_cast<long>(s.data.size()); j++)
+        {
+            auto it = keys.find(s.data[j].key);
+            if(it == keys.end())
+                keys[s.data[j].key] = j;
+            else if(PGEMAPVAL(it) == j + 1)
+                PGEMAPVAL(it) = j;
+        }
+    }
+
+    return true;
+}
+
+
 //*********************************************************
 //****************Sctructure initalizers*******************
 //*********************************************************
@@ -37,12 +37,169 @@
 
 #include "pge_file_lib_globs.h"
 #include "meta_filedata.h"
+#include <vector>
 
 //! Game Save specific Visible element entry <array-id, is-vizible>
 typedef PGEPAIR<unsigned int, bool > visibleItem;
 //! Game Save specific gotten star entry <Level-Filename, Section-ID(SMBX64-Standard, one star per section) or NPC-ArrayID (PGE-X, multiple stars per section)>
 typedef PGEPAIR<PGESTRING, int > starOnLevel;
 
+/*!
+ * \brief Array-ID lookup of visible states of world map elements
+ *
+ * Keeps a dense table of list indices keyed by Array-ID, too large Array-IDs
+ * are kept in a hash. The map is disabled by default, while it's disabled,
+ * functions are scanning the list. Once it's built with rebuild(), changes
+ * of the list should be done by set() and erase() to keep the map fast.
+ * After direct changes, the map is found stale by the size of the list or by
+ * the found entry, and functions are scanning the list until update().
+ * Array-IDs changed in place to ones which aren't in the map, or entries
+ * added and removed without changing the size of the list need rebuild().
+ */
+class VisibleItemsMap
+{
+public:
+    /*!
+     * \brief Is map built and maintained
+     */
+    bool isEnabled() const
+    {
+        return m_enabled;
+    }
+    /*!
+     * \brief Clears the map and stops it's maintenance
+     */
+    void disable();
+    /*!
+     * \brief Enables the map and fills it from the list
+     * \param list List of visible states
+     */
+    void rebuild(const PGELIST<visibleItem> &list);
+    /*!
+     * \brief Rebuilds the enabled map if it went stale after direct changes of the list
+     * \param list List of visible states
+     */
+    void update(const PGELIST<visibleItem> &list);
+
+    /*!
+     * \brief Finds the entry of element
+     * \param list List of visible states
+     * \param arrayId Array-ID of the element
+     * \return Index of entry in the list or -1 if not found
+     */
+    long find(const PGELIST<visibleItem> &list, unsigned int arrayId) const;
+    /*!
+     * \brief Is element visible
+     * \param list List of visible states
+     * \param arrayId Array-ID of the element
+     * \return true if the entry of element exists and is visible
+     */
+    bool isVisible(const PGELIST<visibleItem> &list, unsigned int arrayId) const;
+    /*!
+     * \brief Sets the visible state of element, new entry gets appended to the end of list
+     * \param list List of visible states
+     * \param arrayId Array-ID of the element
+     * \param visible Visible state
+     */
+    void set(PGELIST<visibleItem> &list, unsigned int arrayId, bool visible);
+    /*!
+     * \brief Removes the entry of element from the list
+     * \param list List of visible states
+     * \param arrayId Array-ID of the element
+     * \return true if entry was found and removed
+     */
+    bool erase(PGELIST<visibleItem> &list, unsigned int arrayId);
+
+private:
+    //! Stores the index of entry, keeping the first of duplicated entries
+    void store(unsigned int arrayId, long index);
+    //! Updates indices after removal of entry from the list
+    void shift(const PGELIST<visibleItem> &list, long removed);
+    //! Index of entry stored in the map, or -1
+    long lookup(unsigned int arrayId) const;
+
+    bool m_enabled = false;
+    //! Number of entries of the list the map was made for
+    size_t m_entries = 0;
+    //! Index of entry + 1 per Array-ID, zero if not exists
+    std::vector<unsigned int> m_dense;
+    //! Indices of entries with Array-IDs out of dense table
+    PGEHASH<unsigned int, long> m_sparse;
+};
+
+/*!
+ * \brief Lookup of gotten stars by level file name and section or NPC Array-ID
+ *
+ * Disabled by default, while it's disabled, functions are scanning the list.
+ * Once it's built with rebuild(), changes of the list should be done by
+ * insert() and erase() to keep the map fast, after direct changes functions
+ * are scanning the list until update(), like VisibleItemsMap does.
+ */
+class GottenStarsMap
+{
+public:
+    /*!
+     * \brief Is map built and maintained
+     */
+    bool isEnabled() const
+    {
+        return m_enabled;
+    }
+    /*!
+     * \brief Clears the map and stops it's maintenance
+     */
+    void disable();
+    /*!
+     * \brief Enables the map and fills it from the list
+     * \param list List of gotten stars
+     */
+    void rebuild(const PGELIST<starOnLevel> &list);
+    /*!
+     * \brief Rebuilds the enabled map if it went stale after direct changes of the list
+     * \param list List of gotten stars
+     */
+    void update(const PGELIST<starOnLevel> &list);
+
+    /*!
+     * \brief Finds the star
+     * \param list List of gotten stars
+     * \param star Level file name and section or NPC Array-ID
+     * \return Index of star in the list or -1 if not found
+     */
+    long find(const PGELIST<starOnLevel> &list, const starOnLevel &star) const;
+    /*!
+     * \brief Was star gotten
+     * \param list List of gotten stars
+     * \param star Level file name and section or NPC Array-ID
+     * \return true if star is in the list
+     */
+    bool contains(const PGELIST<starOnLevel> &list, const starOnLevel &star) const
+    {
+        return find(list, star) >= 0;
+    }
+    /*!
+     * \brief Appends the star to the end of list if it's not here yet
+     * \param list List of gotten stars
+     * \param star Level file name and section or NPC Array-ID
+     * \return true if star was added
+     */
+    bool insert(PGELIST<starOnLevel> &list, const starOnLevel &star);
+    /*!
+     * \brief Removes the star from the list
+     * \param list List of gotten stars
+     * \param star Level file name and section or NPC Array-ID
+     * \return true if star was found and removed
+     */
+    bool erase(PGELIST<starOnLevel> &list, const starOnLevel &star);
+
+private:
+    bool m_enabled = false;
+    //! Number of stars of the list the map was made for
+    size_t m_entries = 0;
+    //! Index of star in the list per level file name and section
+    PGEHASH<PGESTRING, long> m_map;
+};
+
 /*!
  * \brief Recent state of each playable character
  */
@@ -105,6 +262,115 @@ struct saveUserData
     };
     //! Data store
     PGELIST<DataSection> store;
+
+    /*!
+     * \brief Builds the lookup index of sections and keys and enables it's maintenance
+     *
+     * The index is built by the game save reader. Functions below keep it
+     * in sync. After direct modifications of the store, lookups find the
+     * index stale by the count of sections or entries, or by the found
+     * entry, and scan the store until the index is updated. Renames made
+     * in place to names which aren't in the index, or sections and entries
+     * added and removed without changing their count need rebuildIndex().
+     * When the index is disabled, functions below are scanning the store.
+     */
+    void rebuildIndex();
+    /*!
+     * \brief Rebuilds parts of the lookup index which went stale after direct modifications of the store
+     */
+    void updateIndex();
+    /*!
+     * \brief Clears the lookup index and stops it's maintenance
+     */
+    void disableIndex();
+    /*!
+     * \brief Is lookup index built and maintained
+     */
+    bool isIndexed() const
+    {
+        return m_indexed;
+    }
+
+    /*!
+     * \brief Finds the data section
+     * \param location Type of data location
+     * \param location_name Name of data location
+     * \param name Name of data section
+     * \return Index of section in the store or -1 if not found
+     */
+    long findSection(int location, const PGESTRING &location_name, const PGESTRING &name) const;
+    /*!
+     * \brief Finds the data section, or appends the new empty one to the end of store
+     * \param location Type of data location
+     * \param location_name Name of data location
+     * \param name Name of data section
+     * \return Index of section in the store
+     */
+    long addSection(int location, const PGESTRING &location_name, const PGESTRING &name);
+    /*!
+     * \brief Removes the data section with all it's entries
+     * \param section Index of section in the store
+     * \return true if section was removed
+     */
+    bool removeSection(long section);
+
+    /*!
+     * \brief Finds the data entry in the section
+     * \param section Index of section in the store
+     * \param key Key of data entry
+     * \return Index of entry in the section or -1 if not found
+     */
+    long findKey(long section, const PGESTRING &key) const;
+    /*!
+     * \brief Gets the value of data entry
+     * \param section Index of section in the store
+     * \param key Key of data entry
+     * \return Pointer to the value, or null if there is no such entry
+     */
+    const PGESTRING *value(long section, const PGESTRING &key) const;
+    /*!
+     * \brief Sets the value of data entry, new entry gets appended to the end of section
+     * \param section Index of section in the store
+     * \param key Key of data entry
+     * \param value Value to set
+     */
+    void setValue(long section, const PGESTRING &key, const PGESTRING &value);
+    /*!
+     * \brief Removes the data entry from the section
+     * \param section Index of section in the store
+     * \param key Key of data entry
+     * \return true if entry was removed
+     */
+    bool removeValue(long section, const PGESTRING &key);
+
+private:
+    //! Key index of one section
+    struct KeyIndex
+    {
+        //! Key to entry index
+        PGEHASH<PGESTRING, long> keys;
+        //! Number of entries of the section the index was made for
+        size_t entries = 0;
+    };
+
+    //! Rebuilds the key index of one section
+    void rebuildKeys(long section);
+    //! Key index of the section, or null if it's disabled or stale
+    const KeyIndex *keyIndex(long section) const;
+    //! Were sections added or removed without updating the index
+    bool sectionsStale() const
+    {
+        return m_keys.size() != static_cast<size_t>(store.size());
+    }
+    //! Updates the stale index before the change of the section
+    void syncIndex(long section);
+
+    //! Is lookup index built
+    bool m_indexed = false;
+    //! Section identity to the section index
+    PGEHASH<PGESTRING, long> m_sections;
+    //! Key index for each section of the store
+    std::vector<KeyIndex> m_keys;
 };
 
 
@@ -152,6 +418,26 @@ struct GamesaveData
     PGELIST<visibleItem > visiblePaths;
     PGELIST<visibleItem > visibleScenery;
     PGELIST<starOnLevel > gottenStars;
+
+    /*
+     * Lookup maps of visible states and stars (disabled until buildLookupMaps() call)
+     */
+    VisibleItemsMap visibleLevels_map;
+    VisibleItemsMap visiblePaths_map;
+    VisibleItemsMap visibleScenery_map;
+    GottenStarsMap  gottenStars_map;
+
+    /*!
+     * \brief Enables and fills lookup maps of visible states, stars and user data
+     *
+     * Game save readers are calling this after the file got read.
+     */
+    void buildLookupMaps();
+
+    //! Number of journal records applied over this state, tracked to compact the PGE-X game save file
+    unsigned long journalRecords = 0;
+    //! The file ends with the journal section cut by an interrupted append, the next append rewrites the file
+    bool journalTruncated = false;
 };
 
 #endif // SAVE_FILEDATA_H
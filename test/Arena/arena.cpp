@@ -0,0 +1,136 @@
+#include <catch.hpp>
+#include <cstdint>
+#include "pge_arena.h"
+#include "file_formats.h"
+#include "pge_memory_usage.h"
+#include "synthetic_data.h"
+
+TEST_CASE("[Arena] Monotonic allocation")
+{
+    PGE_Arena arena(1024);
+    REQUIRE(arena.bytesReserved() == 0);
+
+    void *a = arena.allocate(3, 1);
+    void *b = arena.allocate(8, 8);
+    REQUIRE(a != nullptr);
+    REQUIRE(reinterpret_cast<uintptr_t>(b) % 8 == 0);
+    REQUIRE(arena.allocationsCount() == 2);
+    REQUIRE(arena.bytesReserved() == 1024);
+
+    // The most recent allocation gets rolled back
+    arena.deallocate(b, 8);
+    void *c = arena.allocate(8, 8);
+    REQUIRE(c == b);
+
+    // Older ones are kept until release
+    arena.deallocate(a, 3);
+    REQUIRE(arena.allocate(1, 1) != a);
+
+    // Big allocations get their own block
+    void *big = arena.allocate(4096, 16);
+    REQUIRE(big != nullptr);
+    REQUIRE(arena.bytesReserved() >= 1024 + 4096);
+
+    size_t reserved = arena.bytesReserved();
+    arena.rewind();
+    REQUIRE(arena.bytesUsed() == 0);
+    REQUIRE(arena.bytesReserved() == reserved);
+    REQUIRE(arena.allocate(8, 8) == a); // First block is reused from the beginning
+
+    arena.release();
+    REQUIRE(arena.bytesReserved() == 0);
+    REQUIRE(arena.bytesUsed() == 0);
+}
+
+TEST_CASE("[Arena] Allocator and scopes")
+{
+    PGE_Arena arena;
+    REQUIRE(PGE_Arena::current() == nullptr);
+
+    PGE_ArenaList<int> heapList;
+    {
+        PGE_ArenaScope scope(&arena);
+        REQUIRE(PGE_Arena::current() == &arena);
+
+        PGE_ArenaList<int> list;
+        for(int i = 0; i < 1000; i++)
+            list.push_back(i);
+        REQUIRE(list.get_allocator().arena() == &arena);
+        REQUIRE(arena.bytesUsed() >= 1000 * sizeof(int));
+
+        {
+            PGE_ArenaScope inner(nullptr);
+            PGE_ArenaList<int> copy(list);
+            REQUIRE(copy.get_allocator().arena() == nullptr);
+            REQUIRE(copy == list);
+        }
+        REQUIRE(PGE_Arena::current() == &arena);
+
+        // Moved lists keep the memory of the arena
+        heapList = std::move(list);
+        REQUIRE(heapList.get_allocator().arena() == &arena);
+        heapList = PGE_ArenaList<int>(PGE_ArenaAllocator<int>(nullptr));
+    }
+    REQUIRE(PGE_Arena::current() == nullptr);
+    REQUIRE(heapList.get_allocator().arena() == nullptr);
+}
+
+#ifdef PGE_FILES_ARENA
+TEST_CASE("[Arena] Loading the level into the arena")
+{
+    const PGESTRING path = "../old_deep_tests/PGEFileLib_test_files/pgex/Sky Tower.lvlx";
+    LevelData heap;
+    REQUIRE(FileFormats::OpenLevelFile(path, heap));
+
+    PGE_Arena arena;
+    PGESTRING a, b;
+    {
+        PGE_ArenaScope scope(&arena);
+        LevelData lvl;
+        REQUIRE(FileFormats::OpenLevelFile(path, lvl));
+        REQUIRE(lvl.blocks.get_allocator().arena() == &arena);
+        REQUIRE(lvl.events.get_allocator().arena() == &arena);
+        REQUIRE(arena.bytesUsed() >= lvl.blocks.size() * sizeof(LevelBlock));
+        REQUIRE(FileFormats::WriteExtendedLvlFileRaw(lvl, a));
+    }
+    REQUIRE(FileFormats::WriteExtendedLvlFileRaw(heap, b));
+    REQUIRE(a == b);
+    arena.release();
+}
+
+/*
+ * The arena must hold not much more than the element lists of the loaded
+ * level: parser temporaries and buffers left behind by the growth of lists
+ * must not pile up in it.
+ */
+static void checkArenaOverhead(FileFormats::LevelFileFormat format)
+{
+    SyntheticData::LevelConfig cfg = SyntheticData::LevelConfig::scaled(50000);
+    LevelData src = SyntheticData::makeLevel(cfg);
+    PGESTRING raw;
+    REQUIRE(FileFormats::SaveLevelData(src, raw, format));
+
+    PGE_Arena arena;
+    {
+        PGE_ArenaScope scope(&arena);
+        LevelData lvl;
+        REQUIRE(FileFormats::OpenLevelRaw(raw, "arena.lvl", lvl));
+        REQUIRE(lvl.blocks.size() == src.blocks.size());
+        REQUIRE(lvl.blocks.get_allocator().arena() == &arena);
+
+        const size_t elements = PGE_MemoryUsage::ofLevel(lvl).elementBytes();
+        INFO("format " << static_cast<int>(format) << ": arena holds " << arena.bytesUsed()
+             << " bytes in " << arena.allocationsCount() << " allocations, elements take "
+             << elements << " bytes");
+        REQUIRE(arena.bytesUsed() <= elements + elements / 10);
+    }
+    arena.release();
+}
+
+TEST_CASE("[Arena] Arena overhead of loaded levels")
+{
+    checkArenaOverhead(FileFormats::LVL_PGEX);
+    checkArenaOverhead(FileFormats::LVL_SMBX64);
+    checkArenaOverhead(FileFormats::LVL_SMBX38A);
+}
+#endif
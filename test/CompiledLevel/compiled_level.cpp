@@ -0,0 +1,127 @@
+#include <catch.hpp>
+#include "file_formats.h"
+#include "compiled_level.h"
+
+#include <cstring>
+#include <vector>
+
+static PGESTRING tempPath(const char *name)
+{
+    return PGESTRING(TEST_TEMP_DIR) + "/" + name;
+}
+
+static void checkView(const LevelData &lvl, const CompiledLevelView &v)
+{
+    REQUIRE(v.isValid());
+    REQUIRE(PGESTRING(v.string(v.levelName())) == lvl.LevelName);
+    REQUIRE(v.stars() == lvl.stars);
+    REQUIRE(v.sectionsCount() == lvl.sections.size());
+    REQUIRE(v.layersCount() == lvl.layers.size());
+    REQUIRE(v.eventsCount() == lvl.events.size());
+
+    const CompiledLevelBlocks &b = v.blocks();
+    REQUIRE(b.count == lvl.blocks.size());
+    for(uint32_t i = 0; i < b.count; i++)
+    {
+        const LevelBlock &o = lvl.blocks[i];
+        REQUIRE(b.x[i] == o.x);
+        REQUIRE(b.y[i] == o.y);
+        REQUIRE(b.id[i] == o.id);
+        REQUIRE(b.layer[i] >= CompiledLevel::NONE);
+        if(b.layer[i] != CompiledLevel::NONE)
+            REQUIRE(PGESTRING(v.string(v.layers()[b.layer[i]].name)) == o.layer);
+    }
+
+    const CompiledLevelBGOs &bg = v.bgo();
+    REQUIRE(bg.count == lvl.bgo.size());
+    for(uint32_t i = 0; i < bg.count; i++)
+        REQUIRE(bg.x[i] == lvl.bgo[i].x);
+
+    const CompiledLevelNPCs &n = v.npc();
+    REQUIRE(n.count == lvl.npc.size());
+    for(uint32_t i = 0; i < n.count; i++)
+    {
+        REQUIRE(n.id[i] == lvl.npc[i].id);
+        REQUIRE(PGESTRING(v.string(n.msg[i])) == lvl.npc[i].msg);
+    }
+
+    const CompiledLevelDoors &d = v.doors();
+    REQUIRE(d.count == lvl.doors.size());
+    for(uint32_t i = 0; i < d.count; i++)
+        REQUIRE(PGESTRING(v.string(d.levelName[i])) == lvl.doors[i].lname);
+
+    REQUIRE(v.physez().count == lvl.physez.size());
+
+    for(uint32_t i = 0; i < v.eventsCount(); i++)
+    {
+        const CompiledLevelEvent &e = v.events()[i];
+        REQUIRE(PGESTRING(v.string(e.name)) == lvl.events[i].name);
+        REQUIRE(e.layersHideCount == lvl.events[i].layers_hide.size());
+        REQUIRE(e.setsCount == lvl.events[i].sets.size());
+    }
+}
+
+static void checkLevel(const PGESTRING &path)
+{
+    LevelData lvl;
+    REQUIRE(FileFormats::OpenLevelFile(path, lvl));
+    REQUIRE(lvl.meta.ReadFileValid);
+
+    std::string image;
+    REQUIRE(CompiledLevel::build(lvl, image));
+
+    // Keep the image aligned as it would be in the mapped file
+    std::vector<uint64_t> aligned((image.size() + 7) / 8);
+    std::memcpy(aligned.data(), image.data(), image.size());
+
+    CompiledLevelView view;
+    REQUIRE(view.open(aligned.data(), image.size()));
+    checkView(lvl, view);
+
+    // Truncated image must be rejected
+    CompiledLevelView broken;
+    REQUIRE(!broken.open(aligned.data(), image.size() - 1));
+    REQUIRE(!broken.isValid());
+
+    // Damaged chunks table must be rejected
+    reinterpret_cast<uint32_t*>(aligned.data())[6] += 1;
+    REQUIRE(!broken.open(aligned.data(), image.size()));
+}
+
+TEST_CASE("[CompiledLevel] Build and view")
+{
+    checkLevel("../LevelLoad/sample.lvl");
+    checkLevel("../old_deep_tests/PGEFileLib_test_files/pgex/Sky Tower.lvlx");
+    checkLevel("../old_deep_tests/PGEFileLib_test_files/smbx38a/1-1.lvl");
+}
+
+TEST_CASE("[CompiledLevel] Mapped file")
+{
+    LevelData lvl;
+    REQUIRE(FileFormats::OpenLevelFile("../LevelLoad/sample.lvl", lvl));
+
+    PGESTRING path = tempPath("sample.lvlc");
+    REQUIRE(CompiledLevel::buildFile(lvl, path));
+
+    CompiledLevelFile f;
+    REQUIRE(f.open(path));
+    checkView(lvl, f.view());
+    f.close();
+    REQUIRE(!f.view().isValid());
+
+    REQUIRE(!f.open("../LevelLoad/sample.lvl"));
+    REQUIRE(!f.open(tempPath("not-exists.lvlc")));
+}
+
+TEST_CASE("[CompiledLevel] Out of range values")
+{
+    LevelData lvl = FileFormats::CreateLevelData();
+    LevelBlock b = FileFormats::CreateLvlBlock();
+    b.x = 0x100000000LL;
+    lvl.blocks.push_back(b);
+
+    std::string image;
+    PGESTRING err;
+    REQUIRE(!CompiledLevel::build(lvl, image, &err));
+    REQUIRE(!err.empty());
+}
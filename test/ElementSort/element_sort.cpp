@@ -0,0 +1,187 @@
+#include <catch.hpp>
+#include "file_formats.h"
+
+#include <algorithm>
+
+static unsigned int s_seed = 777;
+
+static long rnd(long range)
+{
+    s_seed = s_seed * 1103515245u + 12345u;
+    return static_cast<long>((s_seed >> 8) % static_cast<unsigned int>(range));
+}
+
+static LevelData makeLevel(size_t count, long range)
+{
+    LevelData lvl = FileFormats::CreateLevelData();
+    for(size_t i = 0; i < count; i++)
+    {
+        LevelBlock b = FileFormats::CreateLvlBlock();
+        b.x = (rnd(range) - range / 2) * 32;
+        b.y = (rnd(range) - range / 2) * 32;
+        b.id = static_cast<unsigned long>(i);
+        b.meta.array_id = lvl.blocks_array_id++;
+        lvl.blocks.push_back(b);
+
+        LevelBGO g = FileFormats::CreateLvlBgo();
+        g.id = static_cast<unsigned long>(i);
+        g.smbx64_sp_apply = rnd(5) * 25 - 25;
+        g.z_offset = static_cast<double>(rnd(7) - 3) * 0.5;
+        g.meta.array_id = lvl.bgo_array_id++;
+        lvl.bgo.push_back(g);
+    }
+    return lvl;
+}
+
+static bool blockLess(const LevelBlock &a, const LevelBlock &b)
+{
+    if(a.x != b.x)
+        return a.x < b.x;
+    if(a.y != b.y)
+        return a.y < b.y;
+    return a.meta.array_id < b.meta.array_id;
+}
+
+static bool bgoLess(const LevelBGO &a, const LevelBGO &b)
+{
+    if(a.smbx64_sp_apply != b.smbx64_sp_apply)
+        return a.smbx64_sp_apply < b.smbx64_sp_apply;
+    return a.meta.array_id < b.meta.array_id;
+}
+
+static bool smbx2BgoLess(const LevelBGO &a, const LevelBGO &b)
+{
+    if(a.smbx64_sp_apply != b.smbx64_sp_apply)
+        return a.smbx64_sp_apply < b.smbx64_sp_apply;
+    if(a.z_offset != b.z_offset)
+        return a.z_offset < b.z_offset;
+    return a.meta.array_id < b.meta.array_id;
+}
+
+template<class T>
+static std::vector<unsigned long> ids(const PGELIST<T> &arr)
+{
+    std::vector<unsigned long> out;
+    for(const T &e : arr)
+        out.push_back(static_cast<unsigned long>(e.id));
+    return out;
+}
+
+static void checkLevelSorts(LevelData lvl)
+{
+    LevelData ref = lvl;
+
+    std::stable_sort(ref.blocks.begin(), ref.blocks.end(), blockLess);
+    FileFormats::smbx64LevelSortBlocks(lvl);
+    REQUIRE(ids(lvl.blocks) == ids(ref.blocks));
+
+    std::stable_sort(ref.bgo.begin(), ref.bgo.end(), bgoLess);
+    FileFormats::smbx64LevelSortBGOs(lvl);
+    REQUIRE(ids(lvl.bgo) == ids(ref.bgo));
+
+    std::stable_sort(ref.bgo.begin(), ref.bgo.end(), smbx2BgoLess);
+    FileFormats::smbx2bLevelSortBGOs(lvl);
+    REQUIRE(ids(lvl.bgo) == ids(ref.bgo));
+
+    FileFormats::arrayIdLevelSortBGOs(lvl);
+    for(size_t i = 1; i < lvl.bgo.size(); i++)
+        REQUIRE(lvl.bgo[i - 1].meta.array_id < lvl.bgo[i].meta.array_id);
+}
+
+TEST_CASE("[ElementSort] Level sorts")
+{
+    checkLevelSorts(makeLevel(0, 10));
+    checkLevelSorts(makeLevel(1, 10));
+    checkLevelSorts(makeLevel(50, 10));    // Small arrays
+    checkLevelSorts(makeLevel(5000, 20));  // Many equal coordinates
+    checkLevelSorts(makeLevel(5000, 100000));
+
+    // Already sorted and reversed input
+    LevelData lvl = makeLevel(3000, 1000);
+    FileFormats::smbx64LevelSortBlocks(lvl);
+    checkLevelSorts(lvl);
+    std::reverse(lvl.blocks.begin(), lvl.blocks.end());
+    std::reverse(lvl.bgo.begin(), lvl.bgo.end());
+    checkLevelSorts(lvl);
+}
+
+TEST_CASE("[ElementSort] Strings survive the sorting")
+{
+    LevelData lvl = makeLevel(500, 50);
+    for(LevelBlock &b : lvl.blocks)
+        b.layer = "Layer " + std::to_string(b.id);
+
+    FileFormats::smbx64LevelSortBlocks(lvl);
+    for(const LevelBlock &b : lvl.blocks)
+        REQUIRE(b.layer == "Layer " + std::to_string(b.id));
+}
+
+TEST_CASE("[ElementSort] World prepare")
+{
+    WorldData wld = FileFormats::CreateWorldData();
+    for(unsigned int i = 0; i < 2000; i++)
+    {
+        WorldTerrainTile t = FileFormats::CreateWldTile();
+        t.id = i;
+        t.meta.array_id = static_cast<unsigned int>(rnd(100000));
+        wld.tiles.push_back(t);
+
+        WorldLevelTile l = FileFormats::CreateWldLevel();
+        l.meta.array_id = 2000 - i;
+        wld.levels.push_back(l);
+    }
+
+    WorldData ref = wld;
+    std::stable_sort(ref.tiles.begin(), ref.tiles.end(), [](const WorldTerrainTile &a, const WorldTerrainTile &b)
+    {
+        return a.meta.array_id < b.meta.array_id;
+    });
+
+    FileFormats::WorldPrepare(wld);
+    REQUIRE(ids(wld.tiles) == ids(ref.tiles));
+    for(size_t i = 1; i < wld.levels.size(); i++)
+        REQUIRE(wld.levels[i - 1].meta.array_id < wld.levels[i].meta.array_id);
+}
+
+TEST_CASE("[ElementSort] Array-ID maps")
+{
+    LevelData lvl = makeLevel(1000, 50);
+    REQUIRE(!lvl.blocks_arrayid_map.isEnabled());
+    REQUIRE(lvl.blocks_arrayid_map.find(1) == -1);
+
+    lvl.buildArrayIdMaps();
+    REQUIRE(lvl.blocks_arrayid_map.isEnabled());
+
+    // Maps follow the sorting
+    FileFormats::smbx64LevelSortBlocks(lvl);
+    FileFormats::smbx64LevelSortBGOs(lvl);
+    for(size_t i = 0; i < lvl.blocks.size(); i++)
+        REQUIRE(lvl.blocks_arrayid_map.find(lvl.blocks[i].meta.array_id) == static_cast<long>(i));
+    for(size_t i = 0; i < lvl.bgo.size(); i++)
+        REQUIRE(lvl.bgo_arrayid_map.find(lvl.bgo[i].meta.array_id) == static_cast<long>(i));
+
+    // Append and erase
+    LevelBlock b = FileFormats::CreateLvlBlock();
+    b.meta.array_id = lvl.blocks_array_id++;
+    lvl.blocks_arrayid_map.append(lvl.blocks, b);
+    REQUIRE(lvl.blocks_arrayid_map.find(b.meta.array_id) == static_cast<long>(lvl.blocks.size() - 1));
+
+    const unsigned int victim = lvl.blocks[10].meta.array_id;
+    REQUIRE(lvl.blocks_arrayid_map.erase(lvl.blocks, victim));
+    REQUIRE(!lvl.blocks_arrayid_map.erase(lvl.blocks, victim));
+    REQUIRE(lvl.blocks_arrayid_map.find(victim) == -1);
+    for(size_t i = 0; i < lvl.blocks.size(); i++)
+        REQUIRE(lvl.blocks_arrayid_map.find(lvl.blocks[i].meta.array_id) == static_cast<long>(i));
+
+    // Internal events are added into enabled maps
+    FileFormats::LevelAddInternalEvents(lvl);
+    for(size_t i = 0; i < lvl.events.size(); i++)
+        REQUIRE(lvl.events_arrayid_map.find(lvl.events[i].meta.array_id) == static_cast<long>(i));
+
+    // Erase works without the map too
+    LevelData plain = makeLevel(10, 10);
+    const unsigned int id = plain.blocks[3].meta.array_id;
+    REQUIRE(plain.blocks_arrayid_map.erase(plain.blocks, id));
+    REQUIRE(plain.blocks.size() == 9);
+    REQUIRE(!plain.blocks_arrayid_map.isEnabled());
+}
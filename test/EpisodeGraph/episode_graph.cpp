@@ -0,0 +1,86 @@
+#include <catch.hpp>
+#include "file_formats.h"
+#include "episode_graph.h"
+
+#include <cstdio>
+
+static PGESTRING tempPath(const char *name)
+{
+    return PGESTRING(TEST_TEMP_DIR) + "/" + name;
+}
+
+static void addWarp(LevelData &lvl, const PGESTRING &target)
+{
+    LevelDoor door = FileFormats::CreateLvlWarp();
+    door.isSetIn = true;
+    door.isSetOut = true;
+    door.lname = target;
+    door.meta.array_id = lvl.doors_array_id++;
+    lvl.doors.push_back(door);
+}
+
+TEST_CASE("[EpisodeGraph] Crawl episode")
+{
+    WorldData wld = FileFormats::CreateWorldData();
+    wld.IntroLevel_file = "intro.lvlx";
+    {
+        WorldLevelTile t = FileFormats::CreateWldLevel();
+        t.lvlfile = "hub.lvlx";
+        t.meta.array_id = wld.level_array_id++;
+        wld.levels.push_back(t);
+    }
+    REQUIRE(FileFormats::WriteExtendedWldFileF(tempPath("world.wldx"), wld));
+
+    LevelData intro = FileFormats::CreateLevelData();
+    REQUIRE(FileFormats::WriteExtendedLvlFileF(tempPath("intro.lvlx"), intro));
+
+    LevelData hub = FileFormats::CreateLevelData();
+    hub.open_level_on_fail = "hub.lvlx";
+    addWarp(hub, "castle.lvl");
+    addWarp(hub, "house.lvlx");
+    addWarp(hub, "house.lvlx");
+    REQUIRE(FileFormats::WriteExtendedLvlFileF(tempPath("hub.lvlx"), hub));
+
+    LevelData house = FileFormats::CreateLevelData();
+    addWarp(house, "hub.lvlx");
+    REQUIRE(FileFormats::WriteExtendedLvlFileF(tempPath("house.lvlx"), house));
+
+    LevelData castle = FileFormats::CreateLevelData();
+    addWarp(castle, "hub.lvlx");
+    REQUIRE(FileFormats::WriteSMBX64LvlFileF(tempPath("castle.lvl"), castle));
+
+    EpisodeGraph graph;
+    REQUIRE(graph.crawl(tempPath("world.wldx")) == 5);
+    REQUIRE(graph.size() == 5);
+
+    PGESTRINGList next = graph.likelyNext(tempPath("world.wldx"));
+    REQUIRE(next.size() == 2);
+    REQUIRE(next[0] == EpisodeGraph::normalizePath(tempPath("intro.lvlx")));
+    REQUIRE(next[1] == EpisodeGraph::normalizePath(tempPath("hub.lvlx")));
+
+    next = graph.likelyNext(tempPath("hub.lvlx"));
+    REQUIRE(next.size() == 2);
+    REQUIRE(next[0] == EpisodeGraph::normalizePath(tempPath("house.lvlx")));
+    REQUIRE(next[1] == EpisodeGraph::normalizePath(tempPath("castle.lvl")));
+
+    next = graph.likelyNext(tempPath("castle.lvl"), 1);
+    REQUIRE(next.size() == 1);
+    REQUIRE(next[0] == EpisodeGraph::normalizePath(tempPath("hub.lvlx")));
+
+    EpisodeGraph shallow;
+    REQUIRE(shallow.crawl(tempPath("world.wldx"), 1) == 3);
+    REQUIRE(!shallow.contains(tempPath("house.lvlx")));
+
+    const char *files[] = {"world.wldx", "intro.lvlx", "hub.lvlx", "house.lvlx", "castle.lvl"};
+    for(const char *f : files)
+        std::remove(tempPath(f).c_str());
+}
+
+TEST_CASE("[EpisodeGraph] Missing file")
+{
+    EpisodeGraph graph;
+    REQUIRE(!graph.addLevel("not-existing-file.lvlx"));
+    REQUIRE(graph.contains("not-existing-file.lvlx"));
+    REQUIRE(!graph.node("not-existing-file.lvlx")->valid);
+    REQUIRE(graph.likelyNext("not-existing-file.lvlx").empty());
+}
@@ -0,0 +1,110 @@
+#include <catch.hpp>
+#include "file_formats.h"
+#include "file_cache.h"
+
+#include <thread>
+#include <vector>
+#include <cstdio>
+
+
+TEST_CASE("[FileCache] Repeated open")
+{
+    FileFormatsCache cache;
+
+    FileFormatsCache::LevelHandle a = cache.openLevel("../LevelLoad/sample.lvl");
+    FileFormatsCache::LevelHandle b = cache.openLevel("../LevelLoad/sample.lvl");
+
+    REQUIRE(a);
+    REQUIRE(a->meta.ReadFileValid);
+    REQUIRE(a == b);
+
+    FileFormatsCache::Stats st = cache.stats();
+    REQUIRE(st.misses == 1);
+    REQUIRE(st.hits == 1);
+    REQUIRE(st.entries == 1);
+    REQUIRE(st.memoryUsage > 0);
+
+    cache.invalidate("../LevelLoad/sample.lvl");
+    FileFormatsCache::LevelHandle c = cache.openLevel("../LevelLoad/sample.lvl");
+    REQUIRE(c != a);
+    REQUIRE(c->blocks.size() == a->blocks.size());
+}
+
+TEST_CASE("[FileCache] Broken files are not cached")
+{
+    FileFormatsCache cache;
+
+    FileFormatsCache::LevelHandle a = cache.openLevel("not-existing-file.lvl");
+    REQUIRE(a);
+    REQUIRE(!a->meta.ReadFileValid);
+    REQUIRE(cache.stats().entries == 0);
+}
+
+TEST_CASE("[FileCache] Changed file is re-parsed")
+{
+    const PGESTRING path = PGESTRING(TEST_TEMP_DIR) + "/cache_test.lvlx";
+    LevelData lvl = FileFormats::CreateLevelData();
+    lvl.LevelName = "First";
+    REQUIRE(FileFormats::WriteExtendedLvlFileF(path, lvl));
+
+    FileFormatsCache cache;
+    FileFormatsCache::LevelHandle a = cache.openLevel(path);
+    REQUIRE(a->LevelName == "First");
+
+    lvl.LevelName = "Second, and longer";
+    REQUIRE(FileFormats::WriteExtendedLvlFileF(path, lvl));
+
+    FileFormatsCache::LevelHandle b = cache.openLevel(path);
+    REQUIRE(b->LevelName == "Second, and longer");
+    REQUIRE(a->LevelName == "First"); // Old handle stays alive and unchanged
+    REQUIRE(cache.stats().entries == 1);
+
+    std::remove(path.c_str());
+}
+
+TEST_CASE("[FileCache] Memory budget")
+{
+    FileFormatsCache cache(0);
+
+    FileFormatsCache::LevelHandle a = cache.openLevel("../LevelLoad/sample.lvl");
+    REQUIRE(a->meta.ReadFileValid);
+    REQUIRE(cache.stats().entries == 0);
+    REQUIRE(cache.stats().evictions == 1);
+
+    cache.setMemoryBudget(64 * 1024 * 1024);
+    cache.openLevel("../LevelLoad/sample.lvl");
+    REQUIRE(cache.stats().entries == 1);
+
+    cache.setMemoryBudget(1);
+    REQUIRE(cache.stats().entries == 0);
+    REQUIRE(cache.stats().memoryUsage == 0);
+}
+
+TEST_CASE("[FileCache] Concurrent access")
+{
+    FileFormatsCache cache;
+    std::vector<std::thread> threads;
+    std::vector<FileFormatsCache::LevelHandle> results(8);
+
+    for(size_t i = 0; i < results.size(); i++)
+    {
+        threads.emplace_back([&cache, &results, i]()
+        {
+            for(int j = 0; j < 20; j++)
+                results[i] = cache.openLevel("../LevelLoad/sample.lvl");
+        });
+    }
+
+    for(auto &t : threads)
+        t.join();
+
+    for(auto &r : results)
+    {
+        REQUIRE(r);
+        REQUIRE(r->meta.ReadFileValid);
+    }
+
+    FileFormatsCache::Stats st = cache.stats();
+    REQUIRE(st.entries == 1);
+    REQUIRE(st.hits + st.misses == 160);
+}
@@ -153,3 +153,137 @@ TEST_CASE("[UserData] Save and Load data with volatile entry")
     REQUIRE(COMPARE_FIELD(userData.store[2].data[1].value));
 #undef COMPARE_FIELD
 }
+
+
+TEST_CASE("[UserData] Indexed lookup")
+{
+    PGESTRING rawData;
+    GamesaveData origin = FileFormats::CreateGameSaveData();
+    GamesaveData target;
+    saveUserData &u = origin.userData;
+
+    REQUIRE(!u.isIndexed());
+    long world = u.addSection(saveUserData::DATA_WORLD, "", "default");
+    u.setValue(world, "kek", "12345");
+    u.setValue(world, "i am", "goblin!");
+    REQUIRE(u.findSection(saveUserData::DATA_WORLD, "", "default") == world);
+
+    u.rebuildIndex();
+    REQUIRE(u.isIndexed());
+
+    long level = u.addSection(saveUserData::DATA_LEVEL, "Random universe.lvlx", "default");
+    long math = u.addSection(saveUserData::DATA_LEVEL, "Random universe.lvlx", "Math");
+    REQUIRE(level == 1);
+    REQUIRE(math == 2);
+    REQUIRE(u.addSection(saveUserData::DATA_LEVEL, "Random universe.lvlx", "default") == level);
+    REQUIRE(u.findSection(saveUserData::DATA_LEVEL, "", "default") == -1);
+
+    for(int i = 0; i < 1000; i++)
+        u.setValue(level, "key" + std::to_string(i), std::to_string(i));
+    u.setValue(math, "x=", "12+3/y == kek");
+    u.setValue(world, "kek", "54321");
+
+    REQUIRE(*u.value(world, "kek") == "54321");
+    REQUIRE(*u.value(level, "key500") == "500");
+    REQUIRE(u.value(level, "key1000") == nullptr);
+    REQUIRE(u.value(-1, "kek") == nullptr);
+
+    REQUIRE(u.removeValue(level, "key0"));
+    REQUIRE(!u.removeValue(level, "key0"));
+    REQUIRE(u.findKey(level, "key1") == 0);
+    REQUIRE(u.findKey(level, "key999") == 998);
+
+    REQUIRE(u.removeSection(world));
+    level = u.findSection(saveUserData::DATA_LEVEL, "Random universe.lvlx", "default");
+    math = u.findSection(saveUserData::DATA_LEVEL, "Random universe.lvlx", "Math");
+    REQUIRE(level == 0);
+    REQUIRE(math == 1);
+    REQUIRE(u.findSection(saveUserData::DATA_WORLD, "", "default") == -1);
+    REQUIRE(*u.value(math, "x=") == "12+3/y == kek");
+
+    // Order of sections and keys is kept by the writer
+    REQUIRE(FileFormats::WriteExtendedSaveFileRaw(origin, rawData));
+    REQUIRE(FileFormats::ReadExtendedSaveFileRaw(rawData, "fakePath.savx", target));
+    REQUIRE(target.userData.isIndexed());
+    REQUIRE(target.userData.store.size() == 2);
+    REQUIRE(target.userData.store[0].data.size() == 999);
+    REQUIRE(target.userData.store[0].data[0].key == "key1");
+    REQUIRE(target.userData.store[0].data[998].key == "key999");
+    REQUIRE(target.userData.store[1].name == "Math");
+    REQUIRE(*target.userData.value(0, "key42") == "42");
+    REQUIRE(target.userData.findKey(1, "x=") == 0);
+}
+
+TEST_CASE("[UserData] Duplicated keys")
+{
+    saveUserData u;
+    saveUserData::DataSection ds;
+    ds.name = "default";
+    ds.data.push_back({"a", "1"});
+    ds.data.push_back({"b", "2"});
+    ds.data.push_back({"a", "3"});
+    u.store.push_back(ds);
+    u.store.push_back(ds);
+    u.rebuildIndex();
+
+    // The first one is found, like by the scan
+    REQUIRE(u.findSection(saveUserData::DATA_WORLD, "", "default") == 0);
+    REQUIRE(*u.value(0, "a") == "1");
+    REQUIRE(u.removeValue(0, "a"));
+    REQUIRE(*u.value(0, "a") == "3");
+    REQUIRE(u.findKey(0, "b") == 0);
+
+    REQUIRE(u.removeSection(0));
+    REQUIRE(u.findSection(saveUserData::DATA_WORLD, "", "default") == 0);
+    REQUIRE(*u.value(0, "a") == "1");
+
+    u.disableIndex();
+    REQUIRE(!u.isIndexed());
+    REQUIRE(u.findKey(0, "b") == 1);
+}
+
+TEST_CASE("[UserData] Direct modification of indexed store")
+{
+    PGESTRING rawData;
+    GamesaveData origin = FileFormats::CreateGameSaveData();
+    GamesaveData saved, target;
+
+    long world = origin.userData.addSection(saveUserData::DATA_WORLD, "", "default");
+    origin.userData.setValue(world, "kek", "12345");
+    REQUIRE(FileFormats::WriteExtendedSaveFileRaw(origin, rawData));
+    REQUIRE(FileFormats::ReadExtendedSaveFileRaw(rawData, "fakePath.savx", saved));
+    REQUIRE(saved.userData.isIndexed());
+
+    GamesaveData state = saved;
+    saveUserData &u = state.userData;
+
+    saveUserData::DataSection ds;
+    ds.location = saveUserData::DATA_LEVEL;
+    ds.location_name = "kek.lvlx";
+    ds.name = "Math";
+    ds.data.push_back({"x", "1"});
+    u.store.push_back(ds);
+    u.store[0].data.push_back({"lol", "2"});
+    u.store[0].data[0].key = "kek2";
+
+    // The stale index isn't used
+    REQUIRE(u.findSection(saveUserData::DATA_LEVEL, "kek.lvlx", "Math") == 1);
+    REQUIRE(*u.value(1, "x") == "1");
+    REQUIRE(*u.value(0, "lol") == "2");
+    REQUIRE(u.findKey(0, "kek") == -1);
+    REQUIRE(*u.value(0, "kek2") == "12345");
+
+    u.setValue(1, "y", "3");
+    REQUIRE(u.findKey(1, "y") == 1);
+    REQUIRE(*u.value(0, "lol") == "2");
+
+    u.store[1].data.push_back({"z", "4"});
+    REQUIRE(FileFormats::AppendExtendedSaveJournalRaw(saved, state, rawData));
+    REQUIRE(FileFormats::ReadExtendedSaveFileRaw(rawData, "fakePath.savx", target));
+    REQUIRE(target.userData.store.size() == 2);
+    REQUIRE(*target.userData.value(0, "kek2") == "12345");
+    REQUIRE(target.userData.findKey(0, "kek") == -1);
+    REQUIRE(*target.userData.value(0, "lol") == "2");
+    REQUIRE(*target.userData.value(1, "y") == "3");
+    REQUIRE(*target.userData.value(1, "z") == "4");
+}
@@ -0,0 +1,90 @@
+#include <catch.hpp>
+#include "file_formats.h"
+#include "level_layer_index.h"
+
+#include <algorithm>
+
+static std::vector<unsigned int> scanBlocks(const LevelData &lvl, const PGESTRING &layer)
+{
+    std::vector<unsigned int> out;
+    for(const LevelBlock &b : lvl.blocks)
+    {
+        if(b.layer == layer)
+            out.push_back(b.meta.array_id);
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+static std::vector<unsigned int> sorted(std::vector<unsigned int> v)
+{
+    std::sort(v.begin(), v.end());
+    return v;
+}
+
+TEST_CASE("[LevelLayerIndex] Build from level")
+{
+    LevelData lvl;
+    REQUIRE(FileFormats::OpenLevelFile("../LevelLoad/sample.lvl", lvl));
+    REQUIRE(lvl.meta.ReadFileValid);
+
+    LevelLayerIndex index;
+    index.build(lvl);
+    REQUIRE(index.size() == static_cast<size_t>(lvl.blocks.size() + lvl.bgo.size() + lvl.npc.size() +
+                                                lvl.doors.size() + lvl.physez.size()));
+
+    for(const LevelLayer &l : lvl.layers)
+        REQUIRE(sorted(index.members(l.name, LevelLayerIndex::MEMBER_BLOCK)) == scanBlocks(lvl, l.name));
+}
+
+TEST_CASE("[LevelLayerIndex] Incremental changes")
+{
+    LevelData lvl = FileFormats::CreateLevelData();
+    for(unsigned int i = 1; i <= 100; i++)
+    {
+        LevelBlock b = FileFormats::CreateLvlBlock();
+        b.layer = (i % 3 == 0) ? "Three" : ((i % 2 == 0) ? "Two" : "Default");
+        b.meta.array_id = i;
+        lvl.blocks.push_back(b);
+    }
+
+    LevelLayerIndex index;
+    index.build(lvl);
+    REQUIRE(sorted(index.members("Three", LevelLayerIndex::MEMBER_BLOCK)) == scanBlocks(lvl, "Three"));
+    REQUIRE(!index.add(LevelLayerIndex::MEMBER_BLOCK, 1, "Two"));
+
+    // Move some blocks into another layer
+    for(unsigned int i = 3; i <= 100; i += 9)
+    {
+        REQUIRE(index.setLayer(LevelLayerIndex::MEMBER_BLOCK, i, "Moved"));
+        lvl.blocks[i - 1].layer = "Moved";
+    }
+    REQUIRE(sorted(index.members("Three", LevelLayerIndex::MEMBER_BLOCK)) == scanBlocks(lvl, "Three"));
+    REQUIRE(sorted(index.members("Moved", LevelLayerIndex::MEMBER_BLOCK)) == scanBlocks(lvl, "Moved"));
+
+    PGESTRING layer;
+    REQUIRE(index.layerOf(LevelLayerIndex::MEMBER_BLOCK, 12, layer));
+    REQUIRE(layer == "Moved");
+
+    // Remove
+    REQUIRE(index.remove(LevelLayerIndex::MEMBER_BLOCK, 6));
+    REQUIRE(!index.remove(LevelLayerIndex::MEMBER_BLOCK, 6));
+    REQUIRE(!index.layerOf(LevelLayerIndex::MEMBER_BLOCK, 6, layer));
+    lvl.blocks.erase(lvl.blocks.begin() + 5);
+    REQUIRE(sorted(index.members("Three", LevelLayerIndex::MEMBER_BLOCK)) == scanBlocks(lvl, "Three"));
+
+    // Rename and merge
+    const size_t merged = index.membersCount("Moved") + index.membersCount("Three");
+    REQUIRE(index.renameLayer("Moved", "Three"));
+    REQUIRE(index.membersCount("Moved") == 0);
+    REQUIRE(index.membersCount("Three") == merged);
+    REQUIRE(index.layerOf(LevelLayerIndex::MEMBER_BLOCK, 12, layer));
+    REQUIRE(layer == "Three");
+    REQUIRE(index.remove(LevelLayerIndex::MEMBER_BLOCK, 12));
+    REQUIRE(index.membersCount("Three") == merged - 1);
+
+    REQUIRE(index.renameLayer("Two", "Second"));
+    REQUIRE(index.members("Two", LevelLayerIndex::MEMBER_BLOCK).empty());
+    REQUIRE(sorted(index.members("Second", LevelLayerIndex::MEMBER_BLOCK)) == scanBlocks(lvl, "Two"));
+    REQUIRE(!index.renameLayer("Two", "Other"));
+}
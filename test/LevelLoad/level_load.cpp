@@ -1,6 +1,10 @@
 #include <catch.hpp>
 #include "file_formats.h"
 
+#include <algorithm>
+#include <chrono>
+#include <string>
+
 
 TEST_CASE("[LevelFile] Load")
 {
@@ -12,3 +16,144 @@ TEST_CASE("[LevelFile] Load")
     REQUIRE(res);
     REQUIRE(lvl.meta.ReadFileValid);
 }
+
+static void checkBinaryRoundTrip(const PGESTRING &path)
+{
+    LevelData lvl, restored;
+    PGESTRING textOrig, textRestored;
+    std::string blob;
+    uint64_t hash = 0;
+
+    REQUIRE(FileFormats::OpenLevelFile(path, lvl));
+    REQUIRE(FileFormats::WriteLevelBinary(lvl, blob, 0x1234));
+    REQUIRE(FileFormats::ReadLevelBinary(blob, restored, &hash));
+    REQUIRE(hash == 0x1234);
+    REQUIRE(restored.meta.ReadFileValid);
+
+    REQUIRE(FileFormats::WriteExtendedLvlFileRaw(lvl, textOrig));
+    REQUIRE(FileFormats::WriteExtendedLvlFileRaw(restored, textRestored));
+    REQUIRE(textOrig == textRestored);
+
+    // Damaged blob must be rejected
+    blob[blob.size() / 2] ^= 0x55;
+    REQUIRE(!FileFormats::ReadLevelBinary(blob, restored));
+    REQUIRE(!restored.meta.ReadFileValid);
+}
+
+TEST_CASE("[LevelFile] Binary round trip")
+{
+    checkBinaryRoundTrip("sample.lvl");
+    checkBinaryRoundTrip("../old_deep_tests/PGEFileLib_test_files/pgex/Sky Tower.lvlx");
+    checkBinaryRoundTrip("../old_deep_tests/PGEFileLib_test_files/smbx38a/1-1.lvl");
+}
+
+TEST_CASE("[LevelFile] Binary cache directory")
+{
+    const PGESTRING cacheDir = TEST_TEMP_DIR;
+    LevelData plain, first, second;
+
+    REQUIRE(FileFormats::OpenLevelFile("sample.lvl", plain));
+
+    FileFormats::SetLevelCacheDirectory(cacheDir);
+    REQUIRE(FileFormats::OpenLevelFile("sample.lvl", first));  // Miss, stores the entry
+    REQUIRE(FileFormats::OpenLevelFile("sample.lvl", second)); // Hit
+    FileFormats::SetLevelCacheDirectory(PGESTRING());
+
+    REQUIRE(second.meta.RecentFormat == plain.meta.RecentFormat);
+    REQUIRE(second.meta.filename == plain.meta.filename);
+
+    PGESTRING a, b;
+    REQUIRE(FileFormats::WriteExtendedLvlFileRaw(plain, a));
+    REQUIRE(FileFormats::WriteExtendedLvlFileRaw(second, b));
+    REQUIRE(a == b);
+}
+
+TEST_CASE("[LevelFile] Binary cache miss merges meta-data")
+{
+    const PGESTRING cacheDir = TEST_TEMP_DIR;
+    const PGESTRING path = cacheDir + "/cache_miss.lvlx";
+    LevelData src = FileFormats::CreateLevelData();
+    // Unique title makes sure the cache has no entry for this file yet
+    const std::string stamp = std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+    src.LevelName = PGESTRING("Cache miss ") + stamp.c_str();
+    REQUIRE(FileFormats::WriteExtendedLvlFileF(path, src));
+
+    MetaData meta;
+    Bookmark bm;
+    bm.bookmarkName = "Start";
+    bm.x = 64;
+    bm.y = 32;
+    meta.bookmarks.push_back(bm);
+    REQUIRE(FileFormats::WriteNonSMBX64MetaDataF(path + ".meta", meta));
+
+    LevelData plain, cached;
+    REQUIRE(FileFormats::OpenLevelFile(path, plain));
+    FileFormats::SetLevelCacheDirectory(cacheDir);
+    REQUIRE(FileFormats::OpenLevelFile(path, cached)); // Miss
+    FileFormats::SetLevelCacheDirectory(PGESTRING());
+
+    REQUIRE(cached.LevelName == src.LevelName);
+    REQUIRE(cached.meta.filename == plain.meta.filename);
+    REQUIRE(cached.meta.path == plain.meta.path);
+    REQUIRE(cached.metaData.bookmarks.size() == 1);
+    REQUIRE(cached.metaData.bookmarks[0].bookmarkName == "Start");
+}
+
+TEST_CASE("[LevelFile] Resolve references")
+{
+    LevelData lvl;
+
+    FileFormats::SetLevelResolveReferences(true);
+    REQUIRE(FileFormats::OpenLevelFile("sample.lvl", lvl));
+    FileFormats::SetLevelResolveReferences(false);
+
+    REQUIRE(lvl.layers_lookup.size() > 0);
+    REQUIRE(lvl.events_lookup.size() > 0);
+
+    for(const LevelBlock &b : lvl.blocks)
+    {
+        REQUIRE(b.layer_index == lvl.layerIndex(b.layer));
+        if(b.layer_index >= 0)
+            REQUIRE(lvl.layers[b.layer_index].name == b.layer);
+        REQUIRE(b.event_hit_index == (b.event_hit.empty() ? -1 : lvl.eventIndex(b.event_hit)));
+    }
+
+    for(const LevelNPC &n : lvl.npc)
+    {
+        REQUIRE(n.layer_index == lvl.layerIndex(n.layer));
+        if(n.event_die_index >= 0)
+            REQUIRE(lvl.events[n.event_die_index].name == n.event_die);
+    }
+
+    for(const LevelSMBX64Event &e : lvl.events)
+    {
+        REQUIRE(e.layers_hide_index.size() == e.layers_hide.size());
+        REQUIRE(e.layers_show_index.size() == e.layers_show.size());
+        const auto showCount = e.layers_show.size();
+        for(decltype(e.layers_show.size()) i = 0; i < showCount; i++)
+            REQUIRE(e.layers_show_index[i] == lvl.layerIndex(e.layers_show[i]));
+        for(const LevelEvent_MoveLayer &ml : e.moving_layers)
+            REQUIRE(ml.layer_index == lvl.layerIndex(ml.name));
+    }
+
+    // Lookups reflect changes made after resolving
+    LevelData edited = lvl;
+    REQUIRE(!edited.layerIsExist("Renamed"));
+    edited.layers[0].name = "Renamed";
+    REQUIRE(edited.layerIsExist("Renamed"));
+    REQUIRE(edited.layerIndex("Renamed") == 0);
+    LevelSMBX64Event event = FileFormats::CreateLvlEvent();
+    event.name = "Added";
+    edited.events.push_back(event);
+    REQUIRE(edited.eventIsExist("Added"));
+    REQUIRE(edited.eventIndex("Added") == static_cast<int>(edited.events.size()) - 1);
+
+    // Without resolving, the index fields stay unset
+    LevelData plain;
+    REQUIRE(FileFormats::OpenLevelFile("sample.lvl", plain));
+    REQUIRE(plain.layers_lookup.empty());
+    REQUIRE((plain.blocks.empty() || plain.blocks[0].layer_index == -1));
+    REQUIRE(plain.layerIndex("Default") == lvl.layerIndex("Default"));
+    REQUIRE(plain.layerIndex("No such layer") == -1);
+    REQUIRE(lvl.eventIndex("No such event") == -1);
+}
@@ -0,0 +1,126 @@
+#include <catch.hpp>
+#include <thread>
+#include "file_formats.h"
+#include "level_snapshot.h"
+
+static PGESTRING levelText(LevelData lvl)
+{
+    PGESTRING out;
+    FileFormats::WriteExtendedLvlFileRaw(lvl, out);
+    return out;
+}
+
+TEST_CASE("[LevelSnapshot] Structural sharing")
+{
+    LevelData lvl;
+    REQUIRE(FileFormats::OpenLevelFile("../old_deep_tests/PGEFileLib_test_files/pgex/Sky Tower.lvlx", lvl));
+    REQUIRE(!lvl.blocks.empty());
+    REQUIRE(!lvl.bgo.empty());
+
+    const PGESTRING original = levelText(lvl);
+    LevelDataCow cow(lvl);
+    REQUIRE(levelText(cow.toLevelData()) == original);
+    REQUIRE(cow.header().blocks.empty());
+
+    LevelDataSnapshot snap = cow.snapshot();
+    REQUIRE(&snap.blocks() == &cow.blocks());
+    REQUIRE(&snap.bgo() == &cow.bgo());
+    REQUIRE(&snap.header() == &cow.header());
+
+    // The first edit copies the touched collection only
+    cow.edit_blocks()[0].x += 64;
+    cow.edit_blocks().pop_back();
+    REQUIRE(&snap.blocks() != &cow.blocks());
+    REQUIRE(&snap.bgo() == &cow.bgo());
+    REQUIRE(&snap.header() == &cow.header());
+    REQUIRE(snap.blocks().size() == lvl.blocks.size());
+    REQUIRE(snap.blocks()[0].x == lvl.blocks[0].x);
+    REQUIRE(cow.blocks().size() == lvl.blocks.size() - 1);
+
+    // Further edits until the next snapshot happen in-place
+    const PGELIST<LevelBlock> *blocks = &cow.blocks();
+    cow.edit_blocks()[0].y += 32;
+    REQUIRE(&cow.blocks() == blocks);
+
+    cow.editHeader().LevelName = "Renamed";
+    REQUIRE(snap.header().LevelName == lvl.LevelName);
+    REQUIRE(cow.header().LevelName == "Renamed");
+
+    LevelDataSnapshot snap2 = cow.snapshot();
+    REQUIRE(&snap2.blocks() == &cow.blocks());
+    REQUIRE(&snap2.bgo() == &snap.bgo());
+
+    REQUIRE(levelText(snap.toLevelData()) == original);
+    LevelData changed = snap2.toLevelData();
+    REQUIRE(changed.LevelName == "Renamed");
+    REQUIRE(changed.blocks[0].x == lvl.blocks[0].x + 64);
+    REQUIRE(changed.blocks[0].y == lvl.blocks[0].y + 32);
+
+    LevelDataSnapshot empty;
+    REQUIRE(empty.blocks().empty());
+    REQUIRE(empty.sections().empty());
+}
+
+TEST_CASE("[LevelSnapshot] Reading snapshots from another thread")
+{
+    LevelDataCow cow;
+    for(int i = 0; i < 1000; i++)
+    {
+        LevelBlock b = FileFormats::CreateLvlBlock();
+        b.x = i;
+        cow.edit_blocks().push_back(b);
+    }
+
+    LevelDataSnapshot snap = cow.snapshot();
+    long long sum = 0;
+    std::thread reader([snap, &sum]()
+    {
+        for(int pass = 0; pass < 50; pass++)
+        {
+            for(const LevelBlock &b : snap.blocks())
+                sum += b.x;
+        }
+    });
+
+    for(int pass = 0; pass < 50; pass++)
+    {
+        for(LevelBlock &b : cow.edit_blocks())
+            b.x += 1;
+        cow.edit_blocks().push_back(FileFormats::CreateLvlBlock());
+        if(pass % 10 == 0)
+            cow.snapshot();
+    }
+
+    reader.join();
+    REQUIRE(sum == 50LL * (999LL * 1000LL / 2));
+    REQUIRE(cow.blocks().size() == 1050);
+    REQUIRE(cow.blocks()[0].x == 50);
+}
+
+TEST_CASE("[LevelSnapshot] Lookup maps are rebuilt by toLevelData()")
+{
+    LevelData lvl;
+    REQUIRE(FileFormats::OpenLevelFile("../old_deep_tests/PGEFileLib_test_files/pgex/Sky Tower.lvlx", lvl));
+    REQUIRE(lvl.layers.size() > 1);
+    FileFormats::LevelResolveReferences(lvl);
+    lvl.buildArrayIdMaps();
+
+    LevelDataCow cow(lvl);
+    LevelLayer extra = FileFormats::CreateLvlLayer();
+    extra.name = "Added later";
+    extra.meta.array_id = 100000;
+    cow.edit_layers().insert(cow.edit_layers().begin(), extra);
+    cow.edit_blocks().erase(cow.edit_blocks().begin());
+
+    // Header keeps the maps of the original collections
+    REQUIRE(cow.header().layerIndex("Added later") == -1);
+
+    LevelData out = cow.toLevelData();
+    REQUIRE(out.layerIndex("Added later") == 0);
+    REQUIRE(out.layerIndex(lvl.layers[0].name) == 1);
+    REQUIRE(out.layers_arrayid_map.find(100000) == 0);
+    REQUIRE(out.blocks_arrayid_map.find(lvl.blocks[0].meta.array_id) == -1);
+    REQUIRE(out.blocks_arrayid_map.find(lvl.blocks[1].meta.array_id) == 0);
+    if(!out.blocks.empty())
+        REQUIRE(out.blocks[0].layer_index == out.layerIndex(out.blocks[0].layer));
+}
@@ -0,0 +1,107 @@
+#include <catch.hpp>
+#include "file_formats.h"
+#include "level_soa.h"
+
+#include <algorithm>
+
+TEST_CASE("[LevelSoA] Build and sync")
+{
+    LevelData lvl;
+    REQUIRE(FileFormats::OpenLevelFile("../old_deep_tests/PGEFileLib_test_files/pgex/Sky Tower.lvlx", lvl));
+    REQUIRE(lvl.meta.ReadFileValid);
+
+    LevelDataSoA soa;
+    soa.build(lvl);
+    REQUIRE(soa.blocks.size() == static_cast<size_t>(lvl.blocks.size()));
+    REQUIRE(soa.bgo.size() == static_cast<size_t>(lvl.bgo.size()));
+    REQUIRE(soa.npc.size() == static_cast<size_t>(lvl.npc.size()));
+
+    // Bounds must match the plain scan over the element arrays
+    long l, t, r, b;
+    REQUIRE(soa.blocks.bounds(l, t, r, b));
+    long el = lvl.blocks[0].x, et = lvl.blocks[0].y;
+    long er = el + lvl.blocks[0].w, eb = et + lvl.blocks[0].h;
+    for(const LevelBlock &blk : lvl.blocks)
+    {
+        el = std::min(el, blk.x);
+        et = std::min(et, blk.y);
+        er = std::max(er, blk.x + blk.w);
+        eb = std::max(eb, blk.y + blk.h);
+    }
+    REQUIRE(l == el);
+    REQUIRE(t == et);
+    REQUIRE(r == er);
+    REQUIRE(b == eb);
+
+    // Everything is inside the whole bounds
+    std::vector<size_t> sel;
+    REQUIRE(soa.bounds(l, t, r, b));
+    soa.blocks.selectInRect(l, t, r, b, sel);
+    REQUIRE(sel.size() == soa.blocks.size());
+
+    // Sections of the blocks
+    std::vector<int> sections;
+    soa.blocks.classifySections(lvl.sections, sections);
+    REQUIRE(sections.size() == soa.blocks.size());
+    for(size_t i = 0; i < sections.size(); i++)
+    {
+        if(sections[i] < 0)
+            continue;
+        const LevelSection &s = lvl.sections[sections[i]];
+        long cx = soa.blocks.x[i] + soa.blocks.w[i] / 2;
+        REQUIRE(cx >= s.size_left);
+        REQUIRE(cx <= s.size_right);
+    }
+
+    // Move everything and write back
+    for(size_t i = 0; i < soa.blocks.size(); i++)
+        soa.blocks.x[i] += 32;
+    for(size_t i = 0; i < soa.npc.size(); i++)
+        soa.npc.y[i] -= 16;
+
+    LevelData moved = lvl;
+    REQUIRE(soa.syncTo(moved));
+    for(size_t i = 0; i < lvl.blocks.size(); i++)
+        REQUIRE(moved.blocks[i].x == lvl.blocks[i].x + 32);
+    for(size_t i = 0; i < lvl.npc.size(); i++)
+        REQUIRE(moved.npc[i].y == lvl.npc[i].y - 16);
+
+    // Arrays were grown or shrunk since the build
+    LevelData grown = lvl;
+    grown.npc.insert(grown.npc.begin(), FileFormats::CreateLvlNpc());
+    REQUIRE(!soa.syncTo(grown));
+    REQUIRE(grown.npc[1].y == lvl.npc[0].y);
+    moved.blocks.clear();
+    REQUIRE(!soa.syncTo(moved));
+}
+
+TEST_CASE("[LevelSoA] Selection")
+{
+    LevelData lvl = FileFormats::CreateLevelData();
+    for(int i = 0; i < 10; i++)
+    {
+        LevelBlock b = FileFormats::CreateLvlBlock();
+        b.x = i * 32;
+        b.y = 0;
+        b.w = 32;
+        b.h = 32;
+        b.id = 1;
+        lvl.blocks.push_back(b);
+    }
+
+    LevelDataSoA soa;
+    soa.build(lvl);
+
+    std::vector<size_t> sel;
+    soa.blocks.selectInRect(40, 10, 90, 20, sel);
+    REQUIRE(sel.size() == 2);
+    REQUIRE(soa.blocks.index[sel[0]] == 1);
+    REQUIRE(soa.blocks.index[sel[1]] == 2);
+
+    soa.blocks.selectInRect(0, 100, 320, 200, sel);
+    REQUIRE(sel.empty());
+
+    LevelDataSoA empty;
+    long l, t, r, b;
+    REQUIRE(!empty.bounds(l, t, r, b));
+}
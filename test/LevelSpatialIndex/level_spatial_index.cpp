@@ -0,0 +1,161 @@
+#include <catch.hpp>
+#include "file_formats.h"
+#include "level_spatial_index.h"
+
+#include <algorithm>
+#include <map>
+
+typedef std::pair<int, unsigned int> ItemId;
+
+static std::vector<ItemId> sorted(const std::vector<LevelSpatialIndex::Item> &items)
+{
+    std::vector<ItemId> out;
+    for(const LevelSpatialIndex::Item &i : items)
+        out.push_back(ItemId(i.type, i.arrayId));
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+static std::vector<ItemId> bruteForce(const std::map<ItemId, LevelSpatialIndex::Rect> &items,
+                                      long l, long t, long r, long b)
+{
+    std::vector<ItemId> out;
+    for(const auto &i : items)
+    {
+        const LevelSpatialIndex::Rect &e = i.second;
+        if(e.left < r && e.right > l && e.top < b && e.bottom > t)
+            out.push_back(i.first);
+    }
+    return out;
+}
+
+static void checkBackend(LevelSpatialIndex::Backend backend)
+{
+    LevelSpatialIndex index(backend, 64);
+    std::map<ItemId, LevelSpatialIndex::Rect> model;
+    unsigned int seed = 12345;
+    auto rnd = [&seed](long range) -> long
+    {
+        seed = seed * 1103515245u + 12345u;
+        return static_cast<long>((seed >> 8) % static_cast<unsigned int>(range));
+    };
+
+    for(unsigned int i = 1; i <= 2000; i++)
+    {
+        int type = static_cast<int>(rnd(6));
+        long x = rnd(8000) - 4000, y = rnd(8000) - 4000, w = rnd(200) + 1, h = rnd(200) + 1;
+        REQUIRE(index.insert(type, i, x, y, w, h));
+        model[ItemId(type, i)] = {x, y, x + w, y + h};
+    }
+
+    REQUIRE(!index.insert(model.begin()->first.first, model.begin()->first.second, 0, 0, 1, 1));
+    REQUIRE(index.size() == model.size());
+
+    for(int step = 0; step < 1500; step++)
+    {
+        auto it = model.begin();
+        std::advance(it, rnd(static_cast<long>(model.size())));
+        if(step % 3 == 0)
+        {
+            REQUIRE(index.remove(it->first.first, it->first.second));
+            REQUIRE(!index.contains(it->first.first, it->first.second));
+            model.erase(it);
+        }
+        else
+        {
+            long x = rnd(8000) - 4000, y = rnd(8000) - 4000, w = rnd(300) + 1, h = rnd(300) + 1;
+            REQUIRE(index.move(it->first.first, it->first.second, x, y, w, h));
+            it->second = {x, y, x + w, y + h};
+        }
+    }
+
+    REQUIRE(index.size() == model.size());
+    REQUIRE(!index.remove(100, 1));
+
+    std::vector<LevelSpatialIndex::Item> found;
+    for(int q = 0; q < 200; q++)
+    {
+        long l = rnd(9000) - 4500, t = rnd(9000) - 4500;
+        long r = l + rnd(1000) + 1, b = t + rnd(1000) + 1;
+        index.queryRect(l, t, r, b, found);
+        REQUIRE(sorted(found) == bruteForce(model, l, t, r, b));
+
+        index.queryPoint(l, t, found);
+        REQUIRE(sorted(found) == bruteForce(model, l, t, l + 1, t + 1));
+    }
+
+    // Query larger than the whole populated area
+    index.queryRect(-100000, -100000, 100000, 100000, found);
+    REQUIRE(found.size() == model.size());
+
+    index.clear();
+    index.queryRect(-100000, -100000, 100000, 100000, found);
+    REQUIRE(found.empty());
+}
+
+TEST_CASE("[LevelSpatialIndex] Grid")
+{
+    checkBackend(LevelSpatialIndex::BACKEND_GRID);
+}
+
+TEST_CASE("[LevelSpatialIndex] R-tree")
+{
+    checkBackend(LevelSpatialIndex::BACKEND_RTREE);
+}
+
+TEST_CASE("[LevelSpatialIndex] Build from level")
+{
+    LevelData lvl;
+    REQUIRE(FileFormats::OpenLevelFile("../old_deep_tests/PGEFileLib_test_files/pgex/Sky Tower.lvlx", lvl));
+    REQUIRE(lvl.meta.ReadFileValid);
+
+    LevelSpatialIndex grid(LevelSpatialIndex::BACKEND_GRID);
+    LevelSpatialIndex rtree(LevelSpatialIndex::BACKEND_RTREE);
+    grid.build(lvl);
+    rtree.build(lvl);
+    REQUIRE(grid.size() == rtree.size());
+    REQUIRE(grid.size() >= static_cast<size_t>(lvl.blocks.size()));
+
+    REQUIRE(!lvl.blocks.empty());
+    const LevelBlock &b = lvl.blocks[0];
+    std::vector<LevelSpatialIndex::Item> a, c;
+    grid.queryPoint(b.x, b.y, a);
+    rtree.queryPoint(b.x, b.y, c);
+    std::vector<ItemId> here = sorted(a);
+    REQUIRE(here == sorted(c));
+    REQUIRE(std::find(here.begin(), here.end(),
+                      ItemId(LevelSpatialIndex::ITEM_BLOCK, b.meta.array_id)) != here.end());
+}
+
+TEST_CASE("[LevelSpatialIndex] Huge elements")
+{
+    LevelSpatialIndex index(LevelSpatialIndex::BACKEND_GRID, 64);
+    std::map<ItemId, LevelSpatialIndex::Rect> model;
+
+    // Section-wide zone covers about a million cells, it must be kept aside
+    REQUIRE(index.insert(LevelSpatialIndex::ITEM_PHYSENV, 1, -200000, -200000, 400000, 200000));
+    model[ItemId(LevelSpatialIndex::ITEM_PHYSENV, 1)] = {-200000, -200000, 200000, 0};
+    REQUIRE(index.insert(LevelSpatialIndex::ITEM_BLOCK, 2, 0, 0, 32, 32));
+    model[ItemId(LevelSpatialIndex::ITEM_BLOCK, 2)] = {0, 0, 32, 32};
+
+    std::vector<LevelSpatialIndex::Item> found;
+    index.queryPoint(-150000, -100, found);
+    REQUIRE(sorted(found) == bruteForce(model, -150000, -100, -149999, -99));
+    index.queryRect(-10, -10, 10, 10, found);
+    REQUIRE(sorted(found) == bruteForce(model, -10, -10, 10, 10));
+
+    // Moving between the grid and the aside list
+    REQUIRE(index.move(LevelSpatialIndex::ITEM_PHYSENV, 1, 100, 100, 64, 64));
+    model[ItemId(LevelSpatialIndex::ITEM_PHYSENV, 1)] = {100, 100, 164, 164};
+    REQUIRE(index.move(LevelSpatialIndex::ITEM_BLOCK, 2, 0, 0, 1000000, 64));
+    model[ItemId(LevelSpatialIndex::ITEM_BLOCK, 2)] = {0, 0, 1000000, 64};
+    index.queryRect(-1000, -1000, 1000, 1000, found);
+    REQUIRE(sorted(found) == bruteForce(model, -1000, -1000, 1000, 1000));
+    index.queryPoint(-150000, -100, found);
+    REQUIRE(found.empty());
+
+    REQUIRE(index.remove(LevelSpatialIndex::ITEM_BLOCK, 2));
+    index.queryPoint(500000, 10, found);
+    REQUIRE(found.empty());
+    REQUIRE(index.size() == 1);
+}
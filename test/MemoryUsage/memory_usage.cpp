@@ -0,0 +1,73 @@
+#include <catch.hpp>
+#include "pge_memory_usage.h"
+#include "file_formats.h"
+
+static size_t entriesSum(const PGE_MemoryUsage &u)
+{
+    size_t out = 0;
+    for(const auto &e : u.entries)
+        out += e.total();
+    return out;
+}
+
+TEST_CASE("[MemoryUsage] Level")
+{
+    LevelData lvl;
+    REQUIRE(FileFormats::OpenLevelFile("../old_deep_tests/PGEFileLib_test_files/pgex/Sky Tower.lvlx", lvl));
+    REQUIRE(!lvl.blocks.empty());
+
+    PGE_MemoryUsage u = PGE_MemoryUsage::ofLevel(lvl);
+    const PGE_MemoryUsage::Entry *blocks = u.find("blocks");
+    REQUIRE(blocks != nullptr);
+    REQUIRE(blocks->count == static_cast<size_t>(lvl.blocks.size()));
+    REQUIRE(blocks->elementBytes >= lvl.blocks.size() * sizeof(LevelBlock));
+    REQUIRE(u.find("no-such-entry") == nullptr);
+    REQUIRE(u.total() == entriesSum(u));
+    REQUIRE(u.total() == u.elementBytes() + u.stringBytes());
+
+    // Long strings are stored at the heap and must be counted
+    const size_t before = u.find("events")->stringBytes;
+    lvl.events[0].msg = PGESTRING(1000, 'x');
+    PGE_MemoryUsage after = PGE_MemoryUsage::ofLevel(lvl);
+    REQUIRE(after.find("events")->stringBytes >= before + 1000);
+    REQUIRE(after.find("blocks")->total() == blocks->total());
+
+    // Array-ID maps take memory when they are built
+    REQUIRE(u.find("arrayid_maps")->count == 0);
+    lvl.blocks_arrayid_map.rebuild(lvl.blocks);
+    after = PGE_MemoryUsage::ofLevel(lvl);
+    REQUIRE(after.find("arrayid_maps")->count == static_cast<size_t>(lvl.blocks.size()));
+    REQUIRE(after.find("arrayid_maps")->elementBytes >= lvl.blocks.size() * sizeof(long) + u.find("arrayid_maps")->elementBytes);
+}
+
+TEST_CASE("[MemoryUsage] World")
+{
+    WorldData wld;
+    REQUIRE(FileFormats::OpenWorldFile("../old_deep_tests/PGEFilelib_STL_test/test.wldx", wld));
+
+    PGE_MemoryUsage u = PGE_MemoryUsage::ofWorld(wld);
+    REQUIRE(u.find("tiles")->count == static_cast<size_t>(wld.tiles.size()));
+    REQUIRE(u.find("levels")->count == static_cast<size_t>(wld.levels.size()));
+    REQUIRE(u.find("tiles")->elementBytes >= wld.tiles.size() * sizeof(WorldTerrainTile));
+    REQUIRE(u.total() == entriesSum(u));
+}
+
+TEST_CASE("[MemoryUsage] Game save and NPC config")
+{
+    GamesaveData sav = FileFormats::CreateGameSaveData();
+    for(int i = 0; i < 100; i++)
+        sav.gottenStars.push_back(starOnLevel("a_very_long_level_file_name_to_avoid_small_strings.lvlx", i));
+
+    PGE_MemoryUsage u = PGE_MemoryUsage::ofGamesave(sav);
+    REQUIRE(u.find("gottenStars")->count == 100);
+    REQUIRE(u.find("gottenStars")->stringBytes >= 100 * 50);
+    REQUIRE(u.total() == entriesSum(u));
+
+    NPCConfigFile npc = FileFormats::CreateEmpytNpcTXT();
+    PGESTRING raw = "gfxwidth=32\nname=A long name of NPC which is out of small string buffer\n";
+    REQUIRE(FileFormats::ReadNpcTXTFileRAW(raw, npc));
+    u = PGE_MemoryUsage::ofNpcConfig(npc);
+    REQUIRE(u.find("entries")->count == static_cast<size_t>(npc.entries.size()));
+    REQUIRE(u.find("header")->stringBytes > 0);
+    REQUIRE(u.total() == entriesSum(u));
+}
@@ -0,0 +1,192 @@
+#include <catch.hpp>
+#include <string>
+#include <cstdio>
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+#include "npc_config_set.h"
+#include "file_formats.h"
+
+static const std::string s_folder = std::string(TEST_TEMP_DIR) + "/npc_folder";
+static const std::string s_snapshot = std::string(TEST_TEMP_DIR) + "/npc_folder.cache";
+
+static void writeText(const std::string &path, const std::string &text)
+{
+    REQUIRE(PGE_FileFormats_misc::writeBinaryFile(path, text));
+}
+
+static std::string configText(unsigned long id)
+{
+    std::string out;
+    out += "gfxwidth=" + std::to_string(32 + id % 16) + "\n";
+    out += "frames=" + std::to_string(1 + id % 4) + "\n";
+    out += "nogravity=" + std::to_string(id % 2) + "\n";
+    out += "name=\"NPC number " + std::to_string(id) + "\"\n";
+    if(id % 10 == 0)
+        out += "custom-flag=" + std::to_string(id) + "\n";
+    return out;
+}
+
+static std::string dump(const NPCConfigSet &set)
+{
+    std::string out;
+    for(unsigned long id = 0; id <= set.maxId(); id++)
+    {
+        const NPCConfigFile *c = set.get(id);
+        if(!c)
+            continue;
+        NPCConfigFile copy = *c;
+        PGESTRING raw;
+        REQUIRE(FileFormats::WriteNPCTxtFileRaw(copy, raw));
+        out += std::to_string(id) + ":" + raw + c->unknownLines;
+    }
+    return out;
+}
+
+TEST_CASE("[NpcConfigSet] Folder load and snapshot")
+{
+    const unsigned long count = 300;
+
+    for(unsigned long id = 1; id <= count; id++)
+        writeText(s_folder + "/npc-" + std::to_string(id) + ".txt", configText(id));
+    // Files which are not NPC configs
+    writeText(s_folder + "/npc-abc.txt", "gfxwidth=1\n");
+    writeText(s_folder + "/block-1.txt", "width=1\n");
+    writeText(s_folder + "/npc-5.txt.bak", "width=1\n");
+    writeText(s_folder + "/npc-0.txt", "width=1\n");
+    std::remove(s_snapshot.c_str());
+
+    NPCConfigSet set;
+    REQUIRE(set.loadFolder(s_folder, 4));
+    REQUIRE(!set.loadedFromSnapshot());
+    REQUIRE(set.size() == count);
+    REQUIRE(set.maxId() == count);
+    REQUIRE(set.get(0) == nullptr);
+    REQUIRE(set.get(count + 1) == nullptr);
+
+    for(unsigned long id = 1; id <= count; id++)
+    {
+        const NPCConfigFile *c = set.get(id);
+        REQUIRE(c != nullptr);
+        REQUIRE(c->en_gfxwidth);
+        REQUIRE(c->gfxwidth == 32 + id % 16);
+        REQUIRE(c->frames == 1 + id % 4);
+        REQUIRE(c->nogravity == (id % 2 != 0));
+        REQUIRE(c->name == "NPC number " + std::to_string(id));
+    }
+
+    const NPCConfigSet::MergedEntries &merged = set.mergedEntries();
+    REQUIRE(merged.size() == 1);
+    REQUIRE(merged.begin()->first == "custom-flag");
+    REQUIRE(merged.begin()->second.size() == count / 10);
+    REQUIRE(merged.begin()->second.at(120) == "120");
+
+    // Serial load gives the same result
+    NPCConfigSet serial;
+    REQUIRE(serial.loadFolder(s_folder, 1));
+    const std::string reference = dump(set);
+    REQUIRE(dump(serial) == reference);
+
+    // First cached load makes the snapshot, second one uses it
+    NPCConfigSet cached;
+    REQUIRE(cached.loadFolderCached(s_folder, s_snapshot));
+    REQUIRE(!cached.loadedFromSnapshot());
+    REQUIRE(cached.loadFolderCached(s_folder, s_snapshot));
+    REQUIRE(cached.loadedFromSnapshot());
+    REQUIRE(cached.isUpToDate());
+    REQUIRE(cached.size() == count);
+    REQUIRE(dump(cached) == reference);
+    REQUIRE(cached.mergedEntries() == merged);
+
+    // Changed file invalidates the snapshot
+    writeText(s_folder + "/npc-7.txt", "gfxwidth=100\nname=\"Changed\"\n");
+    REQUIRE(!cached.isUpToDate());
+    REQUIRE(cached.loadFolderCached(s_folder, s_snapshot));
+    REQUIRE(!cached.loadedFromSnapshot());
+    REQUIRE(cached.get(7)->gfxwidth == 100);
+    REQUIRE(cached.loadFolderCached(s_folder, s_snapshot));
+    REQUIRE(cached.loadedFromSnapshot());
+    REQUIRE(cached.get(7)->name == "Changed");
+
+    // Added file invalidates the snapshot
+    writeText(s_folder + "/NPC-1000.TXT", "width=48\n");
+    REQUIRE(cached.loadFolderCached(s_folder, s_snapshot));
+    REQUIRE(!cached.loadedFromSnapshot());
+    REQUIRE(cached.maxId() == 1000);
+    REQUIRE(cached.get(1000)->width == 48);
+    REQUIRE(cached.get(999) == nullptr);
+
+    // Removed file invalidates the snapshot
+    REQUIRE(std::remove((s_folder + "/NPC-1000.TXT").c_str()) == 0);
+    REQUIRE(cached.loadFolderCached(s_folder, s_snapshot));
+    REQUIRE(!cached.loadedFromSnapshot());
+    REQUIRE(cached.maxId() == count);
+
+    // Broken snapshot is rejected
+    std::string snapshot;
+    REQUIRE(PGE_FileFormats_misc::readBinaryFile(s_snapshot, snapshot));
+    writeText(s_snapshot, snapshot.substr(0, snapshot.size() / 2));
+    NPCConfigSet broken;
+    REQUIRE(!broken.loadSnapshot(s_folder, s_snapshot));
+    REQUIRE(broken.size() == 0);
+    REQUIRE(broken.loadFolderCached(s_folder, s_snapshot));
+    REQUIRE(!broken.loadedFromSnapshot());
+    REQUIRE(broken.size() == count);
+
+    // Missing folder
+    NPCConfigSet missing;
+    REQUIRE(!missing.loadFolder(s_folder + "/no-such-dir"));
+    REQUIRE(missing.size() == 0);
+}
+
+#ifndef _WIN32
+TEST_CASE("[NpcConfigSet] Unreadable files keep the snapshot valid")
+{
+    const std::string folder = std::string(TEST_TEMP_DIR) + "/npc_folder_unreadable";
+    const std::string snapshot = folder + ".cache";
+    const std::string locked = folder + "/npc-3.txt";
+
+    // Locked file may remain from the interrupted run
+    std::remove(locked.c_str());
+    writeText(folder + "/npc-1.txt", configText(1));
+    writeText(folder + "/npc-2.txt", configText(2));
+    writeText(locked, configText(3));
+    std::remove(snapshot.c_str());
+    REQUIRE(chmod(locked.c_str(), 0) == 0);
+
+    FILE *probe = std::fopen(locked.c_str(), "rb");
+    if(probe)
+    {
+        // Permissions are not checked for the superuser
+        std::fclose(probe);
+        REQUIRE(chmod(locked.c_str(), 0644) == 0);
+        WARN("Can't make an unreadable file, skipped");
+        return;
+    }
+
+    NPCConfigSet set;
+    REQUIRE(set.loadFolderCached(folder, snapshot));
+    REQUIRE(!set.loadedFromSnapshot());
+    REQUIRE(set.size() == 2);
+    REQUIRE(set.get(3) == nullptr);
+    REQUIRE(set.isUpToDate());
+
+    REQUIRE(set.loadFolderCached(folder, snapshot));
+    REQUIRE(set.loadedFromSnapshot());
+    REQUIRE(set.size() == 2);
+    REQUIRE(set.maxId() == 2);
+    REQUIRE(set.get(2) != nullptr);
+    REQUIRE(set.get(3) == nullptr);
+    REQUIRE(set.isUpToDate());
+
+    // The file which became readable invalidates the snapshot
+    REQUIRE(chmod(locked.c_str(), 0644) == 0);
+    writeText(locked, configText(3) + "width=40\n");
+    REQUIRE(!set.isUpToDate());
+    REQUIRE(set.loadFolderCached(folder, snapshot));
+    REQUIRE(!set.loadedFromSnapshot());
+    REQUIRE(set.size() == 3);
+    REQUIRE(set.get(3) != nullptr);
+    REQUIRE(set.get(3)->width == 40);
+}
+#endif
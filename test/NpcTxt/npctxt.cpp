@@ -1,5 +1,7 @@
 #include <catch.hpp>
 #include "file_formats.h"
+#include <string>
+#include <vector>
 
 
 TEST_CASE("[NpcTxt] Load")
@@ -12,3 +14,111 @@ TEST_CASE("[NpcTxt] Load")
     REQUIRE(res);
     REQUIRE(npc.ReadFileValid);
 }
+
+TEST_CASE("[NpcTxt] Known fields")
+{
+    PGESTRING raw =
+        "GFXOffsetX = -4\n"
+        "gfx width=32\n"
+        "gfxheight=  64 \n"
+        "speed=1.5\n"
+        "nogravity=1\n"
+        "NoShell=0\n"
+        "name=\"Super NPC\"\n"
+        "  description  =  Some text with spaces  \n"
+        "frames=abc\n"
+        "score=1234567890\n"
+        "Custom Value=  hello \n"
+        "no separator\n";
+    NPCConfigFile npc;
+
+    REQUIRE(FileFormats::ReadNpcTXTFileRAW(raw, npc));
+    REQUIRE(npc.ReadFileValid);
+
+    REQUIRE(npc.en_gfxoffsetx);
+    REQUIRE(npc.gfxoffsetx == -4);
+    REQUIRE(npc.en_gfxwidth);
+    REQUIRE(npc.gfxwidth == 32);
+    REQUIRE(npc.en_gfxheight);
+    REQUIRE(npc.gfxheight == 64);
+    REQUIRE(npc.en_speed);
+    REQUIRE(npc.speed == 1.5);
+    REQUIRE(npc.en_nogravity);
+    REQUIRE(npc.nogravity);
+    REQUIRE(npc.en_noshell);
+    REQUIRE(!npc.noshell);
+    REQUIRE(npc.en_name);
+    REQUIRE(npc.name == "Super NPC");
+    REQUIRE(npc.en_description);
+    REQUIRE(npc.description == "Some text with spaces");
+
+    // Invalid and too long numbers are not applied
+    REQUIRE(!npc.en_frames);
+    REQUIRE(!npc.en_score);
+    REQUIRE(npc.score == 0);
+
+    REQUIRE(npc.entries.size() == 1);
+    REQUIRE(npc.entries["customvalue"] == "hello");
+
+    PGESTRING unknown = npc.unknownLines;
+    REQUIRE(unknown.find("9: frames=abc <Should be unsigned intger number!>") != PGESTRING::npos);
+    REQUIRE(unknown.find("11: Custom Value=  hello ") != PGESTRING::npos);
+    REQUIRE(unknown.find("12: no separator <wrong syntax!>") != PGESTRING::npos);
+
+    NPCConfigFile quiet;
+    REQUIRE(FileFormats::ReadNpcTXTFileRAW(raw, quiet, true));
+    REQUIRE(quiet.unknownLines.empty());
+    REQUIRE(quiet.entries.size() == 1);
+}
+
+TEST_CASE("[NpcTxt] Parse generated files")
+{
+    const int filesCount = 1000;
+    PGESTRINGList files;
+
+    for(int i = 0; i < filesCount; i++)
+    {
+        NPCConfigFile npc = FileFormats::CreateEmpytNpcTXT();
+        npc.en_gfxwidth = true;
+        npc.gfxwidth = static_cast<uint32_t>(32 + i % 64);
+        npc.en_gfxoffsetx = true;
+        npc.gfxoffsetx = -(i % 16);
+        npc.en_frames = true;
+        npc.frames = static_cast<uint32_t>(1 + i % 8);
+        npc.en_nogravity = true;
+        npc.nogravity = (i % 2) != 0;
+        npc.en_speed = true;
+        npc.speed = 0.5 * (i % 5);
+        npc.en_name = true;
+        npc.name = "Generated NPC " + std::to_string(i);
+        npc.en_grid = true;
+        npc.grid = 16;
+
+        PGESTRING path = PGESTRING(TEST_TEMP_DIR) + "/npc-" + std::to_string(i + 1) + ".txt";
+        REQUIRE(FileFormats::WriteNPCTxtFileF(path, npc));
+        files.push_back(path);
+    }
+
+    std::vector<NPCConfigFile> loaded(files.size());
+
+    BENCHMARK("Parse 1000 NPC.txt files")
+    {
+        for(size_t i = 0; i < files.size(); i++)
+            FileFormats::ReadNpcTXTFileF(files[i], loaded[i]);
+    }
+
+    for(int i = 0; i < filesCount; i++)
+    {
+        const NPCConfigFile &npc = loaded[static_cast<size_t>(i)];
+        REQUIRE(npc.ReadFileValid);
+        REQUIRE(npc.unknownLines.empty());
+        REQUIRE(npc.gfxwidth == static_cast<uint32_t>(32 + i % 64));
+        REQUIRE(npc.gfxoffsetx == -(i % 16));
+        REQUIRE(npc.frames == static_cast<uint32_t>(1 + i % 8));
+        REQUIRE(npc.nogravity == ((i % 2) != 0));
+        REQUIRE(npc.speed == 0.5 * (i % 5));
+        REQUIRE(npc.name == "Generated NPC " + std::to_string(i));
+        REQUIRE(npc.en_grid);
+        REQUIRE(npc.grid == 16);
+    }
+}
@@ -0,0 +1,230 @@
+#include <catch.hpp>
+#include "file_formats.h"
+#include "pge_parse_stats.h"
+#include "synthetic_data.h"
+
+#include <chrono>
+#include <thread>
+
+/*
+ * Readers report to the observer of the current thread only when the library
+ * is built with PGE_FILES_PARSE_STATS, otherwise nothing must arrive.
+ */
+
+//! Attaches the observer for the scope
+struct ScopedObserver
+{
+    explicit ScopedObserver(PGE_ParseObserver *o)
+    {
+        FileFormats::SetParseObserver(o);
+    }
+    ~ScopedObserver()
+    {
+        FileFormats::SetParseObserver(nullptr);
+    }
+};
+
+static LevelData makeLevel()
+{
+    SyntheticData::LevelConfig cfg = SyntheticData::LevelConfig::scaled(2000);
+    return SyntheticData::makeLevel(cfg);
+}
+
+static uint64_t phaseNs(const PGE_ParseStats &stats, const char *format, PGE_ParseObserver::Phase phase)
+{
+    auto f = stats.formats.find(format);
+    return f == stats.formats.end() ? 0 : f->second.phaseNs[phase];
+}
+
+TEST_CASE("[ParseStats] Phase names and accumulation")
+{
+    REQUIRE(std::string(PGE_ParseObserver::phaseName(PGE_ParseObserver::PHASE_IO)) == "io");
+    REQUIRE(std::string(PGE_ParseObserver::phaseName(PGE_ParseObserver::PHASE_TREE)) == "tree");
+    REQUIRE(std::string(PGE_ParseObserver::phaseName(PGE_ParseObserver::PHASE_POSTPROCESS)) == "postprocess");
+
+    PGE_ParseStats stats;
+    stats.onPhase("A", PGE_ParseObserver::PHASE_FIELDS, 10);
+    stats.onPhase("A", PGE_ParseObserver::PHASE_FIELDS, 5);
+    stats.onPhase("B", PGE_ParseObserver::PHASE_FIELDS, 7);
+    stats.onCounter("A", "blocks", 3);
+    stats.onCounter("B", "blocks", 4);
+    REQUIRE(phaseNs(stats, "A", PGE_ParseObserver::PHASE_FIELDS) == 15);
+    REQUIRE(stats.totalNs(PGE_ParseObserver::PHASE_FIELDS) == 22);
+    REQUIRE(stats.totalNs(PGE_ParseObserver::PHASE_IO) == 0);
+    REQUIRE(stats.counter("blocks") == 7);
+    REQUIRE(stats.report().find("fields") != std::string::npos);
+    stats.reset();
+    REQUIRE(stats.formats.empty());
+}
+
+TEST_CASE("[ParseStats] Observer is attached per thread")
+{
+    PGE_ParseStats stats;
+    ScopedObserver attach(&stats);
+    REQUIRE(FileFormats::ParseObserver() == &stats);
+
+    PGE_ParseObserver *other = &stats;
+    std::thread t([&other]()
+    {
+        other = FileFormats::ParseObserver();
+    });
+    t.join();
+    REQUIRE(other == nullptr);
+}
+
+#ifdef PGE_FILES_PARSE_STATS
+
+static uint64_t counter(const PGE_ParseStats &stats, const char *format, const char *name)
+{
+    auto f = stats.formats.find(format);
+    if(f == stats.formats.end())
+        return 0;
+    auto c = f->second.counters.find(name);
+    return c == f->second.counters.end() ? 0 : c->second;
+}
+
+TEST_CASE("[ParseStats] Level readers report phases and counters")
+{
+    LevelData src = makeLevel();
+    PGE_ParseStats stats;
+
+    SECTION("PGE-X LVLX")
+    {
+        PGESTRING raw;
+        REQUIRE(FileFormats::SaveLevelData(src, raw, FileFormats::LVL_PGEX));
+        LevelData loaded;
+        {
+            ScopedObserver attach(&stats);
+            REQUIRE(FileFormats::OpenLevelRaw(raw, "stats.lvlx", loaded));
+        }
+        const char *f = "PGE-X LVLX";
+        REQUIRE(phaseNs(stats, f, PGE_ParseObserver::PHASE_IO) > 0);
+        REQUIRE(phaseNs(stats, f, PGE_ParseObserver::PHASE_SPLIT) > 0);
+        REQUIRE(phaseNs(stats, f, PGE_ParseObserver::PHASE_TREE) > 0);
+        REQUIRE(phaseNs(stats, f, PGE_ParseObserver::PHASE_FIELDS) > 0);
+        REQUIRE(phaseNs(stats, f, PGE_ParseObserver::PHASE_POSTPROCESS) > 0);
+        REQUIRE(counter(stats, f, "bytes") == static_cast<uint64_t>(raw.size()));
+        REQUIRE(counter(stats, f, "lines") > 0);
+        REQUIRE(counter(stats, f, "blocks") == static_cast<uint64_t>(loaded.blocks.size()));
+        REQUIRE(counter(stats, f, "npc") == static_cast<uint64_t>(loaded.npc.size()));
+        REQUIRE(stats.formats.size() == 1);
+    }
+
+    SECTION("SMBX64 LVL")
+    {
+        PGESTRING raw;
+        REQUIRE(FileFormats::SaveLevelData(src, raw, FileFormats::LVL_SMBX64));
+        LevelData loaded;
+        {
+            ScopedObserver attach(&stats);
+            REQUIRE(FileFormats::OpenLevelRaw(raw, "stats.lvl", loaded));
+        }
+        const char *f = "SMBX64 LVL";
+        REQUIRE(phaseNs(stats, f, PGE_ParseObserver::PHASE_SPLIT) == 0);
+        REQUIRE(phaseNs(stats, f, PGE_ParseObserver::PHASE_TREE) == 0);
+        REQUIRE(phaseNs(stats, f, PGE_ParseObserver::PHASE_FIELDS) > 0);
+        REQUIRE(phaseNs(stats, f, PGE_ParseObserver::PHASE_POSTPROCESS) > 0);
+        REQUIRE(counter(stats, f, "bytes") > 0);
+        REQUIRE(counter(stats, f, "lines") > 0);
+        REQUIRE(counter(stats, f, "blocks") == static_cast<uint64_t>(loaded.blocks.size()));
+    }
+
+    SECTION("SMBX-38A LVL")
+    {
+        PGESTRING raw;
+        REQUIRE(FileFormats::SaveLevelData(src, raw, FileFormats::LVL_SMBX38A));
+        LevelData loaded;
+        {
+            ScopedObserver attach(&stats);
+            REQUIRE(FileFormats::OpenLevelRaw(raw, "stats.lvl", loaded));
+        }
+        const char *f = "SMBX-38A LVL";
+        REQUIRE(phaseNs(stats, f, PGE_ParseObserver::PHASE_FIELDS) > 0);
+        REQUIRE(counter(stats, f, "lines") > 0);
+        REQUIRE(counter(stats, f, "bgo") == static_cast<uint64_t>(loaded.bgo.size()));
+    }
+}
+
+TEST_CASE("[ParseStats] Nested phases are not counted twice")
+{
+    LevelData src = makeLevel();
+    PGESTRING raw;
+    REQUIRE(FileFormats::SaveLevelData(src, raw, FileFormats::LVL_PGEX));
+
+    PGE_ParseStats stats;
+    LevelData loaded;
+    auto begin = std::chrono::steady_clock::now();
+    {
+        ScopedObserver attach(&stats);
+        REQUIRE(FileFormats::OpenLevelRaw(raw, "stats.lvlx", loaded));
+    }
+    const uint64_t wall = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                    std::chrono::steady_clock::now() - begin).count());
+    uint64_t sum = 0;
+    for(int p = 0; p < PGE_ParseObserver::PHASE_COUNT; p++)
+        sum += stats.totalNs(static_cast<PGE_ParseObserver::Phase>(p));
+    REQUIRE(sum > 0);
+    REQUIRE(sum <= wall);
+}
+
+TEST_CASE("[ParseStats] World and save readers report phases and counters")
+{
+    PGE_ParseStats stats;
+
+    SECTION("PGE-X WLDX and SMBX64 WLD")
+    {
+        WorldData src = SyntheticData::makeWorld(SyntheticData::WorldConfig::scaled(2000));
+        PGESTRING rawX, raw64;
+        REQUIRE(FileFormats::SaveWorldData(src, rawX, FileFormats::WLD_PGEX));
+        REQUIRE(FileFormats::SaveWorldData(src, raw64, FileFormats::WLD_SMBX64));
+        WorldData a, b;
+        {
+            ScopedObserver attach(&stats);
+            REQUIRE(FileFormats::OpenWorldRaw(rawX, "stats.wldx", a));
+            REQUIRE(FileFormats::OpenWorldRaw(raw64, "stats.wld", b));
+        }
+        REQUIRE(phaseNs(stats, "PGE-X WLDX", PGE_ParseObserver::PHASE_TREE) > 0);
+        REQUIRE(phaseNs(stats, "PGE-X WLDX", PGE_ParseObserver::PHASE_POSTPROCESS) > 0);
+        REQUIRE(counter(stats, "PGE-X WLDX", "tiles") == static_cast<uint64_t>(a.tiles.size()));
+        REQUIRE(phaseNs(stats, "SMBX64 WLD", PGE_ParseObserver::PHASE_FIELDS) > 0);
+        REQUIRE(counter(stats, "SMBX64 WLD", "levels") == static_cast<uint64_t>(b.levels.size()));
+    }
+
+    SECTION("PGE-X SAVX and SMBX64 SAV")
+    {
+        GamesaveData src = SyntheticData::makeSave(2000);
+        PGESTRING rawX;
+        REQUIRE(FileFormats::WriteExtendedSaveFileRaw(src, rawX));
+        PGESTRING raw64 = SyntheticData::smbx64SaveText(src);
+        GamesaveData a, b;
+        {
+            ScopedObserver attach(&stats);
+            REQUIRE(FileFormats::ReadExtendedSaveFileRaw(rawX, "stats.savx", a));
+            REQUIRE(FileFormats::ReadSMBX64SavFileRaw(raw64, "stats.sav", b));
+        }
+        REQUIRE(phaseNs(stats, "PGE-X SAVX", PGE_ParseObserver::PHASE_TREE) > 0);
+        REQUIRE(counter(stats, "PGE-X SAVX", "visibleLevels") == static_cast<uint64_t>(a.visibleLevels.size()));
+        REQUIRE(phaseNs(stats, "SMBX64 SAV", PGE_ParseObserver::PHASE_FIELDS) > 0);
+        REQUIRE(counter(stats, "SMBX64 SAV", "gottenStars") == static_cast<uint64_t>(b.gottenStars.size()));
+    }
+}
+
+#else // PGE_FILES_PARSE_STATS
+
+TEST_CASE("[ParseStats] Readers report nothing when instrumentation is compiled out")
+{
+    LevelData src = makeLevel();
+    PGESTRING raw;
+    REQUIRE(FileFormats::SaveLevelData(src, raw, FileFormats::LVL_PGEX));
+
+    PGE_ParseStats stats;
+    LevelData loaded;
+    {
+        ScopedObserver attach(&stats);
+        REQUIRE(FileFormats::OpenLevelRaw(raw, "stats.lvlx", loaded));
+    }
+    REQUIRE(loaded.blocks.size() == src.blocks.size());
+    REQUIRE(stats.formats.empty());
+}
+
+#endif // PGE_FILES_PARSE_STATS
@@ -0,0 +1,118 @@
+#include <catch.hpp>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include "file_formats.h"
+
+/*
+ * Counts heap allocations made by every reader. Budgets below are measured
+ * numbers with a small headroom: if the reader starts to allocate more,
+ * the test fails and the budget must be either justified or the regression fixed.
+ */
+
+static std::atomic<unsigned long> s_allocations(0);
+
+void *operator new(std::size_t size)
+{
+    s_allocations++;
+    void *p = std::malloc(size ? size : 1);
+    if(!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+static PGESTRING loadRaw(const char *path)
+{
+    std::string raw;
+    REQUIRE(PGE_FileFormats_misc::readBinaryFile(path, raw));
+#ifdef PGE_FILES_QT
+    return QString::fromStdString(raw);
+#else
+    return raw;
+#endif
+}
+
+template<class Data, class Reader>
+static unsigned long countAllocations(const char *name, const char *path, Reader reader, size_t &elements)
+{
+    PGESTRING raw = loadRaw(path);
+    Data data;
+    unsigned long before = s_allocations.load();
+    REQUIRE(reader(raw, PGESTRING(path), data));
+    unsigned long result = s_allocations.load() - before;
+    elements = data.elementsCount();
+    std::printf("%-14s %8lu allocations, %6zu elements, %.2f per element\n",
+                name, result, elements, elements ? double(result) / double(elements) : 0.0);
+    std::fflush(stdout);
+    return result;
+}
+
+struct LevelCount : LevelData
+{
+    size_t elementsCount() const
+    {
+        return blocks.size() + bgo.size() + npc.size() + doors.size() + physez.size() +
+               layers.size() + events.size();
+    }
+};
+
+struct WorldCount : WorldData
+{
+    size_t elementsCount() const
+    {
+        return tiles.size() + scenery.size() + paths.size() + levels.size() + music.size();
+    }
+};
+
+TEST_CASE("[ReaderAllocations] Allocations per file format")
+{
+    size_t elements = 0;
+    unsigned long n;
+
+    n = countAllocations<LevelCount>("SMBX64 LVL", "../old_deep_tests/PGEFileLib_test_files/smbx64/Sky Tower.lvl",
+                                     [](PGESTRING &raw, const PGESTRING &p, LevelData &d)
+                                     { return FileFormats::ReadSMBX64LvlFileRaw(raw, p, d); }, elements);
+    REQUIRE(elements > 0);
+    REQUIRE(n <= 400ul);
+
+    n = countAllocations<LevelCount>("SMBX-38A LVL", "../old_deep_tests/PGEFileLib_test_files/smbx38a/1-1.lvl",
+                                     [](PGESTRING &raw, const PGESTRING &p, LevelData &d)
+                                     { return FileFormats::ReadSMBX38ALvlFileRaw(raw, p, d); }, elements);
+    REQUIRE(elements > 0);
+    REQUIRE(n <= 3000ul);
+
+    n = countAllocations<LevelCount>("PGE-X LVLX", "../old_deep_tests/PGEFileLib_test_files/pgex/Sky Tower.lvlx",
+                                     [](PGESTRING &raw, const PGESTRING &p, LevelData &d)
+                                     { return FileFormats::ReadExtendedLvlFileRaw(raw, p, d); }, elements);
+    REQUIRE(elements > 0);
+    REQUIRE(n <= 86000ul);
+
+    n = countAllocations<WorldCount>("SMBX64 WLD", "../old_deep_tests/PGEFilelib_STL_test/test.wld",
+                                     [](PGESTRING &raw, const PGESTRING &p, WorldData &d)
+                                     { return FileFormats::ReadSMBX64WldFileRaw(raw, p, d); }, elements);
+    REQUIRE(elements > 0);
+    REQUIRE(n <= 600ul);
+
+    n = countAllocations<WorldCount>("SMBX-38A WLD", "../old_deep_tests/PGEFileLib_test_files/smbx38a_wld/tinvworld.wld",
+                                     [](PGESTRING &raw, const PGESTRING &p, WorldData &d)
+                                     { return FileFormats::ReadSMBX38AWldFileRaw(raw, p, d); }, elements);
+    REQUIRE(elements > 0);
+    REQUIRE(n <= 6600ul);
+
+    n = countAllocations<WorldCount>("PGE-X WLDX", "../old_deep_tests/PGEFilelib_STL_test/test.wldx",
+                                     [](PGESTRING &raw, const PGESTRING &p, WorldData &d)
+                                     { return FileFormats::ReadExtendedWldFileRaw(raw, p, d); }, elements);
+    REQUIRE(elements > 0);
+    REQUIRE(n <= 102000ul);
+}
@@ -0,0 +1,262 @@
+#include <catch.hpp>
+#include <string>
+#include "file_formats.h"
+
+static PGESTRING written(GamesaveData d)
+{
+    PGESTRING raw;
+    REQUIRE(FileFormats::WriteExtendedSaveFileRaw(d, raw));
+    return raw;
+}
+
+static GamesaveData readRaw(PGESTRING raw)
+{
+    GamesaveData d;
+    REQUIRE(FileFormats::ReadExtendedSaveFileRaw(raw, "journal.savx", d));
+    REQUIRE(d.meta.ReadFileValid);
+    return d;
+}
+
+static GamesaveData makeBase()
+{
+    GamesaveData d = FileFormats::CreateGameSaveData();
+    for(unsigned int i = 1; i <= 50; i++)
+    {
+        d.visibleLevels.push_back(visibleItem(i, i % 3 == 0));
+        d.visiblePaths.push_back(visibleItem(i, false));
+        d.visibleScenery.push_back(visibleItem(i, true));
+    }
+    for(int i = 0; i < 20; i++)
+        d.gottenStars.push_back(starOnLevel("level-" + std::to_string(i) + ".lvlx", i % 3));
+
+    saveUserData::DataSection ds;
+    ds.name = "default";
+    ds.data.push_back({"counter", "0"});
+    ds.data.push_back({"flag", "no"});
+    d.userData.store.push_back(ds);
+    return d;
+}
+
+TEST_CASE("[SaveJournal] Checkpoints are appended and replayed")
+{
+    GamesaveData saved = makeBase();
+    GamesaveData current = saved;
+    PGESTRING raw = written(saved);
+
+    for(int step = 1; step <= 40; step++)
+    {
+        const size_t oldSize = raw.size();
+        current.coins += 7;
+        current.worldPosX = step * 32;
+        current.visiblePaths[static_cast<size_t>(step)].second = true;
+        current.gottenStars.push_back(starOnLevel("bonus-" + std::to_string(step) + ".lvlx", 0));
+        current.userData.store[0].data[0].value = std::to_string(step);
+        if(step == 10)
+        {
+            current.visibleLevels.push_back(visibleItem(100, true));
+            current.visibleScenery.erase(current.visibleScenery.begin());
+            current.gottenStars.erase(current.gottenStars.begin() + 3);
+            current.userData.store[0].data.erase(current.userData.store[0].data.begin() + 1);
+        }
+        if(step == 20)
+        {
+            current.characterStates.push_back(FileFormats::CreateSavCharacterState());
+            current.characterStates[1].id = 2;
+            current.characterStates[0].state = 3;
+            current.currentCharacter.push_back(2);
+
+            saveUserData::DataSection ds;
+            ds.location = saveUserData::DATA_LEVEL;
+            ds.location_name = "castle.lvlx";
+            ds.name = "Boss";
+            ds.data.push_back({"beaten", "yes"});
+            current.userData.store.push_back(ds);
+        }
+        if(step == 30)
+            current.userData.store.erase(current.userData.store.begin() + 1);
+
+        REQUIRE(FileFormats::AppendExtendedSaveJournalRaw(saved, current, raw, 100000));
+        REQUIRE(saved.journalRecords == current.journalRecords);
+        // Only changes get appended, much less than the whole save
+        REQUIRE(raw.size() - oldSize < written(current).size() / 4);
+
+        GamesaveData loaded = readRaw(raw);
+        REQUIRE(loaded.journalRecords == saved.journalRecords);
+        REQUIRE(written(loaded) == written(current));
+    }
+
+    REQUIRE(saved.journalRecords > 40);
+
+    // Nothing changed, nothing is written
+    PGESTRING before = raw;
+    REQUIRE(FileFormats::AppendExtendedSaveJournalRaw(saved, current, raw, 100000));
+    REQUIRE(raw == before);
+}
+
+TEST_CASE("[SaveJournal] Compaction")
+{
+    GamesaveData saved = makeBase();
+    GamesaveData current = saved;
+    PGESTRING raw = written(saved);
+
+    // Too many records
+    current.coins = 10;
+    REQUIRE(FileFormats::AppendExtendedSaveJournalRaw(saved, current, raw, 3));
+    REQUIRE(saved.journalRecords == 1);
+    for(unsigned int i = 0; i < 5; i++)
+        current.visiblePaths[i].second = true;
+    REQUIRE(FileFormats::AppendExtendedSaveJournalRaw(saved, current, raw, 3));
+    REQUIRE(saved.journalRecords == 0);
+    REQUIRE(raw.find("JOURNAL") == PGESTRING::npos);
+    REQUIRE(written(readRaw(raw)) == written(current));
+
+    // Reordering can't be expressed by records
+    current.lives = 5;
+    REQUIRE(FileFormats::AppendExtendedSaveJournalRaw(saved, current, raw));
+    REQUIRE(saved.journalRecords == 1);
+    std::swap(current.visibleLevels[0], current.visibleLevels[1]);
+    REQUIRE(FileFormats::AppendExtendedSaveJournalRaw(saved, current, raw));
+    REQUIRE(saved.journalRecords == 0);
+    REQUIRE(raw.find("JOURNAL") == PGESTRING::npos);
+    REQUIRE(written(readRaw(raw)) == written(current));
+
+    // Duplicated entries and reordered keys can't be expressed by records
+    current.lives = 6;
+    REQUIRE(FileFormats::AppendExtendedSaveJournalRaw(saved, current, raw));
+    REQUIRE(saved.journalRecords == 1);
+    current.gottenStars.push_back(current.gottenStars[2]);
+    REQUIRE(FileFormats::AppendExtendedSaveJournalRaw(saved, current, raw));
+    REQUIRE(saved.journalRecords == 0);
+    current.gottenStars.pop_back();
+    current.visiblePaths.push_back(current.visiblePaths[4]);
+    REQUIRE(FileFormats::AppendExtendedSaveJournalRaw(saved, current, raw));
+    REQUIRE(saved.journalRecords == 0);
+    current.visiblePaths.pop_back();
+    std::swap(current.userData.store[0].data[0], current.userData.store[0].data[1]);
+    REQUIRE(FileFormats::AppendExtendedSaveJournalRaw(saved, current, raw));
+    REQUIRE(saved.journalRecords == 0);
+    REQUIRE(written(readRaw(raw)) == written(current));
+
+    // Unnamed section is the same as the default one
+    current.userData.store[0].name.clear();
+    PGESTRING unchanged = raw;
+    REQUIRE(FileFormats::AppendExtendedSaveJournalRaw(saved, current, raw));
+    REQUIRE(raw == unchanged);
+
+    // Volatile user data is never saved
+    saveUserData::DataSection ds;
+    ds.location = saveUserData::DATA_WORLD | saveUserData::DATA_VOLATILE_FLAG;
+    ds.name = "temp";
+    ds.data.push_back({"a", "b"});
+    current.userData.store.push_back(ds);
+    PGESTRING before = raw;
+    REQUIRE(FileFormats::AppendExtendedSaveJournalRaw(saved, current, raw));
+    REQUIRE(raw == before);
+}
+
+TEST_CASE("[SaveJournal] File journal")
+{
+    const PGESTRING path = PGESTRING(TEST_TEMP_DIR) + "/journal.savx";
+    GamesaveData saved = makeBase();
+    GamesaveData current = saved;
+    REQUIRE(FileFormats::WriteExtendedSaveFileF(path, current));
+
+    for(int step = 0; step < 5; step++)
+    {
+        current.points += 100;
+        current.visiblePaths[static_cast<size_t>(step)].second = true;
+        REQUIRE(FileFormats::AppendExtendedSaveJournalF(path, saved, current));
+    }
+
+    GamesaveData loaded;
+    REQUIRE(FileFormats::ReadExtendedSaveFileF(path, loaded));
+    REQUIRE(loaded.journalRecords == 10);
+    REQUIRE(written(loaded) == written(current));
+}
+
+TEST_CASE("[SaveJournal] Unknown record")
+{
+    PGESTRING raw = written(makeBase());
+    raw += "JOURNAL\nOP:\"???\";\nJOURNAL_END\n";
+    GamesaveData d;
+    REQUIRE(!FileFormats::ReadExtendedSaveFileRaw(raw, "journal.savx", d));
+    REQUIRE(!d.meta.ReadFileValid);
+}
+
+TEST_CASE("[SaveJournal] Index out of range")
+{
+    GamesaveData base = makeBase();
+    base.characterStates.clear();
+    base.characterStates.push_back(FileFormats::CreateSavCharacterState());
+    base.currentCharacter.clear();
+    base.currentCharacter.push_back(1);
+    const char *records[] =
+    {
+        "OP:\"CHR\";I:3000000000;",
+        "OP:\"PLR\";I:3000000000;ID:1;",
+        "OP:\"CHR\";I:2;",
+    };
+    for(const char *record : records)
+    {
+        PGESTRING raw = written(base);
+        raw += "JOURNAL\n";
+        raw += record;
+        raw += "\nJOURNAL_END\n";
+        GamesaveData d;
+        REQUIRE(!FileFormats::ReadExtendedSaveFileRaw(raw, "journal.savx", d));
+        REQUIRE(!d.meta.ReadFileValid);
+    }
+
+    // The new size alone doesn't allocate elements, the next records add them
+    PGESTRING raw = written(base);
+    raw += "JOURNAL\nOP:\"CHN\";I:3000000000;\nOP:\"CHR\";I:1;ST:2;\nOP:\"PLN\";I:0;\nJOURNAL_END\n";
+    GamesaveData d = readRaw(raw);
+    REQUIRE(d.characterStates.size() == 2);
+    REQUIRE(d.characterStates[1].state == 2);
+    REQUIRE(d.currentCharacter.empty());
+}
+
+TEST_CASE("[SaveJournal] Interrupted append")
+{
+    GamesaveData saved = makeBase();
+    GamesaveData current = saved;
+    PGESTRING raw = written(saved);
+
+    current.coins = 10;
+    REQUIRE(FileFormats::AppendExtendedSaveJournalRaw(saved, current, raw));
+    const PGESTRING checkpoint = raw;
+    const GamesaveData checkpointState = current;
+
+    current.lives = 7;
+    current.visiblePaths[3].second = true;
+    current.gottenStars.push_back(starOnLevel("bonus.lvlx", 0));
+    REQUIRE(FileFormats::AppendExtendedSaveJournalRaw(saved, current, raw));
+    const size_t end = raw.rfind("JOURNAL_END");
+    REQUIRE(end != PGESTRING::npos);
+    REQUIRE(end > checkpoint.size());
+
+    // Cuts at any point of the last section give the state before it
+    for(size_t cut = checkpoint.size() + 1; cut < end + 11; cut++)
+    {
+        GamesaveData loaded = readRaw(raw.substr(0, cut));
+        REQUIRE(loaded.journalTruncated);
+        REQUIRE(loaded.journalRecords == 1);
+        REQUIRE(written(loaded) == written(checkpointState));
+    }
+
+    // The next append rewrites the file
+    PGESTRING cutRaw = raw.substr(0, end);
+    GamesaveData loaded = readRaw(cutRaw);
+    GamesaveData next = loaded;
+    next.points = 500;
+    REQUIRE(FileFormats::AppendExtendedSaveJournalRaw(loaded, next, cutRaw));
+    REQUIRE(!loaded.journalTruncated);
+    REQUIRE(!next.journalTruncated);
+    REQUIRE(cutRaw.find("JOURNAL") == PGESTRING::npos);
+    REQUIRE(written(readRaw(cutRaw)) == written(next));
+
+    // The complete file is read as is
+    GamesaveData complete = readRaw(raw);
+    REQUIRE(!complete.journalTruncated);
+    REQUIRE(written(complete) == written(current));
+}
@@ -0,0 +1,217 @@
+#include <catch.hpp>
+#include <random>
+#include <string>
+#include "file_formats.h"
+
+TEST_CASE("[SaveLookup] Visible items map matches the scan")
+{
+    PGELIST<visibleItem> indexed, scanned;
+    VisibleItemsMap map, scan;
+    map.rebuild(indexed);
+    REQUIRE(map.isEnabled());
+    REQUIRE(!scan.isEnabled());
+
+    std::mt19937 rng(42);
+    // Mix of dense and huge Array-IDs
+    auto randomId = [&rng]() -> unsigned int
+    {
+        unsigned int id = rng() % 300;
+        return (id < 250) ? id : 0x7FFFFFF0u + id;
+    };
+
+    for(int i = 0; i < 5000; i++)
+    {
+        unsigned int id = randomId();
+        switch(rng() % 4)
+        {
+        case 0:
+            REQUIRE(map.erase(indexed, id) == scan.erase(scanned, id));
+            break;
+        default:
+        {
+            bool visible = (rng() % 2) == 0;
+            map.set(indexed, id, visible);
+            scan.set(scanned, id, visible);
+            break;
+        }
+        }
+
+        REQUIRE(indexed == scanned);
+        unsigned int probe = randomId();
+        REQUIRE(map.find(indexed, probe) == scan.find(scanned, probe));
+        REQUIRE(map.isVisible(indexed, probe) == scan.isVisible(scanned, probe));
+    }
+
+    map.rebuild(indexed);
+    for(unsigned int id = 0; id < 300; id++)
+        REQUIRE(map.isVisible(indexed, id) == scan.isVisible(scanned, id));
+}
+
+TEST_CASE("[SaveLookup] Duplicated entries")
+{
+    PGELIST<visibleItem> list;
+    list.push_back(visibleItem(5, false));
+    list.push_back(visibleItem(7, true));
+    list.push_back(visibleItem(5, true));
+
+    VisibleItemsMap map;
+    map.rebuild(list);
+    REQUIRE(map.find(list, 5) == 0);
+    REQUIRE(!map.isVisible(list, 5));
+    REQUIRE(map.erase(list, 5));
+    REQUIRE(map.find(list, 5) == 1);
+    REQUIRE(map.isVisible(list, 5));
+    REQUIRE(map.find(list, 7) == 0);
+
+    PGELIST<starOnLevel> stars;
+    stars.push_back(starOnLevel("a.lvl", 1));
+    stars.push_back(starOnLevel("b.lvl", 1));
+    stars.push_back(starOnLevel("a.lvl", 1));
+
+    GottenStarsMap starsMap;
+    starsMap.rebuild(stars);
+    REQUIRE(starsMap.find(stars, starOnLevel("a.lvl", 1)) == 0);
+    REQUIRE(!starsMap.insert(stars, starOnLevel("a.lvl", 1)));
+    REQUIRE(starsMap.erase(stars, starOnLevel("a.lvl", 1)));
+    REQUIRE(starsMap.find(stars, starOnLevel("a.lvl", 1)) == 1);
+    REQUIRE(starsMap.find(stars, starOnLevel("b.lvl", 1)) == 0);
+    REQUIRE(!starsMap.contains(stars, starOnLevel("a.lvl", 2)));
+    REQUIRE(starsMap.insert(stars, starOnLevel("a.lvl", 2)));
+    REQUIRE(starsMap.find(stars, starOnLevel("a.lvl", 2)) == 2);
+}
+
+TEST_CASE("[SaveLookup] Direct changes of the lists")
+{
+    PGELIST<visibleItem> list;
+    for(unsigned int i = 1; i <= 10; i++)
+        list.push_back(visibleItem(i, false));
+    list.push_back(visibleItem(0x7FFFFFF0u, false));
+
+    VisibleItemsMap map;
+    map.rebuild(list);
+    list[2].second = true;
+    list[9].second = true;
+    REQUIRE(map.isVisible(list, 3));
+    REQUIRE(map.isVisible(list, 10));
+    list[3].first = 4000;
+    REQUIRE(map.find(list, 4) == -1);
+    list[3].first = 4;
+    list.push_back(visibleItem(20, true));
+    REQUIRE(map.isVisible(list, 20));
+    map.set(list, 21, true);
+    REQUIRE(map.find(list, 21) == 12);
+    list.erase(list.begin());
+    REQUIRE(map.find(list, 1) == -1);
+    REQUIRE(map.find(list, 2) == 0);
+    REQUIRE(map.find(list, 0x7FFFFFF0u) == 9);
+    REQUIRE(map.erase(list, 2));
+    REQUIRE(map.find(list, 20) == 9);
+
+    PGELIST<starOnLevel> stars;
+    stars.push_back(starOnLevel("a.lvl", 1));
+    stars.push_back(starOnLevel("b.lvl", 1));
+
+    GottenStarsMap starsMap;
+    starsMap.rebuild(stars);
+    stars[0].second = 2;
+    REQUIRE(!starsMap.contains(stars, starOnLevel("a.lvl", 1)));
+    stars.push_back(starOnLevel("c.lvl", 1));
+    REQUIRE(starsMap.find(stars, starOnLevel("c.lvl", 1)) == 2);
+    REQUIRE(starsMap.find(stars, starOnLevel("a.lvl", 2)) == 0);
+    REQUIRE(starsMap.erase(stars, starOnLevel("b.lvl", 1)));
+    REQUIRE(starsMap.find(stars, starOnLevel("c.lvl", 1)) == 1);
+    REQUIRE(starsMap.insert(stars, starOnLevel("a.lvl", 1)));
+    REQUIRE(starsMap.find(stars, starOnLevel("a.lvl", 1)) == 2);
+}
+
+TEST_CASE("[SaveLookup] Maps are built by the PGE-X reader")
+{
+    GamesaveData origin = FileFormats::CreateGameSaveData();
+    for(unsigned int i = 1; i <= 3000; i++)
+    {
+        origin.visibleLevels.push_back(visibleItem(i, i % 2 == 0));
+        origin.visiblePaths.push_back(visibleItem(i, i % 3 == 0));
+        origin.visibleScenery.push_back(visibleItem(i, i % 5 == 0));
+    }
+    for(int i = 0; i < 500; i++)
+        origin.gottenStars.push_back(starOnLevel("level-" + std::to_string(i / 4) + ".lvlx", i % 4));
+
+    PGESTRING raw;
+    GamesaveData target;
+    REQUIRE(FileFormats::WriteExtendedSaveFileRaw(origin, raw));
+    REQUIRE(FileFormats::ReadExtendedSaveFileRaw(raw, "lookup.savx", target));
+
+    REQUIRE(target.visibleLevels_map.isEnabled());
+    REQUIRE(target.visiblePaths_map.isEnabled());
+    REQUIRE(target.visibleScenery_map.isEnabled());
+    REQUIRE(target.gottenStars_map.isEnabled());
+    REQUIRE(target.userData.isIndexed());
+
+    REQUIRE(target.visibleLevels_map.isVisible(target.visibleLevels, 2000));
+    REQUIRE(!target.visibleLevels_map.isVisible(target.visibleLevels, 2001));
+    REQUIRE(target.visiblePaths_map.isVisible(target.visiblePaths, 2001));
+    REQUIRE(target.visibleScenery_map.isVisible(target.visibleScenery, 2000));
+    REQUIRE(target.visibleLevels_map.find(target.visibleLevels, 3001) == -1);
+    REQUIRE(target.gottenStars_map.contains(target.gottenStars, starOnLevel("level-100.lvlx", 3)));
+    REQUIRE(!target.gottenStars_map.contains(target.gottenStars, starOnLevel("level-125.lvlx", 0)));
+
+    // Changes done via maps are written back in the same order
+    target.visiblePaths_map.set(target.visiblePaths, 1, true);
+    target.visiblePaths_map.set(target.visiblePaths, 5000, true);
+    target.gottenStars_map.insert(target.gottenStars, starOnLevel("bonus.lvlx", 0));
+    REQUIRE(FileFormats::WriteExtendedSaveFileRaw(target, raw));
+
+    GamesaveData reread;
+    REQUIRE(FileFormats::ReadExtendedSaveFileRaw(raw, "lookup.savx", reread));
+    REQUIRE(reread.visiblePaths == target.visiblePaths);
+    REQUIRE(reread.visiblePaths.back() == visibleItem(5000, true));
+    REQUIRE(reread.gottenStars == target.gottenStars);
+    REQUIRE(reread.visiblePaths_map.isVisible(reread.visiblePaths, 1));
+}
+
+TEST_CASE("[SaveLookup] Maps are built by the SMBX64 reader")
+{
+    PGESTRING raw = "64\n3\n10\n64\n128\n";
+    for(int i = 0; i < 5; i++)
+        raw += "2\n0\n0\n0\n1\n";
+    raw += "2\n#TRUE#\n";
+    raw += "#TRUE#\n#FALSE#\n#TRUE#\nnext\n";
+    raw += "#FALSE#\n#TRUE#\nnext\n";
+    raw += "#TRUE#\nnext\n";
+    raw += "\"one.lvl\"\n1\n\"two.lvl\"\n0\nnext\n2\n";
+
+    GamesaveData d;
+    REQUIRE(FileFormats::ReadSMBX64SavFileRaw(raw, "save1.sav", d));
+    REQUIRE(d.meta.ReadFileValid);
+    REQUIRE(d.visibleLevels.size() == 3);
+    REQUIRE(d.visibleLevels_map.isVisible(d.visibleLevels, 1));
+    REQUIRE(!d.visibleLevels_map.isVisible(d.visibleLevels, 2));
+    REQUIRE(d.visibleLevels_map.isVisible(d.visibleLevels, 3));
+    REQUIRE(d.visiblePaths_map.isVisible(d.visiblePaths, 2));
+    REQUIRE(d.visibleScenery_map.isVisible(d.visibleScenery, 1));
+    REQUIRE(d.gottenStars_map.contains(d.gottenStars, starOnLevel("one.lvl", 1)));
+    REQUIRE(d.gottenStars_map.contains(d.gottenStars, starOnLevel("two.lvl", 0)));
+    REQUIRE(!d.gottenStars_map.contains(d.gottenStars, starOnLevel("two.lvl", 1)));
+}
+
+TEST_CASE("[SaveLookup] Lookup of many world map items")
+{
+    GamesaveData d = FileFormats::CreateGameSaveData();
+    for(unsigned int i = 1; i <= 20000; i++)
+        d.visibleLevels.push_back(visibleItem(i, (i % 7) == 0));
+    VisibleItemsMap scan;
+    d.buildLookupMaps();
+
+    size_t visibleScan = 0, visibleMap = 0;
+    BENCHMARK("Scan of 20000 entries")
+    {
+        for(unsigned int i = 1; i <= 20000; i += 10)
+            visibleScan += scan.isVisible(d.visibleLevels, i) ? 1 : 0;
+    }
+    BENCHMARK("Bitset of 20000 entries")
+    {
+        for(unsigned int i = 1; i <= 20000; i += 10)
+            visibleMap += d.visibleLevels_map.isVisible(d.visibleLevels, i) ? 1 : 0;
+    }
+    REQUIRE(visibleScan == visibleMap);
+}
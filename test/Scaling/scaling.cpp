@@ -0,0 +1,302 @@
+#include <catch.hpp>
+#include "file_formats.h"
+#include "synthetic_data.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+
+/*
+ * Each reader and writer is measured at two sizes of synthetic data. Time
+ * must grow nearly in proportion to the size: the allowed factor leaves room
+ * for cache effects and noise, but catches quadratic behavior of large inputs.
+ *
+ * Timings depend on the machine load, so the default run checks only the
+ * round trip of the same data. Run the timing checks explicitly:
+ * ScalingTest "[.scaling]"
+ */
+
+static const long c_baseSize = 4000;
+static const long c_scale = 8;
+
+//! Best of several runs in seconds
+static double measure(const std::function<void()> &fn)
+{
+    double best = 0.0;
+    for(int i = 0; i < 3; i++)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        fn();
+        const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        if(i == 0 || sec < best)
+            best = sec;
+    }
+    return best;
+}
+
+static void checkGrowth(const char *name, double small, double large, long scale = c_scale)
+{
+    const double growth = large / std::max(small, 1e-6);
+    std::printf("%-24s %9.3f ms -> %9.3f ms, x%.1f at x%ld size\n", name, small * 1000.0, large * 1000.0, growth, scale);
+    std::fflush(stdout);
+    INFO(name);
+    REQUIRE(growth < scale * 2.5);
+}
+
+static void levelScaling(const char *name, FileFormats::LevelFileFormat format, bool escapes, long base, long scale, bool timed)
+{
+    double readTime[2] = {}, writeTime[2] = {};
+    for(int step = 0; step < 2; step++)
+    {
+        SyntheticData::LevelConfig cfg = SyntheticData::LevelConfig::scaled(step ? base * scale : base);
+        cfg.escapes = escapes;
+        LevelData src = SyntheticData::makeLevel(cfg);
+
+        PGESTRING raw;
+        REQUIRE(FileFormats::SaveLevelData(src, raw, format));
+        if(timed)
+            writeTime[step] = measure([&]()
+            {
+                PGESTRING out;
+                FileFormats::SaveLevelData(src, out, format);
+            });
+
+        LevelData loaded;
+        REQUIRE(FileFormats::OpenLevelRaw(raw, "scaling.lvl", loaded));
+        REQUIRE(loaded.blocks.size() == src.blocks.size());
+        REQUIRE(loaded.bgo.size() == src.bgo.size());
+        REQUIRE(loaded.npc.size() == src.npc.size());
+        REQUIRE(static_cast<long>(loaded.events.size()) >= cfg.events);
+        if(timed)
+            readTime[step] = measure([&]()
+            {
+                LevelData d;
+                FileFormats::OpenLevelRaw(raw, "scaling.lvl", d);
+            });
+    }
+    if(!timed)
+        return;
+    checkGrowth((std::string(name) + " read").c_str(), readTime[0], readTime[1], scale);
+    checkGrowth((std::string(name) + " write").c_str(), writeTime[0], writeTime[1], scale);
+}
+
+static void worldScaling(const char *name, FileFormats::WorldFileFormat format, long base, long scale, bool timed)
+{
+    double readTime[2] = {}, writeTime[2] = {};
+    const bool canWrite = (format != FileFormats::WLD_SMBX38A);
+    for(int step = 0; step < 2; step++)
+    {
+        WorldData src = SyntheticData::makeWorld(SyntheticData::WorldConfig::scaled(step ? base * scale : base));
+
+        PGESTRING raw;
+        if(canWrite)
+        {
+            REQUIRE(FileFormats::SaveWorldData(src, raw, format));
+            if(timed)
+                writeTime[step] = measure([&]()
+                {
+                    PGESTRING out;
+                    FileFormats::SaveWorldData(src, out, format);
+                });
+        }
+        else
+            raw = SyntheticData::smbx38aWorldText(src);
+
+        WorldData loaded;
+        REQUIRE(FileFormats::OpenWorldRaw(raw, "scaling.wld", loaded));
+        REQUIRE(SyntheticData::worldElements(loaded) == SyntheticData::worldElements(src));
+        if(timed)
+            readTime[step] = measure([&]()
+            {
+                WorldData d;
+                FileFormats::OpenWorldRaw(raw, "scaling.wld", d);
+            });
+    }
+    if(!timed)
+        return;
+    checkGrowth((std::string(name) + " read").c_str(), readTime[0], readTime[1], scale);
+    if(canWrite)
+        checkGrowth((std::string(name) + " write").c_str(), writeTime[0], writeTime[1], scale);
+}
+
+static void saveScaling(long base, long scale, bool timed)
+{
+    double savxRead[2] = {}, savxWrite[2] = {}, savRead[2] = {};
+    for(int step = 0; step < 2; step++)
+    {
+        GamesaveData src = SyntheticData::makeSave(step ? base * scale : base);
+
+        PGESTRING savx;
+        REQUIRE(FileFormats::WriteExtendedSaveFileRaw(src, savx));
+        if(timed)
+            savxWrite[step] = measure([&]()
+            {
+                PGESTRING out;
+                FileFormats::WriteExtendedSaveFileRaw(src, out);
+            });
+
+        GamesaveData loaded;
+        REQUIRE(FileFormats::ReadExtendedSaveFileRaw(savx, "scaling.savx", loaded));
+        REQUIRE(SyntheticData::saveElements(loaded) == SyntheticData::saveElements(src));
+        if(timed)
+            savxRead[step] = measure([&]()
+            {
+                GamesaveData d;
+                FileFormats::ReadExtendedSaveFileRaw(savx, "scaling.savx", d);
+            });
+
+        PGESTRING sav = SyntheticData::smbx64SaveText(src);
+        REQUIRE(FileFormats::ReadSMBX64SavFileRaw(sav, "scaling.sav", loaded));
+        REQUIRE(SyntheticData::saveElements(loaded) == SyntheticData::saveElements(src));
+        if(timed)
+            savRead[step] = measure([&]()
+            {
+                GamesaveData d;
+                FileFormats::ReadSMBX64SavFileRaw(sav, "scaling.sav", d);
+            });
+    }
+    if(!timed)
+        return;
+    checkGrowth("PGE-X SAVX read", savxRead[0], savxRead[1], scale);
+    checkGrowth("PGE-X SAVX write", savxWrite[0], savxWrite[1], scale);
+    checkGrowth("SMBX64 SAV read", savRead[0], savRead[1], scale);
+}
+
+//! Writes the chunks through the raw text output, then overwrites them from the 5th character
+static void overwriteRawText(long chunks, PGESTRING &data)
+{
+    PGE_FileFormats_misc::RawTextOutput out(&data, PGE_FileFormats_misc::TextOutput::truncate);
+    for(long i = 0; i < chunks; i++)
+        out << "0123456789";
+    out.seek(5, PGE_FileFormats_misc::TextOutput::begin);
+    for(long i = 0; i < chunks; i++)
+        out << "abcdefghij";
+}
+
+TEST_CASE("[Synthetic] Generated data has requested counts and survives the round trip")
+{
+    SyntheticData::LevelConfig cfg;
+    cfg.blocks = 123;
+    cfg.bgo = 45;
+    cfg.npc = 67;
+    cfg.warps = 3;
+    cfg.physenvs = 4;
+    cfg.layers = 20;
+    cfg.events = 30;
+    cfg.eventDepth = 12;
+    cfg.stringLength = 500;
+    cfg.escapes = true;
+
+    const LevelData base = FileFormats::CreateLevelData();
+    LevelData lvl = SyntheticData::makeLevel(cfg);
+    REQUIRE(lvl.blocks.size() == 123);
+    REQUIRE(lvl.bgo.size() == 45);
+    REQUIRE(lvl.npc.size() == 67);
+    REQUIRE(lvl.doors.size() == 3);
+    REQUIRE(lvl.physez.size() == 4);
+    REQUIRE(lvl.layers.size() == base.layers.size() + 20);
+    REQUIRE(lvl.events.size() == base.events.size() + 30);
+
+    const LevelSMBX64Event &e = lvl.events.back();
+    REQUIRE(e.layers_hide.size() == 12);
+    REQUIRE(e.msg.size() == 500);
+
+    PGESTRING raw;
+    REQUIRE(FileFormats::SaveLevelData(lvl, raw, FileFormats::LVL_PGEX));
+    LevelData loaded;
+    REQUIRE(FileFormats::OpenLevelRaw(raw, "synthetic.lvlx", loaded));
+    REQUIRE(SyntheticData::levelElements(loaded) == SyntheticData::levelElements(lvl));
+    REQUIRE(loaded.events.back().msg == e.msg);
+    REQUIRE(loaded.events.back().layers_toggle.size() == 12);
+    REQUIRE(loaded.npc.front().msg == lvl.npc.front().msg);
+
+    // SMBX64 strings can't keep quotes and line feeds
+    cfg.escapes = false;
+    lvl = SyntheticData::makeLevel(cfg);
+    REQUIRE(FileFormats::SaveLevelData(lvl, raw, FileFormats::LVL_SMBX64));
+    REQUIRE(FileFormats::OpenLevelRaw(raw, "synthetic.lvl", loaded));
+    REQUIRE(loaded.events.back().msg == lvl.events.back().msg);
+
+    SyntheticData::WorldConfig wcfg;
+    wcfg.tiles = 10;
+    wcfg.scenery = 20;
+    wcfg.paths = 30;
+    wcfg.levels = 40;
+    wcfg.music = 5;
+    WorldData wld = SyntheticData::makeWorld(wcfg);
+    REQUIRE(SyntheticData::worldElements(wld) == 105);
+    PGESTRING wraw = SyntheticData::smbx38aWorldText(wld);
+    WorldData wloaded;
+    REQUIRE(FileFormats::OpenWorldRaw(wraw, "synthetic.wld", wloaded));
+    REQUIRE(wloaded.meta.RecentFormat == WorldData::SMBX38A);
+    REQUIRE(wloaded.levels.size() == 40);
+    REQUIRE(wloaded.levels.back().title == wld.levels.back().title);
+}
+
+TEST_CASE("[Scaling] Round trip of generated data at both sizes")
+{
+    levelScaling("PGE-X LVLX", FileFormats::LVL_PGEX, true, c_baseSize, c_scale, false);
+    levelScaling("SMBX64 LVL", FileFormats::LVL_SMBX64, false, c_baseSize, c_scale, false);
+    levelScaling("SMBX-38A LVL", FileFormats::LVL_SMBX38A, true, c_baseSize, c_scale, false);
+    worldScaling("PGE-X WLDX", FileFormats::WLD_PGEX, c_baseSize, c_scale, false);
+    worldScaling("SMBX64 WLD", FileFormats::WLD_SMBX64, c_baseSize, c_scale, false);
+    worldScaling("SMBX-38A WLD", FileFormats::WLD_SMBX38A, c_baseSize, c_scale, false);
+    saveScaling(c_baseSize, c_scale, false);
+
+    PGESTRING data;
+    overwriteRawText(c_baseSize * c_scale * 10, data);
+    REQUIRE(static_cast<long>(data.size()) == c_baseSize * c_scale * 100 + 5);
+    REQUIRE(data.substr(0, 12) == "01234abcdefg");
+}
+
+TEST_CASE("[Scaling] Level formats", "[.scaling]")
+{
+    levelScaling("PGE-X LVLX", FileFormats::LVL_PGEX, true, c_baseSize, c_scale, true);
+    levelScaling("SMBX64 LVL", FileFormats::LVL_SMBX64, false, c_baseSize, c_scale, true);
+    levelScaling("SMBX-38A LVL", FileFormats::LVL_SMBX38A, true, c_baseSize, c_scale, true);
+}
+
+TEST_CASE("[Scaling] World map formats", "[.scaling]")
+{
+    worldScaling("PGE-X WLDX", FileFormats::WLD_PGEX, c_baseSize, c_scale, true);
+    worldScaling("SMBX64 WLD", FileFormats::WLD_SMBX64, c_baseSize, c_scale, true);
+    worldScaling("SMBX-38A WLD", FileFormats::WLD_SMBX38A, c_baseSize, c_scale, true);
+}
+
+TEST_CASE("[Scaling] Game save formats", "[.scaling]")
+{
+    saveScaling(c_baseSize, c_scale, true);
+}
+
+TEST_CASE("[Scaling] Overwriting of raw text output", "[.scaling]")
+{
+    double t[2];
+    for(int step = 0; step < 2; step++)
+    {
+        const long chunks = (step ? c_baseSize * c_scale : c_baseSize) * 10;
+        PGESTRING data;
+        t[step] = measure([&]()
+        {
+            overwriteRawText(chunks, data);
+        });
+        REQUIRE(static_cast<long>(data.size()) == chunks * 10 + 5);
+        REQUIRE(data.substr(0, 12) == "01234abcdefg");
+    }
+    checkGrowth("RawTextOutput overwrite", t[0], t[1]);
+}
+
+/*
+ * Large sizes take minutes and gigabytes of memory, run them explicitly:
+ * ScalingTest "[.scaling-large]"
+ */
+TEST_CASE("[Scaling] Large inputs", "[.scaling-large]")
+{
+    levelScaling("PGE-X LVLX", FileFormats::LVL_PGEX, true, 10000, 100, true);
+    levelScaling("SMBX64 LVL", FileFormats::LVL_SMBX64, false, 10000, 100, true);
+    levelScaling("SMBX-38A LVL", FileFormats::LVL_SMBX38A, true, 10000, 100, true);
+    worldScaling("PGE-X WLDX", FileFormats::WLD_PGEX, 10000, 100, true);
+    worldScaling("SMBX64 WLD", FileFormats::WLD_SMBX64, 10000, 100, true);
+    worldScaling("SMBX-38A WLD", FileFormats::WLD_SMBX38A, 10000, 100, true);
+    saveScaling(10000, 100, true);
+}
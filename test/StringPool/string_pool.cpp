@@ -0,0 +1,96 @@
+#include <catch.hpp>
+#include "file_formats.h"
+#include "pge_string_pool.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("[StringPool] Interning on load")
+{
+    const PGESTRING path = "../old_deep_tests/PGEFileLib_test_files/pgex/Sky Tower.lvlx";
+    PGE_StringPool pool;
+    LevelData plain, first, second;
+
+    REQUIRE(FileFormats::OpenLevelFile(path, plain));
+
+#ifdef PGE_FILES_QT
+    FileFormats::SetStringPool(&pool);
+    REQUIRE(FileFormats::StringPool() == &pool);
+    REQUIRE(FileFormats::OpenLevelFile(path, first));
+    PGE_StringPool::Stats s1 = pool.stats();
+    REQUIRE(FileFormats::OpenLevelFile(path, second));
+    PGE_StringPool::Stats s2 = pool.stats();
+    FileFormats::SetStringPool(nullptr);
+
+    REQUIRE(s1.uniqueStrings > 0);
+    REQUIRE(s1.references > s1.uniqueStrings); // "Default" layer alone is repeated everywhere
+    REQUIRE(s2.uniqueStrings == s1.uniqueStrings);
+    REQUIRE(s2.references == s1.references * 2);
+    REQUIRE(s2.bytesDuplicated >= s1.bytesDuplicated + s1.bytesUnique);
+    REQUIRE(s2.bytesSaved == s2.bytesDuplicated);
+    REQUIRE(first.blocks[0].layer.constData() == second.blocks[0].layer.constData());
+#else
+    // std::string can't share storage, readers have no pool to use
+    REQUIRE(FileFormats::OpenLevelFile(path, first));
+    REQUIRE(FileFormats::OpenLevelFile(path, second));
+#endif
+
+    // Content is unchanged
+    PGESTRING a, b;
+    REQUIRE(FileFormats::WriteExtendedLvlFileRaw(plain, a));
+    REQUIRE(FileFormats::WriteExtendedLvlFileRaw(second, b));
+    REQUIRE(a == b);
+
+    // Direct use of the pool still measures duplicates
+    pool.internLevel(first);
+    PGE_StringPool::Stats s3 = pool.stats();
+    REQUIRE(s3.uniqueStrings > 0);
+    REQUIRE(s3.references > s3.uniqueStrings);
+
+    pool.clear();
+    REQUIRE(pool.stats().uniqueStrings == 0);
+}
+
+TEST_CASE("[StringPool] World map")
+{
+    PGE_StringPool pool;
+    WorldData wld = FileFormats::CreateWorldData();
+    for(int i = 0; i < 10; i++)
+    {
+        WorldLevelTile l = FileFormats::CreateWldLevel();
+        l.lvlfile = "a-very-long-level-file-name-which-is-not-small.lvlx";
+        wld.levels.push_back(l);
+    }
+
+    pool.internWorld(wld);
+    PGE_StringPool::Stats s = pool.stats();
+    REQUIRE(s.uniqueStrings == 2); // Layer and level file
+    REQUIRE(s.references == 20);
+    REQUIRE(s.bytesDuplicated == 9 * PGE_StringPool::heapBytes(wld.levels[0].lvlfile) +
+                                 9 * PGE_StringPool::heapBytes(wld.levels[0].layer));
+    REQUIRE(wld.levels[9].lvlfile == "a-very-long-level-file-name-which-is-not-small.lvlx");
+}
+
+TEST_CASE("[StringPool] Parallel interning")
+{
+    PGE_StringPool pool;
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&pool]()
+        {
+            for(int i = 0; i < 1000; i++)
+            {
+                PGESTRING s = PGESTRING("shared-string-which-is-long-enough-for-the-heap-") + std::to_string(i % 100).c_str();
+                pool.intern(s);
+            }
+        });
+    }
+    for(std::thread &t : threads)
+        t.join();
+
+    PGE_StringPool::Stats s = pool.stats();
+    REQUIRE(s.uniqueStrings == 100);
+    REQUIRE(s.references == 4000);
+}
@@ -0,0 +1,319 @@
+#include <catch.hpp>
+#include "file_formats.h"
+#include "world_path_graph.h"
+
+#include <algorithm>
+#include <set>
+
+static void addPath(WorldData &wld, long x, long y)
+{
+    WorldPathTile p = FileFormats::CreateWldPath();
+    p.x = x;
+    p.y = y;
+    p.meta.array_id = static_cast<unsigned int>(wld.paths.size() + 1);
+    wld.paths.push_back(p);
+}
+
+static WorldLevelTile &addLevel(WorldData &wld, long x, long y)
+{
+    WorldLevelTile l = FileFormats::CreateWldLevel();
+    l.x = x;
+    l.y = y;
+    l.meta.array_id = static_cast<unsigned int>(wld.levels.size() + 1);
+    wld.levels.push_back(l);
+    return wld.levels.back();
+}
+
+/*
+ * Level 1 at (0,0) opens the right path by exit 1, the top path by exit 2,
+ * and the left path by exit 4 or additional exit 1. Level 2 teleports
+ * to the isolated level 3, level 4 may move onto the end of the right path.
+ */
+static WorldData makeWorld()
+{
+    WorldData wld = FileFormats::CreateWorldData();
+    addPath(wld, 32, 0);    // 1
+    addPath(wld, 64, 0);    // 2
+    addPath(wld, 0, -32);   // 3
+    addPath(wld, -32, 0);   // 4
+    addPath(wld, 128, 0);   // 5
+    addPath(wld, 160, 0);   // 6
+    addPath(wld, 352, 320); // 7
+
+    WorldLevelTile &l1 = addLevel(wld, 0, 0);
+    l1.top_exit = 2;
+    l1.left_exit = 4;
+    l1.left_exit_extra.exit_codes.push_back(1);
+    l1.bottom_exit = 3;
+    l1.right_exit = 1;
+
+    WorldLevelTile &l2 = addLevel(wld, 96, 0);
+    l2.gotox = 320;
+    l2.gotoy = 320;
+
+    addLevel(wld, 320, 320);
+
+    WorldLevelTile &l4 = addLevel(wld, 640, 640);
+    WorldLevelTile::Movement::Node n;
+    n.x = 160;
+    n.y = 0;
+    l4.movement.nodes.push_back(n);
+    return wld;
+}
+
+static std::set<std::pair<long, long> > positions(const WorldPathGraph &g, const std::vector<int32_t> &nodes)
+{
+    std::set<std::pair<long, long> > out;
+    for(int32_t n : nodes)
+        out.insert(std::make_pair(g.node(n).x, g.node(n).y));
+    return out;
+}
+
+static std::vector<unsigned int> sorted(std::vector<unsigned int> v)
+{
+    std::sort(v.begin(), v.end());
+    return v;
+}
+
+TEST_CASE("[WorldPathGraph] Cells and neighbors")
+{
+    WorldData wld = makeWorld();
+    WorldPathGraph g;
+    REQUIRE(!g.isEnabled());
+    g.build(wld);
+    REQUIRE(g.isEnabled());
+    REQUIRE(g.size() == 11);
+
+    const int32_t l1 = g.levelNode(1);
+    REQUIRE(l1 == g.nodeAt(10, 10));
+    REQUIRE(g.node(l1).levelId == 1);
+    REQUIRE(g.node(l1).pathId == 0);
+    REQUIRE(g.node(g.node(l1).neighbor[WorldPathGraph::DIR_RIGHT]).pathId == 1);
+    REQUIRE(g.node(g.node(l1).neighbor[WorldPathGraph::DIR_UP]).pathId == 3);
+    REQUIRE(g.node(g.node(l1).neighbor[WorldPathGraph::DIR_LEFT]).pathId == 4);
+    REQUIRE(g.node(l1).neighbor[WorldPathGraph::DIR_DOWN] == -1);
+    REQUIRE(g.nodeAt(-1, 0) == g.nodeAt(-32, 0));
+    REQUIRE(g.nodeAt(0, 32) == -1);
+    REQUIRE(g.levelNode(100) == -1);
+    REQUIRE(g.memoryBytes() > 0);
+}
+
+TEST_CASE("[WorldPathGraph] Exits of cleared level")
+{
+    WorldData wld = makeWorld();
+    WorldPathGraph g;
+    g.build(wld);
+
+    std::vector<unsigned int> paths, levels;
+    g.openedByLevel(1, 1, paths, levels);
+    REQUIRE(sorted(paths) == std::vector<unsigned int>({1, 2, 4}));
+    REQUIRE(levels == std::vector<unsigned int>({2}));
+
+    g.openedByLevel(1, 2, paths, levels);
+    REQUIRE(paths == std::vector<unsigned int>({3}));
+    REQUIRE(levels.empty());
+
+    g.openedByLevel(1, 3, paths, levels);
+    REQUIRE(paths.empty());
+    REQUIRE(levels.empty());
+
+    // Exit codes of -1 are matching any code
+    g.openedByLevel(2, 7, paths, levels);
+    REQUIRE(sorted(paths) == std::vector<unsigned int>({1, 2, 5, 6}));
+    REQUIRE(levels == std::vector<unsigned int>({1}));
+
+    g.openedByLevel(100, 1, paths, levels);
+    REQUIRE(paths.empty());
+}
+
+TEST_CASE("[WorldPathGraph] Reachability and routes")
+{
+    WorldData wld = makeWorld();
+    WorldPathGraph g;
+    g.build(wld);
+
+    const int32_t l1 = g.levelNode(1);
+    const int32_t l3 = g.levelNode(3);
+    std::vector<int32_t> nodes;
+
+    g.reachable(l1, nodes);
+    REQUIRE(nodes.size() == 10);
+    REQUIRE(nodes.front() == l1);
+    REQUIRE(positions(g, nodes).count(std::make_pair(352L, 320L)) == 1);
+
+    g.reachable(l1, nodes, WorldPathGraph::WALK_NO_TELEPORTS);
+    REQUIRE(nodes.size() == 8);
+    REQUIRE(std::find(nodes.begin(), nodes.end(), l3) == nodes.end());
+
+    g.reachable(l1, nodes, WorldPathGraph::WALK_STOP_AT_LEVELS);
+    REQUIRE(positions(g, nodes).count(std::make_pair(128L, 0L)) == 0);
+    REQUIRE(std::find(nodes.begin(), nodes.end(), l3) != nodes.end());
+
+    std::vector<unsigned int> levels;
+    g.reachableLevels(l1, levels);
+    REQUIRE(levels.front() == 1);
+    REQUIRE(sorted(levels) == std::vector<unsigned int>({1, 2, 3, 4}));
+    g.reachableLevels(l1, levels, WorldPathGraph::WALK_NO_TELEPORTS | WorldPathGraph::WALK_STOP_AT_LEVELS);
+    REQUIRE(levels == std::vector<unsigned int>({1, 2}));
+
+    std::vector<int32_t> route;
+    REQUIRE(g.route(l1, l3, route));
+    REQUIRE(route.size() == 5);
+    REQUIRE(route.front() == l1);
+    REQUIRE(route[3] == g.levelNode(2));
+    REQUIRE(route.back() == l3);
+    REQUIRE(!g.route(l1, l3, route, WorldPathGraph::WALK_NO_TELEPORTS));
+    REQUIRE(route.empty());
+    REQUIRE(!g.route(l1, g.levelNode(4), route));
+    REQUIRE(g.route(l1, l1, route));
+    REQUIRE(route.size() == 1);
+}
+
+TEST_CASE("[WorldPathGraph] Incremental changes match the new build")
+{
+    WorldData wld = makeWorld();
+    WorldPathGraph g;
+    g.build(wld);
+
+    std::vector<int32_t> route;
+    REQUIRE(g.removePath(2));
+    REQUIRE(!g.removePath(2));
+    REQUIRE(!g.route(g.levelNode(1), g.levelNode(3), route));
+    REQUIRE(g.addPath(wld.paths[1]));
+    REQUIRE(!g.addPath(wld.paths[1]));
+    REQUIRE(g.route(g.levelNode(1), g.levelNode(3), route));
+
+    // Path tile under the level entrance keeps the cell after level removal
+    WorldPathTile under = FileFormats::CreateWldPath();
+    under.x = 96;
+    under.y = 0;
+    under.meta.array_id = 50;
+    REQUIRE(g.addPath(under));
+    REQUIRE(g.removeLevel(2));
+    REQUIRE(!g.removeLevel(2));
+    REQUIRE(g.node(g.nodeAt(96, 0)).pathId == 50);
+    REQUIRE(g.route(g.levelNode(1), g.nodeAt(160, 0), route));
+    REQUIRE(!g.route(g.levelNode(1), g.levelNode(3), route));
+    REQUIRE(g.removePath(50));
+    REQUIRE(g.nodeAt(96, 0) == -1);
+
+    REQUIRE(g.removePath(7));
+    REQUIRE(g.removeLevel(4));
+    REQUIRE(g.removePath(3));
+
+    wld.paths.erase(wld.paths.begin() + 6);
+    wld.paths.erase(wld.paths.begin() + 2);
+    wld.levels.erase(wld.levels.begin() + 3);
+    wld.levels.erase(wld.levels.begin() + 1);
+
+    WorldPathGraph fresh;
+    fresh.build(wld);
+    REQUIRE(g.size() == fresh.size());
+    for(size_t i = 0; i < g.size(); i++)
+    {
+        const WorldPathGraph::Node &n = g.node(static_cast<int32_t>(i));
+        const int32_t f = fresh.nodeAt(n.x, n.y);
+        REQUIRE(f >= 0);
+        REQUIRE(fresh.node(f).pathId == n.pathId);
+        REQUIRE(fresh.node(f).levelId == n.levelId);
+        for(int d = 0; d < 4; d++)
+        {
+            if(n.neighbor[d] < 0)
+                REQUIRE(fresh.node(f).neighbor[d] < 0);
+            else
+                REQUIRE(fresh.node(f).neighbor[d] == fresh.nodeAt(g.node(n.neighbor[d]).x, g.node(n.neighbor[d]).y));
+        }
+    }
+
+    std::vector<int32_t> a, b;
+    g.reachable(g.levelNode(1), a);
+    fresh.reachable(fresh.levelNode(1), b);
+    REQUIRE(positions(g, a) == positions(fresh, b));
+}
+
+TEST_CASE("[WorldPathGraph] Elements sharing cells")
+{
+    WorldData wld = FileFormats::CreateWorldData();
+    for(long i = 0; i < 100; i++)
+    {
+        addPath(wld, i * 32, 0);
+        addPath(wld, i * 32, 0);
+        addLevel(wld, i * 32, 32);
+        addLevel(wld, i * 32, 32);
+    }
+
+    WorldPathGraph g;
+    g.build(wld);
+    REQUIRE(g.size() == 200);
+
+    // Shared cell of the last node gets moved into the freed place
+    REQUIRE(g.removeLevel(1));
+    REQUIRE(g.removeLevel(2));
+    REQUIRE(g.size() == 199);
+    REQUIRE(g.levelNode(199) == g.levelNode(200));
+    REQUIRE(g.removeLevel(200));
+    REQUIRE(g.node(g.levelNode(199)).levelId == 199);
+    REQUIRE(g.addLevel(wld.levels[0]));
+    REQUIRE(g.addLevel(wld.levels[1]));
+    REQUIRE(g.addLevel(wld.levels[199]));
+    REQUIRE(g.size() == 200);
+
+    // Remaining element keeps the cell
+    for(unsigned int id = 1; id <= 200; id += 2)
+    {
+        REQUIRE(g.removePath(id));
+        REQUIRE(g.removeLevel(id));
+    }
+    REQUIRE(g.size() == 200);
+    REQUIRE(g.node(g.nodeAt(0, 0)).pathId == 2);
+    REQUIRE(g.node(g.levelNode(2)).levelId == 2);
+
+    wld.paths.push_back(wld.paths[1]);
+    wld.paths.back().meta.array_id = 1000;
+    REQUIRE(g.addPath(wld.paths.back()));
+    REQUIRE(g.node(g.nodeAt(0, 0)).pathId == 1000);
+
+    // Removal of first cells moves nodes of the last cells into freed places
+    REQUIRE(g.removePath(1000));
+    for(unsigned int id = 2; id <= 100; id += 2)
+    {
+        REQUIRE(g.removePath(id));
+        REQUIRE(g.removeLevel(id));
+    }
+    REQUIRE(g.size() == 100);
+    for(unsigned int id = 102; id <= 200; id += 2)
+    {
+        const WorldPathTile &p = wld.paths[id - 1];
+        const WorldLevelTile &l = wld.levels[id - 1];
+        REQUIRE(g.node(g.nodeAt(p.x, p.y)).pathId == id);
+        REQUIRE(g.node(g.levelNode(id)).x == l.x);
+        REQUIRE(g.node(g.levelNode(id)).y == l.y);
+        REQUIRE(g.node(g.levelNode(id)).levelId == id);
+    }
+
+    for(unsigned int id = 102; id <= 200; id += 2)
+    {
+        REQUIRE(g.removePath(id));
+        REQUIRE(g.removeLevel(id));
+    }
+    REQUIRE(g.size() == 0);
+}
+
+TEST_CASE("[WorldPathGraph] Built by world map readers when enabled")
+{
+    WorldData wld;
+    REQUIRE(FileFormats::OpenWorldFile("../old_deep_tests/PGEFilelib_STL_test/test.wldx", wld));
+    REQUIRE(!wld.path_graph.isEnabled());
+
+    FileFormats::SetWorldBuildPathGraph(true);
+    REQUIRE(FileFormats::WorldBuildPathGraphEnabled());
+    REQUIRE(FileFormats::OpenWorldFile("../old_deep_tests/PGEFilelib_STL_test/test.wldx", wld));
+    FileFormats::SetWorldBuildPathGraph(false);
+
+    REQUIRE(wld.path_graph.isEnabled());
+    REQUIRE(wld.path_graph.size() > 0);
+    for(const WorldPathTile &p : wld.paths)
+        REQUIRE(wld.path_graph.nodeAt(p.x, p.y) >= 0);
+    for(const WorldLevelTile &l : wld.levels)
+        REQUIRE(wld.path_graph.node(wld.path_graph.levelNode(l.meta.array_id)).x == l.x - (l.x % 32 + 32) % 32);
+}
@@ -0,0 +1,231 @@
+#include <catch.hpp>
+#include "file_formats.h"
+#include "world_spatial_index.h"
+
+#include <algorithm>
+#include <map>
+
+typedef std::pair<int, unsigned int> ItemId;
+
+static std::vector<ItemId> sorted(const std::vector<WorldSpatialIndex::Item> &items)
+{
+    std::vector<ItemId> out;
+    for(const WorldSpatialIndex::Item &i : items)
+        out.push_back(ItemId(i.type, i.arrayId));
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+static std::vector<ItemId> bruteForce(const std::map<ItemId, WorldSpatialIndex::Rect> &items,
+                                      long l, long t, long r, long b, unsigned int typeMask)
+{
+    std::vector<ItemId> out;
+    for(const auto &i : items)
+    {
+        const WorldSpatialIndex::Rect &e = i.second;
+        if(((typeMask >> i.first.first) & 1u) == 0)
+            continue;
+        if(e.left < r && e.right > l && e.top < b && e.bottom > t)
+            out.push_back(i.first);
+    }
+    return out;
+}
+
+TEST_CASE("[WorldSpatialIndex] Matches the brute force")
+{
+    WorldSpatialIndex index;
+    std::map<ItemId, WorldSpatialIndex::Rect> model;
+    unsigned int seed = 12345;
+    auto rnd = [&seed](long range) -> long
+    {
+        seed = seed * 1103515245u + 12345u;
+        return static_cast<long>((seed >> 8) % static_cast<unsigned int>(range));
+    };
+    // Mostly tiles on the grid, some area rectangles, rare elements far away
+    auto place = [&rnd](int type, long &x, long &y, long &w, long &h)
+    {
+        x = (rnd(200) - 100) * 32;
+        y = (rnd(200) - 100) * 32;
+        w = h = (type == WorldSpatialIndex::ITEM_SCENERY) ? 16 : 32;
+        if(type == WorldSpatialIndex::ITEM_AREARECT)
+        {
+            w = rnd(800) + 1;
+            h = rnd(800) + 1;
+            if(rnd(20) == 0)
+                w = h = 100000;
+        }
+        if(rnd(100) == 0)
+            x += 50000000;
+    };
+
+    for(unsigned int i = 1; i <= 3000; i++)
+    {
+        int type = static_cast<int>(rnd(6));
+        long x, y, w, h;
+        place(type, x, y, w, h);
+        REQUIRE(index.insert(type, i, x, y, w, h));
+        model[ItemId(type, i)] = {x, y, x + w, y + h};
+    }
+
+    REQUIRE(!index.insert(model.begin()->first.first, model.begin()->first.second, 0, 0, 1, 1));
+    REQUIRE(index.size() == model.size());
+
+    for(int step = 0; step < 2000; step++)
+    {
+        auto it = model.begin();
+        std::advance(it, rnd(static_cast<long>(model.size())));
+        if(step % 3 == 0)
+        {
+            REQUIRE(index.remove(it->first.first, it->first.second));
+            REQUIRE(!index.contains(it->first.first, it->first.second));
+            model.erase(it);
+        }
+        else
+        {
+            long x, y, w, h;
+            place(it->first.first, x, y, w, h);
+            REQUIRE(index.move(it->first.first, it->first.second, x, y, w, h));
+            it->second = {x, y, x + w, y + h};
+        }
+    }
+
+    REQUIRE(index.size() == model.size());
+    REQUIRE(!index.remove(100, 1));
+
+    std::vector<WorldSpatialIndex::Item> found;
+    for(int q = 0; q < 300; q++)
+    {
+        long l = rnd(8000) - 4000, t = rnd(8000) - 4000;
+        long r = l + rnd(1000) + 1, b = t + rnd(1000) + 1;
+        unsigned int mask = (q % 2) ? static_cast<unsigned int>(WorldSpatialIndex::MASK_ALL) :
+                            static_cast<unsigned int>(rnd(WorldSpatialIndex::MASK_ALL) + 1);
+        index.queryRect(l, t, r, b, found, mask);
+        REQUIRE(sorted(found) == bruteForce(model, l, t, r, b, mask));
+
+        index.queryPoint(l, t, found, mask);
+        std::vector<ItemId> here = bruteForce(model, l, t, l + 1, t + 1, mask);
+        REQUIRE(sorted(found) == here);
+
+        for(int type = 0; type < 6; type++)
+        {
+            unsigned int top = 0;
+            for(const ItemId &i : bruteForce(model, l, t, l + 1, t + 1, 1u << type))
+                top = std::max(top, i.second);
+            REQUIRE(index.findAt(type, l, t) == top);
+        }
+    }
+
+    index.queryRect(-100000000, -100000000, 100000000, 100000000, found);
+    REQUIRE(found.size() == model.size());
+
+    index.clear();
+    REQUIRE(!index.isEnabled());
+    index.queryRect(-100000, -100000, 100000, 100000, found);
+    REQUIRE(found.empty());
+}
+
+TEST_CASE("[WorldSpatialIndex] Built by world map readers")
+{
+    WorldData plain, wld;
+    REQUIRE(FileFormats::OpenWorldFile("../old_deep_tests/PGEFilelib_STL_test/test.wldx", plain));
+    REQUIRE(!plain.spatial_index.isEnabled());
+
+    FileFormats::SetWorldBuildSpatialIndex(true);
+    REQUIRE(FileFormats::WorldBuildSpatialIndexEnabled());
+    REQUIRE(FileFormats::OpenWorldFile("../old_deep_tests/PGEFilelib_STL_test/test.wldx", wld));
+    REQUIRE(wld.meta.ReadFileValid);
+    REQUIRE(wld.spatial_index.isEnabled());
+    REQUIRE(wld.spatial_index.size() == static_cast<size_t>(wld.tiles.size() + wld.scenery.size() + wld.paths.size() +
+                                                            wld.levels.size() + wld.music.size() + wld.arearects.size()));
+
+    REQUIRE(!wld.levels.empty());
+    WorldLevelTile &l = wld.levels[0];
+    REQUIRE(wld.spatial_index.findAt(WorldSpatialIndex::ITEM_LEVEL, l.x + 16, l.y + 16) == l.meta.array_id);
+
+    // Incremental update
+    l.x += 32 * 10;
+    REQUIRE(wld.spatial_index.move(l));
+    REQUIRE(wld.spatial_index.findAt(WorldSpatialIndex::ITEM_LEVEL, l.x, l.y) == l.meta.array_id);
+    WorldSpatialIndex::Rect r;
+    REQUIRE(wld.spatial_index.contains(WorldSpatialIndex::ITEM_LEVEL, l.meta.array_id, &r));
+    REQUIRE(r.left == l.x);
+    REQUIRE(r.right == l.x + 32);
+
+    WorldAreaRect area;
+    area.meta.array_id = 1000;
+    area.x = l.x - 64;
+    area.y = l.y - 64;
+    area.w = 256;
+    area.h = 256;
+    REQUIRE(wld.spatial_index.insert(area));
+    std::vector<WorldSpatialIndex::Item> found;
+    wld.spatial_index.queryPoint(l.x, l.y, found, WorldSpatialIndex::MASK_AREARECT | WorldSpatialIndex::MASK_LEVEL);
+    REQUIRE(sorted(found) == std::vector<ItemId>{ItemId(WorldSpatialIndex::ITEM_LEVEL, l.meta.array_id),
+                                                  ItemId(WorldSpatialIndex::ITEM_AREARECT, 1000)});
+
+    WorldData smbx64;
+    REQUIRE(FileFormats::OpenWorldFile("../old_deep_tests/PGEFilelib_STL_test/test.wld", smbx64));
+    REQUIRE(smbx64.spatial_index.isEnabled());
+    REQUIRE(!smbx64.tiles.empty());
+    const WorldTerrainTile &t = smbx64.tiles.back();
+    REQUIRE(smbx64.spatial_index.findAt(WorldSpatialIndex::ITEM_TILE, t.x, t.y) != 0);
+
+    WorldData smbx38a;
+    REQUIRE(FileFormats::OpenWorldFile("../old_deep_tests/PGEFileLib_test_files/smbx38a_wld/tinvworld.wld", smbx38a));
+    REQUIRE(smbx38a.spatial_index.isEnabled());
+    REQUIRE(smbx38a.spatial_index.size() >= static_cast<size_t>(smbx38a.tiles.size()));
+    FileFormats::SetWorldBuildSpatialIndex(false);
+}
+
+TEST_CASE("[WorldSpatialIndex] Lookup on the big world map")
+{
+    WorldData wld;
+    unsigned int id = 1;
+    for(long y = 0; y < 300; y++)
+    {
+        for(long x = 0; x < 300; x++)
+        {
+            WorldTerrainTile t;
+            t.meta.array_id = id++;
+            t.x = x * 32;
+            t.y = y * 32;
+            wld.tiles.push_back(t);
+        }
+    }
+    for(unsigned int i = 1; i <= 2000; i++)
+    {
+        WorldPathTile p;
+        p.meta.array_id = i;
+        p.x = static_cast<long>(i % 300) * 32;
+        p.y = static_cast<long>(i / 300) * 32;
+        wld.paths.push_back(p);
+    }
+    wld.spatial_index.build(wld);
+
+    size_t foundScan = 0, foundIndex = 0;
+    BENCHMARK("Scan of 2000 paths, 1000 steps")
+    {
+        for(long step = 0; step < 1000; step++)
+        {
+            const long x = (step % 300) * 32 + 16, y = (step / 300) * 32 + 16;
+            for(const WorldPathTile &p : wld.paths)
+            {
+                if(x >= p.x && x < p.x + 32 && y >= p.y && y < p.y + 32)
+                {
+                    foundScan++;
+                    break;
+                }
+            }
+        }
+    }
+    BENCHMARK("Index of 92000 elements, 1000 steps")
+    {
+        for(long step = 0; step < 1000; step++)
+        {
+            const long x = (step % 300) * 32 + 16, y = (step / 300) * 32 + 16;
+            if(wld.spatial_index.findAt(WorldSpatialIndex::ITEM_PATH, x, y) != 0)
+                foundIndex++;
+        }
+    }
+    REQUIRE(foundScan == foundIndex);
+}
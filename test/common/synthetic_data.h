@@ -0,0 +1,483 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*!
+ * \file synthetic_data.h
+ * \brief Generator of valid level, world map and game save data of any size for tests and benchmarks
+ */
+
+#pragma once
+#ifndef PGE_SYNTHETIC_DATA_H
+#define PGE_SYNTHETIC_DATA_H
+
+#include "file_formats.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+
+namespace SyntheticData
+{
+
+/*!
+ * \brief Counts of generated level elements
+ */
+struct LevelConfig
+{
+    long blocks = 600;
+    long bgo = 250;
+    long npc = 100;
+    long warps = 20;
+    long physenvs = 30;
+    //! Layers besides the standard ones
+    long layers = 10;
+    //! Events besides the standard ones
+    long events = 10;
+    //! Number of layers hidden, shown and toggled by every event
+    long eventDepth = 3;
+    //! Length of messages of NPCs and events
+    long stringLength = 16;
+    //! Put quotes, backslashes and new lines into messages (unsupported by SMBX64 formats)
+    bool escapes = false;
+    //! Varies element IDs and positions
+    unsigned int seed = 1;
+
+    /*!
+     * \brief Config with the usual proportion of elements
+     * \param elements Total number of elements
+     */
+    static LevelConfig scaled(long elements)
+    {
+        LevelConfig c;
+        c.blocks = elements * 60 / 100;
+        c.bgo = elements * 25 / 100;
+        c.npc = elements * 10 / 100;
+        c.warps = std::max(1L, elements * 2 / 100);
+        c.physenvs = std::max(1L, elements * 3 / 100);
+        c.layers = std::max(1L, elements / 1000);
+        c.events = c.layers;
+        return c;
+    }
+};
+
+/*!
+ * \brief Counts of generated world map elements
+ */
+struct WorldConfig
+{
+    long tiles = 600;
+    long scenery = 200;
+    long paths = 100;
+    long levels = 80;
+    long music = 20;
+    //! Length of level titles
+    long stringLength = 16;
+    //! Varies element IDs and positions
+    unsigned int seed = 1;
+
+    /*!
+     * \brief Config with the usual proportion of elements
+     * \param elements Total number of elements
+     */
+    static WorldConfig scaled(long elements)
+    {
+        WorldConfig c;
+        c.tiles = elements * 60 / 100;
+        c.scenery = elements * 20 / 100;
+        c.paths = elements * 10 / 100;
+        c.levels = std::max(1L, elements * 8 / 100);
+        c.music = std::max(1L, elements * 2 / 100);
+        return c;
+    }
+};
+
+inline PGESTRING toStr(const std::string &s)
+{
+#ifdef PGE_FILES_QT
+    return QString::fromStdString(s);
+#else
+    return s;
+#endif
+}
+
+inline PGESTRING num(long v)
+{
+    return toStr(std::to_string(v));
+}
+
+/*!
+ * \brief Text of the given length
+ * \param prefix Beginning of the text
+ * \param length Total length of the text
+ * \param escapes Use characters which require escaping by PGE-X and SMBX-38A formats
+ */
+inline PGESTRING text(const std::string &prefix, long length, bool escapes)
+{
+    static const char plain[] = "Lorem ipsum, dolor sit amet; ";
+    static const char escaped[] = "Say \"hi\", C:\\path\\; [x]:{y}\nnext line ";
+    const char *fill = escapes ? escaped : plain;
+    const size_t fillLen = escapes ? sizeof(escaped) - 1 : sizeof(plain) - 1;
+
+    std::string out = prefix;
+    for(size_t i = 0; static_cast<long>(out.size()) < length; i++)
+        out.push_back(fill[i % fillLen]);
+    return toStr(out);
+}
+
+inline PGESTRING layerName(long i)
+{
+    return "Layer " + num(i);
+}
+
+inline PGESTRING eventName(long i)
+{
+    return "Event " + num(i);
+}
+
+/*!
+ * \brief Generates the level
+ * \param c Counts of elements
+ * \return Level data with all elements placed into the first section
+ */
+inline LevelData makeLevel(const LevelConfig &c)
+{
+    LevelData lvl = FileFormats::CreateLevelData();
+    const long layers = std::max(1L, c.layers);
+    const long s = static_cast<long>(c.seed);
+
+    for(long i = 0; i < c.layers; i++)
+    {
+        LevelLayer l = FileFormats::CreateLvlLayer();
+        l.name = layerName(i);
+        l.hidden = (i % 3) == 0;
+        l.meta.array_id = lvl.layers_array_id++;
+        lvl.layers.push_back(l);
+    }
+
+    for(long i = 0; i < c.events; i++)
+    {
+        LevelSMBX64Event e = FileFormats::CreateLvlEvent();
+        e.name = eventName(i);
+        e.msg = text("Event " + std::to_string(i) + ": ", c.stringLength, c.escapes);
+        for(long d = 0; d < c.eventDepth && c.layers > 0; d++)
+        {
+            e.layers_hide.push_back(layerName((i + d) % layers));
+            e.layers_show.push_back(layerName((i + d + 1) % layers));
+            e.layers_toggle.push_back(layerName((i + d + 2) % layers));
+        }
+        if(c.eventDepth > 0 && e.sets.size() > 0)
+        {
+            e.sets[0].music_id = (i % 50) + 1;
+            e.sets[0].background_id = (i % 60) + 1;
+        }
+        e.trigger = eventName((i + 1) % c.events);
+        e.trigger_timer = 10;
+        e.meta.array_id = lvl.events_array_id++;
+        lvl.events.push_back(e);
+    }
+
+    const PGESTRING defaultLayer = "Default";
+    auto layerOf = [&](long i) -> PGESTRING
+    {
+        return c.layers > 0 ? layerName(i % layers) : defaultLayer;
+    };
+
+    for(long i = 0; i < c.blocks; i++)
+    {
+        LevelBlock b = FileFormats::CreateLvlBlock();
+        b.x = -200000 + (i % 500) * 32;
+        b.y = -200600 + (i / 500) * 32;
+        b.w = 32;
+        b.h = 32;
+        b.id = static_cast<unsigned long>(1 + (i + s) % 600);
+        b.npc_id = (i % 17 == 0) ? -10 : 0;
+        b.invisible = (i % 31) == 0;
+        b.layer = layerOf(i);
+        if(i % 11 == 0 && c.events > 0)
+            b.event_hit = eventName(i % c.events);
+        b.meta.array_id = lvl.blocks_array_id++;
+        lvl.blocks.push_back(b);
+    }
+
+    for(long i = 0; i < c.bgo; i++)
+    {
+        LevelBGO b = FileFormats::CreateLvlBgo();
+        b.x = -200000 + (i % 400) * 32;
+        b.y = -200600 + (i / 400) * 32;
+        b.id = static_cast<unsigned long>(1 + (i + s) % 190);
+        b.layer = layerOf(i);
+        b.meta.array_id = lvl.bgo_array_id++;
+        lvl.bgo.push_back(b);
+    }
+
+    for(long i = 0; i < c.npc; i++)
+    {
+        LevelNPC n = FileFormats::CreateLvlNpc();
+        n.x = -200000 + (i % 300) * 32;
+        n.y = -200600 + (i / 300) * 32;
+        n.id = static_cast<uint64_t>(1 + (i + s) % 290);
+        n.direct = (i % 2) ? 1 : -1;
+        n.layer = layerOf(i);
+        if(i % 7 == 0)
+            n.msg = text("NPC " + std::to_string(i) + ": ", c.stringLength, c.escapes);
+        if(i % 13 == 0 && c.events > 0)
+            n.event_die = eventName(i % c.events);
+        n.meta.array_id = lvl.npc_array_id++;
+        lvl.npc.push_back(n);
+    }
+
+    for(long i = 0; i < c.warps; i++)
+    {
+        LevelDoor d = FileFormats::CreateLvlWarp();
+        d.ix = -200000 + i * 64;
+        d.iy = -200600;
+        d.ox = -180000 + i * 64;
+        d.oy = -180600;
+        d.isSetIn = true;
+        d.isSetOut = true;
+        d.layer = layerOf(i);
+        d.meta.array_id = lvl.doors_array_id++;
+        lvl.doors.push_back(d);
+    }
+
+    for(long i = 0; i < c.physenvs; i++)
+    {
+        LevelPhysEnv p = FileFormats::CreateLvlPhysEnv();
+        p.x = -200000 + (i % 100) * 128;
+        p.y = -200600 + (i / 100) * 128;
+        p.w = 128;
+        p.h = 96;
+        p.layer = layerOf(i);
+        p.meta.array_id = lvl.physenv_array_id++;
+        lvl.physez.push_back(p);
+    }
+
+    return lvl;
+}
+
+//! Number of elements in the level, including layers and events
+inline size_t levelElements(const LevelData &l)
+{
+    return static_cast<size_t>(l.blocks.size() + l.bgo.size() + l.npc.size() + l.doors.size() +
+                               l.physez.size() + l.layers.size() + l.events.size());
+}
+
+/*!
+ * \brief Generates the world map
+ * \param c Counts of elements
+ * \return World map data
+ */
+inline WorldData makeWorld(const WorldConfig &c)
+{
+    WorldData wld = FileFormats::CreateWorldData();
+    wld.EpisodeTitle = "Synthetic episode";
+    const long s = static_cast<long>(c.seed);
+
+    for(long i = 0; i < c.tiles; i++)
+    {
+        WorldTerrainTile t = FileFormats::CreateWldTile();
+        t.x = (i % 500) * 32;
+        t.y = (i / 500) * 32;
+        t.id = static_cast<unsigned long>(1 + (i + s) % 300);
+        t.meta.array_id = wld.tile_array_id++;
+        wld.tiles.push_back(t);
+    }
+
+    for(long i = 0; i < c.scenery; i++)
+    {
+        WorldScenery sc = FileFormats::CreateWldScenery();
+        sc.x = (i % 500) * 16;
+        sc.y = (i / 500) * 16;
+        sc.id = static_cast<unsigned long>(1 + (i + s) % 60);
+        sc.meta.array_id = wld.scene_array_id++;
+        wld.scenery.push_back(sc);
+    }
+
+    for(long i = 0; i < c.paths; i++)
+    {
+        WorldPathTile p = FileFormats::CreateWldPath();
+        p.x = (i % 500) * 32;
+        p.y = 1000000 + (i / 500) * 32;
+        p.id = static_cast<unsigned long>(1 + (i + s) % 50);
+        p.meta.array_id = wld.path_array_id++;
+        wld.paths.push_back(p);
+    }
+
+    for(long i = 0; i < c.levels; i++)
+    {
+        WorldLevelTile l = FileFormats::CreateWldLevel();
+        l.x = (i % 500) * 32;
+        l.y = 2000000 + (i / 500) * 32;
+        l.id = static_cast<unsigned long>(1 + (i + s) % 30);
+        l.lvlfile = "level-" + num(i) + ".lvlx";
+        l.title = text("Level " + std::to_string(i) + ", ", c.stringLength, false);
+        l.top_exit = static_cast<int>(i % 3) - 1;
+        l.right_exit = 1;
+        l.meta.array_id = wld.level_array_id++;
+        wld.levels.push_back(l);
+    }
+
+    for(long i = 0; i < c.music; i++)
+    {
+        WorldMusicBox m = FileFormats::CreateWldMusicbox();
+        m.x = (i % 500) * 32;
+        m.y = 3000000 + (i / 500) * 32;
+        m.id = static_cast<unsigned long>(1 + (i + s) % 16);
+        m.meta.array_id = wld.musicbox_array_id++;
+        wld.music.push_back(m);
+    }
+
+    return wld;
+}
+
+//! Number of elements in the world map
+inline size_t worldElements(const WorldData &w)
+{
+    return static_cast<size_t>(w.tiles.size() + w.scenery.size() + w.paths.size() +
+                               w.levels.size() + w.music.size());
+}
+
+/*!
+ * \brief Generates the game save
+ * \param elements Total number of visible states and gotten stars
+ * \return Game save data
+ */
+inline GamesaveData makeSave(long elements)
+{
+    GamesaveData sav = FileFormats::CreateGameSaveData();
+    sav.lives = 5;
+    sav.coins = 42;
+    sav.totalStars = static_cast<unsigned int>(elements / 10);
+
+    const long visible = elements * 3 / 10;
+    for(long i = 1; i <= visible; i++)
+    {
+        sav.visibleLevels.push_back(visibleItem(static_cast<unsigned int>(i), (i % 3) != 0));
+        sav.visiblePaths.push_back(visibleItem(static_cast<unsigned int>(i), (i % 2) != 0));
+        sav.visibleScenery.push_back(visibleItem(static_cast<unsigned int>(i), (i % 5) != 0));
+    }
+
+    for(long i = 0; i < elements / 10; i++)
+        sav.gottenStars.push_back(starOnLevel("level-" + num(i / 3) + ".lvlx", static_cast<int>(i % 3)));
+
+    return sav;
+}
+
+//! Number of visible states, gotten stars and user data entries in the game save
+inline size_t saveElements(const GamesaveData &s)
+{
+    size_t n = static_cast<size_t>(s.visibleLevels.size() + s.visiblePaths.size() +
+                                   s.visibleScenery.size() + s.gottenStars.size());
+    for(const saveUserData::DataSection &d : s.userData.store)
+        n += static_cast<size_t>(d.data.size());
+    return n;
+}
+
+inline std::string toStd(const PGESTRING &s)
+{
+#ifdef PGE_FILES_QT
+    return s.toStdString();
+#else
+    return s;
+#endif
+}
+
+/*!
+ * \brief Text of SMBX64 game save, the library has no writer of this format
+ * \param sav Game save data
+ * \return File data
+ */
+inline PGESTRING smbx64SaveText(const GamesaveData &sav)
+{
+    auto n = [](long v) { return std::to_string(v); };
+    std::string out;
+    out += "64\n" + n(sav.lives) + "\n" + n(static_cast<long>(sav.coins)) + "\n0\n0\n";
+    for(int i = 0; i < 5; i++)
+        out += "2\n0\n0\n0\n1\n";
+    out += "0\n#FALSE#\n";
+
+    const PGELIST<visibleItem> *lists[3] = {&sav.visibleLevels, &sav.visiblePaths, &sav.visibleScenery};
+    for(const PGELIST<visibleItem> *l : lists)
+    {
+        for(const visibleItem &v : *l)
+            out += v.second ? "#TRUE#\n" : "#FALSE#\n";
+        out += "\"next\"\n";
+    }
+
+    for(const starOnLevel &st : sav.gottenStars)
+        out += "\"" + toStd(st.first) + "\"\n" + n(st.second) + "\n";
+    out += "\"next\"\n" + n(static_cast<long>(sav.totalStars)) + "\n";
+    return toStr(out);
+}
+
+//! Percent-encoded string of SMBX-38A formats
+inline std::string percentEncode(const PGESTRING &s)
+{
+    static const char *hex = "0123456789ABCDEF";
+    const std::string in = toStd(s);
+    std::string out;
+    for(unsigned char ch : in)
+    {
+        out.push_back('%');
+        out.push_back(hex[ch >> 4]);
+        out.push_back(hex[ch & 0x0F]);
+    }
+    return out;
+}
+
+/*!
+ * \brief Text of SMBX-38A world map, the library has no writer of this format
+ * \param wld World map data
+ * \return File data
+ */
+inline PGESTRING smbx38aWorldText(const WorldData &wld)
+{
+    auto n = [](long v) { return std::to_string(v); };
+    std::string out = "SMBXFile66\n";
+    out += "WS1|" + percentEncode(wld.EpisodeTitle) + "|0,0,0,0,0||0,0,0,0,0,0,1,0|0,0|0|0\n";
+    out += "WS2|\nWS3|\nWS4||\n";
+    out += "WL|" + percentEncode("Default") + "|1\n";
+
+    for(const WorldTerrainTile &t : wld.tiles)
+        out += "T|" + n(static_cast<long>(t.id)) + "|" + n(t.x) + "|" + n(t.y) + "|\n";
+    for(const WorldScenery &sc : wld.scenery)
+        out += "S|" + n(static_cast<long>(sc.id)) + "|" + n(sc.x) + "|" + n(sc.y) + "|\n";
+    for(const WorldPathTile &p : wld.paths)
+        out += "P|" + n(static_cast<long>(p.id)) + "|" + n(p.x) + "|" + n(p.y) + "|\n";
+    for(const WorldLevelTile &l : wld.levels)
+    {
+        out += "L|" + n(static_cast<long>(l.id)) + "|" + n(l.x) + "|" + n(l.y) + "|" +
+               percentEncode(l.lvlfile) + "|" + percentEncode(l.title) +
+               "|-1,0,0,\\-1,0,0,\\-1,0,0,\\-1,0,0,\\\\|-1|-1|0|0,0,0,0,0,0,0,0,0|||\n";
+    }
+    for(const WorldMusicBox &m : wld.music)
+        out += "M|" + n(static_cast<long>(m.id)) + "|" + n(m.x) + "|" + n(m.y) + "|||32|32|1|,0\n";
+    return toStr(out);
+}
+
+} // namespace SyntheticData
+
+#endif // PGE_SYNTHETIC_DATA_H
@@ -27,8 +27,9 @@
 #include "file_formats.h"
 #include "wld_filedata.h"
 #include "pge_file_lib_private.h"
+#include "pge_sort_private.h"
 
-#include <stack>
+#include <atomic>
 
 int FileFormats::smbx64WorldCheckLimits(WorldData &wld)
 {
@@ -108,75 +109,67 @@ WorldData FileFormats::CreateWorldData()
 }
 
 
-template<class T, class U>
-void quickSortByArrayId(T &array)
+template<class T>
+static void sortByArrayId(PGELIST<T> &array)
 {
-    if(array.size() <= 1)
-        return; //Nothing to sort!
-
-    class my_stack : public std::stack< int >
-    {
-    public:
-        using std::stack<int>::c; // expose the container
-    };
-
-    my_stack beg;
-    my_stack end;
-    U piv;
-    int i = 0, L, R, swapv;
-    beg.push(0);
-    end.push(static_cast<int>(array.size()));
-#define ST(x) static_cast<pge_size_t>(x)
-    while(i >= 0)
+    PGE_SortElements<1>(array, [](const T &e, uint64_t *w)
     {
-        L = beg.c[ST(i)];
-        R = end.c[ST(i)] - 1;
-        if(L < R)
-        {
-            piv = array[ST(L)];
-            while(L < R)
-            {
-                while(
-                      (array[ST(R)].meta.array_id >= piv.meta.array_id) &&
-                      (L < R)) R--;
-                if(L < R) array[ST(L++)] = array[ST(R)];
-
-                while(
-                    (
-                        (array[ST(L)].meta.array_id <= piv.meta.array_id)
-                    ) && (L < R)) L++;
-                if(L < R) array[ST(R--)] = array[ST(L)];
-            }
-            array[ST(L)] = piv;
-            beg.push(L + 1);
-            end.push(end.c[ST(i)]);
-            end.c[ST(i++)] = (L);
-            if((end.c[ST(i)] - beg.c[ST(i)]) > (end.c[ST(i - 1)] - beg.c[ST(i - 1)]))
-            {
-                swapv = beg.c[ST(i)];
-                beg.c[ST(i)] = beg.c[ST(i - 1)];
-                beg.c[ST(i - 1)] = swapv;
-                swapv = end.c[ST(i)];
-                end.c[ST(i)] = end.c[ST(i - 1)];
-                end.c[ST(i - 1)] = swapv;
-            }
-        }
-        else
-        {
-            i--;
-            beg.pop();
-            end.pop();
-        }
-    }
-#undef ST
+        w[0] = e.meta.array_id;
+    });
 }
 
 
 void FileFormats::WorldPrepare(WorldData &wld)
 {
-    quickSortByArrayId<PGELIST<WorldTerrainTile>, WorldTerrainTile>(wld.tiles);
-    quickSortByArrayId<PGELIST<WorldScenery>, WorldScenery>(wld.scenery);
-    quickSortByArrayId<PGELIST<WorldPathTile>, WorldPathTile>(wld.paths);
-    quickSortByArrayId<PGELIST<WorldLevelTile>, WorldLevelTile>(wld.levels);
-    quickSortByArrayId<PGELIST<WorldMusicBox>, WorldMusicBox>(wld.music);
+    sortByArrayId(wld.tiles);
+    sortByArrayId(wld.scenery);
+    sortByArrayId(wld.paths);
+    sortByArrayId(wld.levels);
+    sortByArrayId(wld.music);
+    wld.refreshArrayIdMaps();
+}
+
+static std::atomic<bool> s_wldBuildSpatialIndex(false);
+static std::atomic<bool> s_wldBuildPathGraph(false);
+
+void FileFormats::SetWorldBuildSpatialIndex(bool enabled)
+{
+    s_wldBuildSpatialIndex = enabled;
+}
+
+bool FileFormats::WorldBuildSpatialIndexEnabled()
+{
+    return s_wldBuildSpatialIndex;
+}
+
+void FileFormats::SetWorldBuildPathGraph(bool enabled)
+{
+    s_wldBuildPathGraph = enabled;
+}
+
+bool FileFormats::WorldBuildPathGraphEnabled()
+{
+    return s_wldBuildPathGraph;
+}
+
+void WorldData::buildArrayIdMaps()
+{
+    tiles_arrayid_map.rebuild(tiles);
+    scenery_arrayid_map.rebuild(scenery);
+    paths_arrayid_map.rebuild(paths);
+    levels_arrayid_map.rebuild(levels);
+    music_arrayid_map.rebuild(music);
+    arearects_arrayid_map.rebuild(arearects);
+    layers_arrayid_map.rebuild(layers);
+}
+
+void WorldData::refreshArrayIdMaps()
+{
+    tiles_arrayid_map.refresh(tiles);
+    scenery_arrayid_map.refresh(scenery);
+    paths_arrayid_map.refresh(paths);
+    levels_arrayid_map.refresh(levels);
+    music_arrayid_map.refresh(music);
+    arearects_arrayid_map.refresh(arearects);
+    layers_arrayid_map.refresh(layers);
 }
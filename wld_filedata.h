@@ -35,6 +35,8 @@
 
 #include "pge_file_lib_globs.h"
 #include "meta_filedata.h"
+#include "world_spatial_index.h"
+#include "world_path_graph.h"
 
 #ifndef DEFAULT_LAYER_NAME
 #define DEFAULT_LAYER_NAME "Default"
@@ -554,6 +556,57 @@ struct WorldData
     int     CurSection = 0;
     bool    playmusic = false;
     int     currentMusic = 0;
+
+    /*
+     * Array-ID to index maps (disabled until buildArrayIdMaps() call)
+     */
+    ElementArrayIdMap tiles_arrayid_map;
+    ElementArrayIdMap scenery_arrayid_map;
+    ElementArrayIdMap paths_arrayid_map;
+    ElementArrayIdMap levels_arrayid_map;
+    ElementArrayIdMap music_arrayid_map;
+    ElementArrayIdMap arearects_arrayid_map;
+    ElementArrayIdMap layers_arrayid_map;
+
+    /*!
+     * \brief Enables and fills Array-ID to index maps of all element collections
+     */
+    void buildArrayIdMaps();
+    /*!
+     * \brief Refills enabled Array-ID to index maps after reordering of element collections
+     */
+    void refreshArrayIdMaps();
+
+    /*!
+     * \brief Grid index of element positions, built by world map readers
+     *        when FileFormats::SetWorldBuildSpatialIndex() is enabled
+     *
+     * Changes of element positions and collections should be reflected
+     * via insert(), move() and remove() of the index, or by the new build.
+     */
+    WorldSpatialIndex spatial_index;
+    /*!
+     * \brief Connectivity of paths and level entrances, built by world map
+     *        readers when FileFormats::SetWorldBuildPathGraph() is enabled
+     */
+    WorldPathGraph path_graph;
 };
 
+/*!
+ * \brief List of element collections of the WorldData
+ *
+ * Every entry is X(element type, field name of WorldData)
+ */
+#define PGE_WORLD_COLLECTIONS(X) \
+    X(WorldTerrainTile, tiles) \
+    X(WorldScenery, scenery) \
+    X(WorldPathTile, paths) \
+    X(WorldLevelTile, levels) \
+    X(WorldMusicBox, music) \
+    X(WorldAreaRect, arearects) \
+    X(WorldLayer, layers) \
+    X(WorldEvent38A, events38A) \
+    X(WorldItemSetup38A, custom38A_configs) \
+    X(PGESTRING, unsupported_38a_lines)
+
 #endif // WLD_FILEDATA_H
@@ -0,0 +1,470 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "world_path_graph.h"
+#include "wld_filedata.h"
+
+#include <algorithm>
+
+static const WorldPathGraph::Direction c_pathOpposite[4] =
+{
+    WorldPathGraph::DIR_DOWN,
+    WorldPathGraph::DIR_RIGHT,
+    WorldPathGraph::DIR_UP,
+    WorldPathGraph::DIR_LEFT
+};
+
+static const long c_pathStepX[4] = {0, -1, 0, 1};
+static const long c_pathStepY[4] = {-1, 0, 1, 0};
+
+//! Takes one of Array-IDs sharing the node, 0 if none
+static unsigned int pathGraphTakeExtra(std::unordered_multimap<int32_t, unsigned int> &extra, int32_t node)
+{
+    auto it = extra.find(node);
+    if(it == extra.end())
+        return 0;
+    const unsigned int arrayId = it->second;
+    extra.erase(it);
+    return arrayId;
+}
+
+static void pathGraphEraseExtra(std::unordered_multimap<int32_t, unsigned int> &extra, int32_t node, unsigned int arrayId)
+{
+    auto range = extra.equal_range(node);
+    for(auto it = range.first; it != range.second; ++it)
+    {
+        if(it->second == arrayId)
+        {
+            extra.erase(it);
+            return;
+        }
+    }
+}
+
+//! Moves Array-IDs sharing the node to it's new index, the list gets Array-IDs which were moved
+static void pathGraphMoveExtra(std::unordered_multimap<int32_t, unsigned int> &extra, int32_t from, int32_t to,
+                               std::vector<unsigned int> &moved)
+{
+    moved.clear();
+    auto range = extra.equal_range(from);
+    for(auto it = range.first; it != range.second; ++it)
+        moved.push_back(it->second);
+    extra.erase(range.first, range.second);
+    for(unsigned int arrayId : moved)
+        extra.emplace(to, arrayId);
+}
+
+
+WorldPathGraph::WorldPathGraph(long cellSize) :
+    m_cellSize(cellSize > 0 ? cellSize : 32)
+{}
+
+long WorldPathGraph::cellOf(long v) const
+{
+    // Floor division to keep negative coordinates in their own cells
+    return (v >= 0) ? (v / m_cellSize) : -((-v + m_cellSize - 1) / m_cellSize);
+}
+
+uint64_t WorldPathGraph::cellKey(long x, long y) const
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(cellOf(x))) << 32) |
+           static_cast<uint32_t>(cellOf(y));
+}
+
+void WorldPathGraph::build(const WorldData &wld)
+{
+    clear();
+    m_enabled = true;
+
+    m_nodes.reserve(static_cast<size_t>(wld.paths.size() + wld.levels.size()));
+    m_cells.reserve(static_cast<size_t>(wld.paths.size() + wld.levels.size()));
+    m_paths.reserve(static_cast<size_t>(wld.paths.size()));
+    m_levels.reserve(static_cast<size_t>(wld.levels.size()));
+
+    for(const WorldPathTile &p : wld.paths)
+        addPath(p);
+    for(const WorldLevelTile &l : wld.levels)
+        addLevel(l);
+}
+
+void WorldPathGraph::clear()
+{
+    m_enabled = false;
+    m_nodes.clear();
+    m_cells.clear();
+    m_paths.clear();
+    m_levels.clear();
+    m_extraPaths.clear();
+    m_extraLevels.clear();
+}
+
+size_t WorldPathGraph::memoryBytes() const
+{
+    const size_t nodeOverhead = 2 * sizeof(void *);
+    size_t bytes = m_nodes.capacity() * sizeof(Node);
+    bytes += m_cells.size() * (nodeOverhead + sizeof(std::pair<const uint64_t, int32_t>)) +
+             m_cells.bucket_count() * sizeof(void *);
+    bytes += m_paths.size() * (nodeOverhead + sizeof(std::pair<const unsigned int, int32_t>)) +
+             m_paths.bucket_count() * sizeof(void *);
+    bytes += m_levels.size() * (nodeOverhead + sizeof(std::pair<const unsigned int, LevelInfo>)) +
+             m_levels.bucket_count() * sizeof(void *);
+    bytes += (m_extraPaths.size() + m_extraLevels.size()) * (nodeOverhead + sizeof(std::pair<const int32_t, unsigned int>)) +
+             (m_extraPaths.bucket_count() + m_extraLevels.bucket_count()) * sizeof(void *);
+    for(const auto &l : m_levels)
+    {
+        for(const std::vector<int> &e : l.second.extraExits)
+            bytes += e.capacity() * sizeof(int);
+        bytes += l.second.jumps.capacity() * sizeof(Jump);
+    }
+    return bytes;
+}
+
+int32_t WorldPathGraph::nodeAt(long x, long y) const
+{
+    auto it = m_cells.find(cellKey(x, y));
+    return (it == m_cells.end()) ? -1 : it->second;
+}
+
+int32_t WorldPathGraph::levelNode(unsigned int arrayId) const
+{
+    auto it = m_levels.find(arrayId);
+    return (it == m_levels.end()) ? -1 : it->second.node;
+}
+
+int32_t WorldPathGraph::acquireNode(long x, long y)
+{
+    const uint64_t key = cellKey(x, y);
+    auto it = m_cells.find(key);
+    if(it != m_cells.end())
+        return it->second;
+
+    const int32_t index = static_cast<int32_t>(m_nodes.size());
+    Node n;
+    n.x = cellOf(x) * m_cellSize;
+    n.y = cellOf(y) * m_cellSize;
+    n.pathId = 0;
+    n.levelId = 0;
+    for(int d = 0; d < 4; d++)
+    {
+        n.neighbor[d] = nodeAt(n.x + c_pathStepX[d] * m_cellSize, n.y + c_pathStepY[d] * m_cellSize);
+        if(n.neighbor[d] >= 0)
+            m_nodes[static_cast<size_t>(n.neighbor[d])].neighbor[c_pathOpposite[d]] = index;
+    }
+
+    m_nodes.push_back(n);
+    m_cells[key] = index;
+    m_enabled = true;
+    return index;
+}
+
+void WorldPathGraph::releaseNode(int32_t index)
+{
+    Node &n = m_nodes[static_cast<size_t>(index)];
+    if(n.pathId != 0 || n.levelId != 0)
+        return;
+
+    for(int d = 0; d < 4; d++)
+    {
+        if(n.neighbor[d] >= 0)
+            m_nodes[static_cast<size_t>(n.neighbor[d])].neighbor[c_pathOpposite[d]] = -1;
+    }
+    m_cells.erase(cellKey(n.x, n.y));
+
+    // Move the last node into the freed place
+    const int32_t last = static_cast<int32_t>(m_nodes.size()) - 1;
+    if(index != last)
+    {
+        const Node &moved = m_nodes[static_cast<size_t>(last)];
+        for(int d = 0; d < 4; d++)
+        {
+            if(moved.neighbor[d] >= 0)
+                m_nodes[static_cast<size_t>(moved.neighbor[d])].neighbor[c_pathOpposite[d]] = index;
+        }
+        m_cells[cellKey(moved.x, moved.y)] = index;
+        if(moved.pathId != 0)
+            m_paths[moved.pathId] = index;
+        if(moved.levelId != 0)
+            m_levels[moved.levelId].node = index;
+
+        std::vector<unsigned int> shared;
+        pathGraphMoveExtra(m_extraPaths, last, index, shared);
+        for(unsigned int arrayId : shared)
+            m_paths[arrayId] = index;
+        pathGraphMoveExtra(m_extraLevels, last, index, shared);
+        for(unsigned int arrayId : shared)
+            m_levels[arrayId].node = index;
+
+        m_nodes[static_cast<size_t>(index)] = moved;
+    }
+    m_nodes.pop_back();
+}
+
+bool WorldPathGraph::addPath(const WorldPathTile &path)
+{
+    if(m_paths.find(path.meta.array_id) != m_paths.end())
+        return false;
+
+    const int32_t index = acquireNode(path.x, path.y);
+    Node &n = m_nodes[static_cast<size_t>(index)];
+    if(n.pathId != 0)
+        m_extraPaths.emplace(index, n.pathId);
+    n.pathId = path.meta.array_id;
+    m_paths[path.meta.array_id] = index;
+    return true;
+}
+
+bool WorldPathGraph::removePath(unsigned int arrayId)
+{
+    auto it = m_paths.find(arrayId);
+    if(it == m_paths.end())
+        return false;
+
+    const int32_t index = it->second;
+    m_paths.erase(it);
+
+    Node &n = m_nodes[static_cast<size_t>(index)];
+    if(n.pathId == arrayId) // Another path tile placed into the same cell takes it's place
+        n.pathId = pathGraphTakeExtra(m_extraPaths, index);
+    else
+        pathGraphEraseExtra(m_extraPaths, index, arrayId);
+
+    releaseNode(index);
+    return true;
+}
+
+bool WorldPathGraph::addLevel(const WorldLevelTile &level)
+{
+    if(m_levels.find(level.meta.array_id) != m_levels.end())
+        return false;
+
+    LevelInfo info;
+    info.node = acquireNode(level.x, level.y);
+    info.exits[DIR_UP] = level.top_exit;
+    info.exits[DIR_LEFT] = level.left_exit;
+    info.exits[DIR_DOWN] = level.bottom_exit;
+    info.exits[DIR_RIGHT] = level.right_exit;
+
+    const WorldLevelTile::OpenCondition *extra[4] =
+    {
+        &level.top_exit_extra, &level.left_exit_extra, &level.bottom_exit_extra, &level.right_exit_extra
+    };
+    for(int d = 0; d < 4; d++)
+        info.extraExits[d].assign(extra[d]->exit_codes.begin(), extra[d]->exit_codes.end());
+
+    if(level.gotox != -1 || level.gotoy != -1)
+    {
+        Jump j;
+        j.x = (level.gotox != -1) ? level.gotox : level.x;
+        j.y = (level.gotoy != -1) ? level.gotoy : level.y;
+        j.teleport = true;
+        info.jumps.push_back(j);
+    }
+
+    for(const WorldLevelTile::Movement::Node &mn : level.movement.nodes)
+    {
+        Jump j;
+        j.x = mn.x;
+        j.y = mn.y;
+        j.teleport = false;
+        info.jumps.push_back(j);
+    }
+
+    Node &n = m_nodes[static_cast<size_t>(info.node)];
+    if(n.levelId != 0)
+        m_extraLevels.emplace(info.node, n.levelId);
+    n.levelId = level.meta.array_id;
+    m_levels[level.meta.array_id] = std::move(info);
+    return true;
+}
+
+bool WorldPathGraph::removeLevel(unsigned int arrayId)
+{
+    auto it = m_levels.find(arrayId);
+    if(it == m_levels.end())
+        return false;
+
+    const int32_t index = it->second.node;
+    m_levels.erase(it);
+
+    Node &n = m_nodes[static_cast<size_t>(index)];
+    if(n.levelId == arrayId) // Another level entrance placed into the same cell takes it's place
+        n.levelId = pathGraphTakeExtra(m_extraLevels, index);
+    else
+        pathGraphEraseExtra(m_extraLevels, index, arrayId);
+
+    releaseNode(index);
+    return true;
+}
+
+void WorldPathGraph::walk(int32_t from, unsigned int flags, std::vector<int32_t> &order, std::vector<int32_t> *parents) const
+{
+    order.clear();
+    if(from < 0 || from >= static_cast<int32_t>(m_nodes.size()))
+        return;
+
+    std::vector<char> visited(m_nodes.size(), 0);
+    if(parents)
+        parents->assign(m_nodes.size(), -1);
+
+    auto visit = [&](int32_t next, int32_t cur)
+    {
+        if(next < 0 || visited[static_cast<size_t>(next)])
+            return;
+        visited[static_cast<size_t>(next)] = 1;
+        if(parents)
+            (*parents)[static_cast<size_t>(next)] = cur;
+        order.push_back(next);
+    };
+
+    visit(from, -1);
+    for(size_t head = 0; head < order.size(); head++)
+    {
+        const int32_t cur = order[head];
+        const Node &n = m_nodes[static_cast<size_t>(cur)];
+
+        if(n.levelId != 0 && (flags & WALK_NO_TELEPORTS) == 0)
+        {
+            auto l = m_levels.find(n.levelId);
+            for(const Jump &j : l->second.jumps)
+            {
+                if(j.teleport)
+                    visit(nodeAt(j.x, j.y), cur);
+            }
+        }
+
+        if(n.levelId != 0 && cur != from && (flags & WALK_STOP_AT_LEVELS) != 0)
+            continue;
+
+        for(int d = 0; d < 4; d++)
+            visit(n.neighbor[d], cur);
+    }
+}
+
+void WorldPathGraph::reachable(int32_t from, std::vector<int32_t> &out, unsigned int flags) const
+{
+    walk(from, flags, out, nullptr);
+}
+
+void WorldPathGraph::reachableLevels(int32_t from, std::vector<unsigned int> &out, unsigned int flags) const
+{
+    out.clear();
+
+    std::vector<int32_t> order;
+    walk(from, flags, order, nullptr);
+
+    std::vector<int32_t> rank(m_nodes.size(), -1);
+    for(size_t i = 0; i < order.size(); i++)
+        rank[static_cast<size_t>(order[i])] = static_cast<int32_t>(i);
+
+    std::vector<std::pair<int32_t, unsigned int> > found;
+    for(const auto &l : m_levels)
+    {
+        int32_t best = rank[static_cast<size_t>(l.second.node)];
+        for(const Jump &j : l.second.jumps)
+        {
+            if(j.teleport)
+                continue;
+            const int32_t at = nodeAt(j.x, j.y);
+            const int32_t r = (at >= 0) ? rank[static_cast<size_t>(at)] : -1;
+            if(r >= 0 && (best < 0 || r < best))
+                best = r;
+        }
+        if(best >= 0)
+            found.push_back(std::make_pair(best, l.first));
+    }
+
+    std::sort(found.begin(), found.end());
+    out.reserve(found.size());
+    for(const auto &f : found)
+        out.push_back(f.second);
+}
+
+bool WorldPathGraph::route(int32_t from, int32_t to, std::vector<int32_t> &out, unsigned int flags) const
+{
+    std::vector<int32_t> order, parents;
+    walk(from, flags, order, &parents);
+    out.clear();
+
+    if(to < 0 || to >= static_cast<int32_t>(m_nodes.size()) ||
+       (to != from && parents.empty()) || (to != from && parents[static_cast<size_t>(to)] < 0))
+        return false;
+
+    for(int32_t n = to; n >= 0; n = parents[static_cast<size_t>(n)])
+        out.push_back(n);
+    std::reverse(out.begin(), out.end());
+    return true;
+}
+
+void WorldPathGraph::openedByLevel(unsigned int arrayId, int exitCode,
+                                   std::vector<unsigned int> &paths, std::vector<unsigned int> &levels) const
+{
+    paths.clear();
+    levels.clear();
+
+    auto it = m_levels.find(arrayId);
+    if(it == m_levels.end())
+        return;
+
+    const LevelInfo &info = it->second;
+    std::vector<char> visited(m_nodes.size(), 0);
+    std::vector<int32_t> queue;
+    visited[static_cast<size_t>(info.node)] = 1;
+
+    for(int d = 0; d < 4; d++)
+    {
+        const std::vector<int> &extra = info.extraExits[d];
+        if(info.exits[d] != -1 && info.exits[d] != exitCode &&
+           std::find(extra.begin(), extra.end(), exitCode) == extra.end())
+            continue;
+
+        const int32_t start = m_nodes[static_cast<size_t>(info.node)].neighbor[d];
+        if(start < 0 || visited[static_cast<size_t>(start)])
+            continue;
+
+        visited[static_cast<size_t>(start)] = 1;
+        queue.push_back(start);
+        for(size_t head = queue.size() - 1; head < queue.size(); head++)
+        {
+            const Node &n = m_nodes[static_cast<size_t>(queue[head])];
+            if(n.levelId != 0)
+            {
+                levels.push_back(n.levelId);
+                continue;
+            }
+
+            paths.push_back(n.pathId);
+            for(int nd = 0; nd < 4; nd++)
+            {
+                const int32_t next = n.neighbor[nd];
+                if(next >= 0 && !visited[static_cast<size_t>(next)])
+                {
+                    visited[static_cast<size_t>(next)] = 1;
+                    queue.push_back(next);
+                }
+            }
+        }
+    }
+}
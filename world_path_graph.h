@@ -0,0 +1,265 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*!
+ * \file world_path_graph.h
+ * \brief Contains the graph of walkable cells of the world map
+ */
+
+#pragma once
+#ifndef WORLD_PATH_GRAPH_H
+#define WORLD_PATH_GRAPH_H
+
+#include "pge_file_lib_globs.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct WorldData;
+struct WorldPathTile;
+struct WorldLevelTile;
+
+/*!
+ * \brief Graph of walkable cells of the world map
+ *
+ * Nodes are grid cells occupied by path tiles and level entrances, each
+ * node links it's walkable neighbors on four sides. Level entrances also
+ * have jumps: the teleport to the "goto" position, and the alternative
+ * positions of the movement nodes where the entrance may move to.
+ * Nodes are kept in one array and are referred by their indices, which
+ * are changing when elements are removed.
+ *
+ * The graph is disabled until build() call. World map readers are
+ * building it when FileFormats::SetWorldBuildPathGraph() is enabled.
+ * After changes of paths and level entrances it should be updated by
+ * add and remove functions, or built again.
+ */
+class WorldPathGraph
+{
+public:
+    //! Side of the cell, same order as exits of the level entrance
+    enum Direction
+    {
+        DIR_UP = 0,
+        DIR_LEFT,
+        DIR_DOWN,
+        DIR_RIGHT
+    };
+
+    //! Options of walking queries
+    enum WalkFlags
+    {
+        //! Walk through level entrances as through cleared ones
+        WALK_DEFAULT = 0,
+        //! Don't walk through level entrances except the starting one, their teleports are still taken
+        WALK_STOP_AT_LEVELS = 1,
+        //! Don't use teleports of level entrances
+        WALK_NO_TELEPORTS = 2
+    };
+
+    //! Walkable cell
+    struct Node
+    {
+        //! Position of the cell
+        long x;
+        long y;
+        //! Array-ID of the path tile in the cell, 0 if none
+        unsigned int pathId;
+        //! Array-ID of the level entrance in the cell, 0 if none
+        unsigned int levelId;
+        //! Indices of neighbor nodes per Direction, -1 if not walkable
+        int32_t neighbor[4];
+    };
+
+    /*!
+     * \brief Constructor
+     * \param cellSize Size of the grid cell of the world map
+     */
+    explicit WorldPathGraph(long cellSize = 32);
+
+    /*!
+     * \brief Is graph built and maintained
+     */
+    bool isEnabled() const
+    {
+        return m_enabled;
+    }
+
+    /*!
+     * \brief Fills the graph from paths and level entrances of the world map, previous content gets removed
+     * \param wld World map data
+     */
+    void build(const WorldData &wld);
+    /*!
+     * \brief Removes everything and disables the graph
+     */
+    void clear();
+    /*!
+     * \brief Number of nodes
+     */
+    size_t size() const
+    {
+        return m_nodes.size();
+    }
+    /*!
+     * \brief Heap bytes taken by the graph
+     */
+    size_t memoryBytes() const;
+
+    /*!
+     * \brief Gives the node
+     * \param index Index of the node, must be less than size()
+     * \return Node
+     */
+    const Node &node(int32_t index) const
+    {
+        return m_nodes[static_cast<size_t>(index)];
+    }
+    /*!
+     * \brief Finds the node of the cell
+     * \param x X position inside of the cell
+     * \param y Y position inside of the cell
+     * \return Index of the node or -1 if cell is not walkable
+     */
+    int32_t nodeAt(long x, long y) const;
+    /*!
+     * \brief Finds the node of the level entrance
+     * \param arrayId Array-ID of the level entrance
+     * \return Index of the node or -1 if there is no such level entrance
+     */
+    int32_t levelNode(unsigned int arrayId) const;
+
+    /*!
+     * \brief Adds the path tile
+     * \param path Path tile
+     * \return false if path tile with same Array-ID is already in the graph
+     */
+    bool addPath(const WorldPathTile &path);
+    /*!
+     * \brief Removes the path tile, moving one should be removed and added again
+     * \param arrayId Array-ID of the path tile
+     * \return false if there is no such path tile
+     */
+    bool removePath(unsigned int arrayId);
+    /*!
+     * \brief Adds the level entrance with it's exits and jumps
+     * \param level Level entrance
+     * \return false if level entrance with same Array-ID is already in the graph
+     */
+    bool addLevel(const WorldLevelTile &level);
+    /*!
+     * \brief Removes the level entrance, changed one should be removed and added again
+     * \param arrayId Array-ID of the level entrance
+     * \return false if there is no such level entrance
+     */
+    bool removeLevel(unsigned int arrayId);
+
+    /*!
+     * \brief Finds all nodes reachable from the given one
+     * \param from Index of the starting node
+     * \param [__out] out Indices of reachable nodes including the starting one, in order of distance
+     * \param flags Walking options (WalkFlags)
+     */
+    void reachable(int32_t from, std::vector<int32_t> &out, unsigned int flags = WALK_DEFAULT) const;
+    /*!
+     * \brief Finds level entrances reachable from the given node at any of their positions
+     * \param from Index of the starting node
+     * \param [__out] out Array-IDs of reachable level entrances, in order of distance
+     * \param flags Walking options (WalkFlags)
+     */
+    void reachableLevels(int32_t from, std::vector<unsigned int> &out, unsigned int flags = WALK_DEFAULT) const;
+    /*!
+     * \brief Finds the shortest route between two nodes
+     * \param from Index of the starting node
+     * \param to Index of the target node
+     * \param [__out] out Indices of nodes of the route from the starting to the target one
+     * \param flags Walking options (WalkFlags)
+     * \return false if target is not reachable
+     */
+    bool route(int32_t from, int32_t to, std::vector<int32_t> &out, unsigned int flags = WALK_DEFAULT) const;
+    /*!
+     * \brief Finds elements which get opened when the level is cleared
+     *
+     * Path opens from every side which exit code matches the given one
+     * (-1 matches any code), or which additional exit codes contain it.
+     * Opening spreads over connected path tiles and stops at level entrances.
+     * Expressions of additional conditions are not evaluated.
+     *
+     * \param arrayId Array-ID of the level entrance
+     * \param exitCode Exit code the level was cleared with
+     * \param [__out] paths Array-IDs of opened path tiles
+     * \param [__out] levels Array-IDs of opened level entrances
+     */
+    void openedByLevel(unsigned int arrayId, int exitCode,
+                       std::vector<unsigned int> &paths, std::vector<unsigned int> &levels) const;
+
+private:
+    //! Position where the level entrance leads or may appear
+    struct Jump
+    {
+        long x;
+        long y;
+        //! Teleport of the player, otherwise an alternative position of the entrance
+        bool teleport;
+    };
+
+    struct LevelInfo
+    {
+        int32_t node = -1;
+        //! Exit codes per Direction
+        int exits[4] = {-1, -1, -1, -1};
+        //! Additional exit codes per Direction
+        std::vector<int> extraExits[4];
+        std::vector<Jump> jumps;
+    };
+
+    long cellOf(long v) const;
+    uint64_t cellKey(long x, long y) const;
+    //! Finds or creates the node of the cell
+    int32_t acquireNode(long x, long y);
+    //! Removes the node if nothing is left in it
+    void releaseNode(int32_t index);
+    //! Breadth-first walk, parents are filled when requested
+    void walk(int32_t from, unsigned int flags, std::vector<int32_t> &order, std::vector<int32_t> *parents) const;
+
+    bool m_enabled = false;
+    long m_cellSize;
+    std::vector<Node> m_nodes;
+    //! Node index per cell
+    std::unordered_map<uint64_t, int32_t> m_cells;
+    //! Node index per path tile Array-ID
+    std::unordered_map<unsigned int, int32_t> m_paths;
+    //! Level entrances by Array-ID
+    std::unordered_map<unsigned int, LevelInfo> m_levels;
+    //! Array-IDs of path tiles sharing the cell with Node::pathId, per node index
+    std::unordered_multimap<int32_t, unsigned int> m_extraPaths;
+    //! Array-IDs of level entrances sharing the cell with Node::levelId, per node index
+    std::unordered_multimap<int32_t, unsigned int> m_extraLevels;
+};
+
+#endif // WORLD_PATH_GRAPH_H
@@ -0,0 +1,513 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "world_spatial_index.h"
+#include "wld_filedata.h"
+
+typedef WorldSpatialIndex::Rect WorldRect;
+
+//! Largest number of grid cells, elements out of such grid are kept aside
+static const double c_worldGridMaxCells = 1048576.0;
+//! Largest number of cells covered by one element, larger ones are kept aside
+static const double c_worldElementMaxCells = 1024.0;
+//! Array-IDs starting from this one are kept in the hash to don't allocate huge tables
+static const unsigned int c_worldDenseIds = 0x100000;
+//! Number of element types
+static const int c_worldTypes = WorldSpatialIndex::ITEM_AREARECT + 1;
+
+static inline bool worldIntersects(const WorldRect &a, const WorldRect &b)
+{
+    return (a.left < b.right) && (a.right > b.left) &&
+           (a.top < b.bottom) && (a.bottom > b.top);
+}
+
+static inline uint64_t worldKey(int type, unsigned int arrayId)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(type)) << 32) | arrayId;
+}
+
+static inline WorldSpatialIndex::Item worldItem(uint64_t key)
+{
+    return {static_cast<int>(key >> 32), static_cast<unsigned int>(key & 0xFFFFFFFF)};
+}
+
+static inline bool worldTypeMatch(uint64_t key, unsigned int typeMask)
+{
+    const uint64_t type = key >> 32;
+    return (type < 32) && ((typeMask >> type) & 1u) != 0;
+}
+
+
+WorldSpatialIndex::WorldSpatialIndex(long cellSize) :
+    m_cellSize(cellSize > 0 ? cellSize : 32)
+{}
+
+long WorldSpatialIndex::cellOf(long v) const
+{
+    // Floor division to keep negative coordinates in their own cells
+    return (v >= 0) ? (v / m_cellSize) : -((-v + m_cellSize - 1) / m_cellSize);
+}
+
+WorldSpatialIndex::Stored *WorldSpatialIndex::findStored(int type, unsigned int arrayId)
+{
+    return const_cast<Stored *>(static_cast<const WorldSpatialIndex *>(this)->findStored(type, arrayId));
+}
+
+const WorldSpatialIndex::Stored *WorldSpatialIndex::findStored(int type, unsigned int arrayId) const
+{
+    if(type >= 0 && type < c_worldTypes && arrayId < c_worldDenseIds)
+    {
+        const std::vector<Stored> &items = m_items[type];
+        return (arrayId < items.size() && items[arrayId].used) ? &items[arrayId] : nullptr;
+    }
+
+    auto it = m_sparseItems.find(worldKey(type, arrayId));
+    return (it == m_sparseItems.end()) ? nullptr : &it->second;
+}
+
+void WorldSpatialIndex::build(const WorldData &wld, long tileSize, long scenerySize)
+{
+    clear();
+    m_tileSize = tileSize;
+    m_scenerySize = scenerySize;
+    m_enabled = true;
+
+    // Allocate the grid at once for the area of tile-sized elements
+    bool hasBounds = false;
+    long x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+    auto expand = [&](long x, long y)
+    {
+        if(!hasBounds)
+        {
+            x0 = x1 = x;
+            y0 = y1 = y;
+            hasBounds = true;
+            return;
+        }
+        x0 = (x < x0) ? x : x0;
+        y0 = (y < y0) ? y : y0;
+        x1 = (x > x1) ? x : x1;
+        y1 = (y > y1) ? y : y1;
+    };
+    for(const WorldTerrainTile &t : wld.tiles)
+        expand(t.x, t.y);
+    for(const WorldScenery &s : wld.scenery)
+        expand(s.x, s.y);
+    for(const WorldPathTile &p : wld.paths)
+        expand(p.x, p.y);
+    for(const WorldLevelTile &l : wld.levels)
+        expand(l.x, l.y);
+    for(const WorldMusicBox &m : wld.music)
+        expand(m.x, m.y);
+    if(hasBounds)
+        growGrid(cellOf(x0), cellOf(y0), cellOf(x1 + tileSize - 1), cellOf(y1 + tileSize - 1));
+
+    m_nodes.reserve(static_cast<size_t>(wld.tiles.size() + wld.scenery.size() + wld.paths.size() +
+                                        wld.levels.size() + wld.music.size() + wld.arearects.size()));
+
+    for(const WorldTerrainTile &t : wld.tiles)
+        insert(t);
+    for(const WorldScenery &s : wld.scenery)
+        insert(s);
+    for(const WorldPathTile &p : wld.paths)
+        insert(p);
+    for(const WorldLevelTile &l : wld.levels)
+        insert(l);
+    for(const WorldMusicBox &m : wld.music)
+        insert(m);
+    for(const WorldAreaRect &a : wld.arearects)
+        insert(a);
+}
+
+void WorldSpatialIndex::clear()
+{
+    m_enabled = false;
+    m_gridX = m_gridY = 0;
+    m_gridW = m_gridH = 0;
+    m_cells.clear();
+    m_nodes.clear();
+    m_freeNode = -1;
+    m_far.clear();
+    m_count = 0;
+    for(std::vector<Stored> &items : m_items)
+        items.clear();
+    m_sparseItems.clear();
+}
+
+size_t WorldSpatialIndex::size() const
+{
+    return m_count;
+}
+
+size_t WorldSpatialIndex::memoryBytes() const
+{
+    size_t bytes = m_cells.capacity() * sizeof(int32_t);
+    bytes += m_nodes.capacity() * sizeof(Node);
+    bytes += m_far.capacity() * sizeof(Entry);
+    for(const std::vector<Stored> &items : m_items)
+        bytes += items.capacity() * sizeof(Stored);
+    bytes += m_sparseItems.size() * (2 * sizeof(void *) + sizeof(std::pair<const uint64_t, Stored>));
+    bytes += m_sparseItems.bucket_count() * sizeof(void *);
+    return bytes;
+}
+
+bool WorldSpatialIndex::growGrid(long cx0, long cy0, long cx1, long cy1)
+{
+    long x0 = cx0, y0 = cy0, x1 = cx1, y1 = cy1;
+
+    if(m_gridW > 0)
+    {
+        const long gx1 = m_gridX + m_gridW - 1, gy1 = m_gridY + m_gridH - 1;
+        if(cx0 >= m_gridX && cy0 >= m_gridY && cx1 <= gx1 && cy1 <= gy1)
+            return true;
+
+        // Grow with a reserve to don't re-layout the grid on every next element
+        const long slackX = (m_gridW / 2 > 8) ? m_gridW / 2 : 8;
+        const long slackY = (m_gridH / 2 > 8) ? m_gridH / 2 : 8;
+        x0 = (cx0 < m_gridX) ? cx0 - slackX : m_gridX;
+        y0 = (cy0 < m_gridY) ? cy0 - slackY : m_gridY;
+        x1 = (cx1 > gx1) ? cx1 + slackX : gx1;
+        y1 = (cy1 > gy1) ? cy1 + slackY : gy1;
+    }
+
+    const double cells = (static_cast<double>(x1) - static_cast<double>(x0) + 1.0) *
+                         (static_cast<double>(y1) - static_cast<double>(y0) + 1.0);
+    if(cells > c_worldGridMaxCells)
+        return false;
+
+    // Lists of nodes are kept, only their heads are moving
+    const long w = x1 - x0 + 1, h = y1 - y0 + 1;
+    std::vector<int32_t> cellsNew(static_cast<size_t>(w * h), -1);
+    for(long y = 0; y < m_gridH; y++)
+    {
+        for(long x = 0; x < m_gridW; x++)
+        {
+            const long nx = m_gridX + x - x0, ny = m_gridY + y - y0;
+            cellsNew[static_cast<size_t>(ny * w + nx)] = m_cells[static_cast<size_t>(y * m_gridW + x)];
+        }
+    }
+
+    m_cells.swap(cellsNew);
+    m_gridX = x0;
+    m_gridY = y0;
+    m_gridW = w;
+    m_gridH = h;
+    return true;
+}
+
+bool WorldSpatialIndex::place(uint64_t key, const Rect &r)
+{
+    const long cx0 = cellOf(r.left), cy0 = cellOf(r.top);
+    const long cx1 = cellOf(r.right - 1), cy1 = cellOf(r.bottom - 1);
+
+    if((static_cast<double>(cx1) - static_cast<double>(cx0) + 1.0) *
+       (static_cast<double>(cy1) - static_cast<double>(cy0) + 1.0) > c_worldElementMaxCells ||
+       !growGrid(cx0, cy0, cx1, cy1))
+    {
+        m_far.push_back({key, r});
+        return true;
+    }
+
+    for(long cy = cy0; cy <= cy1; cy++)
+    {
+        for(long cx = cx0; cx <= cx1; cx++)
+        {
+            int32_t &head = m_cells[static_cast<size_t>((cy - m_gridY) * m_gridW + (cx - m_gridX))];
+            int32_t n = m_freeNode;
+            if(n >= 0)
+            {
+                m_freeNode = m_nodes[static_cast<size_t>(n)].next;
+                m_nodes[static_cast<size_t>(n)] = {key, r, head};
+            }
+            else
+            {
+                n = static_cast<int32_t>(m_nodes.size());
+                m_nodes.push_back({key, r, head});
+            }
+            head = n;
+        }
+    }
+
+    return false;
+}
+
+void WorldSpatialIndex::unplace(uint64_t key, const Stored &s)
+{
+    if(s.far)
+    {
+        for(size_t i = 0; i < m_far.size(); i++)
+        {
+            if(m_far[i].key == key)
+            {
+                m_far[i] = m_far.back();
+                m_far.pop_back();
+                break;
+            }
+        }
+        return;
+    }
+
+    const long cx1 = cellOf(s.r.right - 1), cy1 = cellOf(s.r.bottom - 1);
+    for(long cy = cellOf(s.r.top); cy <= cy1; cy++)
+    {
+        for(long cx = cellOf(s.r.left); cx <= cx1; cx++)
+        {
+            int32_t *link = &m_cells[static_cast<size_t>((cy - m_gridY) * m_gridW + (cx - m_gridX))];
+            while(*link >= 0)
+            {
+                Node &node = m_nodes[static_cast<size_t>(*link)];
+                if(node.key == key)
+                {
+                    const int32_t n = *link;
+                    *link = node.next;
+                    node.next = m_freeNode;
+                    m_freeNode = n;
+                    break;
+                }
+                link = &node.next;
+            }
+        }
+    }
+}
+
+bool WorldSpatialIndex::insert(int type, unsigned int arrayId, long x, long y, long w, long h)
+{
+    if(findStored(type, arrayId))
+        return false;
+
+    const uint64_t key = worldKey(type, arrayId);
+    Stored s = {{x, y, x + (w > 0 ? w : 1), y + (h > 0 ? h : 1)}, true, false};
+    s.far = place(key, s.r);
+
+    if(type >= 0 && type < c_worldTypes && arrayId < c_worldDenseIds)
+    {
+        std::vector<Stored> &items = m_items[type];
+        if(arrayId >= items.size())
+            items.resize(static_cast<size_t>(arrayId) + 1, Stored());
+        items[arrayId] = s;
+    }
+    else
+        m_sparseItems[key] = s;
+
+    m_count++;
+    m_enabled = true;
+    return true;
+}
+
+bool WorldSpatialIndex::insert(const WorldTerrainTile &tile)
+{
+    return insert(ITEM_TILE, tile.meta.array_id, tile.x, tile.y, m_tileSize, m_tileSize);
+}
+
+bool WorldSpatialIndex::insert(const WorldScenery &scenery)
+{
+    return insert(ITEM_SCENERY, scenery.meta.array_id, scenery.x, scenery.y, m_scenerySize, m_scenerySize);
+}
+
+bool WorldSpatialIndex::insert(const WorldPathTile &path)
+{
+    return insert(ITEM_PATH, path.meta.array_id, path.x, path.y, m_tileSize, m_tileSize);
+}
+
+bool WorldSpatialIndex::insert(const WorldLevelTile &level)
+{
+    return insert(ITEM_LEVEL, level.meta.array_id, level.x, level.y, m_tileSize, m_tileSize);
+}
+
+bool WorldSpatialIndex::insert(const WorldMusicBox &music)
+{
+    return insert(ITEM_MUSICBOX, music.meta.array_id, music.x, music.y, m_tileSize, m_tileSize);
+}
+
+bool WorldSpatialIndex::insert(const WorldAreaRect &area)
+{
+    return insert(ITEM_AREARECT, area.meta.array_id, area.x, area.y, area.w, area.h);
+}
+
+bool WorldSpatialIndex::remove(int type, unsigned int arrayId)
+{
+    Stored *s = findStored(type, arrayId);
+    if(!s)
+        return false;
+
+    const uint64_t key = worldKey(type, arrayId);
+    unplace(key, *s);
+    if(type >= 0 && type < c_worldTypes && arrayId < c_worldDenseIds)
+        s->used = false;
+    else
+        m_sparseItems.erase(key);
+
+    m_count--;
+    return true;
+}
+
+bool WorldSpatialIndex::move(int type, unsigned int arrayId, long x, long y, long w, long h)
+{
+    Stored *s = findStored(type, arrayId);
+    if(!s)
+        return false;
+
+    const uint64_t key = worldKey(type, arrayId);
+    unplace(key, *s);
+    s->r = {x, y, x + (w > 0 ? w : 1), y + (h > 0 ? h : 1)};
+    s->far = place(key, s->r);
+    return true;
+}
+
+bool WorldSpatialIndex::move(const WorldTerrainTile &tile)
+{
+    return move(ITEM_TILE, tile.meta.array_id, tile.x, tile.y, m_tileSize, m_tileSize);
+}
+
+bool WorldSpatialIndex::move(const WorldScenery &scenery)
+{
+    return move(ITEM_SCENERY, scenery.meta.array_id, scenery.x, scenery.y, m_scenerySize, m_scenerySize);
+}
+
+bool WorldSpatialIndex::move(const WorldPathTile &path)
+{
+    return move(ITEM_PATH, path.meta.array_id, path.x, path.y, m_tileSize, m_tileSize);
+}
+
+bool WorldSpatialIndex::move(const WorldLevelTile &level)
+{
+    return move(ITEM_LEVEL, level.meta.array_id, level.x, level.y, m_tileSize, m_tileSize);
+}
+
+bool WorldSpatialIndex::move(const WorldMusicBox &music)
+{
+    return move(ITEM_MUSICBOX, music.meta.array_id, music.x, music.y, m_tileSize, m_tileSize);
+}
+
+bool WorldSpatialIndex::move(const WorldAreaRect &area)
+{
+    return move(ITEM_AREARECT, area.meta.array_id, area.x, area.y, area.w, area.h);
+}
+
+bool WorldSpatialIndex::contains(int type, unsigned int arrayId, Rect *rect) const
+{
+    const Stored *s = findStored(type, arrayId);
+    if(!s)
+        return false;
+
+    if(rect)
+        *rect = s->r;
+    return true;
+}
+
+/*
+ * Element which covers several cells is reported from one cell only:
+ * the top-left cell of the intersection of the element and the query
+ */
+void WorldSpatialIndex::scanCell(int32_t head, long cx, long cy, const Rect &q,
+                                 long qcx, long qcy, unsigned int typeMask, std::vector<Item> &out) const
+{
+    for(int32_t n = head; n >= 0; n = m_nodes[static_cast<size_t>(n)].next)
+    {
+        const Node &e = m_nodes[static_cast<size_t>(n)];
+        if(!worldTypeMatch(e.key, typeMask) || !worldIntersects(e.r, q))
+            continue;
+        const long ecx = cellOf(e.r.left), ecy = cellOf(e.r.top);
+        const long firstX = (ecx > qcx) ? ecx : qcx;
+        const long firstY = (ecy > qcy) ? ecy : qcy;
+        if(firstX == cx && firstY == cy)
+            out.push_back(worldItem(e.key));
+    }
+}
+
+void WorldSpatialIndex::queryRect(long left, long top, long right, long bottom, std::vector<Item> &out,
+                                  unsigned int typeMask) const
+{
+    out.clear();
+    if(right <= left || bottom <= top)
+        return;
+
+    const Rect q = {left, top, right, bottom};
+    const long qcx = cellOf(left), qcy = cellOf(top);
+    const long qcx1 = cellOf(right - 1), qcy1 = cellOf(bottom - 1);
+
+    const long cx0 = (qcx > m_gridX) ? qcx : m_gridX;
+    const long cy0 = (qcy > m_gridY) ? qcy : m_gridY;
+    const long cx1 = (qcx1 < m_gridX + m_gridW - 1) ? qcx1 : m_gridX + m_gridW - 1;
+    const long cy1 = (qcy1 < m_gridY + m_gridH - 1) ? qcy1 : m_gridY + m_gridH - 1;
+
+    for(long cy = cy0; cy <= cy1; cy++)
+    {
+        for(long cx = cx0; cx <= cx1; cx++)
+        {
+            const int32_t head = m_cells[static_cast<size_t>((cy - m_gridY) * m_gridW + (cx - m_gridX))];
+            if(head >= 0)
+                scanCell(head, cx, cy, q, qcx, qcy, typeMask, out);
+        }
+    }
+
+    for(const Entry &e : m_far)
+    {
+        if(worldTypeMatch(e.key, typeMask) && worldIntersects(e.r, q))
+            out.push_back(worldItem(e.key));
+    }
+}
+
+void WorldSpatialIndex::queryPoint(long x, long y, std::vector<Item> &out, unsigned int typeMask) const
+{
+    queryRect(x, y, x + 1, y + 1, out, typeMask);
+}
+
+unsigned int WorldSpatialIndex::findAt(int type, long x, long y) const
+{
+    if(type < 0 || type >= 32)
+        return 0;
+
+    const Rect q = {x, y, x + 1, y + 1};
+    const unsigned int typeMask = 1u << type;
+    unsigned int found = 0;
+
+    const long cx = cellOf(x), cy = cellOf(y);
+    if(cx >= m_gridX && cy >= m_gridY && cx < m_gridX + m_gridW && cy < m_gridY + m_gridH)
+    {
+        int32_t n = m_cells[static_cast<size_t>((cy - m_gridY) * m_gridW + (cx - m_gridX))];
+        for(; n >= 0; n = m_nodes[static_cast<size_t>(n)].next)
+        {
+            const Node &e = m_nodes[static_cast<size_t>(n)];
+            if(worldTypeMatch(e.key, typeMask) && worldIntersects(e.r, q))
+            {
+                const unsigned int id = static_cast<unsigned int>(e.key & 0xFFFFFFFF);
+                found = (id > found) ? id : found;
+            }
+        }
+    }
+
+    for(const Entry &e : m_far)
+    {
+        if(worldTypeMatch(e.key, typeMask) && worldIntersects(e.r, q))
+        {
+            const unsigned int id = static_cast<unsigned int>(e.key & 0xFFFFFFFF);
+            found = (id > found) ? id : found;
+        }
+    }
+
+    return found;
+}
@@ -0,0 +1,302 @@
+/*
+ * PGE File Library - a library to process file formats, part of Moondust project
+ *
+ * Copyright (c) 2014-2022 Vitaly Novichkov <admin@wohlnet.ru>
+ *
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*!
+ * \file world_spatial_index.h
+ * \brief Contains the dense grid index of world map elements for "what is here" queries
+ */
+
+#pragma once
+#ifndef WORLD_SPATIAL_INDEX_H
+#define WORLD_SPATIAL_INDEX_H
+
+#include "pge_file_lib_globs.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct WorldData;
+struct WorldTerrainTile;
+struct WorldScenery;
+struct WorldPathTile;
+struct WorldLevelTile;
+struct WorldMusicBox;
+struct WorldAreaRect;
+
+/*!
+ * \brief Grid index over tiles, scenery, paths, level entrances, music boxes and area rectangles of the world map
+ *
+ * World map elements are placed on a fixed grid, so the index keeps a dense
+ * array of cells covering the populated area, each cell lists elements of
+ * all kinds which are touching it. The array grows when elements are added
+ * out of it's bounds, elements too far away from the rest are kept aside
+ * and are checked by every query.
+ *
+ * Elements are identified by their type and ElementMeta::array_id.
+ * All rectangles are half-open: the right and bottom edges are excluded.
+ * The index is disabled until build() call. World map readers are building
+ * it when FileFormats::SetWorldBuildSpatialIndex() is enabled, after changes of element positions or collections it should be
+ * updated by insert(), move() and remove(), or built again.
+ */
+class WorldSpatialIndex
+{
+public:
+    //! Type of the indexed element
+    enum ItemType
+    {
+        ITEM_TILE = 0,
+        ITEM_SCENERY,
+        ITEM_PATH,
+        ITEM_LEVEL,
+        ITEM_MUSICBOX,
+        ITEM_AREARECT
+    };
+
+    //! Type filters of queries
+    enum ItemMask
+    {
+        MASK_TILE       = 1 << ITEM_TILE,
+        MASK_SCENERY    = 1 << ITEM_SCENERY,
+        MASK_PATH       = 1 << ITEM_PATH,
+        MASK_LEVEL      = 1 << ITEM_LEVEL,
+        MASK_MUSICBOX   = 1 << ITEM_MUSICBOX,
+        MASK_AREARECT   = 1 << ITEM_AREARECT,
+        MASK_ALL        = 0x3F
+    };
+
+    //! Found element
+    struct Item
+    {
+        //! Type of the element (ItemType)
+        int type;
+        //! Array ID of the element
+        unsigned int arrayId;
+    };
+
+    //! Rectangle of the element
+    struct Rect
+    {
+        long left;
+        long top;
+        long right;
+        long bottom;
+    };
+
+    /*!
+     * \brief Constructor
+     * \param cellSize Size of the grid cell, usually the size of terrain tile
+     */
+    explicit WorldSpatialIndex(long cellSize = 32);
+
+    /*!
+     * \brief Is index built and maintained
+     */
+    bool isEnabled() const
+    {
+        return m_enabled;
+    }
+
+    /*!
+     * \brief Fills the index with all elements of the world map, previous content gets removed
+     * \param wld World map data
+     * \param tileSize Size of terrain tiles, paths, level entrances and music boxes
+     * \param scenerySize Size of scenery
+     */
+    void build(const WorldData &wld, long tileSize = 32, long scenerySize = 16);
+    /*!
+     * \brief Removes all elements and disables the index
+     */
+    void clear();
+    /*!
+     * \brief Number of indexed elements
+     */
+    size_t size() const;
+    /*!
+     * \brief Heap bytes taken by the index
+     */
+    size_t memoryBytes() const;
+
+    /*!
+     * \brief Adds the element
+     * \param type Type of the element (ItemType)
+     * \param arrayId Array ID of the element
+     * \param x X position
+     * \param y Y position
+     * \param w Width, less than 1 is treated as 1
+     * \param h Height, less than 1 is treated as 1
+     * \return false if element with same type and array ID is already indexed
+     */
+    bool insert(int type, unsigned int arrayId, long x, long y, long w, long h);
+    //! Adds the terrain tile, see insert()
+    bool insert(const WorldTerrainTile &tile);
+    //! Adds the scenery, see insert()
+    bool insert(const WorldScenery &scenery);
+    //! Adds the path tile, see insert()
+    bool insert(const WorldPathTile &path);
+    //! Adds the level entrance, see insert()
+    bool insert(const WorldLevelTile &level);
+    //! Adds the music box, see insert()
+    bool insert(const WorldMusicBox &music);
+    //! Adds the area rectangle, see insert()
+    bool insert(const WorldAreaRect &area);
+
+    /*!
+     * \brief Removes the element
+     * \param type Type of the element (ItemType)
+     * \param arrayId Array ID of the element
+     * \return false if element is not indexed
+     */
+    bool remove(int type, unsigned int arrayId);
+
+    /*!
+     * \brief Changes position and size of the element
+     * \param type Type of the element (ItemType)
+     * \param arrayId Array ID of the element
+     * \param x New X position
+     * \param y New Y position
+     * \param w New width
+     * \param h New height
+     * \return false if element is not indexed
+     */
+    bool move(int type, unsigned int arrayId, long x, long y, long w, long h);
+    //! Updates position of the terrain tile, see move()
+    bool move(const WorldTerrainTile &tile);
+    //! Updates position of the scenery, see move()
+    bool move(const WorldScenery &scenery);
+    //! Updates position of the path tile, see move()
+    bool move(const WorldPathTile &path);
+    //! Updates position of the level entrance, see move()
+    bool move(const WorldLevelTile &level);
+    //! Updates position of the music box, see move()
+    bool move(const WorldMusicBox &music);
+    //! Updates position and size of the area rectangle, see move()
+    bool move(const WorldAreaRect &area);
+
+    /*!
+     * \brief Is element indexed
+     * \param type Type of the element (ItemType)
+     * \param arrayId Array ID of the element
+     * \param [__out] rect Rectangle of the element (optional)
+     * \return true if element is indexed
+     */
+    bool contains(int type, unsigned int arrayId, Rect *rect = nullptr) const;
+
+    /*!
+     * \brief Finds all elements which are intersecting the rectangle
+     * \param left Left edge
+     * \param top Top edge
+     * \param right Right edge (excluded)
+     * \param bottom Bottom edge (excluded)
+     * \param [__out] out Found elements, in no particular order
+     * \param typeMask Types of elements to find (ItemMask)
+     */
+    void queryRect(long left, long top, long right, long bottom, std::vector<Item> &out,
+                   unsigned int typeMask = MASK_ALL) const;
+    /*!
+     * \brief Finds all elements which are covering the point
+     * \param x X position
+     * \param y Y position
+     * \param [__out] out Found elements, in no particular order
+     * \param typeMask Types of elements to find (ItemMask)
+     */
+    void queryPoint(long x, long y, std::vector<Item> &out, unsigned int typeMask = MASK_ALL) const;
+    /*!
+     * \brief Finds the element of given type which covers the point
+     * \param type Type of the element (ItemType)
+     * \param x X position
+     * \param y Y position
+     * \return Array ID of the element, the largest one when several elements are here, or 0 if nothing found
+     */
+    unsigned int findAt(int type, long x, long y) const;
+
+private:
+    //! Element in the cell list
+    struct Node
+    {
+        uint64_t key;
+        Rect r;
+        //! Next node of the cell, or -1
+        int32_t next;
+    };
+
+    //! Element aside of the grid
+    struct Entry
+    {
+        uint64_t key;
+        Rect r;
+    };
+
+    struct Stored
+    {
+        Rect r;
+        //! Element is indexed
+        bool used;
+        //! Element is kept aside of grid
+        bool far;
+    };
+
+    long cellOf(long v) const;
+    Stored *findStored(int type, unsigned int arrayId);
+    const Stored *findStored(int type, unsigned int arrayId) const;
+    //! Grows the grid to cover cells, false if grid would be too large
+    bool growGrid(long cx0, long cy0, long cx1, long cy1);
+    //! Places the element into the grid or aside of it, returns true if it was placed aside
+    bool place(uint64_t key, const Rect &r);
+    void unplace(uint64_t key, const Stored &s);
+    void scanCell(int32_t head, long cx, long cy, const Rect &q,
+                  long qcx, long qcy, unsigned int typeMask, std::vector<Item> &out) const;
+
+    bool m_enabled = false;
+    long m_cellSize;
+    long m_tileSize = 32;
+    long m_scenerySize = 16;
+
+    //! Cell coordinates of the top-left grid cell
+    long m_gridX = 0;
+    long m_gridY = 0;
+    //! Size of the grid in cells
+    long m_gridW = 0;
+    long m_gridH = 0;
+    //! First node of each cell in row-major order, or -1
+    std::vector<int32_t> m_cells;
+    //! Pool of nodes of all cells
+    std::vector<Node> m_nodes;
+    //! First free node of the pool, or -1
+    int32_t m_freeNode = -1;
+    //! Elements out of the grid
+    std::vector<Entry> m_far;
+
+    //! Number of indexed elements
+    size_t m_count = 0;
+    //! Rectangles of indexed elements of each type by Array-ID
+    std::vector<Stored> m_items[ITEM_AREARECT + 1];
+    //! Rectangles of elements with too large Array-IDs or unknown types by the element key
+    std::unordered_map<uint64_t, Stored> m_sparseItems;
+};
+
+#endif // WORLD_SPATIAL_INDEX_H